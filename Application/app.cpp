@@ -9,8 +9,19 @@
 #include "app.h"
 #include "animations/boot_animation.h"
 #include "drivers/iwdg_a.h"
+#include "global/analog.h"
+#include "global/binproto.h"
 #include "global/commands.h"
+#include "global/color_engine.h"
 #include "global/controller.h"
+#include "global/deferred.h"
+#include "global/timer_wheel.h"
+#include "global/effects.h"
+#include "global/fan.h"
+#include "global/lumen.h"
+#include "global/presets.h"
+#include "global/pwm_profile.h"
+#include "global/regulator.h"
 #include "global/global_objects.h"
 #include "hardware/devices.h"
 #include "stm32_u8g2.h"
@@ -24,10 +35,8 @@
 #include <stdio.h>
 #include <string.h>
 
-
-/* Forward declarations ------------------------------------------------------*/
-extern void calculateChannelRatio(uint16_t colorTemp, uint16_t brightness,
-                                  uint16_t *ch1PWM, uint16_t *ch2PWM);
+/* Private defines -----------------------------------------------------------*/
+#define APP_UART_MESSAGES_PER_LOOP 8 // 每轮主循环最多处理的串口消息数
 
 /* Private variables ---------------------------------------------------------*/
 static uint32_t loop_counter = 0;
@@ -38,6 +47,9 @@ static uint32_t last_tick = 0;
 static void button_click_handler();
 static void button_long_press_handler(uint32_t duration_ms);
 static void button_multi_click_handler(uint8_t click_count);
+static void btn_1_click_handler();
+static void btn_2_click_handler();
+static void command_tick_work(uint32_t arg);
 // static void encoder_event_handler(EncoderEvent_t event,
 //                                   EncoderDirection_t direction, int32_t
 //                                   steps);
@@ -167,8 +179,18 @@ void App_Init(void) {
   // 初始化全局对象
   GlobalObjects_Init();
 
-  // 启动ADC校准
-  HAL_ADCEx_Calibration_Start(&hadc1);
+  // 通道参数和色度数据恢复默认 (随后可能被EEPROM设置覆盖)
+  PwmProfile_Init();
+  Channels_Init();
+  Color_Init();
+  Effects_Init();
+  Presets_Init();
+  Lumen_Init();
+  Regulator_Init();
+  Fan_Init();
+
+  // ADC校准并开始定时器触发的温度采集 (TIM1已由Channels_Init启动)
+  Analog_Init();
 
   // 初始化开机动画系统
   if (BootAnimation_Init(&u8g2)) {
@@ -217,6 +239,10 @@ void App_Init(void) {
   encoder_button.handleMultiClick(5, button_multi_click_handler,
                                   400); // 最多5击，间隔400ms
 
+  // PA5/PA6按键: 循环调用下一个/上一个预设
+  btn_1.handleClick(btn_1_click_handler);
+  btn_2.handleClick(btn_2_click_handler);
+
   // 启用按键中断模式
   encoder_button.setInterruptMode(true);
 
@@ -236,13 +262,8 @@ void App_Init(void) {
   // 可选：设置编码器方向反转
   // rotary_encoder.setReversed(true);
 
-  // 启动TIM1的PWM输出
-  HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_1); // PA8 - TIM1_CH1
-  HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_2); // PA9 - TIM1_CH2
-
-  // 初始化PWM占空比为0
-  __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, 0);
-  __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_2, 0);
+  // 启动TIM1的PWM输出 (PA8/PA9/PA10/PA11 - TIM1_CH1-CH4)，占空比初始化为0
+  Channels_Start();
 
   // 初始化命令系统
   Commands_Init();
@@ -254,15 +275,26 @@ void App_Init(void) {
  */
 void App_Loop(void) {
 
-  // 检查并处理串口消息
-  if (UART_Has_Message()) {
+  // 检查并处理串口消息: 每轮最多处理APP_UART_MESSAGES_PER_LOOP条，
+  // 流式发送的二进制帧不会一轮只处理一帧而积压在接收缓冲区中
+  for (uint8_t i = 0; i < APP_UART_MESSAGES_PER_LOOP; i++) {
     UartMessage_t *message = UART_Get_Message();
-    if (message != NULL) {
+    if (message == NULL) {
+      break;
+    }
+    if (message->binary) {
+      BinProto_Process(message->data, message->length);
+    } else {
       App_Process_UART_Command((const char *)message->data, message->length);
-      UART_Clear_Message(); // 清除消息，准备接收下一个
     }
+    UART_Clear_Message(); // 清除消息，准备接收下一个
+    UART_Process_DMA_Reception(); // 继续解析缓冲区中剩余的字节
   }
 
+  // 推进软件定时器 (WAIT等)，再执行中断投递的工作 (命令执行节拍等)
+  TimerWheel_Process();
+  Deferred_Run();
+
   GlobalObjects_Process();
 
   loop();
@@ -399,9 +431,22 @@ static void button_multi_click_handler(uint8_t click_count) {
   // serial_printf("Button Multi-Click: %u clicks detected\r\n", click_count);
   if (click_count == 2) {
     handleDoubleClick();
+  } else if (click_count >= PRESET_CLICK_BASE) {
+    // 3/4/5击调用预设1/2/3
+    Presets_Recall(click_count - PRESET_CLICK_BASE);
   }
 }
 
+/**
+ * @brief PA5按键单击: 下一个预设
+ */
+static void btn_1_click_handler() { Presets_Recall_Next(1); }
+
+/**
+ * @brief PA6按键单击: 上一个预设
+ */
+static void btn_2_click_handler() { Presets_Recall_Next(-1); }
+
 // /**
 //  * @brief 编码器事件回调函数
 //  */
@@ -462,6 +507,7 @@ static void encoder_rotation_handler(EncoderDirection_t direction,
 void App_TIM3_IRQHandler(void) {
   // 每次中断发生时，计数器加1
   updatePWM();
+  Fan_Tick();
 }
 
 /**
@@ -476,8 +522,10 @@ void App_Process_UART_Command(const char *command, uint16_t length) {
     return;
   }
 
-  // 发送确认消息（调试用）
-  UART_Printf("Received: %s\r\n", command);
+  // 发送确认消息（调试用，安静模式下不输出）
+  if (!Commands_Is_Quiet()) {
+    UART_Printf("Received: %s\r\n", command);
+  }
 
   // 特殊调试命令：手动执行队列
   if (strcmp(command, "EXEC") == 0) {
@@ -496,8 +544,9 @@ void App_Process_UART_Command(const char *command, uint16_t length) {
 
   // 特殊调试命令：查看队列状态
   if (strcmp(command, "QUEUE") == 0) {
-    UART_Printf("Queue status: %d commands pending\r\n",
-                Commands_Get_Queue_Count());
+    UART_Printf("Queue status: %d commands pending (%d/%d bytes)\r\n",
+                Commands_Get_Queue_Count(), Commands_Get_Queue_Bytes(),
+                CMD_ARENA_SIZE);
     return;
   }
 
@@ -505,13 +554,25 @@ void App_Process_UART_Command(const char *command, uint16_t length) {
   uint16_t parsed_count = Commands_Parse_And_Enqueue(command);
 
   if (parsed_count > 0) {
-    UART_Printf("OK: Enqueued %d commands\r\n", parsed_count);
+    if (!Commands_Is_Quiet()) {
+      UART_Printf("OK: Enqueued %d commands\r\n", parsed_count);
+    }
   } else {
     UART_Send_String("ERROR: Failed to parse commands\r\n");
   }
 }
 
+/**
+ * @brief 命令执行节拍 (主循环中由Deferred_Run调用)
+ */
+static void command_tick_work(uint32_t arg) { Commands_Executor_Loop(); }
+
 /**
  * @brief Command executor timer callback (call from TIM4 interrupt)
+ * @note 中断只投递节拍；命令回调会阻塞发送串口，放在主循环中执行
  */
-void App_Command_Executor_Timer_Callback(void) { Commands_Executor_Loop(); }
\ No newline at end of file
+void App_Command_Executor_Timer_Callback(void) {
+  uint32_t start = Deferred_Isr_Enter();
+  Deferred_Post(command_tick_work, 0);
+  Deferred_Isr_Exit(start);
+}
\ No newline at end of file
@@ -196,7 +196,14 @@ bool EEPROM::writePage(uint16_t page_addr, uint8_t offset, const uint8_t *buffer
  * @brief 计算CRC32校验码
  */
 uint32_t EEPROM::calculateCRC32(const uint8_t* data, uint32_t length) {
-    uint32_t crc = 0xFFFFFFFF;
+    return updateCRC32(0, data, length);
+}
+
+/**
+ * @brief 在上一段的CRC32上继续计算 (结果与整段一次计算相同)
+ */
+uint32_t EEPROM::updateCRC32(uint32_t crc, const uint8_t* data, uint32_t length) {
+    crc ^= 0xFFFFFFFF;
     
     for (uint32_t i = 0; i < length; i++) {
         uint8_t byte = data[i];
@@ -96,8 +96,9 @@ public:
     EEPROM_Status_t getLastError() const { return last_error_; }
     HAL_StatusTypeDef getLastHALError() const { return last_hal_error_; }
 
-    // CRC32计算
+    // CRC32计算 (update可分段计算: crc从0开始，传入上一段的结果)
     static uint32_t calculateCRC32(const uint8_t* data, uint32_t length);
+    static uint32_t updateCRC32(uint32_t crc, const uint8_t* data, uint32_t length);
 
 private:
     I2C_HandleTypeDef *hi2c_;
@@ -0,0 +1,208 @@
+/**
+ * @file power_monitor.cpp
+ * @brief I2C电压电流采样芯片驱动实现
+ * @author User
+ * @date 2025-09-25
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "power_monitor.h"
+
+/* 寄存器定义 (INA219/INA226相同) */
+#define REG_CONFIG 0x00
+#define REG_SHUNT 0x01
+#define REG_BUS 0x02
+#define REG_MANUFACTURER_ID 0xFE // 仅INA226
+
+#define INA226_MANUFACTURER_ID 0x5449 // "TI"
+
+// INA226: 4次平均，分流/母线转换时间各1.1ms，连续转换 (约8.8ms出一个结果)
+#define INA226_CONFIG 0x4327
+// INA219: 32V量程，分流±320mV，12位，连续转换 (约1.1ms出一个结果)
+#define INA219_CONFIG 0x399F
+
+#define TRANSFER_TIMEOUT_MS 20 // 中断传输超时，超时后允许重新发起
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+ * @brief 默认构造函数
+ */
+PowerMonitor::PowerMonitor()
+    : hi2c_(nullptr), device_address_(0x86), shunt_mohm_(10),
+      type_(POWER_MONITOR_NONE), initialized_(false), step_(STEP_IDLE),
+      ready_(0), start_tick_(0), shunt_raw_(0), bus_raw_(0),
+      sample_count_(0), error_count_(0) {
+    rx_buffer_[0] = 0;
+    rx_buffer_[1] = 0;
+}
+
+/**
+ * @brief 初始化采样芯片
+ * @param hi2c I2C句柄
+ * @param device_addr 8位器件地址 (7位地址左移1位)
+ * @param shunt_mohm 分流电阻 (毫欧)
+ */
+bool PowerMonitor::init(I2C_HandleTypeDef *hi2c, uint16_t device_addr,
+                        uint16_t shunt_mohm) {
+    if (hi2c == nullptr || shunt_mohm == 0) {
+        return false;
+    }
+
+    hi2c_ = hi2c;
+    device_address_ = device_addr;
+    shunt_mohm_ = shunt_mohm;
+    initialized_ = false;
+
+    // INA226有制造商ID寄存器，读不到或不匹配时按INA219处理
+    uint16_t id = 0;
+    if (readRegister(REG_MANUFACTURER_ID, &id) && id == INA226_MANUFACTURER_ID) {
+        type_ = POWER_MONITOR_INA226;
+    } else {
+        type_ = POWER_MONITOR_INA219;
+    }
+
+    if (!writeRegister(REG_CONFIG, type_ == POWER_MONITOR_INA226
+                                       ? INA226_CONFIG
+                                       : INA219_CONFIG)) {
+        type_ = POWER_MONITOR_NONE;
+        return false;
+    }
+
+    step_ = STEP_IDLE;
+    ready_ = 0;
+    initialized_ = true;
+    return true;
+}
+
+const char *PowerMonitor::getTypeName() const {
+    switch (type_) {
+    case POWER_MONITOR_INA219:
+        return "INA219";
+    case POWER_MONITOR_INA226:
+        return "INA226";
+    default:
+        return "NONE";
+    }
+}
+
+/**
+ * @brief 发起一次中断方式读取 (主循环调用)
+ * @return 已有传输进行中或总线忙时返回false
+ */
+bool PowerMonitor::startRead() {
+    if (!initialized_) {
+        return false;
+    }
+
+    if (step_ != STEP_IDLE) {
+        // 回调丢失时超时恢复，避免永久卡在传输中
+        if (HAL_GetTick() - start_tick_ > TRANSFER_TIMEOUT_MS &&
+            HAL_I2C_GetState(hi2c_) == HAL_I2C_STATE_READY) {
+            step_ = STEP_IDLE;
+            error_count_ = error_count_ + 1;
+        }
+        return false;
+    }
+
+    // 与OLED共用I2C1，总线正在阻塞传输时下次再读
+    if (HAL_I2C_GetState(hi2c_) != HAL_I2C_STATE_READY) {
+        return false;
+    }
+
+    start_tick_ = HAL_GetTick();
+    step_ = STEP_SHUNT;
+    if (HAL_I2C_Mem_Read_IT(hi2c_, device_address_, REG_SHUNT,
+                            I2C_MEMADD_SIZE_8BIT, rx_buffer_, 2) != HAL_OK) {
+        step_ = STEP_IDLE;
+        error_count_ = error_count_ + 1;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 取出新样本并换算为mV/mA/mW
+ * @return 没有新样本时返回false
+ */
+bool PowerMonitor::fetch(PowerSample_t *sample) {
+    if (!ready_) {
+        return false;
+    }
+
+    // 下次读取只由主循环在fetch之后发起，此处读取原始值不会与中断冲突
+    int32_t shunt = shunt_raw_;
+    uint32_t bus = bus_raw_;
+    ready_ = 0;
+
+    int32_t shunt_uv;
+    if (type_ == POWER_MONITOR_INA226) {
+        shunt_uv = shunt * 5 / 2;               // 2.5uV/LSB
+        sample->busMillivolts = bus * 5 / 4;    // 1.25mV/LSB
+    } else {
+        shunt_uv = shunt * 10;                  // 10uV/LSB
+        sample->busMillivolts = (bus >> 3) * 4; // 4mV/LSB，低3位为状态位
+    }
+
+    // uV / mOhm = mA
+    sample->currentMilliamps = shunt_uv / (int32_t)shunt_mohm_;
+    sample->powerMilliwatts =
+        sample->currentMilliamps > 0
+            ? ((uint32_t)sample->busMillivolts * sample->currentMilliamps) / 1000
+            : 0;
+    return true;
+}
+
+/**
+ * @brief 中断传输完成: 读完分流电压后接着读母线电压
+ */
+void PowerMonitor::onRxComplete(I2C_HandleTypeDef *hi2c) {
+    if (hi2c != hi2c_) {
+        return;
+    }
+
+    uint16_t value = ((uint16_t)rx_buffer_[0] << 8) | rx_buffer_[1];
+    if (step_ == STEP_SHUNT) {
+        shunt_raw_ = (int16_t)value;
+        step_ = STEP_BUS;
+        if (HAL_I2C_Mem_Read_IT(hi2c_, device_address_, REG_BUS,
+                                I2C_MEMADD_SIZE_8BIT, rx_buffer_, 2) != HAL_OK) {
+            step_ = STEP_IDLE;
+            error_count_ = error_count_ + 1;
+        }
+    } else if (step_ == STEP_BUS) {
+        bus_raw_ = value;
+        step_ = STEP_IDLE;
+        sample_count_ = sample_count_ + 1;
+        ready_ = 1;
+    }
+}
+
+/**
+ * @brief 中断传输出错: 放弃本次采样，等待主循环重新发起
+ */
+void PowerMonitor::onError(I2C_HandleTypeDef *hi2c) {
+    if (hi2c != hi2c_ || step_ == STEP_IDLE) {
+        return;
+    }
+    step_ = STEP_IDLE;
+    error_count_ = error_count_ + 1;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+bool PowerMonitor::writeRegister(uint8_t reg, uint16_t value) {
+    uint8_t data[2] = {(uint8_t)(value >> 8), (uint8_t)(value & 0xFF)};
+    return HAL_I2C_Mem_Write(hi2c_, device_address_, reg, I2C_MEMADD_SIZE_8BIT,
+                             data, 2, 50) == HAL_OK;
+}
+
+bool PowerMonitor::readRegister(uint8_t reg, uint16_t *value) {
+    uint8_t data[2];
+    if (HAL_I2C_Mem_Read(hi2c_, device_address_, reg, I2C_MEMADD_SIZE_8BIT,
+                         data, 2, 50) != HAL_OK) {
+        return false;
+    }
+    *value = ((uint16_t)data[0] << 8) | data[1];
+    return true;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file power_monitor.h
+ * @brief I2C电压电流采样芯片驱动 (INA226/INA219，非阻塞读取)
+ * @author User
+ * @date 2025-09-25
+ */
+
+#ifndef __POWER_MONITOR_H__
+#define __POWER_MONITOR_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f1xx_hal.h"
+#include <stdint.h>
+
+/**
+ * @brief 采样芯片型号 (按制造商ID寄存器识别)
+ */
+typedef enum {
+    POWER_MONITOR_NONE = 0,
+    POWER_MONITOR_INA219,       // 分流LSB 10uV, 母线LSB 4mV
+    POWER_MONITOR_INA226        // 分流LSB 2.5uV, 母线LSB 1.25mV
+} PowerMonitor_Type_t;
+
+/**
+ * @brief 一次完整采样 (分流+母线电压)
+ */
+typedef struct {
+    uint16_t busMillivolts;     // LED母线电压 (mV)
+    int32_t currentMilliamps;   // LED电流 (mA)
+    uint32_t powerMilliwatts;   // LED功率 (mW)
+} PowerSample_t;
+
+/**
+ * @brief 电压电流采样驱动
+ * @note 配置寄存器在初始化时阻塞写入；运行时由主循环调用startRead()发起
+ *       中断方式读取，分流和母线两个寄存器在I2C中断回调中连续读完，
+ *       主循环再用fetch()取出换算好的样本，不会阻塞主循环。
+ */
+class PowerMonitor {
+public:
+    PowerMonitor();
+
+    // 禁用拷贝构造和赋值
+    PowerMonitor(const PowerMonitor&) = delete;
+    PowerMonitor& operator=(const PowerMonitor&) = delete;
+
+    // 初始化: 识别型号并写入连续转换配置
+    bool init(I2C_HandleTypeDef *hi2c, uint16_t device_addr, uint16_t shunt_mohm);
+    bool isInitialized() const { return initialized_; }
+    PowerMonitor_Type_t getType() const { return type_; }
+    const char *getTypeName() const;
+
+    // 非阻塞读取
+    bool startRead();
+    bool fetch(PowerSample_t *sample);
+
+    // I2C中断回调 (在HAL_I2C_MemRxCpltCallback/HAL_I2C_ErrorCallback中调用)
+    void onRxComplete(I2C_HandleTypeDef *hi2c);
+    void onError(I2C_HandleTypeDef *hi2c);
+
+    // 统计
+    uint32_t getSampleCount() const { return sample_count_; }
+    uint32_t getErrorCount() const { return error_count_; }
+
+private:
+    enum : uint8_t { STEP_IDLE = 0, STEP_SHUNT, STEP_BUS };
+
+    I2C_HandleTypeDef *hi2c_;
+    uint16_t device_address_;
+    uint16_t shunt_mohm_;
+    PowerMonitor_Type_t type_;
+    bool initialized_;
+
+    volatile uint8_t step_;         // 当前中断传输步骤
+    volatile uint8_t ready_;        // 有未取走的新样本
+    uint32_t start_tick_;           // 本次传输开始时间 (超时恢复)
+    uint8_t rx_buffer_[2];
+    volatile int16_t shunt_raw_;
+    volatile uint16_t bus_raw_;
+    volatile uint32_t sample_count_;
+    volatile uint32_t error_count_;
+
+    // 内部辅助函数
+    bool writeRegister(uint8_t reg, uint16_t value);
+    bool readRegister(uint8_t reg, uint16_t *value);
+};
+
+#endif /* __POWER_MONITOR_H__ */
@@ -12,7 +12,9 @@
 #include <cstdio>
 #include <cstring>
 #include "utils/custom_types.h"
+#include "global/controller.h"
 #include "global/global_objects.h"
+#include "global/pwm_profile.h"
 
 /* Private variables ---------------------------------------------------------*/
 static EEPROM eeprom_instance;
@@ -182,6 +184,43 @@ bool Settings_Erase(void) {
   }
 }
 
+/**
+ * @brief 读取扩展数据块 (数据后紧跟CRC32)
+ */
+bool Settings_LoadBlock(uint16_t address, void* data, uint16_t size) {
+  if (!eeprom_available || !data) {
+    return false;
+  }
+
+  uint32_t crc = 0;
+  if (!eeprom_instance.read(address, (uint8_t*)data, size) ||
+      !eeprom_instance.read(address + size, (uint8_t*)&crc, sizeof(crc))) {
+    serial_printf("读取数据块失败 (0x%04X)\r\n", address);
+    return false;
+  }
+
+  // 空EEPROM (全0xFF) 同样会在这里被拒绝
+  return crc == EEPROM::calculateCRC32((const uint8_t*)data, size);
+}
+
+/**
+ * @brief 写入扩展数据块并附加CRC32
+ */
+bool Settings_SaveBlock(uint16_t address, const void* data, uint16_t size) {
+  if (!eeprom_available || !data) {
+    return false;
+  }
+
+  uint32_t crc = EEPROM::calculateCRC32((const uint8_t*)data, size);
+  if (!eeprom_instance.write(address, (const uint8_t*)data, size) ||
+      !eeprom_instance.write(address + size, (const uint8_t*)&crc, sizeof(crc))) {
+    serial_printf("保存数据块失败 (0x%04X)\r\n", address);
+    return false;
+  }
+
+  return true;
+}
+
 /* Private functions ---------------------------------------------------------*/
 
 /**
@@ -223,6 +262,19 @@ static bool validateSettings(const SimpleSettings_t *settings) {
     return false;
   }
 
+  // 检查PWM配置
+  if (settings->pwmProfile >= PWM_PROFILE_COUNT) {
+    return false;
+  }
+
+  // 检查通道参数
+  for (int i = 0; i < LED_CHANNEL_MAX; i++) {
+    if (settings->channelLimit[i] > MAX_PWM ||
+        settings->channelMix[i] > CHANNEL_MIX_TOTAL) {
+      return false;
+    }
+  }
+
   // 验证校验和
   uint32_t calculated_checksum = calculateChecksum(settings);
   if (calculated_checksum != settings->checksum) {
@@ -244,6 +296,10 @@ static void initDefaultSettings(SimpleSettings_t *settings) {
   settings->brightness = 100;         // 默认亮度
   settings->colorTemp = 4500;         // 默认色温
   settings->fanAuto = 1;              // 默认风扇自动控制
+  for (int i = 0; i < LED_CHANNEL_MAX; i++) {
+    settings->channelLimit[i] = MAX_PWM; // 默认不限幅
+    settings->channelMix[i] = 0;         // 辅助通道默认关闭
+  }
 
   // 计算校验和
   settings->checksum = calculateChecksum(settings);
@@ -259,6 +315,16 @@ static void stateToSettings(const SystemState *state, SimpleSettings_t *settings
   settings->brightness = state->brightness;
   settings->colorTemp = state->colorTemp;
   settings->fanAuto = state->fanAuto ? 1 : 0;
+  settings->pwmProfile = PwmProfile_Get_Requested();
+  // 限幅按标准量程保存，与PWM配置无关
+  forEachChannel([&](uint8_t ch) {
+    settings->channelLimit[ch] = PwmProfile_To_Standard(channels.limit[ch]);
+    settings->channelMix[ch] = channels.mix[ch];
+  });
+  // 未编译进固件的通道保持默认值
+  for (int i = LED_CHANNEL_COUNT; i < LED_CHANNEL_MAX; i++) {
+    settings->channelLimit[i] = MAX_PWM;
+  }
   // checksum会在外部计算
 }
 
@@ -269,4 +335,10 @@ static void settingsToState(const SimpleSettings_t *settings, SystemState *state
   state->brightness = settings->brightness;
   state->colorTemp = settings->colorTemp;
   state->fanAuto = (settings->fanAuto != 0);
+  forEachChannel([&](uint8_t ch) {
+    channels.limit[ch] = PwmProfile_From_Standard(settings->channelLimit[ch]);
+    channels.mix[ch] = settings->channelMix[ch];
+  });
+  // 限幅已换算到当前量程，切换时随其它PWM量一起换算
+  PwmProfile_Select(settings->pwmProfile);
 }
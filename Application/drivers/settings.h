@@ -10,31 +10,43 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f1xx_hal.h"
+#include "global/channels.h"
 #include <stdint.h>
 #include <stdbool.h>
 
 /* Exported types ------------------------------------------------------------*/
 
 /**
- * @brief 简化的设备配置结构体 - 固定16字节
+ * @brief 简化的设备配置结构体 - 固定32字节 (一页AT24C32)
+ * @note 通道参数按LED_CHANNEL_MAX固定布局，与固件通道数无关
  */
 typedef struct {
-    uint32_t magic;           // 魔术字: 0xA5A5C3C3
+    uint32_t magic;           // 魔术字: 0xA5A5C3C4
     uint16_t brightness;      // 亮度值 (0-512)
     uint16_t colorTemp;       // 色温值 (3000-5700K)
     uint8_t fanAuto;         // 风扇自动控制 (0/1)
-    uint8_t reserved[3];     // 保留字节
+    uint8_t pwmProfile;      // PWM频率/分辨率配置 (PwmProfileId_t)
+    uint8_t reserved[2];     // 保留字节
+    uint16_t channelLimit[LED_CHANNEL_MAX]; // 各通道PWM上限 (标准量程MAX_PWM)
+    uint16_t channelMix[LED_CHANNEL_MAX];   // 辅助通道混合权重
     uint32_t checksum;       // 简单校验和
 } __attribute__((packed)) SimpleSettings_t;
 
 /* Exported constants --------------------------------------------------------*/
 
 // EEPROM内存映射
-#define EEPROM_ADDR_SETTINGS        0x0000  // 设备设置 (16字节)
-#define EEPROM_ADDR_BACKUP          0x0010  // 备份设置 (16字节)
+#define EEPROM_ADDR_SETTINGS        0x0000  // 设备设置 (32字节)
+#define EEPROM_ADDR_BACKUP          0x0020  // 备份设置 (32字节)
+#define EEPROM_ADDR_COLOR           0x0040  // 色度校准数据块 (32字节)
+#define EEPROM_ADDR_PRESETS         0x0060  // 预设库数据块 (8x16+4字节)
+#define EEPROM_ADDR_LUMEN           0x0100  // 光衰累计数据块 (60字节)
+#define EEPROM_ADDR_FAN             0x0140  // 风扇曲线/PID/测速配置 (30+4字节)
+#define EEPROM_ADDR_ANALOG          0x0170  // 过温关断阈值/ADC采样点 (6+4字节)
+#define EEPROM_ADDR_THERMAL         0x0180  // 结温估计热模型参数 (26+4字节)
+#define EEPROM_ADDR_HISTORY         0x01A0  // 时间序列小时环快照 (224+4字节)
 
-// 配置值
-#define SETTINGS_MAGIC              0xA5A5C3C3
+// 配置值 (v2: 增加通道参数，旧版数据按首次启动处理)
+#define SETTINGS_MAGIC              0xA5A5C3C4
 
 /* Exported functions prototypes ---------------------------------------------*/
 
@@ -63,4 +75,15 @@ bool Settings_RestoreDefaults(void* state);
  */
 bool Settings_Erase(void);
 
+/**
+ * @brief 读取扩展数据块 (数据后紧跟CRC32)
+ * @return CRC校验通过返回true
+ */
+bool Settings_LoadBlock(uint16_t address, void* data, uint16_t size);
+
+/**
+ * @brief 写入扩展数据块并附加CRC32
+ */
+bool Settings_SaveBlock(uint16_t address, const void* data, uint16_t size);
+
 #endif /* __SIMPLE_SETTINGS_H__ */
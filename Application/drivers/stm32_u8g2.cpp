@@ -33,13 +33,21 @@ uint8_t u8x8_byte_hw_i2c(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int,
     buf_idx += arg_int;
     break;
 
-  case U8X8_MSG_BYTE_END_TRANSFER:
+  case U8X8_MSG_BYTE_END_TRANSFER: {
+    // 等待功率采样的中断读取结束 (共用I2C1，一次读取不到100us)
+    uint32_t start = HAL_GetTick();
+    while (HAL_I2C_GetState(&hi2c1) != HAL_I2C_STATE_READY) {
+      if (HAL_GetTick() - start > 2) {
+        return 0;
+      }
+    }
     // 优化：减少超时时间到100ms
     if (HAL_I2C_Master_Transmit(&hi2c1, OLED_ADDRESS, buffer, buf_idx, 100) !=
         HAL_OK) {
       return 0;
     }
     break;
+  }
 
   case U8X8_MSG_BYTE_SET_DC:
     break;
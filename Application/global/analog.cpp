@@ -0,0 +1,538 @@
+/**
+ * @file analog.cpp
+ * @brief NTC温度采集实现
+ * @author User
+ * @date 2025-09-30
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "analog.h"
+#include "adc.h"
+#include "channels.h"
+#include "controller.h"
+#include "drivers/settings.h"
+#include "global_objects.h"
+#include "pwm_profile.h"
+#include "temp_adc.h"
+#include "tim.h"
+#include "utils/custom_types.h"
+
+/* Private defines -----------------------------------------------------------*/
+#if LED_CHANNEL_COUNT < 3
+#define ANALOG_TRIGGER ADC_EXTERNALTRIGCONV_T1_CC3
+#define ANALOG_TRIGGER_NAME "TIM1_CC3"
+#define ANALOG_TRIGGER_OWN 1 // 触发通道不驱动LED，比较点由本模块设置
+#else
+#define ANALOG_TRIGGER ADC_EXTERNALTRIGCONV_T1_CC1
+#define ANALOG_TRIGGER_NAME "TIM1_CC1"
+#define ANALOG_TRIGGER_OWN 0
+#endif
+
+static_assert(ANALOG_EXTRA_BITS >= 2 && ANALOG_EXTRA_BITS <= 3,
+              "oversampling must be 16x or 64x");
+static_assert(ANALOG_OVERSAMPLE % ANALOG_NTC_PER_SEQ == 0,
+              "oversampling must be a multiple of the NTC ranks");
+static_assert(ANALOG_SEQ_LENGTH <= 16, "regular sequence has 16 ranks");
+
+// 扫描序列: NTC各秩在前，最后是VREFINT和片内温度
+#define RANK_VREFINT ANALOG_NTC_PER_SEQ
+#define RANK_DIE (ANALOG_NTC_PER_SEQ + 1)
+
+/* Private variables ---------------------------------------------------------*/
+static DMA_HandleTypeDef hdma_adc1; // ADC1 -> DMA1_Channel1
+static uint16_t samples[2 * ANALOG_BLOCK_SIZE];
+static uint32_t filter_state = 0; // 滤波值 << ANALOG_IIR_SHIFT
+static volatile uint16_t last_raw = 0;
+static volatile uint16_t vrefint_avg = 0;
+static volatile uint16_t supply_mv = 0;
+static volatile int16_t die_temp = 0;
+static AnalogConfig_t config = {ANALOG_TRIP_DEFAULT, ANALOG_PHASE_FULL / 2, 1,
+                                ANALOG_POINT_QUIET};
+static uint32_t adc_clock_hz = 0;
+static uint16_t window_counts = 0;   // 采样窗口对应的TIM1计数
+static uint16_t window_prescaler = 0xFFFF; // window_counts对应的PSC
+static volatile uint8_t config_unsaved = 0;
+static volatile bool tripped = false;
+static volatile int16_t trip_temp = 0;
+static bool reported_trip = false;
+static volatile uint32_t blocks = 0;
+static volatile uint32_t errors = 0;
+
+/* Private functions ---------------------------------------------------------*/
+
+#if ANALOG_TRIGGER_OWN
+/**
+ * @brief 按当前各通道比较值计算采样窗口中心
+ */
+static uint32_t sampleCenter(TIM_TypeDef *tim, uint32_t period) {
+  // 开关沿: 周期起点(打开)和各通道CCR(关断)，0%和100%的通道没有边沿
+  uint32_t edges[LED_CHANNEL_COUNT + 1];
+  uint32_t count = 0;
+  uint32_t min_on = period;
+  uint32_t max_on = 0;
+  for (uint32_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    uint32_t ccr = (&tim->CCR1)[ch];
+    if (ccr == 0 || ccr >= period) {
+      continue;
+    }
+    edges[count++] = ccr;
+    min_on = (ccr < min_on) ? ccr : min_on;
+    max_on = (ccr > max_on) ? ccr : max_on;
+  }
+
+  uint8_t point = config.samplePoint;
+  if (point == ANALOG_POINT_PHASE) {
+    return period * config.samplePhase / ANALOG_PHASE_FULL;
+  }
+  if (count == 0) {
+    return period / 2; // 没有开关沿，任意位置都安静
+  }
+  if (point == ANALOG_POINT_ON && min_on >= window_counts) {
+    return min_on / 2;
+  }
+  if (point == ANALOG_POINT_OFF && period - max_on >= window_counts) {
+    return (max_on + period) / 2;
+  }
+
+  // QUIET: 插入排序后找相邻边沿(含跨周期)的最大间隔
+  edges[count++] = 0;
+  for (uint32_t i = 1; i < count; i++) {
+    uint32_t v = edges[i];
+    uint32_t j = i;
+    for (; j > 0 && edges[j - 1] > v; j--) {
+      edges[j] = edges[j - 1];
+    }
+    edges[j] = v;
+  }
+  uint32_t best_start = edges[count - 1];
+  uint32_t best_gap = period - edges[count - 1]; // 最后一个沿到下个周期起点
+  for (uint32_t i = 1; i < count; i++) {
+    uint32_t gap = edges[i] - edges[i - 1];
+    if (gap > best_gap) {
+      best_gap = gap;
+      best_start = edges[i - 1];
+    }
+  }
+  return (best_start + best_gap / 2) % period;
+}
+
+/**
+ * @brief 放置触发比较值，使采样窗口中心落在所选位置
+ */
+static void placeTrigger(void) {
+  TIM_TypeDef *tim = htim1.Instance;
+  uint32_t period = tim->ARR + 1;
+
+  // 采样窗口换算为TIM1计数 (只在PWM配置切换后重算)
+  if (tim->PSC != window_prescaler) {
+    window_prescaler = tim->PSC;
+    window_counts = (uint64_t)240 * PWM_TIMER_CLOCK_HZ /
+                    ((uint64_t)(window_prescaler + 1) * adc_clock_hz);
+  }
+
+  uint32_t center = sampleCenter(tim, period);
+  uint32_t lead = window_counts / 2;
+  uint32_t trigger = (center >= lead) ? center - lead : center + period - lead;
+  // PWM模式2下CCR3为0或超过ARR时OC3REF没有上升沿
+  if (trigger == 0) {
+    trigger = 1;
+  } else if (trigger >= period) {
+    trigger = period - 1;
+  }
+  tim->CCR3 = trigger; // 预装载，下个周期生效
+}
+#endif
+
+/**
+ * @brief 处理写满的半区: 抽取、电源补偿、滤波并更新温度
+ */
+static void processBlock(const uint16_t *block) {
+  uint32_t sum = 0;
+  uint32_t vref_sum = 0;
+  uint32_t die_sum = 0;
+  for (uint32_t seq = 0; seq < ANALOG_SEQS_PER_BLOCK; seq++) {
+    const uint16_t *s = &block[seq * ANALOG_SEQ_LENGTH];
+    for (uint32_t i = 0; i < ANALOG_NTC_PER_SEQ; i++) {
+      sum += s[i];
+    }
+    vref_sum += s[RANK_VREFINT];
+    die_sum += s[RANK_DIE];
+  }
+
+  // VDDA = VREFINT * 4095 / VREFINT读数
+  uint32_t vdda = 0;
+  if (vref_sum != 0) {
+    vdda = (uint32_t)ANALOG_VREFINT_MV * ADC_MAX * ANALOG_SEQS_PER_BLOCK /
+           vref_sum;
+    vrefint_avg = vref_sum / ANALOG_SEQS_PER_BLOCK;
+    supply_mv = vdda;
+    // Vsense (uV) = 读数平均 * VDDA / 4095
+    int32_t sense = (uint64_t)die_sum * vdda * 1000 /
+                    ((uint32_t)ADC_MAX * ANALOG_SEQS_PER_BLOCK);
+    die_temp = 2500 + (ANALOG_DIE_V25_UV - sense) * 100 / ANALOG_DIE_SLOPE_UV;
+  }
+
+  // 4^n个样本之和右移n位 = 平均值左移n位
+  uint32_t raw = sum >> ANALOG_EXTRA_BITS;
+#if ANALOG_SUPPLY_COMP
+  // 以VDDA为满量程的读数换算为NTC分压比 (电源为VCC_MV)
+  if (vdda != 0) {
+    raw = raw * vdda / VCC_MV;
+    if (raw > ANALOG_RAW_MAX) {
+      raw = ANALOG_RAW_MAX;
+    }
+  }
+#endif
+  last_raw = raw;
+
+  if (blocks == 0) {
+    filter_state = raw << ANALOG_IIR_SHIFT; // 首个结果直接作为初值
+  } else {
+    filter_state += raw - (int32_t)(filter_state >> ANALOG_IIR_SHIFT);
+  }
+  state.temp = Analog_Raw_To_Temperature(filter_state >> ANALOG_IIR_SHIFT);
+  blocks = blocks + 1;
+
+#if ANALOG_TRIGGER_OWN
+  placeTrigger();
+#endif
+}
+
+/**
+ * @brief 温度对应的看门狗下限: 低于它的12位读数即超过该温度
+ */
+static uint16_t thresholdFor(int32_t temp) {
+  // 换算表随读数单调递减，二分查找温度不高于temp的最小读数
+  uint32_t low = 1;
+  uint32_t high = ANALOG_RAW_MAX - 1;
+  while (low < high) {
+    uint32_t mid = (low + high) / 2;
+    if (Analog_Raw_To_Temperature(mid) <= temp) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+#if ANALOG_SUPPLY_COMP
+  // 看门狗比较的是未补偿的读数
+  uint32_t vdda = supply_mv;
+  if (vdda != 0) {
+    low = low * VCC_MV / vdda;
+  }
+#endif
+  low >>= ANALOG_EXTRA_BITS;
+  return (low > ADC_MAX) ? ADC_MAX : low;
+}
+
+/**
+ * @brief 按当前配置写看门狗阈值并开关看门狗
+ */
+static void applyWatchdog(void) {
+  ADC_TypeDef *adc = hadc1.Instance;
+  if (!config.tripEnabled) {
+    adc->CR1 &= ~(ADC_CR1_AWDEN | ADC_CR1_AWDIE);
+    return;
+  }
+  adc->LTR = thresholdFor(config.tripTemp);
+  adc->HTR = ADC_MAX;
+  uint32_t cr1 = (adc->CR1 & ~ADC_CR1_AWDCH) | ADC_CR1_AWDSGL |
+                 (ADC_CHANNEL_8 << ADC_CR1_AWDCH_Pos) | ADC_CR1_AWDEN;
+  if (!tripped) {
+    cr1 |= ADC_CR1_AWDIE; // 关断后保持关闭，避免每个样本都进中断
+  }
+  adc->CR1 = cr1;
+}
+
+static void configChanged(void) {
+  // 看门狗中断会改tripped并清AWDIE，读改写CR1时不能被打断
+  __disable_irq();
+  applyWatchdog();
+  __enable_irq();
+  config_unsaved = 1;
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+void Analog_Init(void) {
+  adc_clock_hz = HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_ADC);
+
+#if ANALOG_TRIGGER_OWN
+  // CH3 PWM模式2: 计数到CCR3时OC3REF上升，产生触发沿；引脚保持GPIO不输出
+  TIM_TypeDef *tim = htim1.Instance;
+  tim->CCMR2 = (tim->CCMR2 & ~(TIM_CCMR2_OC3M | TIM_CCMR2_CC3S)) |
+               TIM_CCMR2_OC3M_2 | TIM_CCMR2_OC3M_1 | TIM_CCMR2_OC3M_0 |
+               TIM_CCMR2_OC3PE;
+  tim->CCR3 = tim->ARR >> 1;
+  tim->CCER |= TIM_CCER_CC3E;
+#endif
+
+  // MOE清零(过温关断)时输出强制为空闲电平(低)，不悬空
+  htim1.Instance->BDTR |= TIM_BDTR_OSSI;
+
+  // 扫描+间断模式: 每个触发只转换序列中的下一个通道
+  hadc1.Init.ScanConvMode = ADC_SCAN_ENABLE;
+  hadc1.Init.ContinuousConvMode = DISABLE;
+  hadc1.Init.DiscontinuousConvMode = ENABLE;
+  hadc1.Init.NbrOfDiscConversion = 1;
+  hadc1.Init.ExternalTrigConv = ANALOG_TRIGGER;
+  hadc1.Init.NbrOfConversion = ANALOG_SEQ_LENGTH;
+  if (HAL_ADC_Init(&hadc1) != HAL_OK) {
+    Error_Handler();
+  }
+
+  // 100K NTC分压的源阻抗约50K，内部通道也要求长采样时间，统一用最长值
+  // (首次开启TSVREFE时HAL等待约10us，只发生在初始化)
+  ADC_ChannelConfTypeDef channel = {0};
+  channel.SamplingTime = ADC_SAMPLETIME_239CYCLES_5;
+  for (uint32_t rank = 0; rank < ANALOG_SEQ_LENGTH; rank++) {
+    channel.Rank = ADC_REGULAR_RANK_1 + rank;
+    if (rank == RANK_VREFINT) {
+      channel.Channel = ADC_CHANNEL_VREFINT;
+    } else if (rank == RANK_DIE) {
+      channel.Channel = ADC_CHANNEL_TEMPSENSOR;
+    } else {
+      channel.Channel = ADC_CHANNEL_8;
+    }
+    if (HAL_ADC_ConfigChannel(&hadc1, &channel) != HAL_OK) {
+      Error_Handler();
+    }
+  }
+  HAL_ADCEx_Calibration_Start(&hadc1);
+
+  __HAL_RCC_DMA1_CLK_ENABLE();
+  hdma_adc1.Instance = DMA1_Channel1;
+  hdma_adc1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+  hdma_adc1.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_adc1.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+  hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+  hdma_adc1.Init.Mode = DMA_CIRCULAR;
+  hdma_adc1.Init.Priority = DMA_PRIORITY_LOW;
+  if (HAL_DMA_Init(&hdma_adc1) != HAL_OK) {
+    Error_Handler();
+  }
+
+  // 中断由Analog_DMA_IRQHandler直接处理标志，不经过HAL回调
+  HAL_DMA_Start(&hdma_adc1, (uintptr_t)&hadc1.Instance->DR, (uintptr_t)samples,
+                2 * ANALOG_BLOCK_SIZE);
+  DMA1->IFCR = DMA_IFCR_CGIF1;
+  DMA1_Channel1->CCR |= DMA_CCR_HTIE | DMA_CCR_TCIE | DMA_CCR_TEIE;
+  HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+
+  // 开启DMA请求和外部触发，此后每个触发沿转换一次
+  // (校准后ADC已上电；同时修改其他位时写ADON不会启动转换，序列从第1秩开始)
+  hadc1.Instance->CR2 |= ADC_CR2_DMA | ADC_CR2_EXTTRIG | ADC_CR2_ADON;
+
+  // 模拟看门狗中断经ADC1_2_IRQHandler -> HAL_ADC_LevelOutOfWindowCallback
+  applyWatchdog();
+}
+
+bool Analog_Load(void) {
+  AnalogConfig_t record;
+  if (!Settings_LoadBlock(EEPROM_ADDR_ANALOG, &record, sizeof(record)) ||
+      record.tripTemp < ANALOG_TRIP_MIN || record.tripTemp > ANALOG_TRIP_MAX ||
+      record.tripEnabled > 1 || record.samplePoint >= ANALOG_POINT_COUNT ||
+      record.samplePhase > ANALOG_PHASE_FULL) {
+    serial_printf("Over-temperature config not found, using defaults\r\n");
+    return false;
+  }
+
+  __disable_irq();
+  config = record;
+  applyWatchdog();
+  __enable_irq();
+  serial_printf("Over-temperature trip: %d C%s\r\n", record.tripTemp / 100,
+                record.tripEnabled ? "" : " (disabled)");
+  return true;
+}
+
+/**
+ * @brief 主循环调用: 报告关断、按VDDA刷新阈值、保存已修改的配置
+ */
+void Analog_Process(void) {
+  static uint32_t last_refresh = 0;
+
+  bool current = tripped;
+  if (current != reported_trip) {
+    reported_trip = current;
+    if (current) {
+      serial_printf("OVER-TEMPERATURE: LED output cut at %d.%02d C, "
+                    "send ADC CLEAR to recover\r\n",
+                    get_temperature_int(trip_temp),
+                    get_temperature_frac(trip_temp));
+    } else {
+      serial_printf("Over-temperature trip cleared\r\n");
+    }
+  }
+
+  uint32_t now = HAL_GetTick();
+  if (now - last_refresh >= ANALOG_THRESHOLD_MS) {
+    last_refresh = now;
+    __disable_irq();
+    applyWatchdog();
+    __enable_irq();
+  }
+
+  if (!config_unsaved) {
+    return;
+  }
+  config_unsaved = 0;
+
+  __disable_irq();
+  AnalogConfig_t snapshot = config;
+  __enable_irq();
+  if (Settings_SaveBlock(EEPROM_ADDR_ANALOG, &snapshot, sizeof(snapshot))) {
+    serial_printf("Over-temperature config saved\r\n");
+  }
+}
+
+const AnalogConfig_t *Analog_Get_Config(void) { return &config; }
+
+bool Analog_Set_Trip(int16_t temp) {
+  if (temp < ANALOG_TRIP_MIN || temp > ANALOG_TRIP_MAX) {
+    return false;
+  }
+  config.tripTemp = temp;
+  config.tripEnabled = 1;
+  configChanged();
+  return true;
+}
+
+void Analog_Disable_Trip(void) {
+  config.tripEnabled = 0;
+  configChanged();
+}
+
+bool Analog_Set_Sample_Point(uint8_t point, uint16_t phase) {
+#if ANALOG_TRIGGER_OWN
+  if (point >= ANALOG_POINT_COUNT || phase > ANALOG_PHASE_FULL) {
+    return false;
+  }
+  // 下一个半区处理时生效
+  config.samplePoint = point;
+  config.samplePhase = phase;
+  config_unsaved = 1;
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool Analog_Point_Adjustable(void) { return ANALOG_TRIGGER_OWN; }
+
+const char *Analog_Point_Name(uint8_t point) {
+  static const char *const names[] = {"QUIET", "ON", "OFF", "PHASE"};
+  return (point < ANALOG_POINT_COUNT) ? names[point] : "?";
+}
+
+bool Analog_Tripped(void) { return tripped; }
+
+bool Analog_Clear_Trip(void) {
+  if (!tripped) {
+    return true;
+  }
+  if (config.tripEnabled &&
+      state.temp > config.tripTemp - ANALOG_TRIP_HYST) {
+    return false;
+  }
+
+  __disable_irq();
+  hadc1.Instance->SR = ~ADC_SR_AWD;
+  htim1.Instance->SR = ~TIM_SR_BIF;
+  htim1.Instance->BDTR |= TIM_BDTR_MOE;
+  tripped = false;
+  applyWatchdog();
+  __enable_irq();
+  return true;
+}
+
+bool Analog_Ready(void) { return blocks != 0; }
+
+void Analog_Get_Status(AnalogStatus_t *status) {
+  __disable_irq();
+  status->raw = last_raw;
+  status->filtered = filter_state >> ANALOG_IIR_SHIFT;
+  status->vrefint = vrefint_avg;
+  status->supplyMv = supply_mv;
+  status->dieTemp = die_temp;
+  status->threshold = hadc1.Instance->LTR;
+  status->tripped = tripped;
+  status->tripTemp = trip_temp;
+  status->trigger = htim1.Instance->CCR3;
+  status->period = htim1.Instance->ARR + 1;
+  status->window = window_counts;
+  status->blocks = blocks;
+  status->errors = errors;
+  __enable_irq();
+}
+
+uint32_t Analog_Sample_Rate(void) {
+  return PwmProfile_Frequency(PwmProfile_Get_Active());
+}
+
+uint16_t Analog_Supply_Mv(void) { return supply_mv; }
+
+int16_t Analog_Die_Temperature(void) { return die_temp; }
+
+const char *Analog_Trigger_Name(void) { return ANALOG_TRIGGER_NAME; }
+
+int32_t Analog_Raw_To_Temperature(uint16_t raw) {
+  if ((raw >> ANALOG_EXTRA_BITS) == 0 || raw >= ANALOG_RAW_MAX) {
+    return -99900L;
+  }
+  // 高位直接索引，低位插值 (编译期生成的表，见temp_adc.h)
+  return ntc::lookup(raw);
+}
+
+void Analog_Convert_Cycles(uint32_t *tableCycles, uint32_t *floatCycles) {
+  static volatile int32_t sink;
+  uint32_t count = 0;
+  uint32_t start = DWT->CYCCNT;
+  for (uint32_t raw = 1; raw < ANALOG_RAW_MAX; raw += ANALOG_BENCH_STEP) {
+    sink = Analog_Raw_To_Temperature(raw);
+    count++;
+  }
+  *tableCycles = (DWT->CYCCNT - start) / count;
+
+  // 同一组ADC值用单精度公式换算 (F103没有FPU，logf为软件实现)
+  start = DWT->CYCCNT;
+  for (uint32_t raw = 1; raw < ANALOG_RAW_MAX; raw += ANALOG_BENCH_STEP) {
+    sink = ntc::temperatureFloat(raw);
+  }
+  *floatCycles = (DWT->CYCCNT - start) / count;
+  (void)sink; // 只用于防止循环被优化掉
+}
+
+/**
+ * @brief 模拟看门狗: NTC读数低于下限，立即关断LED输出并锁存
+ */
+extern "C" void HAL_ADC_LevelOutOfWindowCallback(ADC_HandleTypeDef *hadc) {
+  if (hadc != &hadc1) {
+    return;
+  }
+  htim1.Instance->EGR = TIM_EGR_BG; // 软件刹车: 硬件清除MOE
+  hadc->Instance->CR1 &= ~ADC_CR1_AWDIE;
+  trip_temp = state.temp;
+  tripped = true;
+}
+
+/**
+ * @brief DMA1_Channel1中断: 半传输处理前半区，传输完成处理后半区
+ */
+extern "C" void Analog_DMA_IRQHandler(void) {
+  uint32_t isr = DMA1->ISR;
+
+  if (isr & DMA_ISR_TEIF1) {
+    DMA1->IFCR = DMA_IFCR_CTEIF1;
+    errors = errors + 1;
+  }
+  if (isr & DMA_ISR_HTIF1) {
+    DMA1->IFCR = DMA_IFCR_CHTIF1;
+    processBlock(&samples[0]);
+  }
+  if (isr & DMA_ISR_TCIF1) {
+    DMA1->IFCR = DMA_IFCR_CTCIF1;
+    processBlock(&samples[ANALOG_BLOCK_SIZE]);
+  }
+}
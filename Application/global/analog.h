@@ -0,0 +1,183 @@
+/**
+ * @file analog.h
+ * @brief NTC温度采集 (定时器触发、DMA循环缓冲、过采样)
+ * @author User
+ * @date 2025-09-30
+ *
+ * ADC1由TIM1比较事件触发，以扫描+间断模式每个触发转换序列中的一个
+ * 通道: NTC (PB0) x4、VREFINT、片内温度传感器，结果由DMA1_Channel1以
+ * 循环方式写入双半区缓冲，转换过程不需要CPU参与。只在半传输/传输完成
+ * 中断中处理刚写满的半区: NTC样本求和后按过采样倍数抽取 (4^n个样本提高
+ * n位)，按VREFINT算出的实际VDDA做电源补偿，再经过一阶IIR滤波，按查找表
+ * 换算为state.temp；VREFINT和片内温度的样本在同一半区内平均，得到供电
+ * 电压和芯片温度。每个触发只转换一个通道，转换时间(约12us)小于最短的
+ * PWM周期 (40kHz)，不会丢触发。
+ *
+ * NTC采样率为触发率(PWM频率)的4/6，标准配置约14kHz，64倍过采样时约每
+ * 4.5ms得到一个15位结果；中断频率为触发率的1/96。
+ *
+ * 电源补偿: NTC分压由VCC_MV标称的电源供电、ADC以VDDA为参考时，VDDA
+ * 变化会直接变成温度误差；结果按VDDA/VCC_MV换算回分压比。分压直接取自
+ * VDDA时两者同步变化，设ANALOG_SUPPLY_COMP为0关闭补偿。F103没有出厂
+ * VREFINT校准值 (典型1.20V，1.16-1.24V)，ANALOG_VREFINT_MV可按实测修正。
+ * 片内温度传感器要求采样17.1us，ADC超频到21MHz时239.5周期只有约11us，
+ * 芯片温度只作参考。
+ *
+ * 过温关断: ADC模拟看门狗只监视NTC通道，12位读数低于按关断温度换算的
+ * 下限(温度越高读数越低)时进入ADC中断，立即以软件刹车事件(TIM1 BG)
+ * 清除MOE，所有LED输出按OSSI强制为低电平，不依赖主循环。关断后保持
+ * (AOE关闭，MOE不会自动恢复)，需要温度降到阈值以下ANALOG_TRIP_HYST并
+ * 由命令解除。看门狗比较的是单个未滤波样本，阈值应留出噪声余量；
+ * 中断与其他中断同优先级，最坏延迟为当时正在执行的中断的时长。
+ *
+ * 触发源: LED只用2个通道时使用空闲的TIM1_CC3 (不输出到引脚)；通道数
+ * 更多时没有空闲的规则组触发比较通道，改用CH1的比较事件，采样点固定在
+ * CH1关断沿。
+ *
+ * 采样点同步 (仅TIM1_CC3): 边沿对齐PWM中所有通道在周期开始时打开、
+ * 计数到各自CCR时关断。每处理一个半区按当前比较值重新放置CCR3，使
+ * 采样保持窗口(239.5个ADC周期)的中心落在:
+ * - QUIET: 离所有开关沿最远处 (相邻开关沿最大间隔的中点，默认)
+ * - ON: 所有通道都导通的区间中点 (0到最小CCR)
+ * - OFF: 所有通道都关断的区间中点 (最大CCR到周期末)
+ * - 固定相位 (周期的千分比)
+ * ON/OFF区间短于采样窗口时退回QUIET。占空比变化后几毫秒内跟随。
+ * 外部电压电流采样芯片(INA226/INA219)没有外部触发输入，其积分型ADC
+ * 每次转换覆盖几十个PWM周期，得到的本来就是平均电流，不做同步。
+ */
+
+#ifndef __ANALOG_H__
+#define __ANALOG_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define ANALOG_EXTRA_BITS 3 // 过采样提高的位数 (2: 16倍/14位, 3: 64倍/15位)
+#define ANALOG_OVERSAMPLE (1U << (2 * ANALOG_EXTRA_BITS)) // 每个结果的样本数
+#define ANALOG_RAW_MAX (4095U << ANALOG_EXTRA_BITS)       // 抽取后满量程
+#define ANALOG_IIR_SHIFT 2 // IIR系数 1/4 (时间常数约4个抽取周期)
+#define ANALOG_NTC_PER_SEQ 4 // 扫描序列中NTC的转换次数
+#define ANALOG_SEQ_LENGTH (ANALOG_NTC_PER_SEQ + 2) // 加VREFINT和片内温度
+#define ANALOG_SEQS_PER_BLOCK (ANALOG_OVERSAMPLE / ANALOG_NTC_PER_SEQ)
+#define ANALOG_BLOCK_SIZE (ANALOG_SEQS_PER_BLOCK * ANALOG_SEQ_LENGTH) // 半区样本数
+#define ANALOG_SUPPLY_COMP 1     // 按VDDA补偿NTC (分压取自VDDA时设0)
+#define ANALOG_VREFINT_MV 1200   // VREFINT电压 (典型值，可按实测修正)
+#define ANALOG_DIE_V25_UV 1430000 // 片内温度传感器25°C电压 (uV)
+#define ANALOG_DIE_SLOPE_UV 4300  // 片内温度传感器斜率 (uV/°C)
+#define ANALOG_TRIP_DEFAULT 9500  // 默认过温关断温度 (x100)
+#define ANALOG_TRIP_MIN 5000      // 关断温度可设范围 (x100)
+#define ANALOG_TRIP_MAX 15000
+#define ANALOG_TRIP_HYST 500      // 解除关断需要低于阈值的温度 (x100)
+#define ANALOG_THRESHOLD_MS 1000  // 按当前VDDA刷新看门狗阈值的间隔
+#define ANALOG_PHASE_FULL 1000    // 固定采样相位满量程 (‰)
+#define ANALOG_BENCH_STEP 7 // 换算耗时测量的ADC值步长
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef enum {
+  ANALOG_POINT_QUIET = 0, // 离开关沿最远处
+  ANALOG_POINT_ON,        // 全部导通区间中点
+  ANALOG_POINT_OFF,       // 全部关断区间中点
+  ANALOG_POINT_PHASE,     // 固定相位
+  ANALOG_POINT_COUNT
+} AnalogPoint_t;
+
+/**
+ * @brief 过温关断/采样点配置 (EEPROM存储)
+ */
+typedef struct {
+  int16_t tripTemp;     // 关断温度 (x100)
+  uint16_t samplePhase; // 固定采样相位 (‰)
+  uint8_t tripEnabled;  // 0=不监视
+  uint8_t samplePoint;  // AnalogPoint_t
+} AnalogConfig_t;
+
+typedef struct {
+  uint16_t raw;      // 最近一次抽取结果 (0-ANALOG_RAW_MAX)
+  uint16_t filtered; // IIR滤波后 (已做电源补偿)
+  uint16_t vrefint;  // VREFINT平均值 (12位)
+  uint16_t supplyMv; // VDDA (mV)
+  int16_t dieTemp;   // 芯片温度 (x100)
+  uint16_t threshold; // 看门狗下限 (12位)
+  bool tripped;       // 已过温关断
+  int16_t tripTemp;   // 关断时的滤波温度 (x100)
+  uint16_t trigger;   // 当前触发比较值 (CCR3)
+  uint16_t period;    // TIM1周期 (计数)
+  uint16_t window;    // 采样窗口 (TIM1计数)
+  uint32_t blocks;   // 已处理的半区数
+  uint32_t errors;   // DMA传输错误次数
+} AnalogStatus_t;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 配置ADC1外部触发和DMA循环传输，校准后开始采集
+ * @note 在Channels_Init (TIM1已启动)之后调用
+ */
+void Analog_Init(void);
+
+/**
+ * @brief 已有第一个有效结果 (state.temp可用)
+ */
+bool Analog_Ready(void);
+
+/**
+ * @brief 运行状态 / 当前触发率 (每个触发转换一个通道)
+ */
+void Analog_Get_Status(AnalogStatus_t *status);
+uint32_t Analog_Sample_Rate(void);
+
+/**
+ * @brief 由VREFINT算出的VDDA (mV) / 芯片温度 (x100)，尚无结果时为0
+ */
+uint16_t Analog_Supply_Mv(void);
+int16_t Analog_Die_Temperature(void);
+const char *Analog_Trigger_Name(void);
+
+/**
+ * @brief 从EEPROM加载配置 / 主循环报告关断、刷新阈值并保存配置
+ */
+bool Analog_Load(void);
+void Analog_Process(void);
+
+/**
+ * @brief 过温关断配置 (温度x100，超出范围返回false)
+ */
+const AnalogConfig_t *Analog_Get_Config(void);
+bool Analog_Set_Trip(int16_t temp);
+void Analog_Disable_Trip(void);
+
+/**
+ * @brief 采样点 (多于2个LED通道时触发点固定，返回false)
+ */
+bool Analog_Set_Sample_Point(uint8_t point, uint16_t phase);
+bool Analog_Point_Adjustable(void);
+const char *Analog_Point_Name(uint8_t point);
+
+/**
+ * @brief 已过温关断 / 解除关断 (温度未降到阈值以下回差时返回false)
+ */
+bool Analog_Tripped(void);
+bool Analog_Clear_Trip(void);
+
+/**
+ * @brief 抽取后的ADC值换算为温度
+ * @return 温度x100，传感器开路/短路时返回-99900
+ */
+int32_t Analog_Raw_To_Temperature(uint16_t raw);
+
+/**
+ * @brief 测量温度换算的平均耗时 (扫描整个ADC量程，DWT周期数/次)
+ * @param tableCycles 查表插值
+ * @param floatCycles 单精度B值公式 (对比用)
+ */
+void Analog_Convert_Cycles(uint32_t *tableCycles, uint32_t *floatCycles);
+
+/**
+ * @brief DMA1_Channel1中断处理 (stm32f1xx_it.c调用)
+ */
+extern "C" void Analog_DMA_IRQHandler(void);
+
+#endif /* __ANALOG_H__ */
@@ -0,0 +1,323 @@
+/**
+ * @file binproto.cpp
+ * @brief 串口二进制控制协议实现
+ * @author User
+ * @date 2025-10-07
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "binproto.h"
+#include "commands.h"
+#include "drivers/eeprom.h"
+#include "global/controller.h"
+#include "global_objects.h"
+#include "usart.h"
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define FRAME_HEADER 2 // opcode + seq
+#define FRAME_CRC 4
+#define REPLY_HEADER 3 // opcode + seq + status
+
+// 应答原始长度及COBS编码后的长度 (每254字节一个开销字节，加两个定界符)
+#define REPLY_RAW_MAX (REPLY_HEADER + BINPROTO_BODY_MAX + FRAME_CRC)
+#define REPLY_TX_MAX (REPLY_RAW_MAX + REPLY_RAW_MAX / 254 + 1 + 2)
+
+/* Private types -------------------------------------------------------------*/
+
+typedef BinStatus_t (*BinHandler_t)(const uint8_t *body, uint8_t length,
+                                    uint8_t *reply, uint8_t *replyLength);
+
+typedef struct {
+  uint8_t opcode;
+  BinHandler_t handler;
+} BinOpEntry_t;
+
+/* Private variables ---------------------------------------------------------*/
+static BinProtoStats_t stats;
+
+/* Private functions ---------------------------------------------------------*/
+
+static uint16_t get_u16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+
+static void put_u16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+  put_u16(p, v & 0xFFFF);
+  put_u16(p + 2, v >> 16);
+}
+
+/**
+ * @brief COBS原地解码 (输出总在输入之后的位置读取，可以覆盖)
+ * @return 解码后的长度，格式错误返回0
+ */
+static uint16_t cobs_decode(uint8_t *buf, uint16_t length) {
+  uint16_t in = 0;
+  uint16_t out = 0;
+  while (in < length) {
+    uint8_t code = buf[in++];
+    if (code == 0) {
+      return 0;
+    }
+    for (uint8_t i = 1; i < code; i++) {
+      if (in >= length) {
+        return 0;
+      }
+      buf[out++] = buf[in++];
+    }
+    // 0xFF块后面没有隐含的0，最后一块也没有
+    if (code != 0xFF && in < length) {
+      buf[out++] = 0;
+    }
+  }
+  return out;
+}
+
+/**
+ * @brief COBS编码
+ * @return 编码后的长度
+ */
+static uint16_t cobs_encode(const uint8_t *src, uint16_t length,
+                            uint8_t *dst) {
+  uint16_t out = 1;
+  uint16_t code_pos = 0;
+  uint8_t code = 1;
+  for (uint16_t i = 0; i < length; i++) {
+    if (src[i] != 0) {
+      dst[out++] = src[i];
+      code++;
+    }
+    if (src[i] == 0 || code == 0xFF) {
+      dst[code_pos] = code;
+      code_pos = out++;
+      code = 1;
+    }
+  }
+  dst[code_pos] = code;
+  return out;
+}
+
+static void send_reply(uint8_t opcode, uint8_t seq, BinStatus_t status,
+                       const uint8_t *body, uint8_t length) {
+  uint8_t raw[REPLY_RAW_MAX];
+  uint8_t tx[REPLY_TX_MAX];
+
+  raw[0] = opcode;
+  raw[1] = seq;
+  raw[2] = status;
+  memcpy(raw + REPLY_HEADER, body, length);
+  uint16_t rawLength = REPLY_HEADER + length;
+  put_u32(raw + rawLength, EEPROM::calculateCRC32(raw, rawLength));
+  rawLength += FRAME_CRC;
+
+  tx[0] = 0;
+  uint16_t txLength = 1 + cobs_encode(raw, rawLength, tx + 1);
+  tx[txLength++] = 0;
+
+  UART_Send_Data(tx, txLength);
+  stats.replies++;
+}
+
+/* Opcode handlers -----------------------------------------------------------*/
+
+static BinStatus_t op_ping(const uint8_t *body, uint8_t length, uint8_t *reply,
+                           uint8_t *replyLength) {
+  reply[0] = BINPROTO_VERSION;
+  reply[1] = LED_CHANNEL_COUNT;
+  put_u32(reply + 2, HAL_GetTick());
+  *replyLength = 6;
+  return BIN_STATUS_OK;
+}
+
+static BinStatus_t op_status(const uint8_t *body, uint8_t length,
+                             uint8_t *reply, uint8_t *replyLength) {
+  reply[0] = state.master;
+  reply[1] = state.fanAuto;
+  put_u16(reply + 2, state.brightness);
+  put_u16(reply + 4, state.colorTemp);
+  put_u32(reply + 6, (uint32_t)state.temp);
+  reply[10] = LED_CHANNEL_COUNT;
+  uint8_t n = 11;
+  forEachChannel([&](uint8_t ch) {
+    put_u16(reply + n, state.targetPWM[ch]);
+    put_u16(reply + n + 2, state.currentPWM[ch]);
+    n += 4;
+  });
+  *replyLength = n;
+  return BIN_STATUS_OK;
+}
+
+static BinStatus_t op_power(const uint8_t *body, uint8_t length,
+                            uint8_t *reply, uint8_t *replyLength) {
+  if (length != 1) {
+    return BIN_STATUS_BAD_LENGTH;
+  }
+  if (body[0] > 1) {
+    return BIN_STATUS_BAD_VALUE;
+  }
+  setMaster(body[0]);
+  return BIN_STATUS_OK;
+}
+
+/**
+ * @brief 设置亮度和色温并立即重算目标PWM
+ * @note 不经过calcPWM (它每次重算都会打印调试信息，流式发送时会占满串口)，
+ *       同步lastState后calcPWM不会再重复计算。不标记设置保存，流式发送
+ *       不会频繁写EEPROM。
+ */
+static BinStatus_t op_level(const uint8_t *body, uint8_t length,
+                            uint8_t *reply, uint8_t *replyLength) {
+  if (length != 4) {
+    return BIN_STATUS_BAD_LENGTH;
+  }
+  uint16_t brightness = get_u16(body);
+  uint16_t colorTemp = get_u16(body + 2);
+  if (colorTemp == 0) {
+    colorTemp = state.colorTemp;
+  }
+  if (brightness > LED_MAX_BRIGHTNESS || colorTemp < COLOR_TEMP_MIN ||
+      colorTemp > COLOR_TEMP_MAX) {
+    return BIN_STATUS_BAD_VALUE;
+  }
+
+  if (!state.master) {
+    state.brightness = brightness;
+    state.colorTemp = colorTemp;
+    return BIN_STATUS_OK; // 开机时turnOn会重新计算
+  }
+
+  uint16_t target[LED_CHANNEL_COUNT];
+  calculateChannelRatio(colorTemp, brightness, target);
+
+  __disable_irq();
+  state.brightness = brightness;
+  state.colorTemp = colorTemp;
+  lastState.brightness = brightness;
+  lastState.colorTemp = colorTemp;
+  forEachChannel([&](uint8_t ch) {
+    state.targetPWM[ch] = target[ch];
+    lastState.targetPWM[ch] = target[ch];
+  });
+  __enable_irq();
+  return BIN_STATUS_OK;
+}
+
+static BinStatus_t op_pwm(const uint8_t *body, uint8_t length, uint8_t *reply,
+                          uint8_t *replyLength) {
+  if (length < 1) {
+    return BIN_STATUS_BAD_LENGTH;
+  }
+  uint8_t mask = body[0];
+  if (mask >> LED_CHANNEL_COUNT) {
+    return BIN_STATUS_BAD_VALUE;
+  }
+  if (length != 1 + 2 * __builtin_popcount(mask)) {
+    return BIN_STATUS_BAD_LENGTH;
+  }
+
+  // 先全部检查，任一通道越界则都不修改。检查和写入在关中断时完成，
+  // TIM3切换PWM配置时的换算不会夹在中间
+  uint16_t value[LED_CHANNEL_COUNT];
+  const uint8_t *p = body + 1;
+  BinStatus_t status = BIN_STATUS_OK;
+  __disable_irq();
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    if (mask & (1 << ch)) {
+      value[ch] = get_u16(p);
+      p += 2;
+      if (value[ch] > channels.limit[ch]) {
+        status = BIN_STATUS_BAD_VALUE;
+      }
+    }
+  }
+  if (status == BIN_STATUS_OK) {
+    forEachChannel([&](uint8_t ch) {
+      if (mask & (1 << ch)) {
+        state.targetPWM[ch] = value[ch];
+      }
+    });
+  }
+  __enable_irq();
+  return status;
+}
+
+/**
+ * @brief 文本命令入队
+ * @note 入队确认按安静模式关闭，条数在应答中给出。入队时的错误和命令执行
+ *       时的结果仍以文本输出 (带#标签时按标签对应)，夹在二进制帧之间
+ */
+static BinStatus_t op_command(const uint8_t *body, uint8_t length,
+                              uint8_t *reply, uint8_t *replyLength) {
+  char text[UART_CMD_MAX_LENGTH];
+  if (length == 0 || length >= sizeof(text)) {
+    return BIN_STATUS_BAD_LENGTH;
+  }
+  memcpy(text, body, length);
+  text[length] = '\0';
+
+  bool quiet = Commands_Is_Quiet();
+  Commands_Set_Quiet(true);
+  uint16_t count = Commands_Parse_And_Enqueue(text);
+  Commands_Set_Quiet(quiet);
+  reply[0] = count;
+  *replyLength = 1;
+  return (count > 0) ? BIN_STATUS_OK : BIN_STATUS_BAD_VALUE;
+}
+
+static const BinOpEntry_t op_table[] = {
+    {BIN_OP_PING, op_ping},   {BIN_OP_STATUS, op_status},
+    {BIN_OP_POWER, op_power}, {BIN_OP_LEVEL, op_level},
+    {BIN_OP_PWM, op_pwm},     {BIN_OP_COMMAND, op_command}};
+
+/* Public functions ----------------------------------------------------------*/
+
+void BinProto_Process(uint8_t *data, uint16_t length) {
+  stats.frames++;
+
+  uint16_t frameLength = cobs_decode(data, length);
+  if (frameLength < FRAME_HEADER + FRAME_CRC) {
+    stats.badFrame++;
+    return;
+  }
+
+  uint8_t opcode = data[0];
+  uint8_t seq = data[1];
+  uint8_t op = opcode & ~BIN_OP_NO_REPLY;
+  uint16_t bodyLength = frameLength - FRAME_HEADER - FRAME_CRC;
+  const uint8_t *body = data + FRAME_HEADER;
+
+  uint8_t reply[BINPROTO_BODY_MAX];
+  uint8_t replyLength = 0;
+  BinStatus_t status = BIN_STATUS_UNKNOWN_OP;
+
+  uint32_t crc = data[frameLength - 4] | (data[frameLength - 3] << 8) |
+                 (data[frameLength - 2] << 16) |
+                 ((uint32_t)data[frameLength - 1] << 24);
+  if (EEPROM::calculateCRC32(data, frameLength - FRAME_CRC) != crc) {
+    status = BIN_STATUS_BAD_CRC;
+    stats.badCrc++;
+  } else {
+    for (const BinOpEntry_t &entry : op_table) {
+      if (entry.opcode == op) {
+        status = entry.handler(body, bodyLength, reply, &replyLength);
+        break;
+      }
+    }
+    if (status != BIN_STATUS_OK) {
+      stats.errors++;
+    }
+  }
+
+  // 流式帧成功时不应答；CRC错误时标志位本身不可信，总是应答
+  if (status == BIN_STATUS_OK && (opcode & BIN_OP_NO_REPLY)) {
+    return;
+  }
+  send_reply(opcode, seq, status, reply, replyLength);
+}
+
+void BinProto_Get_Stats(BinProtoStats_t *out) { *out = stats; }
+
+void BinProto_Reset_Stats(void) { memset(&stats, 0, sizeof(stats)); }
@@ -0,0 +1,79 @@
+/**
+ * @file binproto.h
+ * @brief 串口二进制控制协议 (COBS分帧 + CRC32)，与文本命令共用USART2
+ * @author User
+ * @date 2025-10-07
+ *
+ * 帧格式 (小端序):
+ *   0x00 | COBS( opcode | seq | body... | crc32 ) | 0x00
+ * 每帧以0x00开始和结束，串口解析器收到0x00即切换到二进制帧，文本命令
+ * 不含0x00，两者自动区分。crc32覆盖opcode到body (与EEPROM相同的CRC-32，
+ * 复用crc32_table)。seq由主机填写，应答原样带回。
+ *
+ * 应答格式相同，body前多一个状态字节:
+ *   0x00 | COBS( opcode | seq | status | body... | crc32 ) | 0x00
+ * opcode最高位为BIN_OP_NO_REPLY时成功不应答 (流式发送亮度/PWM)，出错仍应答。
+ * 两帧之间可能夹有文本调试输出，主机按CRC丢弃即可。
+ *
+ * 帧在主循环中直接执行，不经过命令队列。除BIN_OP_COMMAND外二进制命令
+ * 不输出文本；BIN_OP_COMMAND只把文本命令放入命令队列，不输出入队确认，
+ * 但入队错误和命令执行时的结果/错误行 (带#标签时为"#$%>id=<标签> ...")
+ * 照常以文本输出，出现在前后的二进制应答帧之间。
+ */
+
+#ifndef __BINPROTO_H__
+#define __BINPROTO_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define BINPROTO_VERSION 1
+#define BINPROTO_BODY_MAX 64 // 应答body最大字节数
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef enum {
+  BIN_OP_PING = 0x01,    // 应答: version u8, 通道数 u8, 运行时间ms u32
+  BIN_OP_STATUS = 0x02,  // 应答: master u8, fanAuto u8, 亮度 u16, 色温 u16,
+                         //       温度x100 i32, 通道数 u8, 各通道目标/当前PWM u16
+  BIN_OP_POWER = 0x10,   // body: 0关/1开
+  BIN_OP_LEVEL = 0x11,   // body: 亮度 u16, 色温 u16 (0表示不变)
+  BIN_OP_PWM = 0x12,     // body: 通道掩码 u8, 掩码中每个通道一个PWM u16
+  BIN_OP_COMMAND = 0x20, // body: 文本命令 (可带!/@前缀)，应答: 入队条数 u8
+  BIN_OP_NO_REPLY = 0x80 // 标志位: 成功时不应答
+} BinOpcode_t;
+
+typedef enum {
+  BIN_STATUS_OK = 0,
+  BIN_STATUS_BAD_CRC,
+  BIN_STATUS_BAD_LENGTH,
+  BIN_STATUS_UNKNOWN_OP,
+  BIN_STATUS_BAD_VALUE,
+  BIN_STATUS_BUSY
+} BinStatus_t;
+
+typedef struct {
+  uint32_t frames;   // 收到的帧数
+  uint32_t badFrame; // COBS错误或过短，无法应答
+  uint32_t badCrc;   // CRC错误
+  uint32_t errors;   // 其他失败 (长度、未知操作码、参数)
+  uint32_t replies;  // 已发送的应答帧数
+} BinProtoStats_t;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 主循环调用: 解码并执行一帧
+ * @param data COBS编码的帧内容 (不含定界符)，原地解码
+ */
+void BinProto_Process(uint8_t *data, uint16_t length);
+
+/**
+ * @brief 统计数据
+ */
+void BinProto_Get_Stats(BinProtoStats_t *stats);
+void BinProto_Reset_Stats(void);
+
+#endif /* __BINPROTO_H__ */
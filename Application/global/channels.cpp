@@ -0,0 +1,61 @@
+/**
+ * @file channels.cpp
+ * @brief N通道LED输出管线实现
+ * @author User
+ * @date 2025-09-20
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "channels.h"
+#include "controller.h"
+#include "gamma_table.h"
+#include "pwm_profile.h"
+
+/* Global variables ----------------------------------------------------------*/
+ChannelConfig channels;
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+ * @brief 恢复通道默认参数
+ */
+void Channels_Init(void) {
+  forEachChannel([](uint8_t ch) {
+    channels.gamma[ch] = gammaTable;
+    channels.fadeStep[ch] = PwmProfile_From_Standard(PWM_FADE_STEP);
+    channels.limit[ch] = PwmProfile_Get_Max();
+    channels.mix[ch] = 0; // 辅助通道默认不参与混光
+    channels.gain[ch] = CHANNEL_GAIN_ONE;
+  });
+}
+
+/**
+ * @brief 启动所有通道的PWM输出并清零占空比
+ */
+void Channels_Start(void) {
+  forEachChannel([](uint8_t ch) {
+    HAL_TIM_PWM_Start(&htim1, (uint32_t)ch << 2);
+    set_pwm(ch, 0);
+  });
+}
+
+/**
+ * @brief 单通道亮度经伽马校正、增益补偿和限幅得到PWM值
+ * @param ch 通道下标
+ * @param level 线性亮度 (0-LED_MAX_BRIGHTNESS)
+ * @return PWM比较值 (0-channels.limit[ch])
+ */
+uint16_t Channels_LevelToPWM(uint8_t ch, uint16_t level) {
+  if (level == 0) {
+    return 0;
+  }
+  if (level > LED_MAX_BRIGHTNESS) {
+    level = LED_MAX_BRIGHTNESS;
+  }
+
+  // 伽马表为Q16，按当前PWM周期换算到[1, 周期-2]
+  uint32_t span = PwmProfile_Get_Max() - 3;
+  uint32_t pwm = 1 + (((uint32_t)channels.gamma[ch][level] * span + 32768) >> 16);
+  pwm = (pwm * channels.gain[ch]) / CHANNEL_GAIN_ONE;
+  return (pwm > channels.limit[ch]) ? channels.limit[ch] : pwm;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file channels.h
+ * @brief N通道LED输出管线 (TIM1 CH1-CH4)
+ * @author User
+ * @date 2025-09-20
+ */
+
+#ifndef __CHANNELS_H__
+#define __CHANNELS_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "tim.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+#if LED_CHANNEL_COUNT < 2 || LED_CHANNEL_COUNT > 4
+#error "LED_CHANNEL_COUNT must be between 2 and 4 (TIM1 CH1-CH4)"
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define LED_CHANNEL_MAX 4        // 硬件最大通道数 (EEPROM布局按此固定)
+#define LED_CHANNEL_WARM 0       // 暖白通道 (CH1)
+#define LED_CHANNEL_COLD 1       // 冷白通道 (CH2)
+#define CHANNEL_MIX_TOTAL 1024   // 辅助通道混合权重满量程
+#define CHANNEL_GAIN_ONE 1024    // 通道增益满量程 (Q10, 1.0)
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+ * @brief 每通道参数 (结构体数组布局，按通道下标访问)
+ */
+typedef struct {
+  const uint16_t *gamma[LED_CHANNEL_COUNT]; // 伽马表 (输入0-LED_MAX_BRIGHTNESS，Q16)
+  uint16_t fadeStep[LED_CHANNEL_COUNT];     // 每次缓变最大步进 (当前量程)
+  uint16_t limit[LED_CHANNEL_COUNT];        // PWM上限 (当前量程)
+  uint16_t mix[LED_CHANNEL_COUNT]; // 辅助通道混合权重 (CH3/CH4, 0-1024)
+  uint16_t gain[LED_CHANNEL_COUNT]; // 光衰补偿增益 (Q10)，限幅前生效
+} ChannelConfig;
+
+extern ChannelConfig channels;
+
+/* Compile-time channel iteration --------------------------------------------*/
+
+template <typename F, size_t... I>
+__attribute__((always_inline)) inline void
+forEachChannelImpl(F &&f, std::index_sequence<I...>) {
+  (f(std::integral_constant<uint8_t, I>{}), ...);
+}
+
+/**
+ * @brief 对每个通道调用f(ch)，按LED_CHANNEL_COUNT在编译期展开
+ * @note ch为integral_constant，可作为常量参与寄存器地址计算
+ */
+template <typename F> __attribute__((always_inline)) inline void forEachChannel(F &&f) {
+  forEachChannelImpl(f, std::make_index_sequence<LED_CHANNEL_COUNT>{});
+}
+
+/**
+ * @brief 写通道比较寄存器 (TIM_CHANNEL_x = 通道下标 * 4)
+ */
+#define set_pwm(ch, value)                                                     \
+  __HAL_TIM_SET_COMPARE(&htim1, (uint32_t)(ch) << 2, value)
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 恢复通道默认参数
+ */
+void Channels_Init(void);
+
+/**
+ * @brief 启动所有通道的PWM输出并清零占空比
+ */
+void Channels_Start(void);
+
+/**
+ * @brief 单通道亮度(0-LED_MAX_BRIGHTNESS)经伽马校正和限幅得到PWM值
+ */
+uint16_t Channels_LevelToPWM(uint8_t ch, uint16_t level);
+
+#endif /* __CHANNELS_H__ */
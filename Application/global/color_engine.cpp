@@ -0,0 +1,439 @@
+/**
+ * @file color_engine.cpp
+ * @brief CIE 1931 xy / Duv 色度混光引擎实现
+ * @author User
+ * @date 2025-09-21
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "color_engine.h"
+#include "controller.h"
+#include "drivers/settings.h"
+#include "utils/custom_types.h"
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+// 缓存表: COLOR_TEMP_MIN-COLOR_TEMP_MAX，每COLOR_TABLE_STEP_K一个节点
+#define COLOR_TABLE_STEP_K 100
+#define COLOR_TABLE_SIZE                                                       \
+  ((COLOR_TEMP_MAX - COLOR_TEMP_MIN) / COLOR_TABLE_STEP_K + 1)
+
+#define COLOR_NORMAL_DT 200 // 求轨迹法线的差分色温跨度 (K)
+#define COLOR_SHARE_ONE 65536L // 两通道投影系数满量程
+
+static_assert((COLOR_TEMP_MAX - COLOR_TEMP_MIN) % COLOR_TABLE_STEP_K == 0,
+              "CCT range must be a multiple of the table step");
+static_assert(sizeof(ColorCalibration_t) + sizeof(uint32_t) == 32,
+              "Color calibration record must fit one EEPROM page");
+
+/* Global variables ----------------------------------------------------------*/
+ColorCalibration_t color_cal;
+
+/* Private variables ---------------------------------------------------------*/
+// 已发布的缓存表和求解通道 (TIM3/EXTI中计算目标PWM时读取)，重建时
+// 先写入color_scratch，完成后关中断一次性替换
+static uint16_t color_table[COLOR_TABLE_SIZE][LED_CHANNEL_COUNT];
+static uint16_t color_scratch[COLOR_TABLE_SIZE][LED_CHANNEL_COUNT];
+static volatile uint8_t color_dirty = 1;   // 缓存表需要重建
+static volatile uint8_t color_unsaved = 0; // 校准数据需要保存
+static bool color_table_valid = false;     // 至少两个通道参与求解
+static uint8_t solved_mask = 0;            // 参与求解的通道位掩码
+// 重建和求值使用的求解通道 (只在主循环中读写)
+static uint8_t solve_count = 0;
+static uint8_t solve_ch[COLOR_SOLVE_MAX];  // 参与求解的通道下标
+
+/* Private functions ---------------------------------------------------------*/
+
+static int64_t divRound(int64_t num, int64_t den) {
+  return (num >= 0) ? (num + den / 2) / den : (num - den / 2) / den;
+}
+
+static uint32_t isqrt(uint32_t n) {
+  uint32_t root = 0;
+  uint32_t bit = 1UL << 30;
+  while (bit > n) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (n >= root + bit) {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+/**
+ * @brief 普朗克轨迹CIE 1960 uv (Krystek 1985有理近似，1000-15000K)
+ * @note 系数×1e12，结果×COLOR_UV_SCALE (15000K时分子约3.2e18，不溢出)
+ */
+static void planckianUV(int32_t cct, int32_t *u, int32_t *v) {
+  int64_t t = constrain(cct, 1000, 15000);
+  int64_t t2 = t * t;
+  int64_t un = 860117757000LL + 154118254LL * t + 128641LL * t2;
+  int64_t ud = 1000000000000LL + 842420235LL * t + 708145LL * t2;
+  int64_t vn = 317398726000LL + 42280625LL * t + 42048LL * t2;
+  int64_t vd = 1000000000000LL - 28974182LL * t + 161456LL * t2;
+  *u = (int32_t)divRound(un * COLOR_UV_SCALE, ud);
+  *v = (int32_t)divRound(vn * COLOR_UV_SCALE, vd);
+}
+
+/**
+ * @brief 轨迹单位法线 (×COLOR_UV_SCALE)，指向Duv为正(偏绿)的一侧
+ */
+static void planckianNormal(int32_t cct, int32_t *nu, int32_t *nv) {
+  int32_t u0, v0, u1, v1;
+  planckianUV(cct - COLOR_NORMAL_DT / 2, &u0, &v0);
+  planckianUV(cct + COLOR_NORMAL_DT / 2, &u1, &v1);
+
+  // 色温升高时u减小，切线(du,dv)顺时针旋转90°得到(dv,-du)，v分量为正
+  int32_t du = u1 - u0;
+  int32_t dv = v1 - v0;
+  int32_t len = (int32_t)isqrt((uint32_t)(du * du + dv * dv));
+  if (len == 0) {
+    *nu = 0;
+    *nv = COLOR_UV_SCALE;
+    return;
+  }
+  *nu = dv * COLOR_UV_SCALE / len;
+  *nv = -du * COLOR_UV_SCALE / len;
+}
+
+static void uvToXY(int32_t u, int32_t v, uint16_t *x, uint16_t *y) {
+  int64_t den = 2LL * u - 8LL * v + 4LL * COLOR_UV_SCALE;
+  *x = (uint16_t)divRound(3LL * u * COLOR_XY_SCALE, den);
+  *y = (uint16_t)divRound(2LL * v * COLOR_XY_SCALE, den);
+}
+
+static void xyToUV(int32_t x, int32_t y, int32_t *u, int32_t *v) {
+  int64_t den = -2LL * x + 12LL * y + 3LL * COLOR_XY_SCALE;
+  *u = (int32_t)divRound(4LL * x * COLOR_UV_SCALE, den);
+  *v = (int32_t)divRound(6LL * y * COLOR_UV_SCALE, den);
+}
+
+/**
+ * @brief McCamy相关色温近似 (在3000-6500K附近误差<±2K)
+ */
+static uint16_t mccamyCCT(int32_t x, int32_t y) {
+  if (y <= 1858) {
+    return 25000;
+  }
+  // n = (x-0.3320)/(0.1858-y)，×1e4
+  int64_t n = divRound((int64_t)(x - 3320) * 10000, 1858 - y);
+  int64_t cct = 5520 + divRound(68233 * n, 100000) +
+                divRound(3525 * n * n, 100000000) +
+                divRound(449 * n * n * n, 1000000000000LL);
+  return (uint16_t)constrain(cct, 1000, 25000);
+}
+
+/**
+ * @brief 各通道占空比下的混光色度
+ * @note 混光XYZ按通道线性叠加；S_i = d_i*flux_i/y_i 即各通道X+Y+Z
+ */
+static void mixXY(const uint16_t *duty, uint16_t *x, uint16_t *y) {
+  int64_t sum = 0, sum_x = 0, sum_y = 0;
+  for (uint8_t k = 0; k < solve_count; k++) {
+    uint8_t ch = solve_ch[k];
+    int64_t s = (int64_t)duty[ch] * color_cal.flux[ch] * COLOR_XY_SCALE /
+                color_cal.y[ch];
+    sum += s;
+    sum_x += s * color_cal.x[ch];
+    sum_y += s * color_cal.y[ch];
+  }
+  if (sum == 0) {
+    *x = 0;
+    *y = 0;
+    return;
+  }
+  *x = (uint16_t)divRound(sum_x, sum);
+  *y = (uint16_t)divRound(sum_y, sum);
+}
+
+static int64_t cross(int32_t ax, int32_t ay, int32_t bx, int32_t by,
+                     int32_t cx, int32_t cy) {
+  return (int64_t)(bx - ax) * (cy - ay) - (int64_t)(cx - ax) * (by - ay);
+}
+
+/**
+ * @brief 求解目标色度下参与通道的占空比 (最大者归一为COLOR_WEIGHT_ONE)
+ * @note 先求各通道在色度图上的重心坐标(X+Y+Z份额)，再换算为占空比:
+ *       d_i ∝ share_i * y_i / flux_i。三通道目标超出色域时截到边界，
+ *       两通道时取连线上相关色温相同的点。
+ */
+static void solveDuty(uint16_t cct, uint16_t tx, uint16_t ty,
+                      uint16_t *duty) {
+  int64_t share[COLOR_SOLVE_MAX] = {0};
+  const uint16_t *cx = color_cal.x;
+  const uint16_t *cy = color_cal.y;
+  uint8_t a = solve_ch[0], b = solve_ch[1];
+
+  if (solve_count >= 3) {
+    uint8_t c = solve_ch[2];
+    int64_t area = cross(cx[a], cy[a], cx[b], cy[b], cx[c], cy[c]);
+    share[0] = cross(tx, ty, cx[b], cy[b], cx[c], cy[c]);
+    share[1] = cross(cx[a], cy[a], tx, ty, cx[c], cy[c]);
+    share[2] = cross(cx[a], cy[a], cx[b], cy[b], tx, ty);
+    for (uint8_t k = 0; k < 3; k++) {
+      if (area < 0) {
+        share[k] = -share[k];
+      }
+      if (share[k] < 0) {
+        share[k] = 0; // 目标在色域外，截到边界
+      }
+    }
+  }
+
+  if (solve_count < 3 || share[0] + share[1] + share[2] == 0) {
+    // 两通道只能落在两色点连线上: 取连线与目标等温线(轨迹法线)的交点，
+    // 保证相关色温准确，剩余的Duv偏差由色点本身决定
+    int32_t au, av, bu, bv, tu, tv, nu, nv;
+    xyToUV(cx[a], cy[a], &au, &av);
+    xyToUV(cx[b], cy[b], &bu, &bv);
+    xyToUV(tx, ty, &tu, &tv);
+    planckianNormal(cct, &nu, &nv);
+    // 沿轨迹切线方向(nv,-nu)的分量为0即在等温线上
+    int64_t den = (int64_t)(bu - au) * nv - (int64_t)(bv - av) * nu;
+    if (den != 0) {
+      int64_t s = ((int64_t)(tu - au) * nv - (int64_t)(tv - av) * nu) *
+                  COLOR_SHARE_ONE / den;
+      s = constrain(s, 0, COLOR_SHARE_ONE);
+      uvToXY(au + (int32_t)((bu - au) * s / COLOR_SHARE_ONE),
+             av + (int32_t)((bv - av) * s / COLOR_SHARE_ONE), &tx, &ty);
+    }
+
+    // 目标点投影到两色点连线上得到份额
+    int64_t ex = cx[b] - cx[a];
+    int64_t ey = cy[b] - cy[a];
+    int64_t len2 = ex * ex + ey * ey;
+    int64_t t = (len2 == 0) ? 0
+                            : ((tx - cx[a]) * ex + (ty - cy[a]) * ey) *
+                                  COLOR_SHARE_ONE / len2;
+    t = constrain(t, 0, COLOR_SHARE_ONE);
+    share[0] = COLOR_SHARE_ONE - t;
+    share[1] = t;
+    share[2] = 0;
+  }
+
+  int64_t raw[COLOR_SOLVE_MAX];
+  int64_t raw_max = 0;
+  for (uint8_t k = 0; k < solve_count; k++) {
+    uint8_t ch = solve_ch[k];
+    raw[k] = share[k] * color_cal.y[ch] / color_cal.flux[ch];
+    if (raw[k] > raw_max) {
+      raw_max = raw[k];
+    }
+  }
+
+  forEachChannel([&](uint8_t ch) { duty[ch] = 0; });
+  for (uint8_t k = 0; k < solve_count; k++) {
+    duty[solve_ch[k]] =
+        (raw_max == 0) ? 0
+                       : (uint16_t)divRound(raw[k] * COLOR_WEIGHT_ONE, raw_max);
+  }
+}
+
+/**
+ * @brief 重建缓存表
+ * @note 与mired模式一致地在恒光通量与最大亮度两种归一之间按
+ *       CCT_ADDITIVE_BLEND混合，比例不变故色度不受影响
+ */
+static void buildTable(void) {
+  uint8_t mask = 0;
+  solve_count = 0;
+  forEachChannel([&](uint8_t ch) {
+    if (color_cal.flux[ch] > 0 && color_cal.y[ch] > 0 &&
+        solve_count < COLOR_SOLVE_MAX) {
+      solve_ch[solve_count++] = ch;
+      mask |= 1 << ch;
+    }
+  });
+  if (solve_count < 2) {
+    __disable_irq();
+    color_table_valid = false;
+    solved_mask = 0;
+    __enable_irq();
+    serial_printf("Color: need >=2 channels with flux, using mired mode\r\n");
+    return;
+  }
+
+  // 第一遍: 最大亮度归一并记录各节点光通量
+  uint32_t lum[COLOR_TABLE_SIZE];
+  uint32_t lum_min = UINT32_MAX;
+  for (uint8_t i = 0; i < COLOR_TABLE_SIZE; i++) {
+    uint16_t cct = COLOR_TEMP_MIN + i * COLOR_TABLE_STEP_K;
+    uint16_t tx, ty;
+    Color_TargetXY(cct, color_cal.duv, &tx, &ty);
+    solveDuty(cct, tx, ty, color_scratch[i]);
+
+    lum[i] = 0;
+    for (uint8_t k = 0; k < solve_count; k++) {
+      uint8_t ch = solve_ch[k];
+      lum[i] += (uint32_t)color_scratch[i][ch] * color_cal.flux[ch];
+    }
+    // 全为0的节点 (求解退化) 不参与恒光通量归一
+    if (lum[i] > 0 && lum[i] < lum_min) {
+      lum_min = lum[i];
+    }
+  }
+
+  // 第二遍: 与恒光通量归一混合
+  for (uint8_t i = 0; i < COLOR_TABLE_SIZE; i++) {
+    if (lum[i] == 0) {
+      continue;
+    }
+    for (uint8_t k = 0; k < solve_count; k++) {
+      uint8_t ch = solve_ch[k];
+      uint32_t full = color_scratch[i][ch];
+      uint32_t constant = (uint64_t)full * lum_min / lum[i];
+      color_scratch[i][ch] =
+          (constant * (LED_TEMP_SPRI_TOTAL - CCT_ADDITIVE_BLEND) +
+           full * CCT_ADDITIVE_BLEND) /
+          LED_TEMP_SPRI_TOTAL;
+    }
+  }
+
+  // 表、求解通道和有效标志一起替换，中断中不会读到新旧混合的数据
+  __disable_irq();
+  memcpy(color_table, color_scratch, sizeof(color_table));
+  solved_mask = mask;
+  color_table_valid = true;
+  __enable_irq();
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+ * @brief 恢复默认色度数据 (暖白/冷白取COLOR_TEMP_MIN/MAX处的轨迹点)
+ */
+void Color_Init(void) {
+  memset(&color_cal, 0, sizeof(color_cal));
+  Color_TargetXY(COLOR_TEMP_MIN, 0, &color_cal.x[LED_CHANNEL_WARM],
+                 &color_cal.y[LED_CHANNEL_WARM]);
+  Color_TargetXY(COLOR_TEMP_MAX, 0, &color_cal.x[LED_CHANNEL_COLD],
+                 &color_cal.y[LED_CHANNEL_COLD]);
+  color_cal.flux[LED_CHANNEL_WARM] = 1000;
+  color_cal.flux[LED_CHANNEL_COLD] = 1000;
+  // 辅助通道默认不参与求解(flux=0)，沿用mix权重
+  for (uint8_t ch = 2; ch < LED_CHANNEL_MAX; ch++) {
+    color_cal.x[ch] = 3333;
+    color_cal.y[ch] = 3333;
+  }
+  color_cal.duv = 0;
+  color_cal.mode = COLOR_MODE_CIE;
+  color_dirty = 1;
+}
+
+/**
+ * @brief 从EEPROM加载色度数据
+ */
+bool Color_Load(void) {
+  ColorCalibration_t cal;
+  if (!Settings_LoadBlock(EEPROM_ADDR_COLOR, &cal, sizeof(cal))) {
+    serial_printf("Color calibration not found, using defaults\r\n");
+    return false;
+  }
+  if (cal.mode > COLOR_MODE_CIE || cal.duv > COLOR_DUV_LIMIT ||
+      cal.duv < -COLOR_DUV_LIMIT) {
+    serial_printf("Color calibration invalid, using defaults\r\n");
+    return false;
+  }
+  color_cal = cal;
+  color_dirty = 1;
+  serial_printf("Color calibration loaded (mode %s)\r\n",
+                color_cal.mode == COLOR_MODE_CIE ? "CIE" : "MIRED");
+  return true;
+}
+
+void Color_Invalidate(void) {
+  color_dirty = 1;
+  color_unsaved = 1;
+}
+
+/**
+ * @brief 主循环调用: 按需重建缓存表并持久化
+ */
+bool Color_Update(void) {
+  if (!color_dirty) {
+    return false;
+  }
+  color_dirty = 0;
+  buildTable();
+
+  if (color_unsaved) {
+    color_unsaved = 0;
+    Settings_SaveBlock(EEPROM_ADDR_COLOR, &color_cal, sizeof(color_cal));
+  }
+  return true;
+}
+
+bool Color_Enabled(void) {
+  return color_cal.mode == COLOR_MODE_CIE && color_table_valid;
+}
+
+bool Color_IsSolved(uint8_t ch) { return solved_mask & (1 << ch); }
+
+/**
+ * @brief 查表线性插值得到各通道占空比权重
+ */
+void Color_GetWeights(uint16_t colorTemp, uint16_t *weight) {
+  colorTemp = constrain(colorTemp, COLOR_TEMP_MIN, COLOR_TEMP_MAX);
+  uint16_t offset = colorTemp - COLOR_TEMP_MIN;
+  uint8_t i = offset / COLOR_TABLE_STEP_K;
+  uint16_t frac = offset % COLOR_TABLE_STEP_K;
+
+  if (i >= COLOR_TABLE_SIZE - 1) {
+    forEachChannel(
+        [&](uint8_t ch) { weight[ch] = color_table[COLOR_TABLE_SIZE - 1][ch]; });
+    return;
+  }
+
+  forEachChannel([&](uint8_t ch) {
+    int32_t w0 = color_table[i][ch];
+    int32_t w1 = color_table[i + 1][ch];
+    weight[ch] = w0 + (w1 - w0) * frac / COLOR_TABLE_STEP_K;
+  });
+}
+
+/**
+ * @brief 普朗克轨迹上(沿法线偏移Duv后)的目标色度
+ */
+void Color_TargetXY(uint16_t cct, int16_t duv, uint16_t *x, uint16_t *y) {
+  int32_t u, v;
+  planckianUV(cct, &u, &v);
+  if (duv != 0) {
+    int32_t nu, nv;
+    planckianNormal(cct, &nu, &nv);
+    // Duv×1e4 -> uv×1e5
+    int32_t d = duv * (COLOR_UV_SCALE / COLOR_DUV_SCALE);
+    u += d * nu / COLOR_UV_SCALE;
+    v += d * nv / COLOR_UV_SCALE;
+  }
+  uvToXY(u, v, x, y);
+}
+
+/**
+ * @brief 由各通道实际占空比计算混光色度、相关色温和Duv
+ */
+void Color_Evaluate(const uint16_t *duty, uint16_t *x, uint16_t *y,
+                    uint16_t *cct, int16_t *duv) {
+  mixXY(duty, x, y);
+  if (*y == 0) {
+    *cct = 0;
+    *duv = 0;
+    return;
+  }
+
+  *cct = mccamyCCT(*x, *y);
+
+  int32_t u, v, ul, vl, nu, nv;
+  xyToUV(*x, *y, &u, &v);
+  planckianUV(*cct, &ul, &vl);
+  planckianNormal(*cct, &nu, &nv);
+  int64_t dist = (int64_t)(u - ul) * nu + (int64_t)(v - vl) * nv;
+  *duv = (int16_t)divRound(dist, (int64_t)COLOR_UV_SCALE *
+                                     (COLOR_UV_SCALE / COLOR_DUV_SCALE));
+}
@@ -0,0 +1,102 @@
+/**
+ * @file color_engine.h
+ * @brief CIE 1931 xy / Duv 色度混光引擎 (定点运算)
+ * @author User
+ * @date 2025-09-21
+ *
+ * 根据各通道实测色度坐标(x,y)和满占空比光通量，求解目标色温(及Duv)下
+ * 各通道的占空比比例。求解结果按色温缓存为插值表，旋钮调节时只做一次
+ * 查表插值，开销与原mired插值相当。
+ */
+
+#ifndef __COLOR_ENGINE_H__
+#define __COLOR_ENGINE_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include "channels.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define COLOR_XY_SCALE 10000     // 色度坐标定点缩放 (x,y ×10000)
+#define COLOR_UV_SCALE 100000    // CIE 1960 uv定点缩放 (u,v ×100000)
+#define COLOR_DUV_SCALE 10000    // Duv定点缩放 (Duv ×10000)
+#define COLOR_DUV_LIMIT 200      // Duv设定范围 ±0.0200
+#define COLOR_WEIGHT_ONE 1024    // 通道占空比权重满量程
+#define COLOR_SOLVE_MAX 3        // 参与色度求解的通道数上限
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef enum {
+  COLOR_MODE_MIRED = 0, // 原mired线性插值 (不使用色度数据)
+  COLOR_MODE_CIE = 1    // CIE xy求解
+} ColorMode_t;
+
+/**
+ * @brief 色度校准数据 (EEPROM中加CRC32共32字节，一页AT24C32)
+ * @note 按LED_CHANNEL_MAX固定布局，与固件通道数无关。全为16位和成对的
+ *       8位成员，不需要packed (大小由static_assert检查)
+ */
+typedef struct {
+  uint16_t x[LED_CHANNEL_MAX];    // 色度x ×10000
+  uint16_t y[LED_CHANNEL_MAX];    // 色度y ×10000
+  uint16_t flux[LED_CHANNEL_MAX]; // 满占空比光通量 (lm)，0=不参与求解
+  int16_t duv;                    // 目标Duv ×10000
+  uint8_t mode;                   // ColorMode_t
+  uint8_t reserved;
+} ColorCalibration_t;
+
+extern ColorCalibration_t color_cal;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 恢复默认色度数据并标记缓存表需要重建
+ */
+void Color_Init(void);
+
+/**
+ * @brief 从EEPROM加载色度数据，失败时保留默认值
+ */
+bool Color_Load(void);
+
+/**
+ * @brief 色度数据已修改: 下次Color_Update时重建缓存表并保存
+ * @note 可在中断(命令执行器)中调用，耗时的重建在主循环完成
+ */
+void Color_Invalidate(void);
+
+/**
+ * @brief 主循环调用: 按需重建缓存表并持久化
+ * @return 缓存表已重建 (目标PWM需要重新计算)
+ */
+bool Color_Update(void);
+
+/**
+ * @brief CIE模式且缓存表有效
+ */
+bool Color_Enabled(void);
+
+/**
+ * @brief 通道是否参与色度求解 (否则按channels.mix跟随亮度)
+ */
+bool Color_IsSolved(uint8_t ch);
+
+/**
+ * @brief 查表插值得到各通道占空比权重 (0-COLOR_WEIGHT_ONE)
+ */
+void Color_GetWeights(uint16_t colorTemp, uint16_t *weight);
+
+/**
+ * @brief 普朗克轨迹上(偏移Duv后)的目标色度
+ */
+void Color_TargetXY(uint16_t cct, int16_t duv, uint16_t *x, uint16_t *y);
+
+/**
+ * @brief 由各通道实际占空比(如targetPWM)计算混光色度、相关色温和Duv
+ * @note 只统计有光通量数据的通道，两种模式下都可用于核对实际色温
+ */
+void Color_Evaluate(const uint16_t *duty, uint16_t *x, uint16_t *y,
+                    uint16_t *cct, int16_t *duv);
+
+#endif /* __COLOR_ENGINE_H__ */
@@ -0,0 +1,400 @@
+/**
+ * @file command_index.h
+ * @brief 命令表及其编译期索引 (只由commands.cpp和主机基准测试包含)
+ * @author User
+ * @date 2025-10-09
+ *
+ * 各层命令表在编译期展开成一张节点表，节点下标就是入队记录中的操作码；
+ * 再按(父节点, 命令名哈希)建一张开放寻址哈希表，入队时每层查找一次
+ * 即可定位节点，不再逐表扫描。执行时按操作码直接调用该节点的回调。
+ */
+
+#ifndef __COMMAND_INDEX_H__
+#define __COMMAND_INDEX_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include "commands.h"
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define CMD_INDEX_SLOTS 256 // 哈希槽数 (2的幂，槽下标取哈希高8位)
+#define CMD_NODE_NONE 0xFF  // 空槽/找不到/顶层节点的父节点
+
+/* Command structure definitions ---------------------------------------------*/
+// 表项最后的数字为前几个参数是整数 (int_args)，入队时检查并转换，
+// 回调用Commands_Int_Param读取
+
+// POWER子命令定义
+// CHn共用同一组子命令，执行时按节点的channel设置选中的通道
+static constexpr CommandStruct_t power_ch_subcommands[] = {
+    {"READ", Cmd_Power_Ch_Read_Handler, NULL, 0, "Read channel target PWM"},
+    {"SHOW", Cmd_Power_Ch_Read_Handler, NULL, 0, "Show channel target PWM"},
+    {"SET", Cmd_Power_Ch_Set_Handler, NULL, 0, "Set channel target PWM value",
+     1},
+    {"FADE", Cmd_Power_Ch_Fade_Handler, NULL, 0, "Set channel fade step", 1},
+    {"LIMIT", Cmd_Power_Ch_Limit_Handler, NULL, 0, "Set channel PWM limit", 1},
+    {"MIX", Cmd_Power_Ch_Mix_Handler, NULL, 0, "Set aux channel mix weight",
+     1}};
+
+#define POWER_CH_ENTRY(name, desc)                                             \
+  {name, Cmd_Power_Ch_Handler, power_ch_subcommands,                           \
+   sizeof(power_ch_subcommands) / sizeof(CommandStruct_t), desc}
+
+static constexpr CommandStruct_t power_subcommands[] = {
+    {"OFF", Cmd_Power_Off_Handler, NULL, 0, "Turn power off"},
+    {"ON", Cmd_Power_On_Handler, NULL, 0, "Turn power on"},
+    POWER_CH_ENTRY("CH1", "Channel 1 control"),
+    POWER_CH_ENTRY("CH2", "Channel 2 control"),
+#if LED_CHANNEL_COUNT >= 3
+    POWER_CH_ENTRY("CH3", "Channel 3 control"),
+#endif
+#if LED_CHANNEL_COUNT >= 4
+    POWER_CH_ENTRY("CH4", "Channel 4 control"),
+#endif
+    {"FADE", Cmd_Power_Fade_Handler, NULL, 0, "Set PWM fade step", 1}};
+
+// FAN子命令定义
+static constexpr CommandStruct_t fan_subcommands[] = {
+    {"READ", Cmd_Fan_Read_Handler, NULL, 0, "Show fan PWM state"},
+    {"AUTO", Cmd_Fan_Auto_Handler, NULL, 0, "Set fan to auto mode"},
+    {"FORCE", Cmd_Fan_Force_Handler, NULL, 0, "Set fan to force mode"},
+    {"MODE", Cmd_Fan_Mode_Handler, NULL, 0, "Auto control: CURVE/PID"},
+    {"CURVE", Cmd_Fan_Curve_Handler, NULL, 0, "Set fan curve point", 3},
+    {"HYST", Cmd_Fan_Hyst_Handler, NULL, 0, "Set temperature hysteresis", 1},
+    {"PID", Cmd_Fan_Pid_Handler, NULL, 0, "Set PID setpoint and gains", 4},
+    {"TACH", Cmd_Fan_Tach_Handler, NULL, 0, "Set tach pulses per rev"},
+    {"RPM", Cmd_Fan_Rpm_Handler, NULL, 0, "Set closed-loop target RPM", 1},
+    {"MINRPM", Cmd_Fan_Minrpm_Handler, NULL, 0, "Set under-speed limit", 1},
+    {"HISTORY", Cmd_Fan_History_Handler, NULL, 0, "Show RPM history"}};
+
+// COLOR子命令定义
+static constexpr CommandStruct_t color_subcommands[] = {
+    {"READ", Cmd_Color_Read_Handler, NULL, 0, "Show target/actual CCT and Duv"},
+    {"MODE", Cmd_Color_Mode_Handler, NULL, 0, "Select CIE or MIRED mixing"},
+    {"DUV", Cmd_Color_Duv_Handler, NULL, 0, "Set target Duv (x10000)", 1},
+    {"XY", Cmd_Color_XY_Handler, NULL, 0, "Set channel chromaticity", 3},
+    {"FLUX", Cmd_Color_Flux_Handler, NULL, 0, "Set channel luminous flux", 2}};
+
+// EFFECT子命令定义
+static constexpr CommandStruct_t effect_subcommands[] = {
+    {"OFF", Cmd_Effect_Off_Handler, NULL, 0, "Stop effect"},
+    {"READ", Cmd_Effect_Read_Handler, NULL, 0, "Show effect and cost"},
+    {"BREATHE", Cmd_Effect_Breathe_Handler, NULL, 0, "Breathing effect", 2},
+    {"CANDLE", Cmd_Effect_Candle_Handler, NULL, 0, "Candle flicker effect", 2},
+    {"STROBE", Cmd_Effect_Strobe_Handler, NULL, 0, "Strobe pattern effect", 3}};
+
+// PRESET子命令定义
+static constexpr CommandStruct_t preset_subcommands[] = {
+    {"RECALL", Cmd_Preset_Recall_Handler, NULL, 0, "Recall preset", 1},
+    {"STORE", Cmd_Preset_Store_Handler, NULL, 0, "Store current look", 1},
+    {"READ", Cmd_Preset_Read_Handler, NULL, 0, "List presets"},
+    {"FADE", Cmd_Preset_Fade_Handler, NULL, 0, "Set crossfade time", 1}};
+
+// PWM子命令定义
+static constexpr CommandStruct_t pwm_subcommands[] = {
+    {"READ", Cmd_Pwm_Read_Handler, NULL, 0, "List PWM profiles"},
+    {"PROFILE", Cmd_Pwm_Profile_Handler, NULL, 0, "Select PWM profile"}};
+
+// LUMEN子命令定义
+static constexpr CommandStruct_t lumen_subcommands[] = {
+    {"READ", Cmd_Lumen_Read_Handler, NULL, 0, "Show drive hours and gain"},
+    {"COMP", Cmd_Lumen_Comp_Handler, NULL, 0, "Enable/disable compensation"},
+    {"CURVE", Cmd_Lumen_Curve_Handler, NULL, 0, "Set depreciation curve", 3},
+    {"RESET", Cmd_Lumen_Reset_Handler, NULL, 0, "Reset drive hours", 1}};
+
+// REG子命令定义
+static constexpr CommandStruct_t reg_subcommands[] = {
+    {"READ", Cmd_Reg_Read_Handler, NULL, 0, "Show measurement and loop state"},
+    {"MODE", Cmd_Reg_Mode_Handler, NULL, 0, "Select OFF/CP/CC"},
+    {"SET", Cmd_Reg_Set_Handler, NULL, 0, "Set power/current setpoint", 1},
+    {"HOLD", Cmd_Reg_Hold_Handler, NULL, 0, "Hold present measurement"}};
+
+// LATENCY子命令定义
+static constexpr CommandStruct_t latency_subcommands[] = {
+    {"READ", Cmd_Latency_Read_Handler, NULL, 0, "Show input-to-PWM latency"},
+    {"FAST", Cmd_Latency_Fast_Handler, NULL, 0, "Enable/disable fast path"},
+    {"RESET", Cmd_Latency_Reset_Handler, NULL, 0, "Clear statistics"}};
+
+// ADC子命令定义
+static constexpr CommandStruct_t adc_subcommands[] = {
+    {"READ", Cmd_Adc_Read_Handler, NULL, 0, "Show NTC acquisition state"},
+    {"BENCH", Cmd_Adc_Bench_Handler, NULL, 0, "Time temperature conversion"},
+    {"POINT", Cmd_Adc_Point_Handler, NULL, 0, "Sample point in PWM period"},
+    {"TRIP", Cmd_Adc_Trip_Handler, NULL, 0, "Set over-temperature trip"},
+    {"CLEAR", Cmd_Adc_Clear_Handler, NULL, 0, "Recover from a trip"}};
+
+// THERM子命令定义
+static constexpr CommandStruct_t therm_subcommands[] = {
+    {"READ", Cmd_Therm_Read_Handler, NULL, 0, "Show junction estimate"},
+    {"MODEL", Cmd_Therm_Model_Handler, NULL, 0, "Set resistances/time consts",
+     4},
+    {"OBS", Cmd_Therm_Obs_Handler, NULL, 0, "Set observer gains", 2},
+    {"POWER", Cmd_Therm_Power_Handler, NULL, 0, "Set channel full power", 2},
+    {"HEAT", Cmd_Therm_Heat_Handler, NULL, 0, "Set heat fraction", 1},
+    {"FAN", Cmd_Therm_Fan_Handler, NULL, 0, "Fan follows junction"},
+    {"LIMIT", Cmd_Therm_Limit_Handler, NULL, 0, "Set derating start"},
+    {"STEP", Cmd_Therm_Step_Handler, NULL, 0, "Start step response log", 1},
+    {"LOG", Cmd_Therm_Log_Handler, NULL, 0, "Dump step response log"},
+    {"FIT", Cmd_Therm_Fit_Handler, NULL, 0, "Fit heatsink model"}};
+
+// HIST子命令定义
+static constexpr CommandStruct_t hist_subcommands[] = {
+    {"READ", Cmd_Hist_Read_Handler, NULL, 0, "Show latest buckets"},
+    {"DUMP", Cmd_Hist_Dump_Handler, NULL, 0, "Binary dump of a range"},
+    {"SNAP", Cmd_Hist_Snap_Handler, NULL, 0, "Hourly EEPROM snapshots"},
+    {"OLED", Cmd_Hist_Oled_Handler, NULL, 0, "Sparkline page"}};
+
+// CMD子命令定义
+static constexpr CommandStruct_t cmd_subcommands[] = {
+    {"BENCH", Cmd_Cmd_Bench_Handler, NULL, 0, "Time command lookup"},
+    {"ISR", Cmd_Cmd_Isr_Handler, NULL, 0, "Executor ISR and deferred work"},
+    {"PROF", Cmd_Cmd_Prof_Handler, NULL, 0, "Per-command execution time"},
+    {"BUDGET", Cmd_Cmd_Budget_Handler, NULL, 0, "Executor time per tick", 1},
+    {"CHAN", Cmd_Cmd_Chan_Handler, NULL, 0, "Per-channel queue statistics"},
+    {"BIN", Cmd_Cmd_Bin_Handler, NULL, 0, "Binary protocol statistics"},
+    {"QUIET", Cmd_Cmd_Quiet_Handler, NULL, 0, "Suppress command echo"}};
+
+// SLEEP子命令定义
+static constexpr CommandStruct_t sleep_subcommands[] = {
+    {"DEEP", Cmd_Sleep_Deep_Handler, NULL, 0, "Enter deep sleep mode"}};
+
+// EEPROM子命令定义
+static constexpr CommandStruct_t eeprom_subcommands[] = {
+    {"READ", Cmd_Eeprom_Read_Handler, NULL, 0, "Read EEPROM data"},
+    {"WRITE", Cmd_Eeprom_Write_Handler, NULL, 0, "Write EEPROM data"}};
+
+// 主命令表
+static constexpr CommandStruct_t main_commands[] = {
+    {"POWER", Cmd_Power_Handler, power_subcommands,
+     sizeof(power_subcommands) / sizeof(CommandStruct_t), "Power control"},
+    {"FAN", Cmd_Fan_Handler, fan_subcommands,
+     sizeof(fan_subcommands) / sizeof(CommandStruct_t), "Fan control"},
+    {"COLOR", Cmd_Color_Handler, color_subcommands,
+     sizeof(color_subcommands) / sizeof(CommandStruct_t), "Color mixing"},
+    {"EFFECT", Cmd_Effect_Handler, effect_subcommands,
+     sizeof(effect_subcommands) / sizeof(CommandStruct_t), "Lighting effects"},
+    {"PRESET", Cmd_Preset_Handler, preset_subcommands,
+     sizeof(preset_subcommands) / sizeof(CommandStruct_t), "Preset bank"},
+    {"PWM", Cmd_Pwm_Handler, pwm_subcommands,
+     sizeof(pwm_subcommands) / sizeof(CommandStruct_t),
+     "PWM frequency/resolution profile"},
+    {"LUMEN", Cmd_Lumen_Handler, lumen_subcommands,
+     sizeof(lumen_subcommands) / sizeof(CommandStruct_t),
+     "Lumen maintenance"},
+    {"REG", Cmd_Reg_Handler, reg_subcommands,
+     sizeof(reg_subcommands) / sizeof(CommandStruct_t),
+     "Constant power/current loop"},
+    {"LATENCY", Cmd_Latency_Handler, latency_subcommands,
+     sizeof(latency_subcommands) / sizeof(CommandStruct_t),
+     "Input latency probe"},
+    {"ADC", Cmd_Adc_Handler, adc_subcommands,
+     sizeof(adc_subcommands) / sizeof(CommandStruct_t), "NTC acquisition"},
+    {"THERM", Cmd_Therm_Handler, therm_subcommands,
+     sizeof(therm_subcommands) / sizeof(CommandStruct_t),
+     "Junction temperature model"},
+    {"HIST", Cmd_Hist_Handler, hist_subcommands,
+     sizeof(hist_subcommands) / sizeof(CommandStruct_t),
+     "Temperature/power/fan history"},
+    {"CMD", Cmd_Cmd_Handler, cmd_subcommands,
+     sizeof(cmd_subcommands) / sizeof(CommandStruct_t), "Command system"},
+    {"SLEEP", Cmd_Sleep_Handler, sleep_subcommands,
+     sizeof(sleep_subcommands) / sizeof(CommandStruct_t), "Sleep control"},
+    {"WAIT", Cmd_Wait_Handler, NULL, 0, "Wait for specified milliseconds"},
+    {"REBOOT", Cmd_Reboot_Handler, NULL, 0, "Reboot system"},
+    {"EEPROM", Cmd_Eeprom_Handler, eeprom_subcommands,
+     sizeof(eeprom_subcommands) / sizeof(CommandStruct_t), "EEPROM operations"},
+    {"HELP", Cmd_Help_Handler, NULL, 0, "Show available commands"}};
+
+static constexpr uint8_t main_command_count =
+    sizeof(main_commands) / sizeof(CommandStruct_t);
+
+/**
+ * @brief 编译期检查: 每张命令表内哈希互不相同 (比较哈希即可定位表项)
+ */
+static constexpr bool hashes_unique(const CommandStruct_t *table,
+                                    uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    for (uint8_t j = i + 1; j < count; j++) {
+      if (table[i].hash == table[j].hash) {
+        return false;
+      }
+    }
+    if (table[i].subcommands != NULL &&
+        !hashes_unique(table[i].subcommands, table[i].subcommand_count)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static constexpr uint8_t table_depth(const CommandStruct_t *table,
+                                     uint8_t count) {
+  uint8_t depth = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t sub = (table[i].subcommands != NULL)
+                      ? table_depth(table[i].subcommands,
+                                    table[i].subcommand_count)
+                      : 0;
+    depth = (sub > depth) ? sub : depth;
+  }
+  return depth + 1;
+}
+
+static_assert(hashes_unique(main_commands, main_command_count),
+              "command name hash collision, rename the command");
+static_assert(table_depth(main_commands, main_command_count) <= CMD_MAX_DEPTH,
+              "command tables nested deeper than CMD_MAX_DEPTH");
+
+/* Command index -------------------------------------------------------------*/
+
+typedef struct {
+  const CommandStruct_t *entry; // 命令表项
+  uint8_t parent;               // 父节点，顶层命令为CMD_NODE_NONE
+  uint8_t depth;                // 命令名层数 (POWER为1，POWER CH1 SET为3)
+  uint8_t top;                  // 顶层命令下标 (执行耗时按顶层统计)
+  int8_t channel;               // POWER CHn及其子命令为n-1，其余为-1
+} CommandNode_t;
+
+static constexpr uint8_t count_nodes(const CommandStruct_t *table,
+                                     uint8_t count) {
+  uint8_t nodes = count;
+  for (uint8_t i = 0; i < count; i++) {
+    if (table[i].subcommands != NULL) {
+      nodes += count_nodes(table[i].subcommands, table[i].subcommand_count);
+    }
+  }
+  return nodes;
+}
+
+static constexpr uint8_t command_node_count =
+    count_nodes(main_commands, main_command_count);
+
+/**
+ * @brief 哈希槽下标: (父节点, 命令名哈希) 的Fibonacci散列取高8位
+ */
+static constexpr uint8_t command_slot(uint8_t parent, uint32_t hash) {
+  return ((hash ^ parent) * 2654435761u) >> 24;
+}
+
+struct CommandIndex {
+  CommandNode_t nodes[command_node_count]; // 下标即操作码
+  uint8_t slots[CMD_INDEX_SLOTS];          // 节点下标，空槽为CMD_NODE_NONE
+  uint8_t maxProbe;                        // 最长探测距离
+
+  constexpr CommandIndex() : nodes{}, slots{}, maxProbe(0) {
+    for (uint16_t i = 0; i < CMD_INDEX_SLOTS; i++) {
+      slots[i] = CMD_NODE_NONE;
+    }
+    uint8_t next = 0;
+    add(main_commands, main_command_count, CMD_NODE_NONE, next);
+  }
+
+  // 同一张表的节点连续存放，之后依次展开各子表
+  constexpr void add(const CommandStruct_t *table, uint8_t count,
+                     uint8_t parent, uint8_t &next) {
+    uint8_t first = next;
+    for (uint8_t i = 0; i < count; i++) {
+      const char *name = table[i].command;
+      bool channel = name[0] == 'C' && name[1] == 'H' && name[2] >= '1' &&
+                     name[2] <= '9' && name[3] == '\0';
+      CommandNode_t &node = nodes[next];
+      node.entry = &table[i];
+      node.parent = parent;
+      node.depth = (parent == CMD_NODE_NONE) ? 1 : nodes[parent].depth + 1;
+      node.top = (parent == CMD_NODE_NONE) ? i : nodes[parent].top;
+      node.channel = channel ? name[2] - '1'
+                     : (parent == CMD_NODE_NONE) ? -1
+                                                 : nodes[parent].channel;
+
+      uint8_t slot = command_slot(parent, table[i].hash);
+      uint8_t probe = 0;
+      while (slots[slot] != CMD_NODE_NONE) {
+        slot = (slot + 1) & (CMD_INDEX_SLOTS - 1);
+        probe++;
+      }
+      slots[slot] = next++;
+      maxProbe = (probe > maxProbe) ? probe : maxProbe;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+      if (table[i].subcommands != NULL) {
+        add(table[i].subcommands, table[i].subcommand_count, first + i, next);
+      }
+    }
+  }
+};
+
+static constexpr CommandIndex command_index{};
+
+static_assert(command_node_count < CMD_OP_WAIT,
+              "too many commands for an 8-bit opcode");
+static_assert(command_node_count <= CMD_INDEX_SLOTS / 2,
+              "command index more than half full, enlarge CMD_INDEX_SLOTS");
+
+/**
+ * @brief 查找父节点下的子命令
+ * @param parent 父节点，查找顶层命令时为CMD_NODE_NONE
+ * @return 节点下标 (操作码)，找不到时返回CMD_NODE_NONE
+ */
+static inline uint8_t Commands_Lookup(uint8_t parent, const char *text,
+                                      uint8_t length) {
+  uint32_t hash = Commands_Hash_Len(text, length);
+  uint8_t slot = command_slot(parent, hash);
+  uint8_t index;
+
+  while ((index = command_index.slots[slot]) != CMD_NODE_NONE) {
+    const CommandNode_t *node = &command_index.nodes[index];
+    if (node->parent == parent && node->entry->hash == hash) {
+      // 同一父节点下哈希唯一，再比较一次字符串排除不在表中的参数碰巧同哈希
+      const char *name = node->entry->command;
+      return (strncmp(text, name, length) == 0 && name[length] == '\0')
+                 ? index
+                 : CMD_NODE_NONE;
+    }
+    slot = (slot + 1) & (CMD_INDEX_SLOTS - 1);
+  }
+  return CMD_NODE_NONE;
+}
+
+/**
+ * @brief 解析整数参数: 十进制 (可带符号) 或0x开头的十六进制，范围为int32_t
+ * @return 格式错误或溢出时返回false
+ */
+static inline bool Commands_Parse_Int(const char *text, uint8_t length,
+                                      int32_t *value) {
+  const char *p = text;
+  const char *end = text + length;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p++ == '-');
+  }
+  uint8_t base = 10;
+  if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+    base = 16;
+    p += 2;
+  }
+  if (p == end) {
+    return false;
+  }
+
+  const uint32_t limit = negative ? 0x80000000u : 0x7FFFFFFFu;
+  uint32_t v = 0;
+  for (; p < end; p++) {
+    uint8_t c = *p;
+    uint8_t digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (base == 16 && (c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+      digit = (c | 0x20) - 'a' + 10;
+    } else {
+      return false;
+    }
+    if (v > (limit - digit) / base) {
+      return false;
+    }
+    v = v * base + digit;
+  }
+  *value = negative ? (int32_t)(0u - v) : (int32_t)v;
+  return true;
+}
+
+#endif /* __COMMAND_INDEX_H__ */
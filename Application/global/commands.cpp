@@ -7,8 +7,24 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "commands.h"
+#include "command_index.h"
+#include "analog.h"
+#include "binproto.h"
+#include "color_engine.h"
+#include "deferred.h"
+#include "effects.h"
+#include "fan.h"
+#include "history.h"
+#include "latency.h"
+#include "lumen.h"
+#include "presets.h"
+#include "pwm_profile.h"
+#include "regulator.h"
+#include "thermal.h"
+#include "timer_wheel.h"
 #include "global/controller.h"
 #include "global_objects.h"
+#include "hardware/devices.h"
 #include "usart.h"
 #include <cstdio>
 #include <ctype.h>
@@ -17,70 +33,92 @@
 #include <tim.h>
 
 /* Private variables ---------------------------------------------------------*/
-static CommandQueue_t command_queue = {{0}};
-
-/* Command structure definitions ---------------------------------------------*/
-
-// POWER子命令定义
-static const CommandStruct_t power_ch1_subcommands[] = {
-    {"READ", Cmd_Power_Ch1_Read_Handler, NULL, 0, "Read CH1 target PWM"},
-    {"SHOW", Cmd_Power_Ch1_Read_Handler, NULL, 0, "Show CH1 target PWM"},
-    {"SET", Cmd_Power_Ch1_Set_Handler, NULL, 0, "Set CH1 target PWM value"}};
-
-static const CommandStruct_t power_ch2_subcommands[] = {
-    {"READ", Cmd_Power_Ch2_Read_Handler, NULL, 0, "Read CH2 target PWM"},
-    {"SHOW", Cmd_Power_Ch2_Read_Handler, NULL, 0, "Show CH2 target PWM"},
-    {"SET", Cmd_Power_Ch2_Set_Handler, NULL, 0, "Set CH2 target PWM value"}};
-
-static const CommandStruct_t power_subcommands[] = {
-    {"OFF", Cmd_Power_Off_Handler, NULL, 0, "Turn power off"},
-    {"ON", Cmd_Power_On_Handler, NULL, 0, "Turn power on"},
-    {"CH1", Cmd_Power_Ch1_Handler, power_ch1_subcommands,
-     sizeof(power_ch1_subcommands) / sizeof(CommandStruct_t),
-     "Channel 1 control"},
-    {"CH2", Cmd_Power_Ch2_Handler, power_ch2_subcommands,
-     sizeof(power_ch2_subcommands) / sizeof(CommandStruct_t),
-     "Channel 2 control"},
-    {"FADE", Cmd_Power_Fade_Handler, NULL, 0, "Set PWM fade step"}};
-
-// FAN子命令定义
-static const CommandStruct_t fan_subcommands[] = {
-    {"AUTO", Cmd_Fan_Auto_Handler, NULL, 0, "Set fan to auto mode"},
-    {"FORCE", Cmd_Fan_Force_Handler, NULL, 0, "Set fan to force mode"}};
-
-// SLEEP子命令定义
-static const CommandStruct_t sleep_subcommands[] = {
-    {"DEEP", Cmd_Sleep_Deep_Handler, NULL, 0, "Enter deep sleep mode"}};
-
-// EEPROM子命令定义
-static const CommandStruct_t eeprom_subcommands[] = {
-    {"READ", Cmd_Eeprom_Read_Handler, NULL, 0, "Read EEPROM data"},
-    {"WRITE", Cmd_Eeprom_Write_Handler, NULL, 0, "Write EEPROM data"}};
-
-// 主命令表
-static const CommandStruct_t main_commands[] = {
-    {"POWER", Cmd_Power_Handler, power_subcommands,
-     sizeof(power_subcommands) / sizeof(CommandStruct_t), "Power control"},
-    {"FAN", Cmd_Fan_Handler, fan_subcommands,
-     sizeof(fan_subcommands) / sizeof(CommandStruct_t), "Fan control"},
-    {"SLEEP", Cmd_Sleep_Handler, sleep_subcommands,
-     sizeof(sleep_subcommands) / sizeof(CommandStruct_t), "Sleep control"},
-    {"WAIT", Cmd_Wait_Handler, NULL, 0, "Wait for specified cycles"},
-    {"REBOOT", Cmd_Reboot_Handler, NULL, 0, "Reboot system"},
-    {"EEPROM", Cmd_Eeprom_Handler, eeprom_subcommands,
-     sizeof(eeprom_subcommands) / sizeof(CommandStruct_t), "EEPROM operations"},
-    {"HELP", Cmd_Help_Handler, NULL, 0, "Show available commands"}};
-
-static const uint8_t main_command_count =
-    sizeof(main_commands) / sizeof(CommandStruct_t);
+static uint8_t arena_urgent[CMD_ARENA_URGENT];
+static uint8_t arena_interactive[CMD_ARENA_INTERACTIVE];
+static uint8_t arena_script[CMD_ARENA_SCRIPT];
+static uint8_t arena_internal[CMD_ARENA_INTERNAL];
+
+// 下标为CommandChannelId_t
+static CommandChannel_t cmd_channels[CMD_CHANNEL_COUNT] = {
+    {arena_urgent, CMD_ARENA_URGENT, 0, 0, 0, 0, 1, {}, {}},
+    {arena_interactive, CMD_ARENA_INTERACTIVE, 0, 0, 0, 0, 4, {}, {}},
+    {arena_script, CMD_ARENA_SCRIPT, 0, 0, 0, 0, 2, {}, {}},
+    {arena_internal, CMD_ARENA_INTERNAL, 0, 0, 0, 0, 2, {}, {}}};
+static const char *const channel_names[CMD_CHANNEL_COUNT] = {
+    "URGENT", "INTERACTIVE", "SCRIPT", "INTERNAL"};
+// 轮转从紧急通道之后开始，第一次选择时先转到交互通道并领取其权重
+static uint8_t rr_channel = CMD_CHANNEL_URGENT; // 轮转当前通道
+static uint8_t rr_credit = 0;                  // 当前通道本轮剩余条数
+static uint8_t selected_channel = 0; // 当前CHn命令选中的通道下标
+static bool quiet = false;           // 安静模式: 不输出回显和入队提示
+static uint16_t current_tag = 0;     // 正在执行的命令的标签 (结果行带上)
+static char *error_capture = NULL; // 非空时错误信息写入此处 (带标签命令入队)
+static int32_t int_params[CMD_MAX_PARAMS]; // 正在执行的命令的整数参数
+static uint16_t exec_budget_us = CMD_EXEC_BUDGET_DEFAULT; // 每个节拍的执行预算
+
+// 交互通道至少放得下128条典型命令 (记录头加一个整数参数，如POWER CH1 SET
+// 500)，另留一条的回绕余量
+static_assert(CMD_ARENA_INTERACTIVE >=
+                  129 * (sizeof(CommandRecord_t) + sizeof(int32_t)),
+              "interactive channel holds fewer than 128 typical commands");
+
+// 按顶层命令统计执行耗时
+static CommandProfile_t profiles[main_command_count];
+
+/**
+ * @brief 顶层命令的节点下标 (编译期查找)
+ */
+static constexpr uint8_t find_top_node(const char *name) {
+  for (uint8_t i = 0; i < command_node_count; i++) {
+    if (command_index.nodes[i].parent == CMD_NODE_NONE &&
+        command_index.nodes[i].entry->hash == Commands_Hash(name)) {
+      return i;
+    }
+  }
+  return CMD_NODE_NONE;
+}
+
+// WAIT在执行器中直接处理，不调用回调
+static constexpr uint8_t wait_node = find_top_node("WAIT");
+static_assert(wait_node != CMD_NODE_NONE, "WAIT missing from main_commands");
+
+// CMD BENCH使用的典型命令行
+static const char *const bench_lines[] = {
+    "POWER CH1 SET 500", "FAN READ",   "EFFECT BREATHE 2000 80",
+    "ADC READ",          "HIST DUMP MIN 10", "EEPROM READ 0 16",
+    "HELP"};
+
+/* Private types -------------------------------------------------------------*/
+
+// 入队时解析出的命令
+typedef struct {
+  uint8_t opcode;               // 命令节点下标或CMD_OP_WAIT
+  uint8_t depth;                // 命令名占用的词数
+  uint8_t int_count;            // 已转换的整数参数个数
+  int32_t ints[CMD_MAX_PARAMS]; // 整数参数
+  uint32_t wait_ms;             // WAIT的毫秒数
+} ResolvedCommand_t;
 
 /* Private function prototypes -----------------------------------------------*/
-static char *trim_whitespace(char *str);
-static CommandStatus_t execute_command(const CommandStruct_t *cmd_table,
-                                       uint8_t cmd_count, const char *params[],
-                                       uint8_t param_count);
-static bool enqueue_command(const ParsedCommand_t *cmd);
-static bool dequeue_command(ParsedCommand_t *cmd);
+static uint8_t tokenize(const char *begin, const char *end,
+                        CommandToken_t *tokens);
+static const char *parse_tag(const char *begin, const char *end,
+                             uint16_t *tag);
+static CommandStatus_t resolve_command(const CommandToken_t *tokens,
+                                       uint8_t count, ResolvedCommand_t *out);
+static void unpack_params(const CommandRecord_t *cmd,
+                          const CommandNode_t *node, const char *params[]);
+static CommandStatus_t enqueue_command(CommandChannel_t *ch,
+                                       const CommandToken_t *tokens,
+                                       uint8_t count, uint16_t tag);
+static const CommandRecord_t *peek_command(CommandChannel_t *ch);
+static void release_command(CommandChannel_t *ch, const CommandRecord_t *cmd);
+static bool channel_ready(const CommandChannel_t *ch);
+static int8_t pick_channel(void);
+static void executor_work(uint32_t arg);
+static void wait_done(uint32_t channel);
+static void send_response(uint16_t tag, uint8_t channel,
+                          CommandStatus_t status, uint32_t latency_ms);
 
 /* Public functions ----------------------------------------------------------*/
 
@@ -88,11 +126,19 @@ static bool dequeue_command(ParsedCommand_t *cmd);
  * @brief Initialize command system
  */
 void Commands_Init(void) {
-  memset(&command_queue, 0, sizeof(CommandQueue_t));
-  command_queue.head = 0;
-  command_queue.tail = 0;
-  command_queue.count = 0;
-  command_queue.current_wait_cycles = 0;
+  for (uint8_t i = 0; i < CMD_CHANNEL_COUNT; i++) {
+    CommandChannel_t *ch = &cmd_channels[i];
+    TimerWheel_Cancel(&ch->wait);
+    ch->head = 0;
+    ch->tail = 0;
+    ch->enqueued = 0;
+    ch->executed = 0;
+    ch->waitTag = 0;
+    ch->waitLatencyMs = 0;
+    memset(&ch->stats, 0, sizeof(ch->stats));
+  }
+  rr_channel = CMD_CHANNEL_URGENT;
+  rr_credit = 0;
 
   UART_Printf("Command system initialized\r\n");
 }
@@ -100,260 +146,678 @@ void Commands_Init(void) {
 /**
  * @brief Parse and enqueue commands from input string
  * @param input Input command string (commands separated by ';')
- * @return Number of commands successfully parsed and enqueued
+ * @return Number of commands successfully parsed and enqueued (含带标签的
+ *         拒绝记录)
  */
 uint16_t Commands_Parse_And_Enqueue(const char *input) {
   if (input == NULL) {
     return 0;
   }
 
-  char input_copy[1024];
-  strncpy(input_copy, input, sizeof(input_copy) - 1);
-  input_copy[sizeof(input_copy) - 1] = '\0';
-
-  uint16_t parsed_count = 0;
-  char *token = strtok(input_copy, ";");
-
-  while (token != NULL && parsed_count < CMD_MAX_COMMANDS) {
-    token = trim_whitespace(token);
+  while (isspace((unsigned char)*input)) {
+    input++;
+  }
+  if (*input == CMD_PREFIX_URGENT) {
+    return Commands_Enqueue_Channel(CMD_CHANNEL_URGENT, input + 1);
+  }
+  if (*input == CMD_PREFIX_SCRIPT) {
+    return Commands_Enqueue_Channel(CMD_CHANNEL_SCRIPT, input + 1);
+  }
+  return Commands_Enqueue_Channel(CMD_CHANNEL_INTERACTIVE, input);
+}
 
-    if (strlen(token) > 0) {
-      ParsedCommand_t cmd;
-      memset(&cmd, 0, sizeof(ParsedCommand_t));
+/**
+ * @brief 解析命令并放入指定通道
+ * @return 成功入队的命令数 (含带标签的拒绝记录)
+ *
+ * 直接在输入缓冲区中按';'和空白分词，参数只复制一次，写入队列记录。
+ */
+uint16_t Commands_Enqueue_Channel(uint8_t channel, const char *input) {
+  if (input == NULL || channel >= CMD_CHANNEL_COUNT) {
+    return 0;
+  }
 
-      // 复制命令行 (保持原样，不在这里解析)
-      strncpy(cmd.command_line, token, CMD_MAX_COMMAND_LENGTH - 1);
-      cmd.command_line[CMD_MAX_COMMAND_LENGTH - 1] = '\0';
+  CommandChannel_t *ch = &cmd_channels[channel];
+  uint16_t parsed_count = 0;
+  bool full = false;
+  const char *segment = input;
 
-      // 参数解析将在 enqueue_command 中进行
-      cmd.param_count = 0;
+  while (true) {
+    const char *end = strchr(segment, CMD_DELIMITER);
+    if (end == NULL) {
+      end = segment + strlen(segment);
+    }
 
-      // 入队命令
-      if (enqueue_command(&cmd)) {
+    uint16_t tag = 0;
+    const char *begin = parse_tag(segment, end, &tag);
+    CommandToken_t tokens[CMD_MAX_PARAMS];
+    uint8_t count = (begin != NULL) ? tokenize(begin, end, tokens) : 0;
+
+    if (begin == NULL) {
+      Commands_Error_Printf("Request tag must be %c1-%c65535\r\n",
+                            CMD_TAG_PREFIX, CMD_TAG_PREFIX);
+    } else if (count > 0 || tag != 0) {
+      // 入队命令 (未知命令等错误已输出，带标签的随记录保存，跳过该条继续)。
+      // 队列满后同一行后面的命令都丢弃，带标签的立即应答，主机不会一直等待
+      CommandStatus_t status =
+          full ? CMD_STATUS_QUEUE_FULL
+               : enqueue_command(ch, tokens, count, tag);
+      if (status == CMD_STATUS_SUCCESS) {
         parsed_count++;
-      } else {
-        UART_Printf("Error: Command queue full\r\n");
-        break;
+      } else if (status == CMD_STATUS_QUEUE_FULL) {
+        // 放不进队列，只能立即应答 (可能早于同一通道前面命令的应答)
+        if (tag != 0) {
+          uint16_t saved_tag = current_tag;
+          current_tag = tag;
+          Commands_Error_Printf("Command queue full\r\n");
+          current_tag = saved_tag;
+          send_response(tag, channel, CMD_STATUS_QUEUE_FULL, 0);
+        } else if (!full) {
+          Commands_Error_Printf("Command queue full\r\n");
+        }
+        full = true;
+        ch->stats.dropped++;
       }
     }
 
-    token = strtok(NULL, ";");
+    if (*end == '\0') {
+      break;
+    }
+    segment = end + 1;
+  }
+
+  uint16_t depth = ch->enqueued - ch->executed;
+  if (depth > ch->stats.maxDepth) {
+    ch->stats.maxDepth = depth;
   }
 
-  UART_Printf("Parsed and enqueued %d commands\r\n", parsed_count);
+  // 紧急命令不等下一个执行节拍，在本轮主循环中执行
+  if (channel == CMD_CHANNEL_URGENT && parsed_count > 0) {
+    Deferred_Post(executor_work, 0);
+  }
+
+  if (!quiet) {
+    UART_Printf("Parsed and enqueued %d commands\r\n", parsed_count);
+  }
   return parsed_count;
 }
 
 /**
  * @brief Execute one command from the queue (called by executor loop)
  * @return Command execution status
+ *
+ * 由调度器选择通道: 紧急通道优先，其余按权重轮转。
  */
 CommandStatus_t Commands_Execute_Next(void) {
-  if (command_queue.count == 0) {
+  int8_t channel = pick_channel();
+  if (channel < 0) {
+    // 没有可执行的通道: 有积压说明都在WAIT
+    return Commands_Is_Queue_Empty() ? CMD_STATUS_QUEUE_EMPTY
+                                     : CMD_STATUS_WAITING;
+  }
+
+  CommandChannel_t *ch = &cmd_channels[channel];
+  const CommandRecord_t *cmd = peek_command(ch);
+  if (cmd == NULL) {
     return CMD_STATUS_QUEUE_EMPTY;
   }
 
-  // 检查是否在等待状态
-  if (command_queue.current_wait_cycles > 0) {
-    command_queue.current_wait_cycles--;
-    return CMD_STATUS_WAITING;
+  uint32_t enqueued_ms;
+  uint16_t tag;
+  memcpy(&enqueued_ms, &cmd->enqueued_ms, sizeof(enqueued_ms));
+  memcpy(&tag, &cmd->tag, sizeof(tag));
+  uint32_t latency = HAL_GetTick() - enqueued_ms;
+  ch->stats.latencyCount++;
+  ch->stats.latencyTotalMs += latency;
+  if (latency > ch->stats.latencyMaxMs) {
+    ch->stats.latencyMaxMs = latency;
   }
 
-  ParsedCommand_t cmd;
-  if (!dequeue_command(&cmd)) {
-    return CMD_STATUS_QUEUE_EMPTY;
+  // 入队时出错的带标签命令: 按顺序输出入队时保存的错误并应答
+  if (cmd->opcode == CMD_OP_REJECT) {
+    const uint8_t *body = (const uint8_t *)(cmd + 1);
+    CommandStatus_t status = (CommandStatus_t)body[0];
+    current_tag = tag;
+    Commands_Error_Printf("%s", (const char *)&body[1]);
+    current_tag = 0;
+    release_command(ch, cmd);
+    send_response(tag, channel, status, latency);
+    return status;
   }
 
-  // 特殊处理WAIT命令
-  if (cmd.param_count > 0 && strcmp(cmd.params[0], "WAIT") == 0) {
-    if (cmd.param_count >= 2) {
-      command_queue.current_wait_cycles = atoi(cmd.params[1]);
-      return CMD_STATUS_SUCCESS;
-    } else {
-      UART_Printf("Error: WAIT command requires cycle count\r\n");
-      return CMD_STATUS_INVALID_PARAM;
+  // WAIT命令: 毫秒数已在入队时解析和检查，由时间轮到期后继续执行该通道
+  // (带标签的WAIT到期时才应答)
+  if (cmd->opcode == CMD_OP_WAIT) {
+    uint32_t wait_ms;
+    memcpy(&wait_ms, cmd + 1, sizeof(wait_ms));
+    release_command(ch, cmd);
+    if (wait_ms > 0) {
+      ch->waitTag = tag;
+      ch->waitLatencyMs = latency;
+      TimerWheel_Start(&ch->wait, wait_ms, wait_done, channel);
+    } else if (tag != 0) {
+      send_response(tag, channel, CMD_STATUS_SUCCESS, latency);
     }
+    return CMD_STATUS_SUCCESS;
   }
 
-  // 执行普通命令
-  CommandStatus_t status =
-      execute_command(main_commands, main_command_count,
-                      (const char **)cmd.params, cmd.param_count);
+  // 执行普通命令: 按操作码调用一次回调 (参数指向队列中的记录，执行完
+  // 才释放)。POWER CHn的子命令由节点给出通道下标
+  const CommandNode_t *node = &command_index.nodes[cmd->opcode];
+  const char *params[CMD_MAX_PARAMS];
+  unpack_params(cmd, node, params);
+  if (node->channel >= 0) {
+    selected_channel = node->channel;
+  }
 
-  if (status == CMD_STATUS_UNKNOWN_COMMAND) {
-    UART_Printf("Error: Unknown command '%s'\r\n", cmd.params[0]);
+  current_tag = tag;
+  uint32_t start = DWT->CYCCNT;
+  CommandStatus_t status = node->entry->callback(params, cmd->param_count);
+  uint32_t cycles = DWT->CYCCNT - start;
+  current_tag = 0;
+
+  CommandProfile_t *profile = &profiles[node->top];
+  profile->count++;
+  profile->totalUs += cycles / (SystemCoreClock / 1000000);
+  if (cycles > profile->maxCycles) {
+    profile->maxCycles = cycles;
   }
 
+  release_command(ch, cmd);
+  if (tag != 0) {
+    send_response(tag, channel, status, latency);
+  } else if (status != CMD_STATUS_SUCCESS && !quiet) {
+    // 不带标签的命令没有应答行，出错时补一行状态
+    Commands_Error_Printf("Command execution error: %d\r\n", status);
+  }
   return status;
 }
 
 /**
  * @brief Get queue status
- * @return Number of commands in queue
+ * @return Number of commands in queue (all channels)
  */
-uint16_t Commands_Get_Queue_Count(void) { return command_queue.count; }
+uint16_t Commands_Get_Queue_Count(void) {
+  uint16_t count = 0;
+  for (uint8_t i = 0; i < CMD_CHANNEL_COUNT; i++) {
+    count += (uint16_t)(cmd_channels[i].enqueued - cmd_channels[i].executed);
+  }
+  return count;
+}
+
+/**
+ * @brief 队列已占用的字节数 (含回绕留下的空隙)
+ */
+uint16_t Commands_Get_Queue_Bytes(void) {
+  uint16_t bytes = 0;
+  for (uint8_t i = 0; i < CMD_CHANNEL_COUNT; i++) {
+    uint16_t head = cmd_channels[i].head;
+    uint16_t tail = cmd_channels[i].tail;
+    bytes += (tail >= head) ? tail - head : cmd_channels[i].size - head + tail;
+  }
+  return bytes;
+}
 
 /**
  * @brief Clear all commands in queue
  */
 void Commands_Clear_Queue(void) {
-  command_queue.head = 0;
-  command_queue.tail = 0;
-  command_queue.count = 0;
-  command_queue.current_wait_cycles = 0;
+  for (uint8_t i = 0; i < CMD_CHANNEL_COUNT; i++) {
+    CommandChannel_t *ch = &cmd_channels[i];
+    ch->head = ch->tail;
+    ch->executed = ch->enqueued;
+    TimerWheel_Cancel(&ch->wait);
+  }
 }
 
 /**
  * @brief Check if queue is empty
  * @return true if queue is empty, false otherwise
  */
-bool Commands_Is_Queue_Empty(void) { return (command_queue.count == 0); }
+bool Commands_Is_Queue_Empty(void) {
+  for (uint8_t i = 0; i < CMD_CHANNEL_COUNT; i++) {
+    if (cmd_channels[i].head != cmd_channels[i].tail) {
+      return false;
+    }
+  }
+  return true;
+}
 
 /**
- * @brief Command executor loop function (call this from timer interrupt)
+ * @brief Command executor loop function (one executor tick, main loop)
+ *
+ * 连续执行各通道的命令，直到没有可执行的命令 (都为空或在WAIT) 或用完
+ * 执行预算 (每条命令执行完后检查，至少执行一条)。紧急通道不受预算限制。
  */
 void Commands_Executor_Loop(void) {
-  CommandStatus_t status = Commands_Execute_Next();
-
-  // 为了调试，输出执行状态
-  if (status == CMD_STATUS_SUCCESS) {
-    // 成功执行，不输出（避免过多输出）
-  } else if (status == CMD_STATUS_WAITING) {
-    // 等待状态，不输出
-  } else if (status == CMD_STATUS_QUEUE_EMPTY) {
-    // 队列空，不输出
-  } else if (status == CMD_STATUS_CONTINUE_SUBCOMMAND) {
-    // 这个状态不应该出现在这里，如果出现说明逻辑有问题
-    UART_Printf("Warning: Unexpected CONTINUE_SUBCOMMAND status\r\n");
-  } else {
-    // 只在有错误时输出状态
-    UART_Printf("Command execution error: %d\r\n", status);
+  const uint32_t budget = exec_budget_us * (SystemCoreClock / 1000000);
+  uint32_t start = DWT->CYCCNT;
+  CommandStatus_t status;
+
+  do {
+    // 执行错误由Commands_Execute_Next输出 (带标签的命令在应答行中给出状态)
+    status = Commands_Execute_Next();
+  } while (status != CMD_STATUS_WAITING && status != CMD_STATUS_QUEUE_EMPTY &&
+           (DWT->CYCCNT - start < budget ||
+            channel_ready(&cmd_channels[CMD_CHANNEL_URGENT])));
+}
+
+/**
+ * @brief 每个执行节拍的时间预算
+ */
+bool Commands_Set_Budget(uint16_t us) {
+  if (us < CMD_EXEC_BUDGET_MIN || us > CMD_EXEC_BUDGET_MAX) {
+    return false;
   }
+  exec_budget_us = us;
+  return true;
 }
 
-/* Private functions ---------------------------------------------------------*/
+uint16_t Commands_Get_Budget(void) { return exec_budget_us; }
+
+/**
+ * @brief 通道状态: 名称、积压条数/字节数、WAIT剩余毫秒数、统计
+ * @return channel超出范围时返回false
+ */
+bool Commands_Get_Channel(uint8_t channel, const char **name, uint16_t *count,
+                          uint16_t *bytes, uint16_t *size, uint32_t *waitMs,
+                          CommandChannelStats_t *stats) {
+  if (channel >= CMD_CHANNEL_COUNT) {
+    return false;
+  }
+  const CommandChannel_t *ch = &cmd_channels[channel];
+  uint16_t head = ch->head;
+  uint16_t tail = ch->tail;
+
+  *name = channel_names[channel];
+  *count = (uint16_t)(ch->enqueued - ch->executed);
+  *bytes = (tail >= head) ? tail - head : ch->size - head + tail;
+  *size = ch->size;
+  *waitMs = TimerWheel_Remaining(&ch->wait);
+  *stats = ch->stats;
+  return true;
+}
+
+void Commands_Reset_Channel_Stats(void) {
+  for (uint8_t i = 0; i < CMD_CHANNEL_COUNT; i++) {
+    memset(&cmd_channels[i].stats, 0, sizeof(cmd_channels[i].stats));
+  }
+}
+
+/**
+ * @brief 按顶层命令读取执行耗时统计
+ * @return index超出命令表时返回false
+ */
+bool Commands_Get_Profile(uint8_t index, const char **name,
+                          CommandProfile_t *profile) {
+  if (index >= main_command_count) {
+    return false;
+  }
+  *name = main_commands[index].command;
+  *profile = profiles[index];
+  return true;
+}
+
+void Commands_Reset_Profile(void) { memset(profiles, 0, sizeof(profiles)); }
 
 /**
- * @brief Trim leading and trailing whitespace
- * @param str String to trim
- * @return Trimmed string
+ * @brief 正在执行的命令的整数参数 (index与params下标相同)
  */
-static char *trim_whitespace(char *str) {
-  char *end;
+int32_t Commands_Int_Param(uint8_t index) {
+  return (index < CMD_MAX_PARAMS) ? int_params[index] : 0;
+}
 
-  // Trim leading space
-  while (isspace((unsigned char)*str))
-    str++;
+/**
+ * @brief 安静模式: 不输出命令回显和入队提示
+ */
+void Commands_Set_Quiet(bool enabled) { quiet = enabled; }
 
-  if (*str == 0)
-    return str;
+bool Commands_Is_Quiet(void) { return quiet; }
 
-  // Trim trailing space
-  end = str + strlen(str) - 1;
-  while (end > str && isspace((unsigned char)*end))
-    end--;
+/* Private functions ---------------------------------------------------------*/
 
-  end[1] = '\0';
-  return str;
+/**
+ * @brief 按空白把[begin, end)分成最多CMD_MAX_PARAMS个词 (多余的丢弃)
+ * @return 词数，空命令为0
+ */
+static uint8_t tokenize(const char *begin, const char *end,
+                        CommandToken_t *tokens) {
+  uint8_t count = 0;
+  const char *p = begin;
+
+  while (count < CMD_MAX_PARAMS) {
+    while (p < end && isspace((unsigned char)*p)) {
+      p++;
+    }
+    if (p >= end) {
+      break;
+    }
+    tokens[count].text = p;
+    while (p < end && !isspace((unsigned char)*p)) {
+      p++;
+    }
+    tokens[count].length = p - tokens[count].text;
+    count++;
+  }
+  return count;
 }
 
 /**
- * @brief Execute command from command table
- * @param cmd_table Command table to search
- * @param cmd_count Number of commands in table
- * @param params Command parameters
- * @param param_count Number of parameters
- * @return Command execution status
+ * @brief 解析命令前的请求标签 (#<1-65535>，可省略)
+ * @param tag 输出标签，没有标签时为0
+ * @return 标签之后的位置，标签格式错误时返回NULL
  */
-static CommandStatus_t execute_command(const CommandStruct_t *cmd_table,
-                                       uint8_t cmd_count, const char *params[],
-                                       uint8_t param_count) {
-  if (param_count == 0) {
-    return CMD_STATUS_INVALID_PARAM;
+static const char *parse_tag(const char *begin, const char *end,
+                             uint16_t *tag) {
+  const char *p = begin;
+  while (p < end && isspace((unsigned char)*p)) {
+    p++;
+  }
+  *tag = 0;
+  if (p >= end || *p != CMD_TAG_PREFIX) {
+    return begin;
   }
 
-  // 查找命令
-  for (uint8_t i = 0; i < cmd_count; i++) {
-    if (strcmp(params[0], cmd_table[i].command) == 0) {
-      CommandStatus_t callback_status = CMD_STATUS_SUCCESS;
+  uint32_t value = 0;
+  const char *digits = ++p;
+  while (p < end && isdigit((unsigned char)*p) && value <= UINT16_MAX) {
+    value = value * 10 + (*p++ - '0');
+  }
+  if (p == digits || value == 0 || value > UINT16_MAX ||
+      (p < end && !isspace((unsigned char)*p))) {
+    return NULL;
+  }
+  *tag = value;
+  return p;
+}
 
-      // 如果有回调函数，先执行回调
-      if (cmd_table[i].callback != NULL) {
-        callback_status = cmd_table[i].callback(params, param_count);
-      }
+/**
+ * @brief 入队时把命令解析为操作码和整数参数
+ * @return 命令或子命令未知时返回UNKNOWN_COMMAND，空命令、WAIT参数或
+ *         整数参数非法时返回INVALID_PARAM (已输出错误)
+ */
+static CommandStatus_t resolve_command(const CommandToken_t *tokens,
+                                       uint8_t count, ResolvedCommand_t *out) {
+  out->opcode = CMD_NODE_NONE;
+  out->depth = 0;
+  out->int_count = 0;
+  if (count == 0) {
+    Commands_Error_Printf("Empty command\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
 
-      // 如果回调返回CONTINUE_SUBCOMMAND，且有子命令和足够参数，继续执行子命令
-      if (callback_status == CMD_STATUS_CONTINUE_SUBCOMMAND &&
-          cmd_table[i].subcommands != NULL && param_count > 1) {
-        return execute_command(cmd_table[i].subcommands,
-                               cmd_table[i].subcommand_count, &params[1],
-                               param_count - 1);
-      }
-      // 如果回调返回SUCCESS，且有子命令和足够参数，也继续执行子命令
-      else if (callback_status == CMD_STATUS_SUCCESS &&
-               cmd_table[i].subcommands != NULL && param_count > 1) {
-        return execute_command(cmd_table[i].subcommands,
-                               cmd_table[i].subcommand_count, &params[1],
-                               param_count - 1);
+  // 逐层在索引中查找，直到没有子命令的命令或参数用完
+  uint8_t node = CMD_NODE_NONE;
+  uint8_t depth = 0;
+  while (depth < count) {
+    uint8_t child =
+        Commands_Lookup(node, tokens[depth].text, tokens[depth].length);
+    if (child == CMD_NODE_NONE) {
+      if (node == CMD_NODE_NONE) {
+        Commands_Error_Printf("Unknown command '%.*s'\r\n", tokens[0].length,
+                              tokens[0].text);
+      } else {
+        Commands_Error_Printf("Unknown %s subcommand '%.*s'\r\n",
+                              command_index.nodes[node].entry->command,
+                              tokens[depth].length, tokens[depth].text);
       }
+      return CMD_STATUS_UNKNOWN_COMMAND;
+    }
+    node = child;
+    depth++;
+    if (command_index.nodes[node].entry->subcommands == NULL) {
+      break;
+    }
+  }
+  out->opcode = node;
+  out->depth = depth;
+
+  if (node == wait_node) {
+    uint32_t ms = 0;
+    bool valid = (count >= 2);
+    for (uint8_t i = 0; valid && i < tokens[1].length; i++) {
+      uint8_t digit = tokens[1].text[i] - '0';
+      valid = (digit <= 9 && ms <= (UINT32_MAX - digit) / 10);
+      ms = ms * 10 + digit;
+    }
+    if (!valid) {
+      Commands_Error_Printf("WAIT command requires milliseconds\r\n");
+      return CMD_STATUS_INVALID_PARAM;
+    }
+    out->opcode = CMD_OP_WAIT;
+    out->wait_ms = ms;
+    return CMD_STATUS_SUCCESS;
+  }
 
-      // 返回回调函数的状态（如果是错误状态，父命令已经输出了错误信息）
-      return callback_status;
+  // 命令表声明的整数参数在入队时转换，执行时不再解析字符串 (缺少的参数
+  // 由回调提示用法)
+  const CommandStruct_t *entry = command_index.nodes[node].entry;
+  for (uint8_t i = 0; i < entry->int_args && depth + i < count; i++) {
+    const CommandToken_t *token = &tokens[depth + i];
+    if (!Commands_Parse_Int(token->text, token->length, &out->ints[i])) {
+      Commands_Error_Printf("%s argument %d must be an integer\r\n",
+                            entry->command, i + 1);
+      return CMD_STATUS_INVALID_PARAM;
     }
+    out->int_count++;
+  }
+  return CMD_STATUS_SUCCESS;
+}
+
+/**
+ * @brief 还原回调使用的参数数组: params[0]取命令表中的名称，整数参数读入
+ *        int_params (params中为空串)，其余指向记录
+ */
+static void unpack_params(const CommandRecord_t *cmd,
+                          const CommandNode_t *node, const char *params[]) {
+  const uint8_t *body = (const uint8_t *)(cmd + 1);
+  uint8_t ints = cmd->param_count - 1;
+  if (ints > node->entry->int_args) {
+    ints = node->entry->int_args;
+  }
+
+  params[0] = node->entry->command;
+  for (uint8_t i = 1; i <= ints; i++) {
+    memcpy(&int_params[i], body, sizeof(int32_t));
+    body += sizeof(int32_t);
+    params[i] = "";
   }
 
-  return CMD_STATUS_UNKNOWN_COMMAND;
+  const char *text = (const char *)body;
+  for (uint8_t i = ints + 1; i < cmd->param_count; i++) {
+    params[i] = text;
+    text += strlen(text) + 1;
+  }
 }
 
 /**
- * @brief Add command to queue
- * @param cmd Command to enqueue
- * @return true if successful, false if queue is full
+ * @brief 解析命令并写入队列记录
+ * @param tokens 命令的各个词 (指向输入缓冲区)
+ * @param tag 请求标签，0为不带标签
+ * @return SUCCESS (带标签的解析失败命令存为拒绝记录，也算入队，错误随其
+ *         应答按顺序输出), QUEUE_FULL, or UNKNOWN_COMMAND/INVALID_PARAM
+ *         (不带标签，已输出错误)
  */
-static bool enqueue_command(const ParsedCommand_t *cmd) {
-  if (command_queue.count >= CMD_MAX_COMMANDS) {
-    return false;
+static CommandStatus_t enqueue_command(CommandChannel_t *ch,
+                                       const CommandToken_t *tokens,
+                                       uint8_t count, uint16_t tag) {
+  // 带标签的命令入队时的错误先存下来，轮到它执行时再按顺序输出
+  char error_text[CMD_ERROR_TEXT_MAX];
+  error_text[0] = '\0';
+  if (tag != 0) {
+    error_capture = error_text;
+  }
+
+  ResolvedCommand_t resolved;
+  CommandStatus_t status = resolve_command(tokens, count, &resolved);
+  uint8_t first_text = resolved.depth + resolved.int_count;
+  uint16_t size = sizeof(CommandRecord_t);
+  if (status != CMD_STATUS_SUCCESS) {
+    // 解析失败的命令不占用队列空间，带标签的除外 (只存状态，按顺序应答)
+    size = 0;
+  } else if (resolved.opcode == CMD_OP_WAIT) {
+    size += sizeof(resolved.wait_ms);
+  } else {
+    size += resolved.int_count * sizeof(int32_t);
+    for (uint8_t i = first_text; i < count; i++) {
+      size += tokens[i].length + 1;
+    }
+  }
+  if (size > CMD_RECORD_MAX) {
+    Commands_Error_Printf("Command too long\r\n");
+    status = CMD_STATUS_INVALID_PARAM;
+    size = 0;
+  }
+  error_capture = NULL;
+  if (size == 0) {
+    if (tag == 0) {
+      return status;
+    }
+    resolved.opcode = CMD_OP_REJECT;
+    size = sizeof(CommandRecord_t) + 1 + strlen(error_text) + 1;
   }
 
-  // 复制命令数据
-  memcpy(&command_queue.commands[command_queue.tail], cmd,
-         sizeof(ParsedCommand_t));
+  // 找一段连续空间: 末尾放不下时写回绕标记，从头开始。写入后tail
+  // 不能追上head，否则队列看起来为空
+  uint16_t head = ch->head;
+  uint16_t tail = ch->tail;
+  uint16_t start;
+  if (tail >= head) {
+    if (tail + size < ch->size || (tail + size == ch->size && head != 0)) {
+      start = tail;
+    } else if (size < head) {
+      start = 0;
+    } else {
+      return CMD_STATUS_QUEUE_FULL;
+    }
+  } else if (tail + size < head) {
+    start = tail;
+  } else {
+    return CMD_STATUS_QUEUE_FULL;
+  }
+
+  uint32_t now = HAL_GetTick();
+  CommandRecord_t *header = (CommandRecord_t *)&ch->arena[start];
+  header->size = size;
+  header->param_count =
+      (resolved.opcode < CMD_OP_WAIT) ? count - resolved.depth + 1 : 0;
+  header->opcode = resolved.opcode;
+  memcpy(&header->enqueued_ms, &now, sizeof(now));
+  memcpy(&header->tag, &tag, sizeof(tag));
+
+  uint8_t *body = (uint8_t *)(header + 1);
+  if (resolved.opcode == CMD_OP_REJECT) {
+    body[0] = status;
+    memcpy(&body[1], error_text, strlen(error_text) + 1);
+  } else if (resolved.opcode == CMD_OP_WAIT) {
+    memcpy(body, &resolved.wait_ms, sizeof(resolved.wait_ms));
+  } else {
+    memcpy(body, resolved.ints, resolved.int_count * sizeof(int32_t));
+    char *text = (char *)body + resolved.int_count * sizeof(int32_t);
+    for (uint8_t i = first_text; i < count; i++) {
+      memcpy(text, tokens[i].text, tokens[i].length);
+      text += tokens[i].length;
+      *text++ = '\0';
+    }
+  }
+  if (start != tail) {
+    ch->arena[tail] = 0; // 回绕标记
+  }
+
+  // 记录内容写完后再发布tail，执行器中断不会读到半条记录
+  __DMB();
+  uint16_t next = start + size;
+  ch->tail = (next == ch->size) ? 0 : next;
+  ch->enqueued++;
 
-  // 更新参数指针，指向新复制的命令行数据
-  char *cmd_line = command_queue.commands[command_queue.tail].command_line;
-  char *token = strtok(cmd_line, " \t");
-  uint8_t param_idx = 0;
+  return CMD_STATUS_SUCCESS;
+}
 
-  while (token != NULL && param_idx < CMD_MAX_PARAMS) {
-    command_queue.commands[command_queue.tail].params[param_idx] = token;
-    param_idx++;
-    token = strtok(NULL, " \t");
+/**
+ * @brief 取队首记录 (不出队，执行完调用release_command)
+ * @return 队列为空时返回NULL
+ */
+static const CommandRecord_t *peek_command(CommandChannel_t *ch) {
+  uint16_t head = ch->head;
+  if (head == ch->tail) {
+    return NULL;
   }
-  command_queue.commands[command_queue.tail].param_count = param_idx;
+  if (ch->arena[head] == 0) {
+    head = 0; // 回绕标记
+    ch->head = 0;
+  }
+  return (const CommandRecord_t *)&ch->arena[head];
+}
 
-  command_queue.tail = (command_queue.tail + 1) % CMD_MAX_COMMANDS;
-  command_queue.count++;
+/**
+ * @brief 释放已执行的队首记录
+ */
+static void release_command(CommandChannel_t *ch, const CommandRecord_t *cmd) {
+  uint16_t next = ((const uint8_t *)cmd - ch->arena) + cmd->size;
+  ch->head = (next == ch->size) ? 0 : next;
+  ch->executed++;
+}
 
-  return true;
+/**
+ * @brief 通道有命令且不在WAIT中
+ */
+static bool channel_ready(const CommandChannel_t *ch) {
+  return ch->head != ch->tail && !ch->wait.active;
 }
 
 /**
- * @brief Remove command from queue
- * @param cmd Pointer to store dequeued command
- * @return true if successful, false if queue is empty
+ * @brief 选择下一条命令的通道
+ * @return 通道号，没有可执行的命令时返回-1
+ *
+ * 紧急通道严格优先；其余通道轮转，每个通道连续执行不超过weight条后
+ * 让给下一个可执行的通道，暂停或为空的通道直接跳过。
  */
-static bool dequeue_command(ParsedCommand_t *cmd) {
-  if (command_queue.count == 0) {
-    return false;
+static int8_t pick_channel(void) {
+  if (channel_ready(&cmd_channels[CMD_CHANNEL_URGENT])) {
+    return CMD_CHANNEL_URGENT;
   }
 
-  memcpy(cmd, &command_queue.commands[command_queue.head],
-         sizeof(ParsedCommand_t));
+  // 多转一个通道，所有其他通道都不可执行时回到当前通道重新计数
+  for (uint8_t n = 0; n <= CMD_CHANNEL_COUNT; n++) {
+    if (rr_channel != CMD_CHANNEL_URGENT && rr_credit > 0 &&
+        channel_ready(&cmd_channels[rr_channel])) {
+      rr_credit--;
+      return rr_channel;
+    }
+    rr_channel = (rr_channel + 1) % CMD_CHANNEL_COUNT;
+    rr_credit = cmd_channels[rr_channel].weight;
+  }
+  return -1;
+}
 
-  command_queue.head = (command_queue.head + 1) % CMD_MAX_COMMANDS;
-  command_queue.count--;
+/**
+ * @brief 执行节拍 (WAIT到期和紧急命令入队时在主循环中调用)
+ */
+static void executor_work(uint32_t arg) { Commands_Executor_Loop(); }
 
-  return true;
+/**
+ * @brief WAIT到期: 应答带标签的WAIT，继续执行
+ */
+static void wait_done(uint32_t channel) {
+  CommandChannel_t *ch = &cmd_channels[channel];
+  if (ch->waitTag != 0) {
+    send_response(ch->waitTag, channel, CMD_STATUS_SUCCESS, ch->waitLatencyMs);
+    ch->waitTag = 0;
+  }
+  Commands_Executor_Loop();
+}
+
+/**
+ * @brief 带标签命令的完成应答 (key=value，一条命令一行)
+ * @param latency_ms 入队到开始执行的毫秒数
+ */
+static void send_response(uint16_t tag, uint8_t channel,
+                          CommandStatus_t status, uint32_t latency_ms) {
+  char buffer[64];
+  int length = snprintf(buffer, sizeof(buffer),
+                        "#$%%>RSP id=%u st=%d ch=%s lat=%lu\r\n", tag,
+                        status, channel_names[channel], latency_ms);
+  HAL_UART_Transmit(&huart2, (uint8_t *)buffer, length, HAL_MAX_DELAY);
 }
 
 /* Default command handlers (weak implementations) --------------------------*/
@@ -363,8 +827,8 @@ __weak CommandStatus_t Cmd_Power_Handler(const char *params[],
                                          uint8_t param_count) {
   // 如果只有一个参数（就是POWER本身），提示需要子命令
   if (param_count <= 1) {
-    UART_Printf(
-        "Error: POWER command requires subcommand (ON/OFF/CH1/CH2/FADE)\r\n");
+    Commands_Error_Printf(
+        "POWER command requires subcommand (ON/OFF/CH<n>/FADE)\r\n");
     return CMD_STATUS_INVALID_PARAM;
   }
 
@@ -387,11 +851,15 @@ __weak CommandStatus_t Cmd_Power_On_Handler(const char *params[],
   return CMD_STATUS_SUCCESS;
 }
 
-__weak CommandStatus_t Cmd_Power_Ch1_Handler(const char *params[],
-                                             uint8_t param_count) {
-  // CH1命令至少需要2个参数：CH1 SUBCOMMAND
+__weak CommandStatus_t Cmd_Power_Ch_Handler(const char *params[],
+                                            uint8_t param_count) {
+  // 带子命令时执行器直接调用子命令的回调 (通道下标由命令节点给出)，
+  // 这里只处理缺少子命令的情况
+  // CHn命令至少需要2个参数：CHn SUBCOMMAND
   if (param_count < 2) {
-    UART_Printf("Error: CH1 command requires subcommand (READ/SHOW/SET)\r\n");
+    Commands_Error_Printf("%s command requires subcommand "
+                          "(READ/SHOW/SET/FADE/LIMIT/MIX)\r\n",
+                          params[0]);
     return CMD_STATUS_INVALID_PARAM;
   }
 
@@ -399,80 +867,146 @@ __weak CommandStatus_t Cmd_Power_Ch1_Handler(const char *params[],
   return CMD_STATUS_CONTINUE_SUBCOMMAND;
 }
 
-__weak CommandStatus_t Cmd_Power_Ch2_Handler(const char *params[],
-                                             uint8_t param_count) {
-  // CH2命令至少需要2个参数：CH2 SUBCOMMAND
+__weak CommandStatus_t Cmd_Power_Ch_Read_Handler(const char *params[],
+                                                 uint8_t param_count) {
+  uint8_t ch = selected_channel;
+  Commands_Result_Printf("CH%d PWM: %d (current %d, limit %d, fade %d)\r\n",
+                         ch + 1, state.targetPWM[ch], state.currentPWM[ch],
+                         channels.limit[ch], channels.fadeStep[ch]);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Power_Ch_Set_Handler(const char *params[],
+                                                uint8_t param_count) {
+  uint8_t ch = selected_channel;
   if (param_count < 2) {
-    UART_Printf("Error: CH2 command requires subcommand (READ/SHOW/SET)\r\n");
+    Commands_Error_Printf("CH%d SET requires value parameter\r\n", ch + 1);
     return CMD_STATUS_INVALID_PARAM;
   }
 
-  // 继续执行子命令
-  return CMD_STATUS_CONTINUE_SUBCOMMAND;
-}
+  // 范围必须在0-通道上限。检查和写入之间TIM3可能切换PWM配置并换算
+  // 上限和目标，关中断保证两者用同一量程
+  int pwm_value = Commands_Int_Param(1);
+  __disable_irq();
+  uint16_t limit = channels.limit[ch];
+  bool valid = (pwm_value >= 0 && pwm_value <= limit);
+  if (valid) {
+    state.targetPWM[ch] = pwm_value;
+  }
+  __enable_irq();
+
+  if (!valid) {
+    Commands_Error_Printf("CH%d SET value must be between 0 and %d\r\n", ch + 1,
+                          limit);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("CH%d PWM set to %d\r\n", ch + 1, pwm_value);
 
-__weak CommandStatus_t Cmd_Power_Ch1_Read_Handler(const char *params[],
-                                                  uint8_t param_count) {
-  Commands_Result_Printf("CH1 PWM: %d\r\n", state.targetCh1PWM);
   return CMD_STATUS_SUCCESS;
 }
 
-__weak CommandStatus_t Cmd_Power_Ch1_Set_Handler(const char *params[],
+__weak CommandStatus_t Cmd_Power_Ch_Fade_Handler(const char *params[],
                                                  uint8_t param_count) {
+  uint8_t ch = selected_channel;
   if (param_count < 2) {
-    UART_Printf("Error: CH1 SET requires value parameter\r\n");
+    Commands_Error_Printf("CH%d FADE requires step parameter\r\n", ch + 1);
     return CMD_STATUS_INVALID_PARAM;
   }
 
-  // 范围必须在0-LED_MAX_PWM
-  uint16_t pwm_value = atoi(params[1]);
-  if (pwm_value < 0 || pwm_value > MAX_PWM) {
-    UART_Printf("Error: CH1 SET value must be between 0 and %d\r\n", MAX_PWM);
-    return CMD_STATUS_INVALID_PARAM;
+  int step = Commands_Int_Param(1);
+  __disable_irq(); // 与PWM配置切换时的换算互斥
+  uint16_t max = PwmProfile_Get_Max();
+  bool valid = (step >= 1 && step <= max);
+  if (valid) {
+    channels.fadeStep[ch] = step;
   }
+  __enable_irq();
 
-  state.targetCh1PWM = pwm_value;
-
-  Commands_Result_Printf("CH1 PWM set to %d\r\n", state.targetCh1PWM);
-
+  if (!valid) {
+    Commands_Error_Printf("FADE step must be between 1 and %d\r\n", max);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+  Commands_Result_Printf("CH%d fade step set to %d\r\n", ch + 1, step);
   return CMD_STATUS_SUCCESS;
 }
 
-__weak CommandStatus_t Cmd_Power_Ch2_Read_Handler(const char *params[],
+__weak CommandStatus_t Cmd_Power_Ch_Limit_Handler(const char *params[],
                                                   uint8_t param_count) {
-  Commands_Result_Printf("CH2 PWM: %d\r\n", state.targetCh2PWM);
+  uint8_t ch = selected_channel;
+  if (param_count < 2) {
+    Commands_Error_Printf("CH%d LIMIT requires value parameter\r\n", ch + 1);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  int limit = Commands_Int_Param(1);
+  __disable_irq(); // 与PWM配置切换时的换算互斥
+  uint16_t max = PwmProfile_Get_Max();
+  bool valid = (limit >= 0 && limit <= max);
+  if (valid) {
+    channels.limit[ch] = limit;
+  }
+  __enable_irq();
+
+  if (!valid) {
+    Commands_Error_Printf("LIMIT must be between 0 and %d\r\n", max);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+  pwm_dirty = 1;
+  settings_changed = 1;
+  Commands_Result_Printf("CH%d limit set to %d\r\n", ch + 1, limit);
   return CMD_STATUS_SUCCESS;
 }
 
-__weak CommandStatus_t Cmd_Power_Ch2_Set_Handler(const char *params[],
-                                                 uint8_t param_count) {
+__weak CommandStatus_t Cmd_Power_Ch_Mix_Handler(const char *params[],
+                                                uint8_t param_count) {
+  uint8_t ch = selected_channel;
+  if (ch < 2) {
+    Commands_Error_Printf("CH%d is a CCT channel, MIX applies to CH3/CH4\r\n",
+                          ch + 1);
+    return CMD_STATUS_INVALID_PARAM;
+  }
   if (param_count < 2) {
-    UART_Printf("Error: CH2 SET requires value parameter\r\n");
+    Commands_Error_Printf("CH%d MIX requires weight parameter\r\n", ch + 1);
     return CMD_STATUS_INVALID_PARAM;
   }
 
-  // 范围必须在0-LED_MAX_PWM
-  uint16_t pwm_value = atoi(params[1]);
-  if (pwm_value < 0 || pwm_value > MAX_PWM) {
-    UART_Printf("Error: CH2 SET value must be between 0 and %d\r\n", MAX_PWM);
+  int mix = Commands_Int_Param(1);
+  if (mix < 0 || mix > CHANNEL_MIX_TOTAL) {
+    Commands_Error_Printf("MIX must be between 0 and %d\r\n",
+                          CHANNEL_MIX_TOTAL);
     return CMD_STATUS_INVALID_PARAM;
   }
 
-  state.targetCh2PWM = pwm_value;
-
-  Commands_Result_Printf("CH2 PWM set to %d\r\n", state.targetCh2PWM);
-
+  channels.mix[ch] = mix;
+  pwm_dirty = 1;
+  settings_changed = 1;
+  Commands_Result_Printf("CH%d mix set to %d\r\n", ch + 1, mix);
   return CMD_STATUS_SUCCESS;
 }
 
 __weak CommandStatus_t Cmd_Power_Fade_Handler(const char *params[],
                                               uint8_t param_count) {
-  if (param_count >= 2) {
-    Commands_Result_Printf("Power FADE %s command executed\r\n", params[1]);
-  } else {
-    UART_Printf("Error: FADE requires value parameter\r\n");
+  if (param_count < 2) {
+    Commands_Error_Printf("FADE requires value parameter\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  int step = Commands_Int_Param(1);
+  __disable_irq(); // 与PWM配置切换时的换算互斥
+  uint16_t max = PwmProfile_Get_Max();
+  bool valid = (step >= 1 && step <= max);
+  if (valid) {
+    // 所有通道使用同一步进
+    forEachChannel([&](uint8_t ch) { channels.fadeStep[ch] = step; });
+  }
+  __enable_irq();
+
+  if (!valid) {
+    Commands_Error_Printf("FADE step must be between 1 and %d\r\n", max);
     return CMD_STATUS_INVALID_PARAM;
   }
+  Commands_Result_Printf("Fade step set to %d\r\n", step);
   return CMD_STATUS_SUCCESS;
 }
 
@@ -480,7 +1014,10 @@ __weak CommandStatus_t Cmd_Fan_Handler(const char *params[],
                                        uint8_t param_count) {
   // FAN命令至少需要2个参数：FAN SUBCOMMAND
   if (param_count < 2) {
-    UART_Printf("Error: FAN command requires subcommand (AUTO/FORCE)\r\n");
+    Commands_Error_Printf(
+        "FAN command requires subcommand "
+        "(READ/AUTO/FORCE/MODE/CURVE/HYST/PID/TACH/RPM/MINRPM/"
+        "HISTORY)\r\n");
     return CMD_STATUS_INVALID_PARAM;
   }
 
@@ -488,6 +1025,45 @@ __weak CommandStatus_t Cmd_Fan_Handler(const char *params[],
   return CMD_STATUS_CONTINUE_SUBCOMMAND;
 }
 
+__weak CommandStatus_t Cmd_Fan_Read_Handler(const char *params[],
+                                            uint8_t param_count) {
+  FanStatus_t s;
+  Fan_Get_Status(&s);
+
+  Commands_Result_Printf("Mode: %s, temp %d.%02dC\r\n",
+                         state.fanAuto ? "AUTO" : "FORCE",
+                         get_temperature_int(state.temp),
+                         get_temperature_frac(state.temp));
+  Commands_Result_Printf("Phase: %s, demand %d/1000, duty %d/1000\r\n",
+                         Fan_Phase_Name(s.phase), Fan_Duty_Permille(s.demand),
+                         Fan_Duty_Permille(s.duty));
+  Commands_Result_Printf("PWM: %d Hz, compare %d/%d\r\n", PWM_UPDATE_HZ,
+                         s.compare, s.period);
+
+  const FanConfig_t *c = Fan_Get_Config();
+  if (c->tachPulses) {
+    Commands_Result_Printf("Tach: %u RPM (%d ppr, %lu samples), min %u RPM\r\n",
+                           s.rpm, c->tachPulses, s.measurements, c->minRpm);
+    Commands_Result_Printf("Alarm: %s, LED derate %d/%d\r\n",
+                           Fan_Alarm_Name(s.alarm), s.derate, FAN_DERATE_ONE);
+  } else {
+    Commands_Result_Printf("Tach: OFF\r\n");
+  }
+
+  Commands_Result_Printf("Control: %s, hysteresis %dC, curve temp %d.%02dC\r\n",
+                         Fan_Mode_Name(c->mode), c->hysteresis,
+                         get_temperature_int(s.controlTemp),
+                         get_temperature_frac(s.controlTemp));
+  for (uint8_t i = 0; i < FAN_CURVE_POINTS; i++) {
+    Commands_Result_Printf("Curve %d: %dC -> %d/1000\r\n", i + 1,
+                           c->curveTemp[i], c->curveDuty[i]);
+  }
+  Commands_Result_Printf("PID: setpoint %dC, Kp %d, Ki %d, Kd %d\r\n",
+                         c->setpoint, c->kp, c->ki, c->kd);
+  Commands_Result_Printf("RPM target: %u\r\n", c->targetRpm);
+  return CMD_STATUS_SUCCESS;
+}
+
 __weak CommandStatus_t Cmd_Fan_Auto_Handler(const char *params[],
                                             uint8_t param_count) {
   fan_auto();
@@ -502,48 +1078,1613 @@ __weak CommandStatus_t Cmd_Fan_Force_Handler(const char *params[],
   return CMD_STATUS_SUCCESS;
 }
 
-__weak CommandStatus_t Cmd_Sleep_Handler(const char *params[],
-                                         uint8_t param_count) {
-  // 如果只有SLEEP，执行普通睡眠
-  if (param_count == 1) {
-    state.isSleeping = true;
-    state.deepSleep = false;
-    Commands_Result_Printf("Sleep command executed\r\n");
-    return CMD_STATUS_SUCCESS;
+__weak CommandStatus_t Cmd_Fan_Mode_Handler(const char *params[],
+                                            uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("FAN MODE requires CURVE, PID or RPM\r\n");
+    return CMD_STATUS_INVALID_PARAM;
   }
 
-  // 如果有子命令，继续执行
-  return CMD_STATUS_CONTINUE_SUBCOMMAND;
-}
-
-__weak CommandStatus_t Cmd_Sleep_Deep_Handler(const char *params[],
-                                              uint8_t param_count) {
-  state.isSleeping = true;
-  state.deepSleep = true;
-  Commands_Result_Printf("Deep sleep command executed\r\n");
-  return CMD_STATUS_SUCCESS;
-}
-
-__weak CommandStatus_t Cmd_Wait_Handler(const char *params[],
-                                        uint8_t param_count) {
-  // WAIT命令在Commands_Execute_Next中特殊处理
-  return CMD_STATUS_SUCCESS;
-}
+  uint8_t mode;
+  if (strcmp(params[1], "CURVE") == 0) {
+    mode = FAN_CTRL_CURVE;
+  } else if (strcmp(params[1], "PID") == 0) {
+    mode = FAN_CTRL_PID;
+  } else if (strcmp(params[1], "RPM") == 0) {
+    mode = FAN_CTRL_RPM;
+  } else {
+    Commands_Error_Printf("FAN MODE must be CURVE, PID or RPM\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
 
-__weak CommandStatus_t Cmd_Reboot_Handler(const char *params[],
-                                          uint8_t param_count) {
+  if (!Fan_Set_Mode(mode)) {
+    Commands_Error_Printf("RPM mode requires FAN TACH first\r\n");
+    return CMD_STATUS_ERROR;
+  }
+  Commands_Result_Printf("Fan control %s\r\n", Fan_Mode_Name(mode));
   return CMD_STATUS_SUCCESS;
 }
 
-__weak CommandStatus_t Cmd_Eeprom_Handler(const char *params[],
-                                          uint8_t param_count) {
-  // EEPROM命令至少需要2个参数：EEPROM SUBCOMMAND
-  if (param_count < 2) {
-    UART_Printf("Error: EEPROM command requires subcommand (READ/WRITE)\r\n");
+__weak CommandStatus_t Cmd_Fan_Curve_Handler(const char *params[],
+                                             uint8_t param_count) {
+  if (param_count < 4) {
+    Commands_Error_Printf(
+        "FAN CURVE requires <point> <temp C> <duty/1000>\r\n");
     return CMD_STATUS_INVALID_PARAM;
   }
 
-  // 继续执行子命令
+  int point = Commands_Int_Param(1);
+  int temp = Commands_Int_Param(2);
+  int duty = Commands_Int_Param(3);
+  if (point < 1 || point > FAN_CURVE_POINTS) {
+    Commands_Error_Printf("Curve point must be between 1 and %d\r\n",
+                          FAN_CURVE_POINTS);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+  if (duty < 0 || duty > FAN_PERMILLE_FULL) {
+    Commands_Error_Printf("Duty must be between 0 and %d\r\n",
+                          FAN_PERMILLE_FULL);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  // 节点温度必须在0..上限之间且不小于前一节点、不大于后一节点
+  if (temp < 0 || temp > FAN_TEMP_LIMIT ||
+      !Fan_Set_Curve_Point(point - 1, temp, duty)) {
+    Commands_Error_Printf("Curve temp must be 0-%dC, between neighbouring "
+                          "points\r\n",
+                          FAN_TEMP_LIMIT);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("Curve point %d set to %dC -> %d/1000\r\n", point,
+                         temp, duty);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Fan_Hyst_Handler(const char *params[],
+                                            uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("FAN HYST requires a value (C)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  int hyst = Commands_Int_Param(1);
+  if (hyst < 0 || hyst > FAN_HYST_MAX) {
+    Commands_Error_Printf("Hysteresis must be between 0 and %d\r\n",
+                          FAN_HYST_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Fan_Set_Hysteresis(hyst);
+  Commands_Result_Printf("Fan hysteresis set to %dC\r\n", hyst);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Fan_Pid_Handler(const char *params[],
+                                           uint8_t param_count) {
+  if (param_count < 5) {
+    Commands_Error_Printf("FAN PID requires <setpoint C> <kp> <ki> <kd>\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  int setpoint = Commands_Int_Param(1);
+  long kp = Commands_Int_Param(2);
+  long ki = Commands_Int_Param(3);
+  long kd = Commands_Int_Param(4);
+  if (setpoint < 0 || setpoint > FAN_TEMP_LIMIT) {
+    Commands_Error_Printf("Setpoint must be between 0 and %d\r\n",
+                          FAN_TEMP_LIMIT);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+  if (kp < 0 || ki < 0 || kd < 0 || kp > FAN_PID_GAIN_MAX ||
+      ki > FAN_PID_GAIN_MAX || kd > FAN_PID_GAIN_MAX) {
+    Commands_Error_Printf("Gains must be between 0 and %d\r\n",
+                          FAN_PID_GAIN_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Fan_Set_Pid(setpoint, kp, ki, kd);
+  Commands_Result_Printf("PID set: %dC, Kp %ld, Ki %ld, Kd %ld\r\n", setpoint,
+                         kp, ki, kd);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Fan_Tach_Handler(const char *params[],
+                                            uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("FAN TACH requires pulses per rev (1-%d) or OFF\r\n",
+                          FAN_TACH_PPR_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  bool off = strcmp(params[1], "OFF") == 0;
+  int pulses = off ? 0 : atoi(params[1]);
+  if ((!off && pulses < 1) || !Fan_Set_Tach(pulses)) {
+    Commands_Error_Printf("FAN TACH must be 1-%d or OFF\r\n", FAN_TACH_PPR_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  if (pulses) {
+    Commands_Result_Printf("Fan tach ON, %d pulses/rev\r\n", pulses);
+  } else {
+    Commands_Result_Printf("Fan tach OFF\r\n");
+  }
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Fan_Rpm_Handler(const char *params[],
+                                           uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("FAN RPM requires a target\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  long target = Commands_Int_Param(1);
+  if (target < 0 || !Fan_Set_Target_Rpm(target)) {
+    Commands_Error_Printf("Target must be between 0 and %d\r\n", FAN_RPM_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("Fan target set to %ld RPM\r\n", target);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Fan_Minrpm_Handler(const char *params[],
+                                              uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("FAN MINRPM requires a value (0=off)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  long minimum = Commands_Int_Param(1);
+  if (minimum < 0 || !Fan_Set_Min_Rpm(minimum)) {
+    Commands_Error_Printf("Minimum must be between 0 and %d\r\n", FAN_RPM_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("Fan under-speed limit set to %ld RPM\r\n", minimum);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Fan_History_Handler(const char *params[],
+                                               uint8_t param_count) {
+  uint16_t rpm[FAN_RPM_HISTORY];
+  uint8_t count = Fan_Get_History(rpm, FAN_RPM_HISTORY);
+  if (count == 0) {
+    Commands_Result_Printf("No RPM history\r\n");
+    return CMD_STATUS_SUCCESS;
+  }
+
+  // 每行10个点，最早的在前
+  Commands_Result_Printf("RPM history, 1 s/point, %d points:\r\n", count);
+  for (uint8_t i = 0; i < count; i += 10) {
+    char line[64];
+    int len = 0;
+    for (uint8_t j = i; j < count && j < i + 10; j++) {
+      len += snprintf(line + len, sizeof(line) - len, "%u ", rpm[j]);
+    }
+    Commands_Result_Printf("%s\r\n", line);
+  }
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Color_Handler(const char *params[],
+                                         uint8_t param_count) {
+  // COLOR命令至少需要2个参数：COLOR SUBCOMMAND
+  if (param_count < 2) {
+    Commands_Error_Printf("COLOR command requires subcommand "
+                          "(READ/MODE/DUV/XY/FLUX)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  return CMD_STATUS_CONTINUE_SUBCOMMAND;
+}
+
+__weak CommandStatus_t Cmd_Color_Read_Handler(const char *params[],
+                                              uint8_t param_count) {
+  uint16_t tx, ty, x, y, cct;
+  int16_t duv;
+  Color_TargetXY(state.colorTemp, color_cal.duv, &tx, &ty);
+  Color_Evaluate(state.targetPWM, &x, &y, &cct, &duv);
+
+  Commands_Result_Printf("Mode: %s%s\r\n",
+                         color_cal.mode == COLOR_MODE_CIE ? "CIE" : "MIRED",
+                         (color_cal.mode == COLOR_MODE_CIE && !Color_Enabled())
+                             ? " (inactive)"
+                             : "");
+  Commands_Result_Printf("Target: %dK Duv %d xy %d,%d\r\n", state.colorTemp,
+                         color_cal.duv, tx, ty);
+  Commands_Result_Printf("Actual: %dK Duv %d xy %d,%d\r\n", cct, duv, x, y);
+  forEachChannel([](uint8_t ch) {
+    Commands_Result_Printf("CH%d xy %d,%d flux %d\r\n", ch + 1,
+                           color_cal.x[ch], color_cal.y[ch],
+                           color_cal.flux[ch]);
+  });
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Color_Mode_Handler(const char *params[],
+                                              uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("COLOR MODE requires CIE or MIRED\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  if (strcmp(params[1], "CIE") == 0) {
+    color_cal.mode = COLOR_MODE_CIE;
+  } else if (strcmp(params[1], "MIRED") == 0) {
+    color_cal.mode = COLOR_MODE_MIRED;
+  } else {
+    Commands_Error_Printf("COLOR MODE must be CIE or MIRED\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Color_Invalidate();
+  Commands_Result_Printf("Color mode set to %s\r\n", params[1]);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Color_Duv_Handler(const char *params[],
+                                             uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("COLOR DUV requires value parameter\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  int duv = Commands_Int_Param(1);
+  if (duv < -COLOR_DUV_LIMIT || duv > COLOR_DUV_LIMIT) {
+    Commands_Error_Printf("DUV must be between %d and %d (x10000)\r\n",
+                          -COLOR_DUV_LIMIT, COLOR_DUV_LIMIT);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  color_cal.duv = duv;
+  Color_Invalidate();
+  Commands_Result_Printf("Target Duv set to %d\r\n", duv);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Color_XY_Handler(const char *params[],
+                                            uint8_t param_count) {
+  if (param_count < 4) {
+    Commands_Error_Printf("COLOR XY requires <ch> <x> <y> (x10000)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  int ch = Commands_Int_Param(1);
+  int x = Commands_Int_Param(2);
+  int y = Commands_Int_Param(3);
+  if (ch < 1 || ch > LED_CHANNEL_COUNT) {
+    Commands_Error_Printf("Channel must be between 1 and %d\r\n",
+                          LED_CHANNEL_COUNT);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+  if (x <= 0 || y <= 0 || x + y >= COLOR_XY_SCALE) {
+    Commands_Error_Printf("xy must satisfy 0 < x,y and x+y < %d\r\n",
+                          COLOR_XY_SCALE);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  color_cal.x[ch - 1] = x;
+  color_cal.y[ch - 1] = y;
+  Color_Invalidate();
+  Commands_Result_Printf("CH%d chromaticity set to %d,%d\r\n", ch, x, y);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Color_Flux_Handler(const char *params[],
+                                              uint8_t param_count) {
+  if (param_count < 3) {
+    Commands_Error_Printf("COLOR FLUX requires <ch> <lm>\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  int ch = Commands_Int_Param(1);
+  long flux = Commands_Int_Param(2);
+  if (ch < 1 || ch > LED_CHANNEL_COUNT) {
+    Commands_Error_Printf("Channel must be between 1 and %d\r\n",
+                          LED_CHANNEL_COUNT);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+  if (flux < 0 || flux > UINT16_MAX) {
+    Commands_Error_Printf("FLUX must be between 0 and %d\r\n", UINT16_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  color_cal.flux[ch - 1] = flux;
+  Color_Invalidate();
+  Commands_Result_Printf("CH%d flux set to %ld lm\r\n", ch, flux);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Effect_Handler(const char *params[],
+                                          uint8_t param_count) {
+  // EFFECT命令至少需要2个参数：EFFECT SUBCOMMAND
+  if (param_count < 2) {
+    Commands_Error_Printf("EFFECT command requires subcommand "
+                          "(OFF/READ/BREATHE/CANDLE/STROBE)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  return CMD_STATUS_CONTINUE_SUBCOMMAND;
+}
+
+/**
+ * @brief 解析可选的深度参数 (0-EFFECT_GAIN_ONE)
+ */
+static bool parse_effect_depth(uint8_t param_count, uint8_t index,
+                               uint16_t *depth) {
+  if (param_count <= index) {
+    return true; // 未指定时保持原值
+  }
+  int value = Commands_Int_Param(index);
+  if (value < 0 || value > EFFECT_GAIN_ONE) {
+    Commands_Error_Printf("Effect depth must be between 0 and %d\r\n",
+                          EFFECT_GAIN_ONE);
+    return false;
+  }
+  *depth = value;
+  return true;
+}
+
+__weak CommandStatus_t Cmd_Effect_Off_Handler(const char *params[],
+                                              uint8_t param_count) {
+  EffectConfig_t config = effect;
+  config.type = EFFECT_NONE;
+  Effects_Set(&config);
+  Commands_Result_Printf("Effect stopped\r\n");
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Effect_Read_Handler(const char *params[],
+                                               uint8_t param_count) {
+  uint32_t cycles_per_us = SystemCoreClock / 1000000;
+  Commands_Result_Printf("Effect: %s depth %d period %dms step %dms "
+                         "pattern 0x%04X speed %d\r\n",
+                         Effects_Name(effect.type), effect.depth,
+                         effect.period, effect.step, effect.pattern,
+                         effect.speed);
+  Commands_Result_Printf("Cost: last %lu max %lu cycles (max %lu us)\r\n",
+                         Effects_Get_Last_Cycles(), Effects_Get_Max_Cycles(),
+                         Effects_Get_Max_Cycles() / cycles_per_us);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Effect_Breathe_Handler(const char *params[],
+                                                  uint8_t param_count) {
+  EffectConfig_t config = effect;
+  if (param_count >= 2) {
+    int period = Commands_Int_Param(1);
+    if (period < EFFECT_PERIOD_MIN_MS || period > EFFECT_PERIOD_MAX_MS) {
+      Commands_Error_Printf("BREATHE period must be between %d and %d ms\r\n",
+                            EFFECT_PERIOD_MIN_MS, EFFECT_PERIOD_MAX_MS);
+      return CMD_STATUS_INVALID_PARAM;
+    }
+    config.period = period;
+  }
+  if (!parse_effect_depth(param_count, 2, &config.depth)) {
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  config.type = EFFECT_BREATHE;
+  Effects_Set(&config);
+  Commands_Result_Printf("Breathe: period %dms depth %d\r\n", config.period,
+                         config.depth);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Effect_Candle_Handler(const char *params[],
+                                                 uint8_t param_count) {
+  EffectConfig_t config = effect;
+  if (!parse_effect_depth(param_count, 1, &config.depth)) {
+    return CMD_STATUS_INVALID_PARAM;
+  }
+  if (param_count >= 3) {
+    int speed = Commands_Int_Param(2);
+    if (speed < 1 || speed > EFFECT_CANDLE_SPEED_MAX) {
+      Commands_Error_Printf("CANDLE speed must be between 1 and %d\r\n",
+                            EFFECT_CANDLE_SPEED_MAX);
+      return CMD_STATUS_INVALID_PARAM;
+    }
+    config.speed = speed;
+  }
+
+  config.type = EFFECT_CANDLE;
+  Effects_Set(&config);
+  Commands_Result_Printf("Candle: depth %d speed %d\r\n", config.depth,
+                         config.speed);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Effect_Strobe_Handler(const char *params[],
+                                                 uint8_t param_count) {
+  EffectConfig_t config = effect;
+  if (param_count >= 2) {
+    int step = Commands_Int_Param(1);
+    if (step < EFFECT_STROBE_STEP_MIN_MS || step > EFFECT_STROBE_STEP_MAX_MS) {
+      Commands_Error_Printf("STROBE step must be between %d and %d ms\r\n",
+                            EFFECT_STROBE_STEP_MIN_MS,
+                            EFFECT_STROBE_STEP_MAX_MS);
+      return CMD_STATUS_INVALID_PARAM;
+    }
+    config.step = step;
+  }
+  if (param_count >= 3) {
+    // 图样支持0x前缀的十六进制 (入队时已转换)
+    int32_t pattern = Commands_Int_Param(2);
+    if (pattern <= 0 || pattern > 0xFFFF) {
+      Commands_Error_Printf("STROBE pattern must be 16-bit and non-zero\r\n");
+      return CMD_STATUS_INVALID_PARAM;
+    }
+    config.pattern = pattern;
+  }
+  if (!parse_effect_depth(param_count, 3, &config.depth)) {
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  config.type = EFFECT_STROBE;
+  Effects_Set(&config);
+  Commands_Result_Printf("Strobe: step %dms pattern 0x%04X depth %d\r\n",
+                         config.step, config.pattern, config.depth);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Preset_Handler(const char *params[],
+                                          uint8_t param_count) {
+  // PRESET命令至少需要2个参数：PRESET SUBCOMMAND
+  if (param_count < 2) {
+    Commands_Error_Printf("PRESET command requires subcommand "
+                          "(RECALL/STORE/READ/FADE)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  return CMD_STATUS_CONTINUE_SUBCOMMAND;
+}
+
+/**
+ * @brief 解析预设编号 (1-PRESET_COUNT)，返回下标，失败返回-1
+ */
+static int parse_preset_index(const char *params[], uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("%s requires preset number\r\n", params[0]);
+    return -1;
+  }
+  int n = Commands_Int_Param(1);
+  if (n < 1 || n > PRESET_COUNT) {
+    Commands_Error_Printf("Preset must be between 1 and %d\r\n", PRESET_COUNT);
+    return -1;
+  }
+  return n - 1;
+}
+
+__weak CommandStatus_t Cmd_Preset_Recall_Handler(const char *params[],
+                                                 uint8_t param_count) {
+  int index = parse_preset_index(params, param_count);
+  if (index < 0) {
+    return CMD_STATUS_INVALID_PARAM;
+  }
+  if (!Presets_Recall(index)) {
+    Commands_Error_Printf("Preset %d is empty\r\n", index + 1);
+    return CMD_STATUS_ERROR;
+  }
+
+  Commands_Result_Printf("Preset %d recalled\r\n", index + 1);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Preset_Store_Handler(const char *params[],
+                                                uint8_t param_count) {
+  int index = parse_preset_index(params, param_count);
+  if (index < 0) {
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Presets_Store(index);
+  Commands_Result_Printf("Preset %d stored: %dK brightness %d\r\n",
+                         index + 1, state.colorTemp, state.brightness);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Preset_Read_Handler(const char *params[],
+                                               uint8_t param_count) {
+  Commands_Result_Printf("Active: %d, fade %dms\r\n",
+                         Presets_Get_Active() + 1, Presets_Get_Fade());
+  for (uint8_t i = 0; i < PRESET_COUNT; i++) {
+    const Preset_t *p = Presets_Get(i);
+    if (!p->used) {
+      continue;
+    }
+    const uint16_t *target = Presets_Get_Target(i);
+    Commands_Result_Printf("P%d %dK bri %d fan %s effect %s pwm %d,%d\r\n",
+                           i + 1, p->colorTemp, p->brightness,
+                           p->fanAuto ? "AUTO" : "FORCE",
+                           Effects_Name(p->effectType), target[0], target[1]);
+  }
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Preset_Fade_Handler(const char *params[],
+                                               uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("PRESET FADE requires time in ms\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  int ms = Commands_Int_Param(1);
+  if (ms < 0 || ms > PRESET_FADE_MS_MAX) {
+    Commands_Error_Printf("PRESET FADE must be between 0 and %d ms\r\n",
+                          PRESET_FADE_MS_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Presets_Set_Fade(ms);
+  Commands_Result_Printf("Preset crossfade set to %dms\r\n", ms);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Pwm_Handler(const char *params[],
+                                       uint8_t param_count) {
+  // PWM命令至少需要2个参数：PWM SUBCOMMAND
+  if (param_count < 2) {
+    Commands_Error_Printf("PWM command requires subcommand (READ/PROFILE)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  return CMD_STATUS_CONTINUE_SUBCOMMAND;
+}
+
+__weak CommandStatus_t Cmd_Pwm_Read_Handler(const char *params[],
+                                            uint8_t param_count) {
+  uint8_t active = PwmProfile_Get_Active();
+  for (uint8_t i = 0; i < PWM_PROFILE_COUNT; i++) {
+    const PwmProfile_t *p = PwmProfile_Get(i);
+    Commands_Result_Printf("%c %-5s %lu Hz, %u steps (PSC %u, ARR %u)\r\n",
+                           i == active ? '*' : ' ', p->name,
+                           PwmProfile_Frequency(i), p->period + 1,
+                           p->prescaler, p->period);
+  }
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Pwm_Profile_Handler(const char *params[],
+                                               uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("PWM PROFILE requires profile name\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  for (uint8_t i = 0; i < PWM_PROFILE_COUNT; i++) {
+    if (strcmp(params[1], PwmProfile_Get(i)->name) == 0) {
+      PwmProfile_Select(i);
+      settings_changed = 1;
+      Commands_Result_Printf("PWM profile %s (%lu Hz)\r\n", params[1],
+                             PwmProfile_Frequency(i));
+      return CMD_STATUS_SUCCESS;
+    }
+  }
+
+  Commands_Error_Printf("Unknown PWM profile (STD/VIDEO/HIRES)\r\n");
+  return CMD_STATUS_INVALID_PARAM;
+}
+
+__weak CommandStatus_t Cmd_Lumen_Handler(const char *params[],
+                                         uint8_t param_count) {
+  // LUMEN命令至少需要2个参数：LUMEN SUBCOMMAND
+  if (param_count < 2) {
+    Commands_Error_Printf("LUMEN command requires subcommand "
+                          "(READ/COMP/CURVE/RESET)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  return CMD_STATUS_CONTINUE_SUBCOMMAND;
+}
+
+__weak CommandStatus_t Cmd_Lumen_Read_Handler(const char *params[],
+                                              uint8_t param_count) {
+  Commands_Result_Printf("Compensation: %s, temp factor %d/%d\r\n",
+                         lumen.enabled ? "ON" : "OFF", Lumen_Get_Temp_Factor(),
+                         LUMEN_TEMP_ONE);
+  forEachChannel([](uint8_t ch) {
+    uint32_t seconds = lumen.seconds[ch];
+    Commands_Result_Printf("CH%d %lu.%02lu h output %d gain %d\r\n", ch + 1,
+                           seconds / 3600, (seconds % 3600) * 100 / 3600,
+                           Lumen_Output_At(seconds / 3600), channels.gain[ch]);
+  });
+  for (uint8_t i = 0; i < LUMEN_CURVE_POINTS; i++) {
+    Commands_Result_Printf("Curve %d: %lu h -> %d\r\n", i + 1,
+                           lumen.curveHours[i], lumen.curveOutput[i]);
+  }
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Lumen_Comp_Handler(const char *params[],
+                                              uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("LUMEN COMP requires ON or OFF\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  if (strcmp(params[1], "ON") == 0) {
+    lumen.enabled = 1;
+  } else if (strcmp(params[1], "OFF") == 0) {
+    lumen.enabled = 0;
+  } else {
+    Commands_Error_Printf("LUMEN COMP must be ON or OFF\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Lumen_Invalidate();
+  Commands_Result_Printf("Lumen compensation %s\r\n", params[1]);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Lumen_Curve_Handler(const char *params[],
+                                               uint8_t param_count) {
+  if (param_count < 4) {
+    Commands_Error_Printf("LUMEN CURVE requires <point> <hours> <output>\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  int point = Commands_Int_Param(1);
+  long hours = Commands_Int_Param(2);
+  int output = Commands_Int_Param(3);
+  if (point < 1 || point > LUMEN_CURVE_POINTS) {
+    Commands_Error_Printf("Curve point must be between 1 and %d\r\n",
+                          LUMEN_CURVE_POINTS);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+  if (output < LUMEN_OUTPUT_MIN || output > LUMEN_OUTPUT_FULL) {
+    Commands_Error_Printf("Output must be between %d and %d\r\n",
+                          LUMEN_OUTPUT_MIN, LUMEN_OUTPUT_FULL);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  // 节点小时数必须严格递增
+  uint8_t i = point - 1;
+  if (hours < 0 || (i > 0 && (uint32_t)hours <= lumen.curveHours[i - 1]) ||
+      (i < LUMEN_CURVE_POINTS - 1 &&
+       (uint32_t)hours >= lumen.curveHours[i + 1])) {
+    Commands_Error_Printf(
+        "Curve hours must be between neighbouring points\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  lumen.curveHours[i] = hours;
+  lumen.curveOutput[i] = output;
+  Lumen_Invalidate();
+  Commands_Result_Printf("Curve point %d set to %ld h -> %d\r\n", point,
+                         hours, output);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Lumen_Reset_Handler(const char *params[],
+                                               uint8_t param_count) {
+  uint8_t ch = 0xFF;
+  if (param_count >= 2) {
+    int n = Commands_Int_Param(1);
+    if (n < 1 || n > LED_CHANNEL_COUNT) {
+      Commands_Error_Printf("Channel must be between 1 and %d\r\n",
+                            LED_CHANNEL_COUNT);
+      return CMD_STATUS_INVALID_PARAM;
+    }
+    ch = n - 1;
+  }
+
+  Lumen_Reset(ch);
+  if (ch == 0xFF) {
+    Commands_Result_Printf("Drive hours reset (all)\r\n");
+  } else {
+    Commands_Result_Printf("Drive hours reset (%d)\r\n", ch + 1);
+  }
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Reg_Handler(const char *params[],
+                                       uint8_t param_count) {
+  // REG命令至少需要2个参数：REG SUBCOMMAND
+  if (param_count < 2) {
+    Commands_Error_Printf("REG command requires subcommand "
+                          "(READ/MODE/SET/HOLD)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  return CMD_STATUS_CONTINUE_SUBCOMMAND;
+}
+
+__weak CommandStatus_t Cmd_Reg_Read_Handler(const char *params[],
+                                            uint8_t param_count) {
+  if (!devices.extern_adc) {
+    Commands_Error_Printf("Power monitor not available\r\n");
+    return CMD_STATUS_ERROR;
+  }
+
+  const RegulatorTelemetry_t *t = Regulator_Get_Telemetry();
+  uint8_t mode = Regulator_Get_Mode();
+  const char *unit = (mode == REG_MODE_CURRENT) ? "mA" : "mW";
+  Commands_Result_Printf("Monitor: %s %u mV %ld mA %lu mW\r\n",
+                         power_monitor.getTypeName(), t->busMillivolts,
+                         t->currentMilliamps, t->powerMilliwatts);
+  Commands_Result_Printf("Mode: %s, setpoint %lu %s, gain %d/%d\r\n",
+                         Regulator_Mode_Name(mode), Regulator_Get_Setpoint(),
+                         unit, Regulator_Get_Gain(), REG_GAIN_ONE);
+  Commands_Result_Printf("Loop: %d Hz, error %ld %s (%d/1000), peak %d/1000\r\n",
+                         t->loopRate, t->error, unit, t->errorPermille,
+                         t->peakPermille);
+  if (t->settled) {
+    Commands_Result_Printf("Settled in %lu ms\r\n", t->settleMs);
+  } else {
+    Commands_Result_Printf("Settling\r\n");
+  }
+  Commands_Result_Printf("Samples: %lu, I2C errors: %lu%s\r\n",
+                         power_monitor.getSampleCount(),
+                         power_monitor.getErrorCount(),
+                         t->fault ? ", SENSOR TIMEOUT (open loop)" : "");
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Reg_Mode_Handler(const char *params[],
+                                            uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("REG MODE requires OFF, CP or CC\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  uint8_t mode;
+  if (strcmp(params[1], "OFF") == 0) {
+    mode = REG_MODE_OFF;
+  } else if (strcmp(params[1], "CP") == 0) {
+    mode = REG_MODE_POWER;
+  } else if (strcmp(params[1], "CC") == 0) {
+    mode = REG_MODE_CURRENT;
+  } else {
+    Commands_Error_Printf("REG MODE must be OFF, CP or CC\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  if (!Regulator_Set_Mode(mode)) {
+    Commands_Error_Printf("Power monitor not available\r\n");
+    return CMD_STATUS_ERROR;
+  }
+  Commands_Result_Printf("Regulation mode %s\r\n", Regulator_Mode_Name(mode));
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Reg_Set_Handler(const char *params[],
+                                           uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("REG SET requires a value (mW in CP, mA in CC)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+  if (Regulator_Get_Mode() == REG_MODE_OFF) {
+    Commands_Error_Printf("Select REG MODE CP or CC first\r\n");
+    return CMD_STATUS_ERROR;
+  }
+
+  long value = Commands_Int_Param(1);
+  if (value < 1 || value > REG_SETPOINT_MAX) {
+    Commands_Error_Printf("Setpoint must be between 1 and %d\r\n",
+                          REG_SETPOINT_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Regulator_Set_Setpoint(value);
+  Commands_Result_Printf("Setpoint set to %ld\r\n", value);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Reg_Hold_Handler(const char *params[],
+                                            uint8_t param_count) {
+  if (!Regulator_Hold()) {
+    Commands_Error_Printf("No valid measurement (select CP/CC, light on)\r\n");
+    return CMD_STATUS_ERROR;
+  }
+
+  Commands_Result_Printf("Setpoint set to %lu\r\n", Regulator_Get_Setpoint());
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Latency_Handler(const char *params[],
+                                           uint8_t param_count) {
+  // LATENCY命令至少需要2个参数：LATENCY SUBCOMMAND
+  if (param_count < 2) {
+    Commands_Error_Printf("LATENCY command requires subcommand "
+                          "(READ/FAST/RESET)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  return CMD_STATUS_CONTINUE_SUBCOMMAND;
+}
+
+__weak CommandStatus_t Cmd_Latency_Read_Handler(const char *params[],
+                                                uint8_t param_count) {
+  // 命令在主循环中执行，关中断拷贝，避免编码器中断在拷贝过程中修改统计
+  __disable_irq();
+  LatencyStats_t s = *Latency_Get_Stats();
+  __enable_irq();
+  uint32_t cycles_per_us = SystemCoreClock / 1000000;
+
+  Commands_Result_Printf("Fast path: %s\r\n",
+                         Latency_Fast_Path() ? "ON" : "OFF");
+  if (s.count == 0) {
+    Commands_Result_Printf("No samples, turn the encoder\r\n");
+    return CMD_STATUS_SUCCESS;
+  }
+
+  uint32_t avg = (uint32_t)(s.sumCycles / s.count);
+  Commands_Result_Printf("Samples: %lu\r\n", s.count);
+  Commands_Result_Printf("Edge->CCR: min %lu us, avg %lu us, max %lu us\r\n",
+                         s.minCycles / cycles_per_us, avg / cycles_per_us,
+                         s.maxCycles / cycles_per_us);
+  Commands_Result_Printf("(+ up to %lu us until the next PWM period)\r\n",
+                         1000000 /
+                             PwmProfile_Frequency(PwmProfile_Get_Active()));
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Latency_Fast_Handler(const char *params[],
+                                                uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("LATENCY FAST requires ON or OFF\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  if (strcmp(params[1], "ON") == 0) {
+    Latency_Set_Fast_Path(true);
+  } else if (strcmp(params[1], "OFF") == 0) {
+    Latency_Set_Fast_Path(false);
+  } else {
+    Commands_Error_Printf("LATENCY FAST must be ON or OFF\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("Fast path %s, statistics cleared\r\n", params[1]);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Latency_Reset_Handler(const char *params[],
+                                                 uint8_t param_count) {
+  Latency_Reset();
+  Commands_Result_Printf("Latency statistics cleared\r\n");
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Adc_Handler(const char *params[],
+                                       uint8_t param_count) {
+  // ADC命令至少需要2个参数：ADC SUBCOMMAND
+  if (param_count < 2) {
+    Commands_Error_Printf("ADC command requires subcommand "
+                          "(READ/BENCH/POINT/TRIP/CLEAR)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  return CMD_STATUS_CONTINUE_SUBCOMMAND;
+}
+
+__weak CommandStatus_t Cmd_Adc_Read_Handler(const char *params[],
+                                            uint8_t param_count) {
+  AnalogStatus_t s;
+  Analog_Get_Status(&s);
+  uint32_t rate = Analog_Sample_Rate();
+
+  Commands_Result_Printf("Trigger: %s, %lu Hz\r\n", Analog_Trigger_Name(),
+                         rate);
+  Commands_Result_Printf("NTC: %lu Hz, %ux oversampling\r\n",
+                         rate * ANALOG_NTC_PER_SEQ / ANALOG_SEQ_LENGTH,
+                         ANALOG_OVERSAMPLE);
+  Commands_Result_Printf("Output: %u bits, %lu Hz\r\n",
+                         12 + ANALOG_EXTRA_BITS, rate / ANALOG_BLOCK_SIZE);
+  const AnalogConfig_t *c = Analog_Get_Config();
+  if (Analog_Point_Adjustable()) {
+    if (c->samplePoint == ANALOG_POINT_PHASE) {
+      Commands_Result_Printf("Sample point: PHASE %u/1000", c->samplePhase);
+    } else {
+      Commands_Result_Printf("Sample point: %s",
+                             Analog_Point_Name(c->samplePoint));
+    }
+    Commands_Result_Printf(", trigger %u/%u, window %u\r\n", s.trigger,
+                           s.period, s.window);
+  } else {
+    Commands_Result_Printf("Sample point: fixed at CH1 edge\r\n");
+  }
+  Commands_Result_Printf("Raw: %u, filtered: %u (max %u)\r\n", s.raw,
+                         s.filtered, ANALOG_RAW_MAX);
+  Commands_Result_Printf("Temperature: %d.%02d C\r\n",
+                         get_temperature_int(state.temp),
+                         get_temperature_frac(state.temp));
+  Commands_Result_Printf("Supply: %u mV (VREFINT %u, compensation %s)\r\n",
+                         s.supplyMv, s.vrefint,
+                         ANALOG_SUPPLY_COMP ? "ON" : "OFF");
+  Commands_Result_Printf("MCU die: %d.%02d C\r\n",
+                         get_temperature_int(s.dieTemp),
+                         get_temperature_frac(s.dieTemp));
+  Commands_Result_Printf("Blocks: %lu, DMA errors: %lu\r\n", s.blocks,
+                         s.errors);
+
+  if (c->tripEnabled) {
+    Commands_Result_Printf("Trip: %d C (watchdog < %u)\r\n",
+                           c->tripTemp / 100, s.threshold);
+  } else {
+    Commands_Result_Printf("Trip: OFF\r\n");
+  }
+  if (s.tripped) {
+    Commands_Result_Printf("TRIPPED at %d.%02d C, output cut\r\n",
+                           get_temperature_int(s.tripTemp),
+                           get_temperature_frac(s.tripTemp));
+  }
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Adc_Bench_Handler(const char *params[],
+                                             uint8_t param_count) {
+  uint32_t tableCycles;
+  uint32_t floatCycles;
+  Analog_Convert_Cycles(&tableCycles, &floatCycles);
+  uint32_t mhz = SystemCoreClock / 1000000;
+  Commands_Result_Printf("Table: %lu cycles (%lu ns)\r\n", tableCycles,
+                         tableCycles * 1000 / mhz);
+  Commands_Result_Printf("Float: %lu cycles (%lu ns)\r\n", floatCycles,
+                         floatCycles * 1000 / mhz);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Adc_Point_Handler(const char *params[],
+                                             uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("ADC POINT requires QUIET/ON/OFF or <phase 0-%d>\r\n",
+                          ANALOG_PHASE_FULL);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+  if (!Analog_Point_Adjustable()) {
+    Commands_Error_Printf("Fixed at CH1's edge with %d LED channels\r\n",
+                          LED_CHANNEL_COUNT);
+    return CMD_STATUS_ERROR;
+  }
+
+  uint8_t point = ANALOG_POINT_COUNT;
+  uint16_t phase = Analog_Get_Config()->samplePhase;
+  for (uint8_t i = 0; i < ANALOG_POINT_PHASE; i++) {
+    if (strcmp(params[1], Analog_Point_Name(i)) == 0) {
+      point = i;
+    }
+  }
+  if (point == ANALOG_POINT_COUNT && isdigit((unsigned char)params[1][0])) {
+    point = ANALOG_POINT_PHASE;
+    phase = atoi(params[1]);
+  }
+
+  if (!Analog_Set_Sample_Point(point, phase)) {
+    Commands_Error_Printf("ADC POINT must be QUIET/ON/OFF or 0-%d\r\n",
+                          ANALOG_PHASE_FULL);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("Sample point set to %s\r\n", params[1]);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Adc_Trip_Handler(const char *params[],
+                                            uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("ADC TRIP requires <C> or OFF\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  if (strcmp(params[1], "OFF") == 0) {
+    Analog_Disable_Trip();
+    Commands_Result_Printf("Over-temperature trip disabled\r\n");
+    return CMD_STATUS_SUCCESS;
+  }
+
+  int temp = atoi(params[1]);
+  if (!Analog_Set_Trip(temp * 100)) {
+    Commands_Error_Printf("Trip must be %d-%d C\r\n", ANALOG_TRIP_MIN / 100,
+                          ANALOG_TRIP_MAX / 100);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("Over-temperature trip set to %d C\r\n", temp);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Adc_Clear_Handler(const char *params[],
+                                             uint8_t param_count) {
+  if (!Analog_Tripped()) {
+    Commands_Result_Printf("No over-temperature trip\r\n");
+    return CMD_STATUS_SUCCESS;
+  }
+
+  if (!Analog_Clear_Trip()) {
+    Commands_Error_Printf(
+        "Still too hot, cool below %d C first\r\n",
+        (Analog_Get_Config()->tripTemp - ANALOG_TRIP_HYST) / 100);
+    return CMD_STATUS_ERROR;
+  }
+
+  Commands_Result_Printf("Over-temperature trip cleared, output restored\r\n");
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Therm_Handler(const char *params[],
+                                         uint8_t param_count) {
+  // THERM命令至少需要2个参数：THERM SUBCOMMAND
+  if (param_count < 2) {
+    Commands_Error_Printf(
+        "THERM command requires subcommand "
+        "(READ/MODEL/OBS/POWER/HEAT/FAN/LIMIT/STEP/LOG/FIT)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  return CMD_STATUS_CONTINUE_SUBCOMMAND;
+}
+
+__weak CommandStatus_t Cmd_Therm_Read_Handler(const char *params[],
+                                              uint8_t param_count) {
+  ThermalStatus_t s;
+  Thermal_Get_Status(&s);
+  const ThermalConfig_t *c = Thermal_Get_Config();
+
+  if (!s.valid) {
+    Commands_Result_Printf("Model: waiting for a valid NTC reading\r\n");
+  } else {
+    Commands_Result_Printf("Junction: %d.%02d C\r\n",
+                           get_temperature_int(s.junction),
+                           get_temperature_frac(s.junction));
+    Commands_Result_Printf("Heatsink: %d.%02d C (NTC %d.%02d C%s)\r\n",
+                           get_temperature_int(s.heatsink),
+                           get_temperature_frac(s.heatsink),
+                           get_temperature_int(s.sensor),
+                           get_temperature_frac(s.sensor),
+                           s.sensorOk ? "" : ", fault, open loop");
+    Commands_Result_Printf("Ambient: %d.%02d C\r\n",
+                           get_temperature_int(s.ambient),
+                           get_temperature_frac(s.ambient));
+  }
+  Commands_Result_Printf("Heat: %lu mW (%s, %u/1000 of input)\r\n", s.heatMw,
+                         s.measured ? "measured" : "from duty",
+                         c->heatPermille);
+  Commands_Result_Printf("Rjh %u.%02u K/W, tauJ %u.%u s\r\n", c->rjh / 100,
+                         c->rjh % 100, c->tauJ / 10, c->tauJ % 10);
+  Commands_Result_Printf("Rha %u.%02u K/W, tauH %u s\r\n", c->rha / 100,
+                         c->rha % 100, c->tauH);
+  Commands_Result_Printf("Observer: %u/1000/s, ambient %u/1000/s\r\n",
+                         c->gain, c->ambientGain);
+  for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+    Commands_Result_Printf("CH%u: %u mW at full duty\r\n", ch + 1,
+                           c->channelMw[ch]);
+  }
+  Commands_Result_Printf("Fan input: %s\r\n",
+                         (c->flags & THERMAL_FLAG_FAN) ? "junction" : "NTC");
+  if (c->flags & THERMAL_FLAG_DERATE) {
+    Commands_Result_Printf("Derating above %d C, gain %u/%u\r\n",
+                           c->limit / 100, s.derate, THERMAL_DERATE_ONE);
+  } else {
+    Commands_Result_Printf("Derating: OFF\r\n");
+  }
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Therm_Model_Handler(const char *params[],
+                                               uint8_t param_count) {
+  if (param_count < 5) {
+    Commands_Error_Printf("THERM MODEL requires <Rjh> <Rha> <tauJ ds> "
+                          "<tauH s>\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  int rjh = Commands_Int_Param(1);
+  int rha = Commands_Int_Param(2);
+  int tau_j = Commands_Int_Param(3);
+  int tau_h = Commands_Int_Param(4);
+  if (rjh < 0 || rha < 0 || tau_j < 0 || tau_h < 0 ||
+      !Thermal_Set_Model(rjh, rha, tau_j, tau_h)) {
+    Commands_Error_Printf(
+        "R 1-%d (K/W x100), tauJ 0-%d (0.1s), tauH 1-%d s\r\n", THERMAL_R_MAX,
+        THERMAL_TAU_J_MAX, THERMAL_TAU_H_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("Thermal model set\r\n");
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Therm_Obs_Handler(const char *params[],
+                                             uint8_t param_count) {
+  if (param_count < 3) {
+    Commands_Error_Printf("THERM OBS requires <gain> <ambient gain>\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  int gain = Commands_Int_Param(1);
+  int ambient = Commands_Int_Param(2);
+  if (gain < 0 || ambient < 0 || !Thermal_Set_Observer(gain, ambient)) {
+    Commands_Error_Printf("Observer gains must be 0-%d\r\n", THERMAL_GAIN_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("Observer gains set to %d, %d\r\n", gain, ambient);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Therm_Power_Handler(const char *params[],
+                                               uint8_t param_count) {
+  if (param_count < 3) {
+    Commands_Error_Printf("THERM POWER requires <ch> <mW>\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  int ch = Commands_Int_Param(1);
+  int mw = Commands_Int_Param(2);
+  if (ch < 1 || mw < 0 || !Thermal_Set_Channel_Power(ch - 1, mw)) {
+    Commands_Error_Printf("Channel 1-%d, power 0-%d mW\r\n", LED_CHANNEL_COUNT,
+                          THERMAL_CHANNEL_MW_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("CH%d full power set to %d mW\r\n", ch, mw);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Therm_Heat_Handler(const char *params[],
+                                              uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("THERM HEAT requires <0-1000>\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  int permille = Commands_Int_Param(1);
+  if (permille < 0 || !Thermal_Set_Heat(permille)) {
+    Commands_Error_Printf("Heat fraction must be 0-1000\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("Heat fraction set to %d/1000\r\n", permille);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Therm_Fan_Handler(const char *params[],
+                                             uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("THERM FAN requires ON or OFF\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  if (strcmp(params[1], "ON") == 0) {
+    Thermal_Set_Flag(THERMAL_FLAG_FAN, true);
+  } else if (strcmp(params[1], "OFF") == 0) {
+    Thermal_Set_Flag(THERMAL_FLAG_FAN, false);
+  } else {
+    Commands_Error_Printf("THERM FAN requires ON or OFF\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("Fan follows %s\r\n",
+                         strcmp(params[1], "ON") == 0 ? "junction" : "NTC");
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Therm_Limit_Handler(const char *params[],
+                                               uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("THERM LIMIT requires <C> or OFF\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  if (strcmp(params[1], "OFF") == 0) {
+    Thermal_Set_Flag(THERMAL_FLAG_DERATE, false);
+    Commands_Result_Printf("Junction derating disabled\r\n");
+    return CMD_STATUS_SUCCESS;
+  }
+
+  int limit = atoi(params[1]);
+  if (!Thermal_Set_Limit(limit * 100)) {
+    Commands_Error_Printf("Limit must be %d-%d C\r\n", THERMAL_LIMIT_MIN / 100,
+                          THERMAL_LIMIT_MAX / 100);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("Junction derating above %d C\r\n", limit);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Therm_Step_Handler(const char *params[],
+                                              uint8_t param_count) {
+  int interval = (param_count >= 2) ? Commands_Int_Param(1) : 5;
+  if (interval < 1 || !Thermal_Start_Log(interval)) {
+    Commands_Error_Printf("Interval must be 1-%d s\r\n",
+                          THERMAL_LOG_INTERVAL_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("Logging %d points every %d s, change brightness "
+                         "now and hold it\r\n",
+                         THERMAL_LOG_POINTS, interval);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Therm_Log_Handler(const char *params[],
+                                             uint8_t param_count) {
+  uint8_t count = Thermal_Log_Count();
+  if (count == 0) {
+    Commands_Result_Printf("Thermal log empty, start with THERM STEP\r\n");
+    return CMD_STATUS_SUCCESS;
+  }
+
+  uint32_t interval = Thermal_Log_Interval();
+  Commands_Result_Printf("t_s,heat_mW,ntc_C\r\n");
+  for (uint8_t i = 0; i < count; i++) {
+    uint32_t mw;
+    int16_t temp;
+    Thermal_Get_Log(i, &mw, &temp);
+    Commands_Result_Printf("%lu,%lu,%d.%02d\r\n", i * interval, mw,
+                           get_temperature_int(temp),
+                           get_temperature_frac(temp));
+  }
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Therm_Fit_Handler(const char *params[],
+                                             uint8_t param_count) {
+  bool apply = param_count >= 2 && strcmp(params[1], "APPLY") == 0;
+  ThermalFit_t fit;
+  if (!Thermal_Fit(&fit, apply)) {
+    Commands_Error_Printf("Need %d+ points and a heat step of %d+ mW\r\n",
+                          THERMAL_FIT_MIN_POINTS, THERMAL_FIT_MIN_MW);
+    return CMD_STATUS_ERROR;
+  }
+
+  Commands_Result_Printf("Step: %ld mW, rise %ld.%02ld C\r\n", fit.deltaMw,
+                         fit.deltaT / 100,
+                         (fit.deltaT < 0 ? -fit.deltaT : fit.deltaT) % 100);
+  Commands_Result_Printf("Rha %u.%02u K/W, tauH %u s%s\r\n", fit.rha / 100,
+                         fit.rha % 100, fit.tauH, apply ? " (applied)" : "");
+  if (!fit.settled) {
+    Commands_Result_Printf("Warning: not settled, log with a longer "
+                           "interval\r\n");
+  }
+  return CMD_STATUS_SUCCESS;
+}
+
+/**
+ * @brief 解析分辨率名称 (SEC/MIN/HOUR)，无法识别时返回HISTORY_RES_COUNT
+ */
+static uint8_t parseHistoryRes(const char *name) {
+  for (uint8_t r = 0; r < HISTORY_RES_COUNT; r++) {
+    if (strcmp(name, History_Res_Name(r)) == 0) {
+      return r;
+    }
+  }
+  return HISTORY_RES_COUNT;
+}
+
+__weak CommandStatus_t Cmd_Hist_Handler(const char *params[],
+                                        uint8_t param_count) {
+  // HIST命令至少需要2个参数：HIST SUBCOMMAND
+  if (param_count < 2) {
+    Commands_Error_Printf("HIST command requires subcommand "
+                          "(READ/DUMP/SNAP/OLED)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  return CMD_STATUS_CONTINUE_SUBCOMMAND;
+}
+
+__weak CommandStatus_t Cmd_Hist_Read_Handler(const char *params[],
+                                             uint8_t param_count) {
+  for (uint8_t r = 0; r < HISTORY_RES_COUNT; r++) {
+    Commands_Result_Printf("%s: %u buckets, #%lu\r\n", History_Res_Name(r),
+                           History_Count(r), History_Sequence(r));
+    for (uint8_t s = 0; s < HISTORY_SERIES_COUNT; s++) {
+      int32_t mn, mx, avg;
+      if (!History_Get(r, 0, s, &mn, &mx, &avg)) {
+        continue;
+      }
+      char lo[12], hi[12], mean[12];
+      History_Format(s, mn, lo, sizeof(lo));
+      History_Format(s, mx, hi, sizeof(hi));
+      History_Format(s, avg, mean, sizeof(mean));
+      Commands_Result_Printf("  %s: %s (%s-%s)\r\n", History_Series_Name(s),
+                             mean, lo, hi);
+    }
+  }
+  Commands_Result_Printf("Snapshots: %s\r\n",
+                         History_Snapshot_Enabled() ? "ON" : "OFF");
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Hist_Dump_Handler(const char *params[],
+                                             uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("HIST DUMP requires SEC/MIN/HOUR [count] [skip]\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  uint8_t res = parseHistoryRes(params[1]);
+  int count = (param_count >= 3) ? atoi(params[2]) : HISTORY_SECONDS;
+  int skip = (param_count >= 4) ? atoi(params[3]) : 0;
+  if (res == HISTORY_RES_COUNT || count < 1 || count > 255 || skip < 0 ||
+      skip > 255) {
+    Commands_Error_Printf("HIST DUMP requires SEC/MIN/HOUR [count] [skip]\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  uint8_t available = History_Count(res);
+  if (skip >= available) {
+    Commands_Result_Printf("No %s buckets in range\r\n",
+                           History_Res_Name(res));
+    return CMD_STATUS_SUCCESS;
+  }
+  if (count > available - skip) {
+    count = available - skip;
+  }
+
+  // 文本行给出后面二进制帧的长度，便于主机端切换到按字节读取
+  Commands_Result_Printf("HIST %s %d rows, %u bytes\r\n",
+                         History_Res_Name(res), count,
+                         History_Dump_Size(count));
+  History_Dump(res, count, skip);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Hist_Snap_Handler(const char *params[],
+                                             uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("HIST SNAP requires ON/OFF/NOW\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  if (strcmp(params[1], "ON") == 0) {
+    History_Set_Snapshot(true);
+  } else if (strcmp(params[1], "OFF") == 0) {
+    History_Set_Snapshot(false);
+  } else if (strcmp(params[1], "NOW") == 0) {
+    History_Request_Snapshot();
+  } else {
+    Commands_Error_Printf("HIST SNAP requires ON/OFF/NOW\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  Commands_Result_Printf("History snapshots %s\r\n",
+                         History_Snapshot_Enabled() ? "ON" : "OFF");
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Hist_Oled_Handler(const char *params[],
+                                             uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Error_Printf("HIST OLED requires TEMP/POWER/FAN/OFF\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  uint8_t series = HISTORY_SERIES_COUNT;
+  for (uint8_t s = 0; s < HISTORY_SERIES_COUNT; s++) {
+    if (strcmp(params[1], History_Series_Name(s)) == 0) {
+      series = s;
+    }
+  }
+  if (series == HISTORY_SERIES_COUNT && strcmp(params[1], "OFF") != 0) {
+    Commands_Error_Printf("HIST OLED requires TEMP/POWER/FAN/OFF\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  uint8_t res = (param_count >= 3) ? parseHistoryRes(params[2])
+                                   : HISTORY_RES_SEC;
+  if (res == HISTORY_RES_COUNT) {
+    Commands_Error_Printf("Resolution must be SEC/MIN/HOUR\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  History_Set_Display(series, res);
+  Commands_Result_Printf("OLED history: %s\r\n", History_Series_Name(series));
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Cmd_Handler(const char *params[],
+                                       uint8_t param_count) {
+  // CMD命令至少需要2个参数：CMD SUBCOMMAND
+  if (param_count < 2) {
+    Commands_Error_Printf("CMD command requires subcommand "
+                          "(BENCH/ISR/PROF/BUDGET/CHAN)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  return CMD_STATUS_CONTINUE_SUBCOMMAND;
+}
+
+__weak CommandStatus_t Cmd_Cmd_Bench_Handler(const char *params[],
+                                             uint8_t param_count) {
+  uint32_t linear, hashed;
+  Commands_Benchmark(&linear, &hashed);
+  uint32_t mhz = SystemCoreClock / 1000000;
+
+  Commands_Result_Printf("Table walk (strcmp): %lu cycles, %lu cmd/s\r\n",
+                         linear, linear ? SystemCoreClock / linear : 0);
+  Commands_Result_Printf("Indexed resolve: %lu cycles, %lu cmd/s\r\n", hashed,
+                         hashed ? SystemCoreClock / hashed : 0);
+  Commands_Result_Printf("Per command: %lu ns -> %lu ns\r\n",
+                         linear * 1000 / mhz, hashed * 1000 / mhz);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Cmd_Isr_Handler(const char *params[],
+                                           uint8_t param_count) {
+  if (param_count >= 2 && strcmp(params[1], "RESET") == 0) {
+    Deferred_Reset_Stats();
+    Commands_Result_Printf("ISR statistics cleared\r\n");
+    return CMD_STATUS_SUCCESS;
+  }
+
+  DeferredStats_t s;
+  Deferred_Get_Stats(&s);
+  uint32_t mhz = SystemCoreClock / 1000000;
+
+  uint32_t avg = s.isrCount ? (uint32_t)(s.isrSumCycles / s.isrCount) : 0;
+  Commands_Result_Printf("TIM4 ISR: %lu calls, avg %lu cycles, max %lu "
+                         "cycles (%lu ns)\r\n",
+                         s.isrCount, avg, s.isrMaxCycles,
+                         s.isrMaxCycles * 1000 / mhz);
+  Commands_Result_Printf("Deferred: %lu posted, %lu run, %lu dropped, "
+                         "backlog %d (max %d)\r\n",
+                         s.posted, s.executed, s.dropped, Deferred_Pending(),
+                         s.maxBacklog);
+  Commands_Result_Printf("Max item %lu us, max slice %lu us (budget %d us, "
+                         "%lu split)\r\n",
+                         s.maxItemCycles / mhz, s.maxSliceCycles / mhz,
+                         DEFERRED_SLICE_US, s.slices);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Cmd_Prof_Handler(const char *params[],
+                                            uint8_t param_count) {
+  if (param_count >= 2 && strcmp(params[1], "RESET") == 0) {
+    Commands_Reset_Profile();
+    Commands_Result_Printf("Command profile cleared\r\n");
+    return CMD_STATUS_SUCCESS;
+  }
+
+  uint32_t mhz = SystemCoreClock / 1000000;
+  const char *name;
+  CommandProfile_t p;
+  bool any = false;
+
+  for (uint8_t i = 0; Commands_Get_Profile(i, &name, &p); i++) {
+    if (p.count == 0) {
+      continue;
+    }
+    Commands_Result_Printf("%s: %lu runs, avg %lu us, max %lu us\r\n", name,
+                           p.count, p.totalUs / p.count, p.maxCycles / mhz);
+    any = true;
+  }
+  if (!any) {
+    Commands_Result_Printf("No commands executed\r\n");
+  }
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Cmd_Budget_Handler(const char *params[],
+                                              uint8_t param_count) {
+  if (param_count < 2) {
+    Commands_Result_Printf("Executor budget: %d us per tick\r\n",
+                           Commands_Get_Budget());
+    return CMD_STATUS_SUCCESS;
+  }
+
+  int us = Commands_Int_Param(1);
+  if (!Commands_Set_Budget(us)) {
+    Commands_Error_Printf("Budget must be between %d and %d us\r\n",
+                          CMD_EXEC_BUDGET_MIN, CMD_EXEC_BUDGET_MAX);
+    return CMD_STATUS_INVALID_PARAM;
+  }
+  Commands_Result_Printf("Executor budget set to %d us\r\n", us);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Cmd_Chan_Handler(const char *params[],
+                                            uint8_t param_count) {
+  if (param_count >= 2 && strcmp(params[1], "RESET") == 0) {
+    Commands_Reset_Channel_Stats();
+    Commands_Result_Printf("Channel statistics cleared\r\n");
+    return CMD_STATUS_SUCCESS;
+  }
+
+  const char *name;
+  uint16_t count, bytes, size;
+  uint32_t wait;
+  CommandChannelStats_t s;
+
+  for (uint8_t i = 0; Commands_Get_Channel(i, &name, &count, &bytes, &size,
+                                           &wait, &s);
+       i++) {
+    Commands_Result_Printf("%s: %d queued (%d/%d B, max %d), %lu dropped, "
+                           "wait %lu ms\r\n",
+                           name, count, bytes, size, s.maxDepth, s.dropped,
+                           wait);
+    Commands_Result_Printf("  latency: %lu cmds, avg %lu ms, max %lu ms\r\n",
+                           s.latencyCount,
+                           s.latencyCount ? s.latencyTotalMs / s.latencyCount
+                                          : 0,
+                           s.latencyMaxMs);
+  }
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Cmd_Bin_Handler(const char *params[],
+                                           uint8_t param_count) {
+  if (param_count >= 2 && strcmp(params[1], "RESET") == 0) {
+    BinProto_Reset_Stats();
+    Commands_Result_Printf("Binary protocol statistics cleared\r\n");
+    return CMD_STATUS_SUCCESS;
+  }
+
+  BinProtoStats_t s;
+  BinProto_Get_Stats(&s);
+  Commands_Result_Printf("Binary frames: %lu received, %lu replies\r\n",
+                         s.frames, s.replies);
+  Commands_Result_Printf("Errors: %lu bad frame, %lu bad CRC, %lu "
+                         "rejected\r\n",
+                         s.badFrame, s.badCrc, s.errors);
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Cmd_Quiet_Handler(const char *params[],
+                                             uint8_t param_count) {
+  if (param_count >= 2) {
+    if (strcmp(params[1], "ON") == 0) {
+      Commands_Set_Quiet(true);
+    } else if (strcmp(params[1], "OFF") == 0) {
+      Commands_Set_Quiet(false);
+    } else {
+      Commands_Error_Printf("QUIET requires ON or OFF\r\n");
+      return CMD_STATUS_INVALID_PARAM;
+    }
+  }
+  Commands_Result_Printf("Quiet mode: %s\r\n",
+                         Commands_Is_Quiet() ? "ON" : "OFF");
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Sleep_Handler(const char *params[],
+                                         uint8_t param_count) {
+  // 如果只有SLEEP，执行普通睡眠
+  if (param_count == 1) {
+    state.isSleeping = true;
+    state.deepSleep = false;
+    Commands_Result_Printf("Sleep command executed\r\n");
+    return CMD_STATUS_SUCCESS;
+  }
+
+  // 如果有子命令，继续执行
+  return CMD_STATUS_CONTINUE_SUBCOMMAND;
+}
+
+__weak CommandStatus_t Cmd_Sleep_Deep_Handler(const char *params[],
+                                              uint8_t param_count) {
+  state.isSleeping = true;
+  state.deepSleep = true;
+  Commands_Result_Printf("Deep sleep command executed\r\n");
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Wait_Handler(const char *params[],
+                                        uint8_t param_count) {
+  // WAIT命令在Commands_Execute_Next中特殊处理
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Reboot_Handler(const char *params[],
+                                          uint8_t param_count) {
+  return CMD_STATUS_SUCCESS;
+}
+
+__weak CommandStatus_t Cmd_Eeprom_Handler(const char *params[],
+                                          uint8_t param_count) {
+  // EEPROM命令至少需要2个参数：EEPROM SUBCOMMAND
+  if (param_count < 2) {
+    Commands_Error_Printf(
+        "EEPROM command requires subcommand (READ/WRITE)\r\n");
+    return CMD_STATUS_INVALID_PARAM;
+  }
+
+  // 继续执行子命令
   return CMD_STATUS_CONTINUE_SUBCOMMAND;
 }
 
@@ -553,7 +2694,7 @@ __weak CommandStatus_t Cmd_Eeprom_Read_Handler(const char *params[],
     UART_Printf("EEPROM READ addr:%s length:%s command executed\r\n", params[1],
                 params[2]);
   } else {
-    UART_Printf("Error: EEPROM READ requires address and length\r\n");
+    Commands_Error_Printf("EEPROM READ requires address and length\r\n");
     return CMD_STATUS_INVALID_PARAM;
   }
   return CMD_STATUS_SUCCESS;
@@ -565,7 +2706,7 @@ __weak CommandStatus_t Cmd_Eeprom_Write_Handler(const char *params[],
     UART_Printf("EEPROM WRITE addr:%s data:%s command executed\r\n", params[1],
                 params[2]);
   } else {
-    UART_Printf("Error: EEPROM WRITE requires address and data\r\n");
+    Commands_Error_Printf("EEPROM WRITE requires address and data\r\n");
     return CMD_STATUS_INVALID_PARAM;
   }
   return CMD_STATUS_SUCCESS;
@@ -575,14 +2716,81 @@ __weak CommandStatus_t Cmd_Help_Handler(const char *params[],
                                         uint8_t param_count) {
   UART_Printf("Available commands:\r\n");
   UART_Printf("POWER ON/OFF - Power control\r\n");
-  UART_Printf("POWER CH1 READ/SHOW - Read CH1 PWM\r\n");
-  UART_Printf("POWER CH1 SET <value> - Set CH1 PWM\r\n");
-  UART_Printf("POWER CH2 READ/SHOW - Read CH2 PWM\r\n");
-  UART_Printf("POWER CH2 SET <value> - Set CH2 PWM\r\n");
-  UART_Printf("POWER FADE <step> - Set PWM fade step\r\n");
+  UART_Printf("POWER CH<n> READ/SHOW - Read channel PWM (n=1-%d)\r\n",
+              LED_CHANNEL_COUNT);
+  UART_Printf("POWER CH<n> SET <value> - Set channel PWM\r\n");
+  UART_Printf("POWER CH<n> FADE <step> - Set channel fade step\r\n");
+  UART_Printf("POWER CH<n> LIMIT <value> - Set channel PWM limit\r\n");
+  UART_Printf("POWER CH<n> MIX <0-1024> - Set CH3/CH4 mix weight\r\n");
+  UART_Printf("POWER FADE <step> - Set PWM fade step (all channels)\r\n");
   UART_Printf("FAN AUTO/FORCE - Fan control\r\n");
+  UART_Printf("FAN READ - Show fan PWM state and control config\r\n");
+  UART_Printf("FAN MODE CURVE/PID/RPM - Auto control method\r\n");
+  UART_Printf("FAN CURVE <1-%d> <temp C> <duty/1000> - Set curve point\r\n",
+              FAN_CURVE_POINTS);
+  UART_Printf("FAN HYST <C> - Set hysteresis\r\n");
+  UART_Printf("FAN PID <setpoint C> <kp> <ki> <kd> - Set PID\r\n");
+  UART_Printf("FAN TACH <1-%d>/OFF - Tach input on PA1\r\n",
+              FAN_TACH_PPR_MAX);
+  UART_Printf("FAN RPM <rpm> - Target for FAN MODE RPM\r\n");
+  UART_Printf("FAN MINRPM <rpm> - Under-speed limit at full duty\r\n");
+  UART_Printf("FAN HISTORY - RPM history\r\n");
+  UART_Printf("COLOR READ - Show target/actual CCT and Duv\r\n");
+  UART_Printf("COLOR MODE CIE/MIRED - Select mixing method\r\n");
+  UART_Printf("COLOR DUV <+-200> - Set target Duv (x10000)\r\n");
+  UART_Printf("COLOR XY <ch> <x> <y> - Set channel xy (x10000)\r\n");
+  UART_Printf("COLOR FLUX <ch> <lm> - Set channel flux (0=not solved)\r\n");
+  UART_Printf("EFFECT OFF/READ - Stop effect / show effect and cost\r\n");
+  UART_Printf("EFFECT BREATHE [ms] [depth] - Breathing effect\r\n");
+  UART_Printf("EFFECT CANDLE [depth] [speed 1-8] - Candle flicker\r\n");
+  UART_Printf("EFFECT STROBE [step ms] [pattern] [depth] - Strobe\r\n");
+  UART_Printf("PRESET RECALL/STORE <n> - Recall/store preset (n=1-%d)\r\n",
+              PRESET_COUNT);
+  UART_Printf("PRESET READ - List presets\r\n");
+  UART_Printf("PRESET FADE <ms> - Set preset crossfade time\r\n");
+  UART_Printf("PWM READ - List PWM profiles\r\n");
+  UART_Printf("PWM PROFILE STD/VIDEO/HIRES - Select PWM profile\r\n");
+  UART_Printf("LUMEN READ - Show drive hours and compensation\r\n");
+  UART_Printf("LUMEN COMP ON/OFF - Lumen compensation\r\n");
+  UART_Printf("LUMEN CURVE <1-%d> <hours> <output/1000> - Set curve\r\n",
+              LUMEN_CURVE_POINTS);
+  UART_Printf("LUMEN RESET [ch] - Reset drive hours\r\n");
+  UART_Printf("REG READ - Show power monitor and loop telemetry\r\n");
+  UART_Printf("REG MODE OFF/CP/CC - Constant power/current loop\r\n");
+  UART_Printf("REG SET <mW|mA> - Set setpoint\r\n");
+  UART_Printf("REG HOLD - Hold present measurement\r\n");
+  UART_Printf("LATENCY READ/RESET - Encoder-to-PWM latency statistics\r\n");
+  UART_Printf("LATENCY FAST ON/OFF - Input fast path\r\n");
+  UART_Printf("ADC READ - NTC, supply and MCU die temperature\r\n");
+  UART_Printf("ADC BENCH - Time NTC table vs float conversion\r\n");
+  UART_Printf("ADC POINT QUIET/ON/OFF/<0-%d> - Sample point in PWM period\r\n",
+              ANALOG_PHASE_FULL);
+  UART_Printf("ADC TRIP <C>/OFF - Hardware over-temperature cutoff\r\n");
+  UART_Printf("ADC CLEAR - Restore output after a trip\r\n");
+  UART_Printf("THERM READ - Junction/heatsink/ambient estimate\r\n");
+  UART_Printf("THERM MODEL <Rjh> <Rha> <tauJ ds> <tauH s> - K/W x100\r\n");
+  UART_Printf("THERM OBS <gain> <ambient gain> - Observer gains (/1000/s)\r\n");
+  UART_Printf("THERM POWER <ch> <mW> - Channel power at full duty\r\n");
+  UART_Printf("THERM HEAT <0-1000> - Heat fraction of input power\r\n");
+  UART_Printf("THERM FAN ON/OFF - Fan follows predicted junction\r\n");
+  UART_Printf("THERM LIMIT <C>/OFF - Junction derating start\r\n");
+  UART_Printf("THERM STEP [s] - Log a step response\r\n");
+  UART_Printf("THERM LOG - Dump the step response\r\n");
+  UART_Printf("THERM FIT [APPLY] - Fit Rha/tauH from the log\r\n");
+  UART_Printf("HIST READ - Latest second/minute/hour buckets\r\n");
+  UART_Printf("HIST DUMP SEC/MIN/HOUR [count] [skip] - Binary range dump\r\n");
+  UART_Printf("HIST SNAP ON/OFF/NOW - Hourly EEPROM snapshots\r\n");
+  UART_Printf("HIST OLED TEMP/POWER/FAN/OFF [SEC/MIN/HOUR] - Sparkline\r\n");
+  UART_Printf("CMD BENCH - Time command lookup\r\n");
+  UART_Printf("CMD ISR [RESET] - Executor ISR time, deferred work\r\n");
+  UART_Printf("CMD PROF [RESET] - Per-command execution time\r\n");
+  UART_Printf("CMD BUDGET <us> - Executor time per tick\r\n");
+  UART_Printf("CMD CHAN [RESET] - Per-channel queue statistics\r\n");
+  UART_Printf("CMD BIN [RESET] - Binary protocol statistics\r\n");
+  UART_Printf("CMD QUIET [ON/OFF] - Suppress command echo\r\n");
+  UART_Printf("!<commands> - Urgent, @<commands> - Script channel\r\n");
   UART_Printf("SLEEP [DEEP] - Sleep mode\r\n");
-  UART_Printf("WAIT <cycles> - Wait cycles\r\n");
+  UART_Printf("WAIT <ms> - Wait milliseconds\r\n");
   UART_Printf("REBOOT - Restart system\r\n");
   UART_Printf("EEPROM READ <addr> <length> - Read EEPROM\r\n");
   UART_Printf("EEPROM WRITE <addr> <data> - Write EEPROM\r\n");
@@ -590,6 +2798,62 @@ __weak CommandStatus_t Cmd_Help_Handler(const char *params[],
   return CMD_STATUS_SUCCESS;
 }
 
+/**
+ * @brief 测量命令查找耗时 (DWT周期数/条)
+ * @param linearCycles 逐表strcmp查找 (原执行时查找方式)
+ * @param hashedCycles 入队时的索引查找和整数参数转换 (resolve_command)
+ */
+void Commands_Benchmark(uint32_t *linearCycles, uint32_t *hashedCycles) {
+  static volatile uint8_t sink;
+  const uint8_t lines = sizeof(bench_lines) / sizeof(bench_lines[0]);
+  CommandToken_t tokens[sizeof(bench_lines) / sizeof(bench_lines[0])]
+                       [CMD_MAX_PARAMS];
+  uint8_t counts[sizeof(bench_lines) / sizeof(bench_lines[0])];
+
+  // 预先分词，只测查找
+  for (uint8_t i = 0; i < lines; i++) {
+    counts[i] = tokenize(bench_lines[i], bench_lines[i] + strlen(bench_lines[i]),
+                         tokens[i]);
+  }
+
+  uint32_t start = DWT->CYCCNT;
+  for (uint16_t round = 0; round < CMD_BENCH_ROUNDS; round++) {
+    for (uint8_t i = 0; i < lines; i++) {
+      const CommandStruct_t *table = main_commands;
+      uint8_t count = main_command_count;
+      for (uint8_t level = 0; level < counts[i]; level++) {
+        const CommandToken_t *token = &tokens[i][level];
+        uint8_t found = CMD_NODE_NONE;
+        for (uint8_t j = 0; j < count; j++) {
+          if (strncmp(token->text, table[j].command, token->length) == 0 &&
+              table[j].command[token->length] == '\0') {
+            found = j;
+            break;
+          }
+        }
+        sink = found;
+        if (found == CMD_NODE_NONE || table[found].subcommands == NULL) {
+          break;
+        }
+        count = table[found].subcommand_count;
+        table = table[found].subcommands;
+      }
+    }
+  }
+  *linearCycles = (DWT->CYCCNT - start) / (CMD_BENCH_ROUNDS * lines);
+
+  start = DWT->CYCCNT;
+  for (uint16_t round = 0; round < CMD_BENCH_ROUNDS; round++) {
+    for (uint8_t i = 0; i < lines; i++) {
+      ResolvedCommand_t resolved;
+      resolve_command(tokens[i], counts[i], &resolved);
+      sink = resolved.opcode;
+    }
+  }
+  *hashedCycles = (DWT->CYCCNT - start) / (CMD_BENCH_ROUNDS * lines);
+  (void)sink; // 只用于防止循环被优化掉
+}
+
 /**
  * @brief Command result printf function
  * @param format Format string
@@ -601,8 +2865,11 @@ int Commands_Result_Printf(const char *format, ...) {
   va_list args;
   va_start(args, format);
 
-  // 添加前缀
-  int prefix_len = snprintf(buffer, sizeof(buffer), "#$%%>");
+  // 添加前缀 (带标签的命令加上标签，主机据此对应请求)
+  int prefix_len = (current_tag != 0)
+                       ? snprintf(buffer, sizeof(buffer), "#$%%>id=%u ",
+                                  current_tag)
+                       : snprintf(buffer, sizeof(buffer), "#$%%>");
 
   // 格式化用户内容
   int content_len =
@@ -617,5 +2884,40 @@ int Commands_Result_Printf(const char *format, ...) {
                       HAL_MAX_DELAY);
   }
 
+  return total_len;
+}
+
+/**
+ * @brief 命令错误输出 (带标签时与结果行使用相同的前缀)
+ */
+int Commands_Error_Printf(const char *format, ...) {
+  char buffer[128];
+  va_list args;
+  va_start(args, format);
+
+  // 带标签的命令入队时: 只保留第一条错误，执行时再输出
+  if (error_capture != NULL) {
+    if (error_capture[0] == '\0') {
+      vsnprintf(error_capture, CMD_ERROR_TEXT_MAX, format, args);
+    }
+    va_end(args);
+    return 0;
+  }
+
+  int prefix_len = (current_tag != 0)
+                       ? snprintf(buffer, sizeof(buffer), "#$%%>id=%u err=",
+                                  current_tag)
+                       : snprintf(buffer, sizeof(buffer), "Error: ");
+  int content_len =
+      vsnprintf(buffer + prefix_len, sizeof(buffer) - prefix_len, format, args);
+  va_end(args);
+
+  int total_len = prefix_len + content_len;
+  if (total_len > 0) {
+    HAL_UART_Transmit(&huart2, (uint8_t *)buffer,
+                      (total_len > sizeof(buffer) ? sizeof(buffer) : total_len),
+                      HAL_MAX_DELAY);
+  }
+
   return total_len;
 }
\ No newline at end of file
@@ -8,6 +8,8 @@
 #ifndef __COMMANDS_H__
 #define __COMMANDS_H__
 
+#include "timer_wheel.h" // C++链接，放在extern "C"之外
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -18,11 +20,28 @@ extern "C" {
 #include <stdint.h>
 
 /* Defines -------------------------------------------------------------------*/
-#define CMD_MAX_COMMANDS 128      // 最大命令队列长度
-#define CMD_MAX_COMMAND_LENGTH 32 // 单个命令最大长度
+#define CMD_ARENA_URGENT 128      // 各通道队列字节数 (典型命令9-17字节/条)
+#define CMD_ARENA_INTERACTIVE 1792 // 至少128条典型命令 (另留回绕余量)
+#define CMD_ARENA_SCRIPT 640
+#define CMD_ARENA_INTERNAL 256
+#define CMD_ARENA_SIZE                                                         \
+  (CMD_ARENA_URGENT + CMD_ARENA_INTERACTIVE + CMD_ARENA_SCRIPT +               \
+   CMD_ARENA_INTERNAL)
+#define CMD_PREFIX_URGENT '!'     // 串口行首前缀: 紧急通道
+#define CMD_PREFIX_SCRIPT '@'     // 串口行首前缀: 脚本通道
+#define CMD_TAG_PREFIX '#'        // 命令前的请求标签 (#1-#65535)
+#define CMD_RECORD_MAX 255        // 单条命令记录最大字节数
+#define CMD_ERROR_TEXT_MAX 64     // 入队出错的带标签命令保存的错误信息长度
 #define CMD_MAX_PARAMS 8          // 命令最大参数数量
 #define CMD_MAX_PARAM_LENGTH 4    // 参数最大长度
 #define CMD_DELIMITER ';'         // 命令分隔符
+#define CMD_MAX_DEPTH 3           // 命令表最大层数 (POWER CH1 SET)
+#define CMD_OP_WAIT 0xFD          // WAIT命令 (等待毫秒数已在入队时解析)
+#define CMD_OP_REJECT 0xFE        // 入队时出错的带标签命令 (记录体为状态)
+#define CMD_BENCH_ROUNDS 100      // 命令查找耗时测量的轮数
+#define CMD_EXEC_BUDGET_DEFAULT 2000 // 每个执行节拍的时间预算 (us)
+#define CMD_EXEC_BUDGET_MIN 100
+#define CMD_EXEC_BUDGET_MAX 50000
 
 /* Command execution status --------------------------------------------------*/
 typedef enum {
@@ -41,30 +60,109 @@ typedef struct CommandStruct CommandStruct_t;
 typedef CommandStatus_t (*CommandCallback_t)(const char *params[],
                                              uint8_t param_count);
 
+/**
+ * @brief 命令名哈希 (FNV-1a)，命令表在编译期计算，参数在入队时计算
+ */
+constexpr uint32_t Commands_Hash_Len(const char *str, uint8_t length) {
+  uint32_t hash = 2166136261u;
+  while (length--) {
+    hash = (hash ^ (uint8_t)*str++) * 16777619u;
+  }
+  return hash;
+}
+
+constexpr uint32_t Commands_Hash(const char *str) {
+  uint8_t length = 0;
+  while (str[length]) {
+    length++;
+  }
+  return Commands_Hash_Len(str, length);
+}
+
 struct CommandStruct {
   const char *command;                // 命令名称
   CommandCallback_t callback;         // 回调函数
   const CommandStruct_t *subcommands; // 子命令数组
   uint8_t subcommand_count;           // 子命令数量
   const char *description;            // 命令描述
+  uint32_t hash;                      // 命令名哈希 (同一张表内互不相同)
+  uint8_t int_args; // 前int_args个参数为整数 (入队时检查并转换)
+
+  constexpr CommandStruct(const char *command, CommandCallback_t callback,
+                          const CommandStruct_t *subcommands,
+                          uint8_t subcommand_count, const char *description,
+                          uint8_t int_args = 0)
+      : command(command), callback(callback), subcommands(subcommands),
+        subcommand_count(subcommand_count), description(description),
+        hash(Commands_Hash(command)), int_args(int_args) {}
 };
 
-/* Parsed command for execution queue ---------------------------------------*/
+/* Command channels ----------------------------------------------------------*/
+// 每个通道有自己的队列和WAIT状态，一个通道的WAIT只暂停该通道。
+// URGENT为严格优先: 只要有命令就先执行，不受执行预算限制，入队后立即
+// 调度；其余通道按权重轮转，每轮最多连续执行weight条。
+typedef enum {
+  CMD_CHANNEL_URGENT = 0, // 紧急命令 (如!POWER OFF)
+  CMD_CHANNEL_INTERACTIVE, // 串口交互命令 (无前缀)
+  CMD_CHANNEL_SCRIPT,      // 串口脚本 (@前缀，通常带WAIT)
+  CMD_CHANNEL_INTERNAL,    // 固件内部时间线
+  CMD_CHANNEL_COUNT
+} CommandChannelId_t;
+
+/* Command token --------------------------------------------------------------*/
+// 入队时直接在串口消息缓冲区中分词，只记录位置和长度，不复制、不修改输入
 typedef struct {
-  char command_line[CMD_MAX_COMMAND_LENGTH]; // 完整命令行
-  char *params[CMD_MAX_PARAMS];              // 参数指针数组
-  uint8_t param_count;                       // 参数数量
-  uint32_t wait_cycles;                      // 等待周期（用于WAIT命令）
-} ParsedCommand_t;
+  const char *text; // 指向输入缓冲区 (不以'\0'结尾)
+  uint8_t length;
+} CommandToken_t;
+
+/* Queued command record -----------------------------------------------------*/
+// 入队时把命令名解析为操作码 (命令索引中最深一层命令的节点下标)，执行时
+// 直接调用该节点的回调，父命令的回调不再执行 (它们只检查是否带了子命令)。
+// 记录中依次保存命令表声明的整数参数 (int32_t，入队时已检查格式) 和其余
+// 参数 (依次以'\0'结尾)；WAIT只保存毫秒数。
+// 执行器按引用读取记录，回调返回后才释放其空间。
+// 带标签的命令入队出错时也占一条记录 (状态和错误信息)，轮到它时才输出
+// 错误并应答，保证同一通道的错误和应答顺序与请求顺序一致。
+typedef struct {
+  uint8_t size;         // 记录总字节数 (含参数)，0为回绕标记
+  uint8_t param_count;  // 回调的参数数量 (含命令名)
+  uint8_t opcode;       // 命令节点下标或CMD_OP_*
+  uint32_t enqueued_ms; // 入队时间 (统计排队延迟)
+  uint16_t tag;         // 请求标签，0为不带标签
+} __attribute__((packed)) CommandRecord_t;
 
 /* Command queue structure ---------------------------------------------------*/
+// 变长记录的字节环: 入队只写tail，执行器只写head (单生产者单消费者，
+// 无需关中断)。末尾放不下一条记录时写回绕标记，从头开始。
+typedef struct {
+  uint32_t dropped;        // 队列满丢弃的命令数
+  uint32_t latencyCount;   // 入队到开始执行的延迟 (ms)
+  uint32_t latencyTotalMs;
+  uint32_t latencyMaxMs;
+  uint16_t maxDepth;       // 最大积压条数
+} CommandChannelStats_t;
+
 typedef struct {
-  ParsedCommand_t commands[CMD_MAX_COMMANDS]; // 命令队列
-  volatile uint16_t head;                     // 队列头
-  volatile uint16_t tail;                     // 队列尾
-  volatile uint16_t count;                    // 队列中命令数量
-  volatile uint32_t current_wait_cycles;      // 当前等待周期计数器
-} CommandQueue_t;
+  uint8_t *arena;              // 命令记录
+  uint16_t size;               // arena字节数
+  volatile uint16_t head;      // 下一条待执行记录 (消费者)
+  volatile uint16_t tail;      // 下一条记录写入位置 (生产者)
+  volatile uint16_t enqueued;  // 累计入队条数 (生产者)
+  volatile uint16_t executed;  // 累计执行条数 (消费者)
+  uint8_t weight;              // 轮转时每轮最多执行的条数
+  TimerWheelTimer_t wait;      // WAIT定时器 (启动期间该通道暂停)
+  CommandChannelStats_t stats;
+  uint16_t waitTag;            // 进行中的WAIT的标签 (到期时应答)
+  uint32_t waitLatencyMs;      // 进行中的WAIT的排队延迟 (应答带上)
+} CommandChannel_t;
+
+/* Command profile -----------------------------------------------------------*/
+typedef struct {
+  uint32_t count;     // 执行次数
+  uint32_t totalUs;   // 累计耗时
+  uint32_t maxCycles; // 最长一次 (CPU周期)
+} CommandProfile_t;
 
 /* Function prototypes -------------------------------------------------------*/
 
@@ -76,10 +174,19 @@ void Commands_Init(void);
 /**
  * @brief Parse and enqueue commands from input string
  * @param input Input command string (commands separated by ';')
- * @return Number of commands successfully parsed and enqueued
+ * @return Number of commands successfully parsed and enqueued (带标签的命令
+ *         解析失败时也入队，错误随其应答按顺序输出，同样计入)
+ * @note 行首为CMD_PREFIX_URGENT/CMD_PREFIX_SCRIPT时整行进入紧急/脚本通道，
+ *       否则进入交互通道
  */
 uint16_t Commands_Parse_And_Enqueue(const char *input);
 
+/**
+ * @brief 解析命令并放入指定通道
+ * @return 成功入队的命令数 (含带标签的拒绝记录)
+ */
+uint16_t Commands_Enqueue_Channel(uint8_t channel, const char *input);
+
 /**
  * @brief Execute one command from the queue (called by executor loop)
  * @return Command execution status
@@ -88,10 +195,15 @@ CommandStatus_t Commands_Execute_Next(void);
 
 /**
  * @brief Get queue status
- * @return Number of commands in queue
+ * @return Number of commands in queue (all channels)
  */
 uint16_t Commands_Get_Queue_Count(void);
 
+/**
+ * @brief 队列已占用的字节数 (含回绕留下的空隙)
+ */
+uint16_t Commands_Get_Queue_Bytes(void);
+
 /**
  * @brief Clear all commands in queue
  */
@@ -104,43 +216,222 @@ void Commands_Clear_Queue(void);
 bool Commands_Is_Queue_Empty(void);
 
 /**
- * @brief Command executor loop function (call this from timer interrupt)
+ * @brief Command executor loop function (one executor tick, main loop)
  */
 void Commands_Executor_Loop(void);
 
+/**
+ * @brief 执行器每个节拍的时间预算 (超出范围返回false)
+ */
+bool Commands_Set_Budget(uint16_t us);
+uint16_t Commands_Get_Budget(void);
+
+/**
+ * @brief 通道状态: 名称、积压条数/字节数、WAIT剩余毫秒数、统计
+ * @return channel超出范围时返回false
+ */
+bool Commands_Get_Channel(uint8_t channel, const char **name, uint16_t *count,
+                          uint16_t *bytes, uint16_t *size, uint32_t *waitMs,
+                          CommandChannelStats_t *stats);
+void Commands_Reset_Channel_Stats(void);
+
+/**
+ * @brief 按顶层命令读取/清除执行耗时统计 (index超出命令表时返回false)
+ */
+bool Commands_Get_Profile(uint8_t index, const char **name,
+                          CommandProfile_t *profile);
+void Commands_Reset_Profile(void);
+
+/**
+ * @brief 测量命令查找耗时 (DWT周期数/条): 逐表字符串比较与入队时的索引查找
+ */
+void Commands_Benchmark(uint32_t *linearCycles, uint32_t *hashedCycles);
+
+/**
+ * @brief 正在执行的命令的整数参数 (命令表声明的前int_args个参数)
+ * @param index 与params下标相同 (params[0]为命令名)
+ * @note 这些参数在params中为空串，只能用此函数读取
+ */
+int32_t Commands_Int_Param(uint8_t index);
+
+/**
+ * @brief 安静模式: 不输出命令回显和入队提示 (错误和结果照常输出)
+ */
+void Commands_Set_Quiet(bool quiet);
+bool Commands_Is_Quiet(void);
+
 /**
  * @brief Command result printf function
  * @param format Format string
  * @param ... Variable arguments
  * @return Number of characters written
+ * @note 执行带标签的命令时每行以"#$%>id=<标签> "开头
  */
 int Commands_Result_Printf(const char *format, ...);
 
+/**
+ * @brief 命令错误输出 (format不含"Error: "前缀)
+ * @return Number of characters written
+ * @note 执行带标签的命令时输出"#$%>id=<标签> err=<内容>"，否则输出
+ *       "Error: <内容>"。带标签的命令入队时出错，内容先存入队列记录，
+ *       轮到它执行时再输出，紧接着是它的应答行
+ */
+int Commands_Error_Printf(const char *format, ...);
+
 /* Command callback function prototypes -------------------------------------*/
 // 这些函数需要在其他模块中实现
 CommandStatus_t Cmd_Power_Handler(const char *params[], uint8_t param_count);
 CommandStatus_t Cmd_Power_Off_Handler(const char *params[],
                                       uint8_t param_count);
 CommandStatus_t Cmd_Power_On_Handler(const char *params[], uint8_t param_count);
-CommandStatus_t Cmd_Power_Ch1_Handler(const char *params[],
-                                      uint8_t param_count);
-CommandStatus_t Cmd_Power_Ch2_Handler(const char *params[],
-                                      uint8_t param_count);
-CommandStatus_t Cmd_Power_Ch1_Read_Handler(const char *params[],
-                                           uint8_t param_count);
-CommandStatus_t Cmd_Power_Ch1_Set_Handler(const char *params[],
+CommandStatus_t Cmd_Power_Ch_Handler(const char *params[],
+                                     uint8_t param_count);
+CommandStatus_t Cmd_Power_Ch_Read_Handler(const char *params[],
                                           uint8_t param_count);
-CommandStatus_t Cmd_Power_Ch2_Read_Handler(const char *params[],
-                                           uint8_t param_count);
-CommandStatus_t Cmd_Power_Ch2_Set_Handler(const char *params[],
+CommandStatus_t Cmd_Power_Ch_Set_Handler(const char *params[],
+                                         uint8_t param_count);
+CommandStatus_t Cmd_Power_Ch_Fade_Handler(const char *params[],
                                           uint8_t param_count);
+CommandStatus_t Cmd_Power_Ch_Limit_Handler(const char *params[],
+                                           uint8_t param_count);
+CommandStatus_t Cmd_Power_Ch_Mix_Handler(const char *params[],
+                                         uint8_t param_count);
 CommandStatus_t Cmd_Power_Fade_Handler(const char *params[],
                                        uint8_t param_count);
 
 CommandStatus_t Cmd_Fan_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Fan_Read_Handler(const char *params[],
+                                     uint8_t param_count);
 CommandStatus_t Cmd_Fan_Auto_Handler(const char *params[], uint8_t param_count);
 CommandStatus_t Cmd_Fan_Force_Handler(const char *params[],
                                       uint8_t param_count);
+CommandStatus_t Cmd_Fan_Mode_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Fan_Curve_Handler(const char *params[],
+                                      uint8_t param_count);
+CommandStatus_t Cmd_Fan_Hyst_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Fan_Pid_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Fan_Tach_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Fan_Rpm_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Fan_Minrpm_Handler(const char *params[],
+                                       uint8_t param_count);
+CommandStatus_t Cmd_Fan_History_Handler(const char *params[],
+                                        uint8_t param_count);
+
+CommandStatus_t Cmd_Color_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Color_Read_Handler(const char *params[],
+                                       uint8_t param_count);
+CommandStatus_t Cmd_Color_Mode_Handler(const char *params[],
+                                       uint8_t param_count);
+CommandStatus_t Cmd_Color_Duv_Handler(const char *params[],
+                                      uint8_t param_count);
+CommandStatus_t Cmd_Color_XY_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Color_Flux_Handler(const char *params[],
+                                       uint8_t param_count);
+
+CommandStatus_t Cmd_Effect_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Effect_Off_Handler(const char *params[],
+                                       uint8_t param_count);
+CommandStatus_t Cmd_Effect_Read_Handler(const char *params[],
+                                        uint8_t param_count);
+CommandStatus_t Cmd_Effect_Breathe_Handler(const char *params[],
+                                           uint8_t param_count);
+CommandStatus_t Cmd_Effect_Candle_Handler(const char *params[],
+                                          uint8_t param_count);
+CommandStatus_t Cmd_Effect_Strobe_Handler(const char *params[],
+                                          uint8_t param_count);
+
+CommandStatus_t Cmd_Preset_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Preset_Recall_Handler(const char *params[],
+                                          uint8_t param_count);
+CommandStatus_t Cmd_Preset_Store_Handler(const char *params[],
+                                         uint8_t param_count);
+CommandStatus_t Cmd_Preset_Read_Handler(const char *params[],
+                                        uint8_t param_count);
+CommandStatus_t Cmd_Preset_Fade_Handler(const char *params[],
+                                        uint8_t param_count);
+
+CommandStatus_t Cmd_Pwm_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Pwm_Read_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Pwm_Profile_Handler(const char *params[],
+                                        uint8_t param_count);
+
+CommandStatus_t Cmd_Lumen_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Lumen_Read_Handler(const char *params[],
+                                       uint8_t param_count);
+CommandStatus_t Cmd_Lumen_Comp_Handler(const char *params[],
+                                       uint8_t param_count);
+CommandStatus_t Cmd_Lumen_Curve_Handler(const char *params[],
+                                        uint8_t param_count);
+CommandStatus_t Cmd_Lumen_Reset_Handler(const char *params[],
+                                        uint8_t param_count);
+
+CommandStatus_t Cmd_Reg_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Reg_Read_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Reg_Mode_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Reg_Set_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Reg_Hold_Handler(const char *params[], uint8_t param_count);
+
+CommandStatus_t Cmd_Latency_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Latency_Read_Handler(const char *params[],
+                                         uint8_t param_count);
+CommandStatus_t Cmd_Latency_Fast_Handler(const char *params[],
+                                         uint8_t param_count);
+CommandStatus_t Cmd_Latency_Reset_Handler(const char *params[],
+                                          uint8_t param_count);
+
+CommandStatus_t Cmd_Adc_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Adc_Read_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Adc_Bench_Handler(const char *params[],
+                                      uint8_t param_count);
+CommandStatus_t Cmd_Adc_Point_Handler(const char *params[],
+                                      uint8_t param_count);
+CommandStatus_t Cmd_Adc_Trip_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Adc_Clear_Handler(const char *params[],
+                                      uint8_t param_count);
+
+CommandStatus_t Cmd_Therm_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Therm_Read_Handler(const char *params[],
+                                       uint8_t param_count);
+CommandStatus_t Cmd_Therm_Model_Handler(const char *params[],
+                                        uint8_t param_count);
+CommandStatus_t Cmd_Therm_Obs_Handler(const char *params[],
+                                      uint8_t param_count);
+CommandStatus_t Cmd_Therm_Power_Handler(const char *params[],
+                                        uint8_t param_count);
+CommandStatus_t Cmd_Therm_Heat_Handler(const char *params[],
+                                       uint8_t param_count);
+CommandStatus_t Cmd_Therm_Fan_Handler(const char *params[],
+                                      uint8_t param_count);
+CommandStatus_t Cmd_Therm_Limit_Handler(const char *params[],
+                                        uint8_t param_count);
+CommandStatus_t Cmd_Therm_Step_Handler(const char *params[],
+                                       uint8_t param_count);
+CommandStatus_t Cmd_Therm_Log_Handler(const char *params[],
+                                      uint8_t param_count);
+CommandStatus_t Cmd_Therm_Fit_Handler(const char *params[],
+                                      uint8_t param_count);
+
+CommandStatus_t Cmd_Hist_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Hist_Read_Handler(const char *params[],
+                                      uint8_t param_count);
+CommandStatus_t Cmd_Hist_Dump_Handler(const char *params[],
+                                      uint8_t param_count);
+CommandStatus_t Cmd_Hist_Snap_Handler(const char *params[],
+                                      uint8_t param_count);
+CommandStatus_t Cmd_Hist_Oled_Handler(const char *params[],
+                                      uint8_t param_count);
+
+CommandStatus_t Cmd_Cmd_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Cmd_Isr_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Cmd_Prof_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Cmd_Budget_Handler(const char *params[],
+                                       uint8_t param_count);
+CommandStatus_t Cmd_Cmd_Chan_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Cmd_Bin_Handler(const char *params[], uint8_t param_count);
+CommandStatus_t Cmd_Cmd_Quiet_Handler(const char *params[],
+                                      uint8_t param_count);
+CommandStatus_t Cmd_Cmd_Bench_Handler(const char *params[],
+                                      uint8_t param_count);
 
 CommandStatus_t Cmd_Sleep_Handler(const char *params[], uint8_t param_count);
 CommandStatus_t Cmd_Sleep_Deep_Handler(const char *params[],
@@ -1,10 +1,19 @@
 #include "controller.h"
+#include "analog.h"
+#include "color_engine.h"
+#include "effects.h"
+#include "fan.h"
+#include "history.h"
+#include "latency.h"
+#include "lumen.h"
+#include "presets.h"
+#include "pwm_profile.h"
+#include "regulator.h"
+#include "thermal.h"
 #include "custom_types.h"
 #include "drivers/settings.h"
-#include "gamma_table.h"
 #include "global_objects.h"
 #include "stm32f1xx_hal.h"
-#include "temp_adc.h"
 #include "tim.h"
 #include "u8g2.h"
 #include <adc.h>
@@ -15,6 +24,15 @@
 
 unsigned char btn_changed = 0;
 unsigned char settings_changed = 0; // 设置已更改标志
+unsigned char pwm_dirty = 0;        // 通道参数变化，需要重新计算目标PWM
+
+// 交叉渐变中各通道的步进 (0=使用通道默认步进)
+static uint16_t crossfadeStep[LED_CHANNEL_COUNT];
+
+// 最近一次PWM更新节拍的效果增益 (输入快速路径沿用，不推进效果相位)
+static uint16_t lastEffectGain = EFFECT_GAIN_ONE;
+
+static void applyInputNow();
 
 // 启动弹跳动画
 void startBounceAnimation() {
@@ -106,13 +124,29 @@ void updateFanModeAnimation() {
   }
 }
 
-// 计算色温对应的两个通道比例
-// 修正后的色温通道比例计算函数
+// 计算色温对应的各通道比例
+// CIE模式: 参与色度求解的通道按缓存表权重分配占空比(伽马只作用于总亮度，
+//          保证通道间占空比比例即求解比例)；其余通道按混合权重跟随总亮度
+// MIRED模式: CH1(暖白)/CH2(冷白)按mired插值混合，CH3/CH4按混合权重跟随总亮度
 void calculateChannelRatio(uint16_t colorTemp, uint16_t brightness,
-                           uint16_t *ch1PWM, uint16_t *ch2PWM) {
+                           uint16_t *pwm) {
   if (brightness == 0) {
-    *ch1PWM = 0;
-    *ch2PWM = 0;
+    forEachChannel([&](uint8_t ch) { pwm[ch] = 0; });
+    return;
+  }
+
+  if (Color_Enabled()) {
+    uint16_t weight[LED_CHANNEL_COUNT];
+    Color_GetWeights(colorTemp, weight);
+    forEachChannel([&](uint8_t ch) {
+      if (Color_IsSolved(ch)) {
+        uint32_t full = Channels_LevelToPWM(ch, brightness);
+        pwm[ch] = (full * weight[ch]) / COLOR_WEIGHT_ONE;
+      } else {
+        pwm[ch] = Channels_LevelToPWM(
+            ch, (brightness * channels.mix[ch]) / CHANNEL_MIX_TOTAL);
+      }
+    });
     return;
   }
 
@@ -133,36 +167,29 @@ void calculateChannelRatio(uint16_t colorTemp, uint16_t brightness,
   // 0 = 纯线性混合，100 = 完全叠加混合
 
   // 计算各通道的基础权重 (0-LED_TEMP_WEIGHT_TOTAL)
-  int32_t warm_weight = LED_TEMP_WEIGHT_TOTAL - cct_ratio; // ch1 (暖白) 权重
-  int32_t cold_weight = cct_ratio;
-
-  uint16_t ch1_brightness, ch2_brightness;
-
-  // 计算线性混合的亮度
-  int32_t ch1_linear = (brightness * warm_weight) / LED_TEMP_WEIGHT_TOTAL;
-  int32_t ch2_linear = (brightness * cold_weight) / LED_TEMP_WEIGHT_TOTAL;
-
-  // 计算叠加混合的亮度
-  int32_t ch1_additive = (warm_weight > 0) ? brightness : 0;
-  int32_t ch2_additive = (cold_weight > 0) ? brightness : 0;
-
-  // 根据叠加混合比例插值
-  ch1_brightness = ((ch1_linear * (LED_TEMP_SPRI_TOTAL - CCT_ADDITIVE_BLEND)) +
-                    (ch1_additive * CCT_ADDITIVE_BLEND)) /
-                   LED_TEMP_SPRI_TOTAL;
-  ch2_brightness = ((ch2_linear * (LED_TEMP_SPRI_TOTAL - CCT_ADDITIVE_BLEND)) +
-                    (ch2_additive * CCT_ADDITIVE_BLEND)) /
-                   LED_TEMP_SPRI_TOTAL;
-
-  // 限制最大值
-  if (ch1_brightness > LED_MAX_BRIGHTNESS)
-    ch1_brightness = LED_MAX_BRIGHTNESS;
-  if (ch2_brightness > LED_MAX_BRIGHTNESS)
-    ch2_brightness = LED_MAX_BRIGHTNESS;
-
-  // 分别对每个通道进行伽马校正
-  *ch1PWM = (ch1_brightness > 0) ? gammaTable[ch1_brightness] : 0;
-  *ch2PWM = (ch2_brightness > 0) ? gammaTable[ch2_brightness] : 0;
+  int32_t weight[2];
+  weight[LED_CHANNEL_WARM] = LED_TEMP_WEIGHT_TOTAL - cct_ratio; // 暖白权重
+  weight[LED_CHANNEL_COLD] = cct_ratio;                         // 冷白权重
+
+  forEachChannel([&](uint8_t ch) {
+    int32_t level;
+    if (ch < 2) {
+      // 计算线性混合的亮度
+      int32_t linear = (brightness * weight[ch]) / LED_TEMP_WEIGHT_TOTAL;
+      // 计算叠加混合的亮度
+      int32_t additive = (weight[ch] > 0) ? brightness : 0;
+      // 根据叠加混合比例插值
+      level = ((linear * (LED_TEMP_SPRI_TOTAL - CCT_ADDITIVE_BLEND)) +
+               (additive * CCT_ADDITIVE_BLEND)) /
+              LED_TEMP_SPRI_TOTAL;
+    } else {
+      // 辅助通道按混合权重跟随总亮度
+      level = (brightness * channels.mix[ch]) / CHANNEL_MIX_TOTAL;
+    }
+
+    // 伽马校正并限幅
+    pwm[ch] = Channels_LevelToPWM(ch, level);
+  });
 }
 
 // 处理按钮单击事件 - 在色温和亮度之间切换，始终编辑状态
@@ -238,149 +265,39 @@ void handleLongPress() {
   }
 }
 
-void turnOn() {
-  if (!state.master) {
-    state.master = true;
+void setMaster(bool on) {
+  if (on == state.master) {
+    return;
+  }
+  state.master = on;
+  if (on) {
     // 开机的时候要重新设置目标PWM
-    calculateChannelRatio(state.colorTemp, state.brightness,
-                          &state.targetCh1PWM, &state.targetCh2PWM);
-    // 启动弹跳动画
-    startBounceAnimation();
+    calculateChannelRatio(state.colorTemp, state.brightness, state.targetPWM);
+  } else {
+    forEachChannel([](uint8_t ch) { state.targetPWM[ch] = 0; });
   }
+  // 启动弹跳动画
+  startBounceAnimation();
+}
+
+void turnOn() {
+  setMaster(true);
   serial_printf("Master Power: ON\r\n");
 }
 
 void turnOff() {
-  if (state.master) {
-    state.master = false;
-    state.targetCh1PWM = 0;
-    state.targetCh2PWM = 0;
-    // 启动弹跳动画
-    startBounceAnimation();
-  }
+  setMaster(false);
   serial_printf("Master Power: OFF\r\n");
 }
 
-/**
- * @brief 使用查找表和线性插值计算温度
- * @param adc_value 12位ADC采样值 (0-4095)
- * @return 温度值×100 (例如: 2550表示25.5℃)
- *         返回-99900表示传感器开路或超出测量范围
- */
-int32_t adc_to_temperature_fast(uint16_t adc_value) {
-  if (adc_value == 0 || adc_value >= 4095) {
-    return -99900L;
-  }
-
-  // 查找表二分搜索
-  int left = 0;
-  int right = TEMP_TABLE_SIZE - 1;
-
-  // 边界检查
-  uint16_t min_adc = tempTableADC[0];
-  uint16_t max_adc = tempTableADC[TEMP_TABLE_SIZE - 1];
-
-  if (adc_value <= min_adc) {
-    return tempTableTemp[0];
-  }
-  if (adc_value >= max_adc) {
-    return tempTableTemp[TEMP_TABLE_SIZE - 1];
-  }
-
-  // 二分查找
-  while (left < right - 1) {
-    int mid = (left + right) / 2;
-    uint16_t mid_adc = tempTableADC[mid];
-
-    if (adc_value <= mid_adc) {
-      right = mid;
-    } else {
-      left = mid;
-    }
-  }
-
-  // 线性插值
-  uint16_t adc1 = tempTableADC[left];
-  uint16_t adc2 = tempTableADC[right];
-  int16_t temp1 = tempTableTemp[left];
-  int16_t temp2 = tempTableTemp[right];
-
-  if (adc2 == adc1) {
-    return temp1;
-  }
-
-  // 线性插值: temp = temp1 + (temp2-temp1) * (adc-adc1) / (adc2-adc1)
-  int32_t temp_diff = temp2 - temp1;
-  int32_t adc_diff = adc2 - adc1;
-  int32_t adc_offset = adc_value - adc1;
-
-  int32_t result = temp1 + (temp_diff * adc_offset) / adc_diff;
-
-  return result;
-}
-
-// 更新ADC读取数据
+// 把最新温度交给风扇控制 (温度由ADC的DMA中断持续更新，
+// 开启结温估计时为预测结温)
 void updateADC() {
   static uint32_t lastUpdateADCTime = 0;
   uint32_t now = HAL_GetTick();
-  if (now - lastUpdateADCTime > ADC_READ_INTERVAL) {
+  if (now - lastUpdateADCTime > ADC_READ_INTERVAL && Analog_Ready()) {
     lastUpdateADCTime = now;
-    // state.temp = adc_to_temperature_fast(analogRead(TEMP_ADC));
-    // 这里可能是第二次循环才进来
-    if (adc_done_flag) {
-      state.temp = adc_to_temperature_fast(adc_value);
-      adc_done_flag = 0;
-    } else {
-      HAL_ADC_Start_IT(&hadc1); // 开启采样
-    }
-  }
-
-  static uint32_t lastUpdateFanTime = 0;
-  if (now - lastUpdateFanTime > FAN_UPDATE_INTERVAL) {
-
-    lastUpdateFanTime = now;
-    // 以下是模拟PWM与风扇控制
-    if (!state.fanAuto) {
-      // digitalWrite(FAN_EN, HIGH);
-      open_fan();
-      return;
-    }
-    int16_t tempNow = state.temp;
-    if (tempNow < FAN_START_TEMP) {
-      // digitalWrite(FAN_EN, LOW);
-      close_fan();
-      return;
-    }
-    if (tempNow > FAN_FULL_TEMP) {
-      // digitalWrite(FAN_EN, HIGH);
-      open_fan();
-      return;
-    }
-
-    // PWM控制：固定总周期数，根据温度分配开启/关闭次数
-    static uint16_t cycleCounter = 0;
-
-    // 根据温度计算占空比 (0-100)
-    uint16_t tempRange = FAN_FULL_TEMP - FAN_START_TEMP;
-    uint16_t tempOffset = tempNow - FAN_START_TEMP;
-    uint16_t dutyCycle = (tempOffset * 100) / tempRange; // 0-100的占空比
-
-    // 计算开启周期数
-    uint16_t onCycles = (dutyCycle * TOTAL_CYCLES) / 100;
-
-    // PWM输出控制
-    cycleCounter++;
-    if (cycleCounter > TOTAL_CYCLES) {
-      cycleCounter = 1; // 重新开始周期
-    }
-
-    if (cycleCounter <= onCycles) {
-      // digitalWrite(FAN_EN, HIGH);  // 开启阶段
-      open_fan();
-    } else {
-      // digitalWrite(FAN_EN, LOW);   // 关闭阶段
-      close_fan();
-    }
+    Fan_Temperature_Sample(Thermal_Control_Temperature());
   }
 }
 
@@ -405,9 +322,6 @@ void handleEnc(EncoderDirection_t direction, int32_t steps,
 
   btn_changed = 1;
 
-  serial_printf("Encoder Event: Dir=%d, Steps=%d, Speed=%d\r\n", (int)direction,
-                (int)steps, (int)speed);
-
   if (state.edit == 0) {
     // // 编辑模式：根据旋转速度调整步进大小
     // uint32_t td = millis() - lastTime;
@@ -426,7 +340,17 @@ void handleEnc(EncoderDirection_t direction, int32_t steps,
                     0, LED_MAX_BRIGHTNESS);
     }
     settings_changed = 1;
+
+    // 快速路径: 在编码器中断中立即重算目标并写比较寄存器，不等主循环和TIM3节拍
+    Latency_Input();
+    if (Latency_Fast_Path()) {
+      applyInputNow();
+    }
   }
+
+  // 串口阻塞发送，放在出光之后
+  serial_printf("Encoder Event: Dir=%d, Steps=%d, Speed=%d\r\n", (int)direction,
+                (int)steps, (int)speed);
   //     } else {
   //       // 导航模式：选择项目
   //       state.item = (state.item + dir + 3) % 3;
@@ -888,6 +812,59 @@ void drawItemSwitchAnimation() {
 }
 
 // 更新显示屏
+// 时间序列曲线页: 每桶一条最小-最大竖线加平均值横线，纵轴按可见范围自动缩放
+static void drawHistoryPage(uint8_t series, uint8_t res) {
+  const uint8_t plotTop = 10;
+  const uint8_t plotHeight = 64 - plotTop;
+  uint8_t count = History_Count(res);
+  uint8_t width = 120 / History_Capacity(res);
+
+  int32_t lo = INT32_MAX;
+  int32_t hi = INT32_MIN;
+  int32_t latest = 0;
+  bool hasLatest = false;
+  for (uint8_t age = 0; age < count; age++) {
+    int32_t mn, mx, avg;
+    if (!History_Get(res, age, series, &mn, &mx, &avg)) {
+      continue;
+    }
+    if (!hasLatest) {
+      latest = avg;
+      hasLatest = true;
+    }
+    lo = (mn < lo) ? mn : lo;
+    hi = (mx > hi) ? mx : hi;
+  }
+
+  char value[12];
+  char title[32];
+  History_Format(series, latest, value, sizeof(value));
+  snprintf(title, sizeof(title), "%s/%s %s", History_Series_Name(series),
+           History_Res_Name(res), hasLatest ? value : "--");
+  u8g2.setFont(u8g2_font_6x10_tf);
+  u8g2.drawStr(0, 7, title);
+  if (!hasLatest) {
+    return;
+  }
+  if (hi == lo) {
+    hi = lo + 1;
+  }
+
+  // 最新的桶在右侧
+  for (uint8_t age = 0; age < count; age++) {
+    int32_t mn, mx, avg;
+    if (!History_Get(res, age, series, &mn, &mx, &avg)) {
+      continue;
+    }
+    int x = 127 - (age + 1) * width;
+    int yMax = 63 - (int)((mx - lo) * (plotHeight - 1) / (hi - lo));
+    int yMin = 63 - (int)((mn - lo) * (plotHeight - 1) / (hi - lo));
+    int yAvg = 63 - (int)((avg - lo) * (plotHeight - 1) / (hi - lo));
+    u8g2.drawVLine(x, yMax, yMin - yMax + 1);
+    u8g2.drawHLine(x, yAvg, width);
+  }
+}
+
 void updateDisp() {
   static uint32_t lastAnim = 0;
   static uint8_t animFrame = 0;
@@ -960,6 +937,14 @@ void updateDisp() {
     u8g2.setContrast(255); // 恢复正常对比度
   }
 
+  // 时间序列曲线页代替主界面，直到命令关闭
+  uint8_t historySeries = History_Display_Series();
+  if (historySeries != HISTORY_SERIES_NONE) {
+    drawHistoryPage(historySeries, History_Display_Resolution());
+    u8g2.sendBuffer();
+    return;
+  }
+
   // === 顶部温度信息（动画更新） ===
   if (animUpdate || stateChanged) {
     u8g2.setFont(u8g2_font_6x10_tf);
@@ -971,6 +956,9 @@ void updateDisp() {
 
     if (state.temp == -99900L) {
       sprintf(tempStr, "LED:--.-C");
+    } else if (Analog_Tripped()) {
+      // 过温关断，输出已被切断，等待命令解除
+      sprintf(tempStr, "OTP:%d.%02dC", temp_int, temp_frac);
     } else {
       sprintf(tempStr, "LED:%d.%02dC", temp_int, temp_frac);
     }
@@ -982,7 +970,14 @@ void updateDisp() {
       drawFanModeAnimation();
     } else {
       // 正常显示风扇状态
+      // 风扇报警时显示报警代替模式
+      uint8_t fan_alarm = Fan_Get_Alarm();
       const char *fan_status = state.fanAuto ? " AUTO" : "FORCE";
+      if (fan_alarm == FAN_ALARM_STALL) {
+        fan_status = "STALL";
+      } else if (fan_alarm == FAN_ALARM_SLOW) {
+        fan_status = " SLOW";
+      }
       u8g2.drawStr(96, 7, fan_status);
     }
   }
@@ -1118,36 +1113,135 @@ int16_t lerp(int16_t current, int16_t target, int16_t step) {
 }
 
 void calcPWM() {
+  // 色度数据变化后重建缓存表 (耗时较长，放在主循环而不是命令中断里)
+  if (Color_Update()) {
+    pwm_dirty = 1;
+  }
+
+  // 通道参数变化时同时重算预设的目标PWM
+  Presets_Process(pwm_dirty);
+
   // 只有在参数变化时才重新计算
   if (state.master) {
-    if ((state.colorTemp != lastState.colorTemp ||
-         state.brightness != lastState.brightness)) {
-      lastState.colorTemp = state.colorTemp;
-      lastState.brightness = state.brightness;
+    uint16_t colorTemp = state.colorTemp;
+    uint16_t brightness = state.brightness;
+    if ((colorTemp != lastState.colorTemp ||
+         brightness != lastState.brightness || pwm_dirty)) {
+      pwm_dirty = 0;
       serial_printf("Calculating PWM: ColorTemp=%dK, Brightness=%d%%\r\n",
-                    state.colorTemp, state.brightness);
-      calculateChannelRatio(state.colorTemp, state.brightness,
-                            &state.targetCh1PWM, &state.targetCh2PWM);
-      lastState.targetCh1PWM = state.targetCh1PWM;
-      lastState.targetCh2PWM = state.targetCh2PWM;
+                    colorTemp, brightness);
+      uint16_t target[LED_CHANNEL_COUNT];
+      calculateChannelRatio(colorTemp, brightness, target);
+
+      // 计算期间编码器中断可能已按更新的输入写入目标，只提交仍对应当前输入的结果
+      __disable_irq();
+      if (state.colorTemp == colorTemp && state.brightness == brightness) {
+        lastState.colorTemp = colorTemp;
+        lastState.brightness = brightness;
+        forEachChannel([&](uint8_t ch) {
+          state.targetPWM[ch] = target[ch];
+          lastState.targetPWM[ch] = target[ch];
+        });
+        Latency_Target_Updated();
+      }
+      __enable_irq();
     }
   } else {
-    state.targetCh1PWM = 0;
-    state.targetCh2PWM = 0;
+    forEachChannel([](uint8_t ch) { state.targetPWM[ch] = 0; });
+    pwm_dirty = 0; // 开机时turnOn会重新计算
+  }
+}
+
+// 所有通道在fade_ms内同时到达目标PWM
+void startCrossfade(const uint16_t *target, uint16_t fade_ms) {
+  uint32_t ticks = ((uint32_t)fade_ms * PWM_UPDATE_HZ) / 1000;
+  if (ticks == 0) {
+    ticks = 1;
   }
+
+  // 步进和目标在关中断时一起写入: TIM3中断会在到达目标时清零步进，
+  // 切换PWM配置时换算所有PWM量，都不能夹在两次写入之间
+  __disable_irq();
+  forEachChannel([&](uint8_t ch) {
+    uint32_t diff = abs((int32_t)target[ch] - (int32_t)state.currentPWM[ch]);
+    uint32_t step = (diff + ticks - 1) / ticks;
+    crossfadeStep[ch] = step ? step : 1;
+    state.targetPWM[ch] = target[ch];
+    lastState.targetPWM[ch] = target[ch];
+  });
+  __enable_irq();
+}
+
+// 缓变一步并写比较寄存器 (PWM更新节拍和输入快速路径共用)
+static void stepOutputs(uint16_t gain, uint16_t *out) {
+  // 效果增益、闭环增益、风扇故障降额和结温降额同比例作用于所有通道，
+  // 不改变缓变状态和通道配比
+  uint16_t reg_gain = Regulator_Get_Gain();
+  uint16_t derate = ((uint32_t)Fan_Get_Derate() * Thermal_Get_Derate()) /
+                    THERMAL_DERATE_ONE;
+
+  forEachChannel([&](uint8_t ch) {
+    // 平滑过渡 (交叉渐变期间使用按时长算出的步进)
+    uint16_t step =
+        crossfadeStep[ch] ? crossfadeStep[ch] : channels.fadeStep[ch];
+    state.currentPWM[ch] = lerp(state.currentPWM[ch], state.targetPWM[ch], step);
+    if (state.currentPWM[ch] == state.targetPWM[ch]) {
+      crossfadeStep[ch] = 0;
+    }
+
+    // 输出到硬件
+    out[ch] = ((uint32_t)state.currentPWM[ch] * gain) / EFFECT_GAIN_ONE;
+    out[ch] = ((uint32_t)out[ch] * reg_gain) / REG_GAIN_ONE;
+    out[ch] = ((uint32_t)out[ch] * derate) / FAN_DERATE_ONE;
+    if (out[ch] > channels.limit[ch]) {
+      out[ch] = channels.limit[ch]; // 增益上限已按限幅计算，渐变中仍做兜底
+    }
+    set_pwm(ch, out[ch]);
+  });
+
+  Latency_Output_Written();
+}
+
+// 输入快速路径 (编码器中断中调用，与TIM3/TIM4同优先级，不会互相打断)
+static void applyInputNow() {
+  if (!state.master) {
+    return;
+  }
+
+  calculateChannelRatio(state.colorTemp, state.brightness, state.targetPWM);
+  lastState.colorTemp = state.colorTemp;
+  lastState.brightness = state.brightness;
+  forEachChannel(
+      [](uint8_t ch) { lastState.targetPWM[ch] = state.targetPWM[ch]; });
+  Latency_Target_Updated();
+
+  // 立即缓变一步；不调用Effects_Update/Lumen_Accumulate，节拍计时保持不变
+  uint16_t out[LED_CHANNEL_COUNT];
+  stepOutputs(lastEffectGain, out);
 }
 
 // 更新PWM输出
 void updatePWM() {
-  // 平滑过渡
-  state.currentCh1PWM =
-      lerp(state.currentCh1PWM, state.targetCh1PWM, PWM_FADE_STEP);
-  state.currentCh2PWM =
-      lerp(state.currentCh2PWM, state.targetCh2PWM, PWM_FADE_STEP);
-
-  // 输出到硬件
-  set_pwm1(state.currentCh1PWM);
-  set_pwm2(state.currentCh2PWM);
+  uint16_t gain = Effects_Update();
+  uint16_t out[LED_CHANNEL_COUNT];
+  lastEffectGain = gain;
+
+  // 切换PWM配置: 所有PWM量换算到新量程，比较值与新周期在同一个周期边界生效
+  bool switching = PwmProfile_Begin_Switch();
+  if (switching) {
+    forEachChannel([](uint8_t ch) {
+      crossfadeStep[ch] = PwmProfile_Rescale(crossfadeStep[ch]);
+    });
+  }
+
+  stepOutputs(gain, out);
+
+  if (switching) {
+    PwmProfile_End_Switch();
+  }
+
+  // 按实际输出累计光衰时长
+  Lumen_Accumulate(out);
 }
 
 // 程序主循环
@@ -1179,6 +1273,12 @@ void loop() {
   // updatePWM();
   calcPWM();
   updateADC();
+  Lumen_Process();
+  Regulator_Process();
+  Fan_Process();
+  Analog_Process();
+  Thermal_Process();
+  History_Process();
 
   // 息屏处理
   if (now - lastChanged > SLEEP_TIME_MS) {
@@ -3,6 +3,7 @@
 #include <stdbool.h>
 // uint8_t, uint16_t, etc.
 #include "drivers/encoder.h"
+#include "global/channels.h"
 #include <stdint.h>
 
 // 时间参数 (Time parameters)
@@ -27,11 +28,9 @@
 
 // ADC相关
 #define ADC_POW 12             // ADC读取精度
-#define ADC_READ_INTERVAL 250  // ADC读取间隔
+#define ADC_READ_INTERVAL 250  // 温度交给风扇控制的间隔
 #define FAN_START_TEMP 4500    // 风扇开始旋转的温度 x100
 #define FAN_FULL_TEMP 8000     // 风扇满速的温度    x100
-#define FAN_UPDATE_INTERVAL 50 // 风扇状态更新间隔
-#define TOTAL_CYCLES 20        // 多少次循环为一个周期
 
 // NTC参数定义
 #define R0_OHMS 100000L   // 25℃时NTC电阻值 (100K)
@@ -42,8 +41,9 @@
 #define VCC_MV 3300L      // 电源电压 (mV)
 
 // PWM 缓变
-#define MAX_PWM 6100      // 最大PWM值
-#define PWM_FADE_STEP 256 // PWM 每次缓变最大值
+#define MAX_PWM 6100      // 标准PWM配置的周期 (EEPROM中PWM量的满量程)
+#define PWM_FADE_STEP 64 // PWM 每次缓变最大值 (各通道默认值，标准量程，TIM3约116Hz)
+#define PWM_UPDATE_HZ 116 // PWM缓变频率 (TIM3: 128MHz / 700 / 1575)
 // #define PWM_FADE_INTERVAL_MS 32 // 每隔32ms更新一次PWM值
 #define CALC_PWM_INTERVAL_MS 1000 // 每隔50ms计算一次目标PWM值
 
@@ -58,9 +58,6 @@
 #define CCT_ADDITIVE_BLEND 255      // 推荐100%的叠加混合
 #define LED_MAX_BRIGHTNESS 512      // LED最大亮度值
 
-// 温度查找表定义
-#define TEMP_TABLE_SIZE 30
-
 // 硬件引脚定义 (Hardware pin definitions)
 #define TEMP_ADC_CHANNEL                                                       \
   ADC_CHANNEL_0 // 温度传感器ADC通道
@@ -80,11 +77,6 @@
 #define get_temperature_frac(temp_x100)                                        \
   ((temp_x100 < 0) ? -temp_x100 : temp_x100 % 100)
 
-#define set_pwm1(value) __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_1, value)
-#define set_pwm2(value) __HAL_TIM_SET_COMPARE(&htim1, TIM_CHANNEL_2, value)
-
-#define open_fan() HAL_GPIO_WritePin(FAN_EN_PORT, FAN_EN_PIN, GPIO_PIN_SET)
-#define close_fan() HAL_GPIO_WritePin(FAN_EN_PORT, FAN_EN_PIN, GPIO_PIN_RESET)
 
 // constrain宏定义
 #ifndef constrain
@@ -96,6 +88,20 @@ static const char *activeStates[] = {
     "    ACTIVE    ", "   .ACTIVE.   ", "  ..ACTIVE..  ", " ...ACTIVE... ",
     "... ACTIVE ...", "..  ACTIVE  ..", ".   ACTIVE   .", "    ACTIVE    "};
 
+extern unsigned char btn_changed;      // 有操作，唤醒屏幕
+extern unsigned char settings_changed; // 设置已更改标志
+extern unsigned char pwm_dirty;        // 通道参数变化，需要重新计算目标PWM
+
+// 计算色温/亮度对应的各通道目标PWM (pwm[LED_CHANNEL_COUNT])
+void calculateChannelRatio(uint16_t colorTemp, uint16_t brightness,
+                           uint16_t *pwm);
+
+// 所有通道在fade_ms内同时到达目标PWM (预设调用的交叉渐变)，目标同时写入
+// lastState，calcPWM不再重复计算
+void startCrossfade(const uint16_t *target, uint16_t fade_ms);
+
+// 开关总电源，不输出调试信息 (二进制协议使用)；turnOn/turnOff另外打印
+void setMaster(bool on);
 void turnOn();
 void turnOff();
 void fan_auto();
@@ -0,0 +1,139 @@
+/**
+ * @file deferred.cpp
+ * @brief 延后工作队列和中断耗时统计实现
+ * @author User
+ * @date 2025-10-04
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "deferred.h"
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+static_assert((DEFERRED_QUEUE_SIZE & (DEFERRED_QUEUE_SIZE - 1)) == 0,
+              "DEFERRED_QUEUE_SIZE must be a power of two");
+
+/* Private types -------------------------------------------------------------*/
+
+typedef struct {
+  DeferredWork_t work;
+  uint32_t arg;
+  volatile uint8_t ready; // 生产者写完后置位，消费者取出后清除
+} Slot_t;
+
+/* Private variables ---------------------------------------------------------*/
+static Slot_t slots[DEFERRED_QUEUE_SIZE];
+static volatile uint32_t tail = 0; // 下一个待分配的序号 (生产者LDREX/STREX推进)
+static volatile uint32_t head = 0; // 下一个待执行的序号 (只有主循环写)
+
+// 生产者可能在多个中断和主循环中，计数同样用LDREX/STREX累加
+static volatile uint32_t posted = 0;
+static volatile uint32_t dropped = 0;
+static DeferredStats_t stats; // 其余字段只由主循环或被统计的中断写
+
+/* Private functions ---------------------------------------------------------*/
+
+static void atomicIncrement(volatile uint32_t *value) {
+  uint32_t v;
+  do {
+    v = __LDREXW(value);
+  } while (__STREXW(v + 1, value));
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+bool Deferred_Post(DeferredWork_t work, uint32_t arg) {
+  uint32_t index;
+  do {
+    index = __LDREXW(&tail);
+    if (index - head >= DEFERRED_QUEUE_SIZE) {
+      __CLREX();
+      atomicIncrement(&dropped);
+      return false;
+    }
+  } while (__STREXW(index + 1, &tail));
+
+  // 槽位已归本生产者所有，写完内容再置位ready
+  Slot_t *slot = &slots[index & (DEFERRED_QUEUE_SIZE - 1)];
+  slot->work = work;
+  slot->arg = arg;
+  __DMB();
+  slot->ready = 1;
+  atomicIncrement(&posted);
+  return true;
+}
+
+void Deferred_Run(void) {
+  const uint32_t budget = (SystemCoreClock / 1000000) * DEFERRED_SLICE_US;
+  uint32_t start = DWT->CYCCNT;
+  uint32_t count = 0;
+
+  uint8_t backlog = Deferred_Pending();
+  if (backlog > stats.maxBacklog) {
+    stats.maxBacklog = backlog;
+  }
+
+  while (head != tail) {
+    Slot_t *slot = &slots[head & (DEFERRED_QUEUE_SIZE - 1)];
+    if (!slot->ready) {
+      break; // 已分配但生产者还没写完 (被更高优先级打断)，下一轮再取
+    }
+    if (count > 0 && DWT->CYCCNT - start >= budget) {
+      stats.slices++;
+      break;
+    }
+
+    __DMB();
+    DeferredWork_t work = slot->work;
+    uint32_t arg = slot->arg;
+    slot->ready = 0;
+    __DMB();
+    head = head + 1; // 先释放槽位，工作本身可以再投递
+
+    uint32_t itemStart = DWT->CYCCNT;
+    work(arg);
+    uint32_t cycles = DWT->CYCCNT - itemStart;
+    if (cycles > stats.maxItemCycles) {
+      stats.maxItemCycles = cycles;
+    }
+    stats.executed++;
+    count++;
+  }
+
+  if (count > 0) {
+    uint32_t cycles = DWT->CYCCNT - start;
+    if (cycles > stats.maxSliceCycles) {
+      stats.maxSliceCycles = cycles;
+    }
+  }
+}
+
+uint8_t Deferred_Pending(void) { return (uint8_t)(tail - head); }
+
+uint32_t Deferred_Isr_Enter(void) { return DWT->CYCCNT; }
+
+void Deferred_Isr_Exit(uint32_t start) {
+  uint32_t cycles = DWT->CYCCNT - start;
+  if (cycles > stats.isrMaxCycles) {
+    stats.isrMaxCycles = cycles;
+  }
+  stats.isrSumCycles += cycles;
+  stats.isrCount++;
+}
+
+void Deferred_Get_Stats(DeferredStats_t *out) {
+  // 中断中累加64位的isrSumCycles，关中断拷贝保证一致
+  __disable_irq();
+  *out = stats;
+  __enable_irq();
+  out->posted = posted;
+  out->dropped = dropped;
+}
+
+void Deferred_Reset_Stats(void) {
+  __disable_irq();
+  memset(&stats, 0, sizeof(stats));
+  posted = 0;
+  dropped = 0;
+  __enable_irq();
+}
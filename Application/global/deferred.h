@@ -0,0 +1,81 @@
+/**
+ * @file deferred.h
+ * @brief 中断到主循环的延后工作队列，以及中断耗时统计
+ * @author User
+ * @date 2025-10-04
+ *
+ * 中断只把回调和参数放入队列就返回，耗时的处理 (命令执行、串口输出、
+ * EEPROM读写) 在主循环中按投递顺序执行，不再占用中断。
+ *
+ * 投递无锁: 生产者用LDREX/STREX抢占一个槽位，写完回调后置位该槽的
+ * ready标志；主循环是唯一的消费者，只在队首槽位ready后取出执行。
+ * 所以任意中断和主循环都可以投递，同优先级或嵌套都不需要关中断。
+ * 队列满时丢弃并计数。
+ *
+ * 主循环每次调用Deferred_Run()最多执行DEFERRED_SLICE_US的工作 (两项之间
+ * 检查，单项不会被打断)，剩余的留到下一轮，避免积压时一次占住主循环。
+ *
+ * 中断耗时: 被统计的中断入口调用Deferred_Isr_Enter()，出口调用
+ * Deferred_Isr_Exit()，按DWT周期数记录次数、最大值和累计值。
+ */
+
+#ifndef __DEFERRED_H__
+#define __DEFERRED_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define DEFERRED_QUEUE_SIZE 16 // 槽位数 (2的幂)
+#define DEFERRED_SLICE_US 2000 // 每轮主循环的执行预算
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef void (*DeferredWork_t)(uint32_t arg);
+
+typedef struct {
+  uint32_t posted;         // 投递成功次数
+  uint32_t dropped;        // 队列满丢弃次数
+  uint32_t executed;       // 已执行次数
+  uint32_t slices;         // 预算用完、留到下一轮的次数
+  uint32_t maxItemCycles;  // 单项最长执行时间 (CPU周期)
+  uint32_t maxSliceCycles; // 单轮最长执行时间
+  uint8_t maxBacklog;      // 最大积压项数
+
+  uint32_t isrCount;       // 被统计中断的次数
+  uint32_t isrMaxCycles;   // 最长/累计中断耗时
+  uint64_t isrSumCycles;
+} DeferredStats_t;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 投递一项工作 (中断或主循环中调用)
+ * @return 队列满时返回false
+ */
+bool Deferred_Post(DeferredWork_t work, uint32_t arg);
+
+/**
+ * @brief 主循环中调用: 在预算内按顺序执行已投递的工作
+ */
+void Deferred_Run(void);
+
+/**
+ * @brief 当前积压项数
+ */
+uint8_t Deferred_Pending(void);
+
+/**
+ * @brief 中断耗时统计: 入口返回起始周期数，出口传回
+ */
+uint32_t Deferred_Isr_Enter(void);
+void Deferred_Isr_Exit(uint32_t start);
+
+/**
+ * @brief 统计数据
+ */
+void Deferred_Get_Stats(DeferredStats_t *stats);
+void Deferred_Reset_Stats(void);
+
+#endif /* __DEFERRED_H__ */
@@ -0,0 +1,181 @@
+/**
+ * @file effects.cpp
+ * @brief 灯光效果引擎实现
+ * @author User
+ * @date 2025-09-22
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "effects.h"
+#include "main.h"
+#include "utils/custom_types.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define EFFECT_LFSR_TAPS 0xB400u // 16位Galois LFSR (x^16+x^14+x^13+x^11+1)
+#define EFFECT_LFSR_SEED 0xACE1u
+
+/* Global variables ----------------------------------------------------------*/
+EffectConfig_t effect = {EFFECT_NONE, EFFECT_GAIN_ONE, 3000, 100, 0xAAAA, 3};
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t phase = 0;     // 相位累加器 (一周期 = 2^32)
+static uint32_t phase_inc = 0; // 每毫秒相位增量 (在Effects_Set中预先计算)
+static uint32_t last_tick = 0;
+static uint16_t lfsr = EFFECT_LFSR_SEED;
+static int32_t candle_level = EFFECT_GAIN_ONE;
+static uint32_t cycles_last = 0;
+static uint32_t cycles_max = 0;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+ * @brief 呼吸: 三角波经smoothstep近似余弦，再平方近似视觉线性
+ */
+static uint16_t breatheGain(void) {
+  uint32_t p = phase >> 20; // Q12
+  uint32_t tri = (p < 2048) ? p * 2 : (4095 - p) * 2;
+  uint32_t t2 = (tri * tri) >> 12;
+  uint32_t s = (t2 * (3 * 4096 - 2 * tri)) >> 12;
+  uint32_t s2 = (s * s) >> 12;
+  return EFFECT_GAIN_ONE - effect.depth + ((effect.depth * s2) >> 12);
+}
+
+/**
+ * @brief 烛光: LFSR噪声平方后偏向小幅抖动、偶尔深暗，经一阶低通平滑
+ */
+static uint16_t candleGain(void) {
+  // 每次推进8位，取出一个新的字节 (固定次数，无分支)
+  for (uint8_t i = 0; i < 8; i++) {
+    lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & EFFECT_LFSR_TAPS);
+  }
+  uint32_t n = lfsr & 0xFF;
+  uint32_t dip = (n * n) >> 8; // 0-254
+  int32_t target = EFFECT_GAIN_ONE - (int32_t)((effect.depth * dip) >> 8);
+
+  candle_level += (target - candle_level) >> effect.speed;
+  return (uint16_t)candle_level;
+}
+
+/**
+ * @brief 频闪: 16位图样按相位高4位逐位输出
+ */
+static uint16_t strobeGain(void) {
+  uint8_t bit = 15 - (phase >> 28);
+  if (effect.pattern & (1u << bit)) {
+    return EFFECT_GAIN_ONE;
+  }
+  return EFFECT_GAIN_ONE - effect.depth;
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+ * @brief 初始化效果引擎并开启DWT周期计数器
+ */
+void Effects_Init(void) {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  Effects_Set(&effect);
+}
+
+/**
+ * @brief 检查效果参数范围 (与EFFECT命令的限制相同)
+ */
+bool Effects_Valid(const EffectConfig_t *config) {
+  return config->type <= EFFECT_STROBE && config->depth <= EFFECT_GAIN_ONE &&
+         config->period >= EFFECT_PERIOD_MIN_MS &&
+         config->period <= EFFECT_PERIOD_MAX_MS &&
+         config->step >= EFFECT_STROBE_STEP_MIN_MS &&
+         config->step <= EFFECT_STROBE_STEP_MAX_MS && config->speed >= 1 &&
+         config->speed <= EFFECT_CANDLE_SPEED_MAX;
+}
+
+/**
+ * @brief 切换效果，重置相位和噪声状态
+ * @note 相位增量在这里算好，更新路径中不做除法。在主循环中调用，
+ *       TIM3中断读取全部状态，写入时关中断
+ */
+bool Effects_Set(const EffectConfig_t *config) {
+  if (!Effects_Valid(config)) {
+    return false;
+  }
+
+  uint32_t period_ms = 1;
+  if (config->type == EFFECT_BREATHE) {
+    period_ms = config->period;
+  } else if (config->type == EFFECT_STROBE) {
+    period_ms = (uint32_t)config->step * 16;
+  }
+  uint32_t inc = 0xFFFFFFFFUL / period_ms;
+
+  __disable_irq();
+  effect = *config;
+  phase_inc = inc;
+  // 呼吸从最亮处开始，频闪从图样第一位开始
+  phase = (effect.type == EFFECT_BREATHE) ? 0x80000000UL : 0;
+  last_tick = HAL_GetTick();
+  lfsr = EFFECT_LFSR_SEED;
+  candle_level = EFFECT_GAIN_ONE;
+  cycles_max = 0;
+  __enable_irq();
+  return true;
+}
+
+/**
+ * @brief 计算当前效果增益 (TIM3中断中每节拍调用一次)
+ */
+uint16_t Effects_Update(void) {
+  if (effect.type == EFFECT_NONE) {
+    return EFFECT_GAIN_ONE;
+  }
+
+  uint32_t start = DWT->CYCCNT;
+
+  uint32_t now = HAL_GetTick();
+  phase += phase_inc * (now - last_tick);
+  last_tick = now;
+
+  uint16_t gain;
+  switch (effect.type) {
+  case EFFECT_BREATHE:
+    gain = breatheGain();
+    break;
+  case EFFECT_CANDLE:
+    gain = candleGain();
+    break;
+  case EFFECT_STROBE:
+    gain = strobeGain();
+    break;
+  default:
+    gain = EFFECT_GAIN_ONE;
+    break;
+  }
+
+  cycles_last = DWT->CYCCNT - start;
+  if (cycles_last > cycles_max) {
+    cycles_max = cycles_last;
+  }
+  return gain;
+}
+
+/**
+ * @brief 效果名称
+ */
+const char *Effects_Name(uint8_t type) {
+  switch (type) {
+  case EFFECT_BREATHE:
+    return "BREATHE";
+  case EFFECT_CANDLE:
+    return "CANDLE";
+  case EFFECT_STROBE:
+    return "STROBE";
+  default:
+    return "OFF";
+  }
+}
+
+uint32_t Effects_Get_Last_Cycles(void) { return cycles_last; }
+
+uint32_t Effects_Get_Max_Cycles(void) { return cycles_max; }
@@ -0,0 +1,87 @@
+/**
+ * @file effects.h
+ * @brief 灯光效果引擎 (呼吸、烛光闪烁、频闪)
+ * @author User
+ * @date 2025-09-22
+ *
+ * 效果在PWM更新路径(TIM3中断约116Hz，与缓变同一节拍)中计算，输出一个
+ * 0-EFFECT_GAIN_ONE的增益，统一乘到各通道缓变后的PWM上:
+ * - 所有通道同比例缩放，色温(通道配比)不变
+ * - 增益不超过1，不会突破通道限幅和降额
+ * - 不修改currentPWM，缓变过程不受影响
+ *
+ * 每次更新为常数时间: 无数据相关的循环、无除法，只有若干乘法/移位。
+ * 实际耗时由DWT周期计数器测量，EFFECT READ可查看上次/最大周期数。
+ */
+
+#ifndef __EFFECTS_H__
+#define __EFFECTS_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define EFFECT_GAIN_ONE 1024           // 增益/深度满量程
+#define EFFECT_PERIOD_MIN_MS 200       // 呼吸周期范围
+#define EFFECT_PERIOD_MAX_MS 60000
+#define EFFECT_STROBE_STEP_MIN_MS 20   // 频闪图样每位时长范围 (不短于2个TIM3节拍)
+#define EFFECT_STROBE_STEP_MAX_MS 5000
+#define EFFECT_CANDLE_SPEED_MAX 8      // 烛光平滑系数 (越大越慢)
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef enum {
+  EFFECT_NONE = 0,
+  EFFECT_BREATHE,
+  EFFECT_CANDLE,
+  EFFECT_STROBE
+} EffectType_t;
+
+typedef struct {
+  uint8_t type;       // EffectType_t
+  uint16_t depth;     // 调制深度 (0-EFFECT_GAIN_ONE)
+  uint16_t period;    // 呼吸周期 (ms)
+  uint16_t step;      // 频闪图样每位时长 (ms)
+  uint16_t pattern;   // 频闪图样，16位循环，高位先出，1=亮
+  uint8_t speed;      // 烛光平滑系数 (1-EFFECT_CANDLE_SPEED_MAX)
+} EffectConfig_t;
+
+extern EffectConfig_t effect;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 初始化效果引擎并开启DWT周期计数器
+ */
+void Effects_Init(void);
+
+/**
+ * @brief 检查效果参数是否都在范围内 (含当前类型不用的参数)
+ */
+bool Effects_Valid(const EffectConfig_t *config);
+
+/**
+ * @brief 切换效果，重置相位和噪声状态
+ * @return 参数越界时返回false，效果不变
+ */
+bool Effects_Set(const EffectConfig_t *config);
+
+/**
+ * @brief 计算当前效果增益 (在PWM更新路径中每节拍调用一次)
+ * @return 增益 (0-EFFECT_GAIN_ONE)
+ */
+uint16_t Effects_Update(void);
+
+/**
+ * @brief 效果名称
+ */
+const char *Effects_Name(uint8_t type);
+
+/**
+ * @brief 上次/最大单次更新耗时 (CPU周期)
+ */
+uint32_t Effects_Get_Last_Cycles(void);
+uint32_t Effects_Get_Max_Cycles(void);
+
+#endif /* __EFFECTS_H__ */
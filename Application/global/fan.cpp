@@ -0,0 +1,636 @@
+/**
+ * @file fan.cpp
+ * @brief 风扇硬件PWM输出实现
+ * @author User
+ * @date 2025-09-28
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "fan.h"
+#include "controller.h"
+#include "drivers/settings.h"
+#include "global_objects.h"
+#include "tach.h"
+#include "tim.h"
+#include "utils/custom_types.h"
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define FAN_KICK_TICKS ((FAN_KICK_MS * PWM_UPDATE_HZ) / 1000)
+#define FAN_RAMP_STEP                                                          \
+  ((FAN_DUTY_FULL * 1000UL) / ((uint32_t)FAN_RAMP_MS * PWM_UPDATE_HZ))
+#define FAN_DMA_REQUESTS (TIM_DMA_UPDATE | TIM_DMA_CC3)
+#define FAN_TACH_INTERVAL_TICKS ((FAN_TACH_INTERVAL_MS * PWM_UPDATE_HZ) / 1000)
+#define FAN_TACH_WINDOW_TICKS ((FAN_TACH_WINDOW_MS * PWM_UPDATE_HZ) / 1000)
+#define FAN_STALL_GRACE_TICKS ((FAN_STALL_GRACE_MS * PWM_UPDATE_HZ) / 1000)
+
+static_assert(FAN_KICK_TICKS > 0, "Fan kick shorter than one TIM3 period");
+static_assert(FAN_RAMP_STEP > 0, "Fan ramp too slow for Q16 duty");
+static_assert(FAN_FULL_TEMP > FAN_START_TEMP, "Invalid fan temperature range");
+static_assert(sizeof(FanConfig_t) == 30, "Fan EEPROM layout changed");
+static_assert(FAN_TACH_WINDOW_TICKS > 0 &&
+                  FAN_TACH_WINDOW_TICKS < FAN_TACH_INTERVAL_TICKS,
+              "Invalid fan tach window");
+
+/* Private variables ---------------------------------------------------------*/
+
+// DMA写入GPIOA->BSRR的置位/复位字
+static const uint32_t pin_set_word = FAN_EN_PIN;
+static const uint32_t pin_reset_word = (uint32_t)FAN_EN_PIN << 16;
+
+static DMA_HandleTypeDef hdma_fan_set;   // TIM3_UP  -> DMA1_Channel3
+static DMA_HandleTypeDef hdma_fan_reset; // TIM3_CH3 -> DMA1_Channel2
+
+static FanConfig_t config;
+static volatile uint8_t config_unsaved = 0;
+static volatile uint8_t control_reset = 1; // 配置变化后重新初始化回差/PID状态
+static volatile uint8_t rpm_reset = 1;     // 配置变化后重新初始化转速闭环
+static volatile uint16_t auto_demand = 0;  // 自动模式需求 (每个温度采样更新)
+static volatile int16_t control_temp = 0;
+
+// PID状态 (只在温度采样时访问)
+static int32_t pid_integral = 0; // x100°C·ms
+static int16_t pid_last_error = 0;
+static uint32_t pid_last_ms = 0;
+
+static uint8_t phase = FAN_PHASE_STOPPED;
+static uint16_t kick_ticks = 0;
+static uint16_t demand = 0;
+static uint16_t duty = 0;    // 斜坡状态
+static uint16_t output = 0;  // 实际输出 (启动脉冲期间为满占空比)
+static uint16_t compare = 0;
+
+// 测速/报警状态 (只在TIM3中断中修改)
+typedef enum { TACH_IDLE = 0, TACH_MEASURE } TachState_t;
+static uint8_t tach_state = TACH_IDLE;
+static uint16_t tach_timer = 0;
+static uint16_t run_ticks = 0;  // 进入运转后的节拍数 (堵转判断宽限期)
+static uint8_t bad_count = 0;   // 连续异常测量次数
+static int32_t rpm_duty = FAN_DUTY_MIN; // 转速闭环积分状态
+static volatile uint16_t rpm = 0;
+static volatile uint8_t alarm = FAN_ALARM_NONE;
+static volatile uint16_t derate = FAN_DERATE_ONE;
+static volatile uint32_t measurements = 0;
+static uint8_t reported_alarm = FAN_ALARM_NONE; // 主循环已报告的报警
+
+static uint16_t history[FAN_RPM_HISTORY];
+static uint8_t history_head = 0;
+static uint8_t history_count = 0;
+static uint8_t history_ticks = 0;
+
+/* Private functions ---------------------------------------------------------*/
+
+static void startDma(DMA_HandleTypeDef *hdma, DMA_Channel_TypeDef *channel,
+                     const uint32_t *word) {
+  hdma->Instance = channel;
+  hdma->Init.Direction = DMA_MEMORY_TO_PERIPH;
+  hdma->Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma->Init.MemInc = DMA_MINC_DISABLE;
+  hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+  hdma->Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+  hdma->Init.Mode = DMA_CIRCULAR;
+  hdma->Init.Priority = DMA_PRIORITY_MEDIUM;
+  HAL_DMA_Init(hdma);
+  HAL_DMA_Start(hdma, (uintptr_t)word, (uintptr_t)&FAN_EN_PORT->BSRR, 1);
+}
+
+static uint16_t permilleToDuty(int32_t permille) {
+  permille = constrain(permille, 0, FAN_PERMILLE_FULL);
+  return ((uint32_t)permille * FAN_DUTY_FULL + FAN_PERMILLE_FULL / 2) /
+         FAN_PERMILLE_FULL;
+}
+
+static bool validConfig(const FanConfig_t *c) {
+  if (c->mode > FAN_CTRL_RPM || c->hysteresis > FAN_HYST_MAX ||
+      c->tachPulses > FAN_TACH_PPR_MAX ||
+      (c->mode == FAN_CTRL_RPM && c->tachPulses == 0) ||
+      c->targetRpm > FAN_RPM_MAX || c->minRpm > FAN_RPM_MAX ||
+      c->setpoint < 0 || c->setpoint > FAN_TEMP_LIMIT ||
+      c->kp > FAN_PID_GAIN_MAX || c->ki > FAN_PID_GAIN_MAX ||
+      c->kd > FAN_PID_GAIN_MAX) {
+    return false;
+  }
+  for (uint8_t i = 0; i < FAN_CURVE_POINTS; i++) {
+    if (c->curveTemp[i] < 0 || c->curveTemp[i] > FAN_TEMP_LIMIT ||
+        c->curveDuty[i] > FAN_PERMILLE_FULL ||
+        (i > 0 && c->curveTemp[i] < c->curveTemp[i - 1])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void setDefaults(void) {
+  // 默认曲线沿用原来的启动/满速温度，启动点即为最低运转占空比
+  static const int8_t temps[FAN_CURVE_POINTS] = {
+      FAN_START_TEMP / 100, 55, 65, 75, FAN_FULL_TEMP / 100};
+  static const uint16_t duties[FAN_CURVE_POINTS] = {250, 450, 650, 850,
+                                                    FAN_PERMILLE_FULL};
+  memset(&config, 0, sizeof(config));
+  memcpy(config.curveTemp, temps, sizeof(temps));
+  memcpy(config.curveDuty, duties, sizeof(duties));
+  config.mode = FAN_CTRL_CURVE;
+  config.hysteresis = FAN_HYST_DEFAULT;
+  config.setpoint = FAN_PID_SETPOINT;
+  config.kp = FAN_PID_KP;
+  config.ki = FAN_PID_KI;
+  config.kd = FAN_PID_KD;
+  config.minRpm = FAN_MIN_RPM_DEFAULT;
+  config.tachPulses = 0; // 默认未接测速，避免误报堵转
+}
+
+static void configChanged(void) {
+  control_reset = 1;
+  rpm_reset = 1;
+  config_unsaved = 1;
+}
+
+// 分段线性插值，低于第一个节点停转 (temp为x100)
+static uint16_t curveDemand(const FanConfig_t *c, int16_t temp) {
+  if (temp < c->curveTemp[0] * 100) {
+    return 0;
+  }
+  for (uint8_t i = 1; i < FAN_CURVE_POINTS; i++) {
+    int16_t t1 = c->curveTemp[i] * 100;
+    if (temp < t1) {
+      int16_t t0 = c->curveTemp[i - 1] * 100; // temp >= t0，所以t1 > t0
+      int32_t d0 = c->curveDuty[i - 1];
+      int32_t d1 = c->curveDuty[i];
+      return permilleToDuty(d0 + (d1 - d0) * (temp - t0) / (t1 - t0));
+    }
+  }
+  return permilleToDuty(c->curveDuty[FAN_CURVE_POINTS - 1]);
+}
+
+static uint16_t pidDemand(const FanConfig_t *c, int16_t temp, bool reset) {
+  uint32_t now = HAL_GetTick();
+  int16_t error = temp - c->setpoint * 100; // 正值表示过热
+  if (reset) {
+    pid_integral = 0;
+    pid_last_error = error;
+    pid_last_ms = now;
+  }
+
+  uint32_t dt = now - pid_last_ms;
+  pid_last_ms = now;
+  dt = constrain(dt, 1, 2000);
+
+  // 积分项限制在0..满量程，防止长时间低温后积分饱和
+  int32_t integral_max =
+      c->ki ? (int32_t)(((int64_t)FAN_PERMILLE_FULL * 100000) / c->ki) : 0;
+  pid_integral += (int32_t)error * (int32_t)dt;
+  pid_integral = constrain(pid_integral, 0, integral_max);
+
+  int64_t p = (int64_t)c->kp * error / 100;
+  int64_t i = ((int64_t)c->ki * pid_integral) / 100000;
+  int64_t d = (int64_t)c->kd * (error - pid_last_error) * 10 / (int64_t)dt;
+  pid_last_error = error;
+
+  int64_t out = p + i + d;
+  if (out <= 0) {
+    // 运转中且未低于设定温度一个回差时保持最低转速，避免反复启停
+    bool running = auto_demand != 0;
+    return (running && error > -(int16_t)c->hysteresis * 100) ? 1 : 0;
+  }
+  if (out > FAN_PERMILLE_FULL) {
+    out = FAN_PERMILLE_FULL;
+  }
+  uint16_t value = permilleToDuty((int32_t)out);
+  return value ? value : 1;
+}
+
+static void writeOutput(uint16_t value) {
+  uint32_t period = htim3.Instance->ARR + 1;
+  uint32_t cmp = ((uint32_t)value * period + 32768) >> 16;
+
+  output = value;
+  if (cmp == 0 || cmp >= period) {
+    // 0%/100%: 关闭DMA请求，直接写静态电平
+    htim3.Instance->DIER &= ~FAN_DMA_REQUESTS;
+    FAN_EN_PORT->BSRR = cmp ? pin_set_word : pin_reset_word;
+    compare = cmp ? period : 0;
+    return;
+  }
+
+  // CCR3为预装载，下一个TIM3周期生效
+  htim3.Instance->CCR3 = cmp;
+  htim3.Instance->DIER |= FAN_DMA_REQUESTS;
+  compare = cmp;
+}
+
+static void stopMeasurement(void) {
+  if (tach_state == TACH_MEASURE) {
+    Tach_Stop_Window(config.tachPulses);
+    tach_state = TACH_IDLE;
+  }
+  tach_timer = 0;
+}
+
+static void measurementDone(uint16_t value) {
+  rpm = value;
+  measurements = measurements + 1;
+
+  // 转速闭环: 按转速误差积分调整占空比
+  if (config.mode == FAN_CTRL_RPM) {
+    int32_t next = rpm_duty + ((int32_t)config.targetRpm - value) * FAN_RPM_GAIN;
+    rpm_duty = constrain(next, FAN_DUTY_MIN, FAN_DUTY_FULL);
+    auto_demand = config.targetRpm ? rpm_duty : 0;
+  }
+
+  if (run_ticks < FAN_STALL_GRACE_TICKS) {
+    return;
+  }
+
+  uint8_t found = FAN_ALARM_NONE;
+  if (value == 0) {
+    found = FAN_ALARM_STALL;
+  } else if (config.minRpm && duty == demand) {
+    // 斜坡结束后按占空比折算最低转速
+    uint32_t expect = (uint32_t)config.minRpm * duty / FAN_DUTY_FULL;
+    if (value < expect) {
+      found = FAN_ALARM_SLOW;
+    }
+  }
+
+  if (found == FAN_ALARM_NONE) {
+    bad_count = 0;
+    alarm = FAN_ALARM_NONE;
+    return;
+  }
+  if (++bad_count < FAN_ALARM_COUNT) {
+    return;
+  }
+
+  bad_count = 0;
+  alarm = found;
+  if (found == FAN_ALARM_STALL) {
+    phase = FAN_PHASE_STOPPED; // 下一节拍重新给启动脉冲
+  }
+}
+
+// 运转中的测速: 满占空比连续测量，部分占空比时周期性展宽为满占空比
+static void measureTick(uint16_t *value) {
+  bool continuous = (*value >= FAN_DUTY_FULL);
+  if (run_ticks < UINT16_MAX) {
+    run_ticks++;
+  }
+
+  if (tach_state == TACH_IDLE) {
+    if (!continuous && ++tach_timer < FAN_TACH_INTERVAL_TICKS) {
+      return;
+    }
+    tach_timer = 0;
+    tach_state = TACH_MEASURE;
+    Tach_Start_Window();
+  }
+
+  *value = FAN_DUTY_FULL;
+  uint8_t periods = continuous ? FAN_TACH_PERIODS_FULL : FAN_TACH_PERIODS;
+  if (Tach_Periods() < periods && ++tach_timer < FAN_TACH_WINDOW_TICKS) {
+    return;
+  }
+
+  tach_timer = 0;
+  tach_state = TACH_IDLE;
+  measurementDone(Tach_Stop_Window(config.tachPulses));
+}
+
+static void updateDerate(void) {
+  uint16_t target = FAN_DERATE_ONE;
+  if (alarm == FAN_ALARM_STALL) {
+    target = FAN_DERATE_STALL;
+  } else if (alarm == FAN_ALARM_SLOW) {
+    target = FAN_DERATE_SLOW;
+  }
+
+  // 每节拍1个LSB，降到50%约4.4秒，避免亮度突变
+  if (derate > target) {
+    derate = derate - 1;
+  } else if (derate < target) {
+    derate = derate + 1;
+  }
+}
+
+static void recordHistory(void) {
+  if (++history_ticks < PWM_UPDATE_HZ) {
+    return;
+  }
+  history_ticks = 0;
+  history[history_head] = rpm;
+  history_head = (history_head + 1) % FAN_RPM_HISTORY;
+  if (history_count < FAN_RPM_HISTORY) {
+    history_count++;
+  }
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+void Fan_Init(void) {
+  // CH3保持冻结模式(不驱动引脚)，只用比较事件触发DMA
+  htim3.Instance->CCMR2 |= TIM_CCMR2_OC3PE;
+  htim3.Instance->CCR3 = 0;
+
+  startDma(&hdma_fan_set, DMA1_Channel3, &pin_set_word);
+  startDma(&hdma_fan_reset, DMA1_Channel2, &pin_reset_word);
+  Tach_Init();
+
+  setDefaults();
+  control_reset = 1;
+  auto_demand = 0;
+  phase = FAN_PHASE_STOPPED;
+  demand = 0;
+  duty = 0;
+  writeOutput(0);
+}
+
+/**
+ * @brief 温度采样处理 (在ADC采样完成处调用，整数运算)
+ */
+void Fan_Temperature_Sample(int16_t temp) {
+  // 命令中断可能正在修改配置，取快照后计算
+  __disable_irq();
+  FanConfig_t c = config;
+  bool reset = control_reset;
+  control_reset = 0;
+  __enable_irq();
+
+  // 间隙滤波: 升温立即跟随，降温超过回差后才跟随
+  int16_t hyst = c.hysteresis * 100;
+  int16_t t = control_temp;
+  if (reset || temp > t) {
+    t = temp;
+  } else if (temp < t - hyst) {
+    t = temp + hyst;
+  }
+  control_temp = t;
+
+  // 转速闭环的需求在测速完成时更新
+  if (c.mode == FAN_CTRL_PID) {
+    auto_demand = pidDemand(&c, temp, reset);
+  } else if (c.mode == FAN_CTRL_CURVE) {
+    auto_demand = curveDemand(&c, t);
+  }
+}
+
+bool Fan_Load(void) {
+  FanConfig_t record;
+  if (!Settings_LoadBlock(EEPROM_ADDR_FAN, &record, sizeof(record)) ||
+      !validConfig(&record)) {
+    serial_printf("Fan config not found, using defaults\r\n");
+    return false;
+  }
+
+  __disable_irq();
+  config = record;
+  control_reset = 1;
+  rpm_reset = 1;
+  __enable_irq();
+  serial_printf("Fan config loaded\r\n");
+  return true;
+}
+
+/**
+ * @brief 主循环调用: 保存已修改的配置
+ */
+void Fan_Process(void) {
+  uint8_t current = alarm;
+  if (current != reported_alarm) {
+    reported_alarm = current;
+    if (current == FAN_ALARM_NONE) {
+      serial_printf("Fan alarm cleared, %u RPM\r\n", rpm);
+    } else {
+      serial_printf("Fan alarm: %s, %u RPM, derating LEDs\r\n",
+                    Fan_Alarm_Name(current), rpm);
+    }
+  }
+
+  if (!config_unsaved) {
+    return;
+  }
+  config_unsaved = 0;
+
+  __disable_irq();
+  FanConfig_t snapshot = config;
+  __enable_irq();
+  if (Settings_SaveBlock(EEPROM_ADDR_FAN, &snapshot, sizeof(snapshot))) {
+    serial_printf("Fan config saved\r\n");
+  }
+}
+
+const FanConfig_t *Fan_Get_Config(void) { return &config; }
+
+bool Fan_Set_Mode(uint8_t mode) {
+  if (mode > FAN_CTRL_RPM ||
+      (mode == FAN_CTRL_RPM && config.tachPulses == 0)) {
+    return false;
+  }
+  config.mode = mode;
+  configChanged();
+  return true;
+}
+
+bool Fan_Set_Curve_Point(uint8_t index, int8_t temp, uint16_t permille) {
+  if (index >= FAN_CURVE_POINTS || temp < 0 || temp > FAN_TEMP_LIMIT ||
+      permille > FAN_PERMILLE_FULL) {
+    return false;
+  }
+  // 节点温度非递减
+  if ((index > 0 && temp < config.curveTemp[index - 1]) ||
+      (index < FAN_CURVE_POINTS - 1 && temp > config.curveTemp[index + 1])) {
+    return false;
+  }
+  config.curveTemp[index] = temp;
+  config.curveDuty[index] = permille;
+  configChanged();
+  return true;
+}
+
+bool Fan_Set_Hysteresis(uint8_t hysteresis) {
+  if (hysteresis > FAN_HYST_MAX) {
+    return false;
+  }
+  config.hysteresis = hysteresis;
+  configChanged();
+  return true;
+}
+
+bool Fan_Set_Pid(int8_t setpoint, uint16_t kp, uint16_t ki, uint16_t kd) {
+  if (setpoint < 0 || setpoint > FAN_TEMP_LIMIT || kp > FAN_PID_GAIN_MAX ||
+      ki > FAN_PID_GAIN_MAX || kd > FAN_PID_GAIN_MAX) {
+    return false;
+  }
+  config.setpoint = setpoint;
+  config.kp = kp;
+  config.ki = ki;
+  config.kd = kd;
+  configChanged();
+  return true;
+}
+
+bool Fan_Set_Tach(uint8_t pulsesPerRev) {
+  if (pulsesPerRev > FAN_TACH_PPR_MAX) {
+    return false;
+  }
+  config.tachPulses = pulsesPerRev;
+  if (pulsesPerRev == 0) {
+    // 没有测速时不能转速闭环，报警也随之解除
+    if (config.mode == FAN_CTRL_RPM) {
+      config.mode = FAN_CTRL_CURVE;
+    }
+    alarm = FAN_ALARM_NONE;
+    rpm = 0;
+  }
+  configChanged();
+  return true;
+}
+
+bool Fan_Set_Target_Rpm(uint16_t target) {
+  if (target > FAN_RPM_MAX) {
+    return false;
+  }
+  config.targetRpm = target;
+  configChanged();
+  return true;
+}
+
+bool Fan_Set_Min_Rpm(uint16_t minimum) {
+  if (minimum > FAN_RPM_MAX) {
+    return false;
+  }
+  config.minRpm = minimum;
+  configChanged();
+  return true;
+}
+
+const char *Fan_Mode_Name(uint8_t mode) {
+  switch (mode) {
+  case FAN_CTRL_PID:
+    return "PID";
+  case FAN_CTRL_RPM:
+    return "RPM";
+  default:
+    return "CURVE";
+  }
+}
+
+const char *Fan_Alarm_Name(uint8_t id) {
+  switch (id) {
+  case FAN_ALARM_SLOW:
+    return "SLOW";
+  case FAN_ALARM_STALL:
+    return "STALL";
+  default:
+    return "NONE";
+  }
+}
+
+/**
+ * @brief 风扇控制节拍
+ * @note 在TIM3中断中调用 (PWM_UPDATE_HZ)
+ */
+void Fan_Tick(void) {
+  if (rpm_reset) {
+    rpm_reset = 0;
+    rpm_duty = (duty > FAN_DUTY_MIN) ? duty : FAN_DUTY_MIN;
+    if (config.mode == FAN_CTRL_RPM) {
+      auto_demand = config.targetRpm ? rpm_duty : 0;
+    }
+  }
+
+  demand = state.fanAuto ? auto_demand : FAN_DUTY_FULL;
+  updateDerate();
+  recordHistory();
+
+  if (demand == 0) {
+    // 停转时没有测速可以解除报警，降额只在要求运转时生效
+    phase = FAN_PHASE_STOPPED;
+    duty = 0;
+    rpm = 0;
+    bad_count = 0;
+    alarm = FAN_ALARM_NONE;
+    stopMeasurement();
+    writeOutput(0);
+    return;
+  }
+
+  switch (phase) {
+  case FAN_PHASE_STOPPED:
+    // 从停转启动: 先给启动脉冲克服静摩擦，斜坡从最低运转占空比开始
+    phase = FAN_PHASE_KICK;
+    kick_ticks = FAN_KICK_TICKS;
+    duty = FAN_DUTY_MIN;
+    run_ticks = 0;
+    stopMeasurement();
+    writeOutput(FAN_DUTY_FULL);
+    return;
+
+  case FAN_PHASE_KICK:
+    if (--kick_ticks > 0) {
+      return;
+    }
+    phase = FAN_PHASE_RUN;
+    break;
+
+  default:
+    break;
+  }
+
+  // 软启动: 上升按斜率，下降立即跟随
+  if (demand > duty) {
+    uint32_t next = (uint32_t)duty + FAN_RAMP_STEP;
+    duty = (next > demand) ? demand : next;
+  } else {
+    duty = demand;
+  }
+  if (duty < FAN_DUTY_MIN) {
+    duty = FAN_DUTY_MIN;
+  }
+
+  uint16_t value = duty;
+  if (config.tachPulses) {
+    measureTick(&value);
+  }
+  writeOutput(value);
+}
+
+uint16_t Fan_Get_Derate(void) { return derate; }
+
+uint8_t Fan_Get_Alarm(void) { return alarm; }
+
+uint8_t Fan_Get_History(uint16_t *out, uint8_t max) {
+  uint8_t count = (history_count < max) ? history_count : max;
+  uint8_t start =
+      (history_head + FAN_RPM_HISTORY - count) % FAN_RPM_HISTORY;
+  for (uint8_t i = 0; i < count; i++) {
+    out[i] = history[(start + i) % FAN_RPM_HISTORY];
+  }
+  return count;
+}
+
+void Fan_Get_Status(FanStatus_t *status) {
+  status->controlTemp = control_temp;
+  status->demand = demand;
+  status->duty = output;
+  status->compare = compare;
+  status->period = htim3.Instance->ARR + 1;
+  status->phase = phase;
+  status->alarm = alarm;
+  status->rpm = rpm;
+  status->derate = derate;
+  status->measurements = measurements;
+}
+
+const char *Fan_Phase_Name(uint8_t id) {
+  switch (id) {
+  case FAN_PHASE_KICK:
+    return "KICK";
+  case FAN_PHASE_RUN:
+    return "RUN";
+  default:
+    return "STOPPED";
+  }
+}
+
+uint16_t Fan_Duty_Permille(uint16_t value) {
+  return ((uint32_t)value * 1000 + FAN_DUTY_FULL / 2) / FAN_DUTY_FULL;
+}
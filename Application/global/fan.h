@@ -0,0 +1,181 @@
+/**
+ * @file fan.h
+ * @brief 风扇硬件PWM输出 (软启动/启动脉冲)
+ * @author User
+ * @date 2025-09-28
+ *
+ * PA4没有定时器复用功能，改用TIM3的更新事件和CH3比较事件各触发一路
+ * 循环DMA，把置位/复位字写入GPIOA->BSRR: 每个TIM3周期开头拉高，计数到
+ * CCR3时拉低。输出由硬件定时，不占用CPU，频率为TIM3的约116Hz，
+ * 占空比分辨率为TIM3周期的1575级 (3线风扇低频调速，测速信号不受干扰)。
+ *
+ * 输出控制在TIM3中断中运行，与主循环节奏无关: 停转后重新启动时先给
+ * 满占空比的启动脉冲，然后从最低运转占空比开始按斜率上升到需求值。
+ * 0%和100%直接写引脚并关闭DMA请求。
+ *
+ * 自动模式的需求在每个温度采样时按整数运算更新一次:
+ * - CURVE: 分段线性曲线，低于第一个节点停转。温度回差为间隙滤波，
+ *   升温时立即跟随，降温超过回差才跟随，停转点同样有回差，不会在
+ *   阈值附近反复启停。相邻节点温度相同即为阶跃，可用于少于N点的曲线。
+ * - PID: 以设定温度为目标调节占空比，积分限幅防饱和；输出为0时
+ *   低于设定温度一个回差才停转。
+ * - RPM: 按测速结果闭环保持目标转速 (需要开启测速)。
+ * 配置保存在EEPROM (EEPROM_ADDR_FAN)。
+ *
+ * 测速(tach.h)开启后，运转中周期性测量转速: 满占空比时连续测量，部分
+ * 占空比时每FAN_TACH_INTERVAL_MS把输出展宽为满占空比直到测到
+ * FAN_TACH_PERIODS个周期或窗口超时。启动宽限期后测不到转速判为堵转，
+ * 重新给启动脉冲；转速低于按占空比折算的下限判为转速不足。报警时LED
+ * 输出按FAN_DERATE_*逐步降额，转速恢复后自动解除。
+ */
+
+#ifndef __FAN_H__
+#define __FAN_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define FAN_DUTY_FULL 65535 // 满占空比 (Q16)
+#define FAN_DUTY_MIN 16384  // 最低可靠运转占空比 (25%)
+#define FAN_KICK_MS 400     // 启动脉冲时长 (满占空比)
+#define FAN_RAMP_MS 3000    // 软启动: 从0升到满占空比所需时间
+
+#define FAN_CURVE_POINTS 5      // 曲线节点数
+#define FAN_PERMILLE_FULL 1000  // 曲线/PID占空比满量程 (‰)
+#define FAN_TEMP_LIMIT 120      // 曲线/设定温度上限 (°C)
+#define FAN_HYST_DEFAULT 3      // 默认回差 (°C)
+#define FAN_HYST_MAX 20         // 回差上限 (°C)
+#define FAN_PID_GAIN_MAX 10000  // PID增益上限
+#define FAN_PID_SETPOINT 60     // 默认设定温度 (°C)
+#define FAN_PID_KP 100          // 默认比例增益 (‰/°C)
+#define FAN_PID_KI 5            // 默认积分增益 (‰/(°C·s))
+#define FAN_PID_KD 0            // 默认微分增益 (‰/(°C/s))
+
+#define FAN_TACH_PPR_MAX 4         // 每转脉冲数上限 (常见为2)
+#define FAN_TACH_INTERVAL_MS 2000  // 部分占空比时的测速间隔
+#define FAN_TACH_WINDOW_MS 300     // 测速窗口上限 (约200RPM以上可测)
+#define FAN_TACH_PERIODS 2         // 展宽测速: 测到的周期数 (越少转速偏差越小)
+#define FAN_TACH_PERIODS_FULL 4    // 满占空比连续测速: 每次平均的周期数
+#define FAN_STALL_GRACE_MS 3000    // 启动后多久开始判断堵转/转速不足
+#define FAN_ALARM_COUNT 2          // 连续几次异常测量才报警
+#define FAN_MIN_RPM_DEFAULT 800    // 满占空比时的最低转速
+#define FAN_RPM_MAX 10000          // 目标/最低转速上限
+#define FAN_RPM_GAIN 8             // 转速闭环积分增益 (Q16占空比/RPM/次)
+#define FAN_RPM_HISTORY 60         // 转速历史点数 (每秒一个)
+#define FAN_DERATE_ONE 1024        // LED降额增益满量程 (Q10)
+#define FAN_DERATE_SLOW 768        // 转速不足时降到75%
+#define FAN_DERATE_STALL 512       // 堵转时降到50%
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef enum {
+  FAN_PHASE_STOPPED = 0, // 停转
+  FAN_PHASE_KICK,        // 启动脉冲
+  FAN_PHASE_RUN          // 运转 (软启动斜坡/稳定)
+} FanPhase_t;
+
+typedef enum {
+  FAN_CTRL_CURVE = 0, // 分段线性曲线
+  FAN_CTRL_PID,       // 目标温度PID
+  FAN_CTRL_RPM        // 目标转速闭环
+} FanCtrlMode_t;
+
+typedef enum {
+  FAN_ALARM_NONE = 0,
+  FAN_ALARM_SLOW,  // 转速不足
+  FAN_ALARM_STALL  // 堵转
+} FanAlarm_t;
+
+/**
+ * @brief 风扇配置 (EEPROM存储)
+ */
+typedef struct {
+  uint16_t curveDuty[FAN_CURVE_POINTS]; // 节点占空比 (‰)
+  uint16_t kp;                          // ‰/°C
+  uint16_t ki;                          // ‰/(°C·s)
+  uint16_t kd;                          // ‰/(°C/s)
+  uint16_t targetRpm;                   // 转速闭环目标
+  uint16_t minRpm;                      // 满占空比时的最低转速 (0=不检测)
+  int8_t curveTemp[FAN_CURVE_POINTS];   // 节点温度 (°C，非递减)
+  int8_t setpoint;                      // PID设定温度 (°C)
+  uint8_t mode;                         // FanCtrlMode_t
+  uint8_t hysteresis;                   // 回差 (°C)
+  uint8_t tachPulses;                   // 每转脉冲数 (0=未接测速)
+  uint8_t reserved;
+} FanConfig_t;
+
+typedef struct {
+  int16_t controlTemp; // 曲线取值温度 (回差后, x100)
+  uint16_t demand;  // 需求占空比 (Q16)
+  uint16_t duty;    // 实际输出占空比 (Q16)
+  uint16_t compare; // CCR3
+  uint16_t period;  // TIM3周期 (计数)
+  uint8_t phase;    // FanPhase_t
+  uint8_t alarm;    // FanAlarm_t
+  uint16_t rpm;     // 最近一次测速 (0=未测到)
+  uint16_t derate;  // LED降额增益 (Q10)
+  uint32_t measurements; // 测速次数
+} FanStatus_t;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 初始化TIM3 CH3比较和两路DMA，风扇停转
+ */
+void Fan_Init(void);
+
+/**
+ * @brief TIM3中断调用: 执行启动脉冲/软启动、测速和报警并更新输出
+ */
+void Fan_Tick(void);
+
+/**
+ * @brief LED降额增益 (Q10，PWM更新时乘到所有通道)
+ */
+uint16_t Fan_Get_Derate(void);
+uint8_t Fan_Get_Alarm(void);
+
+/**
+ * @brief 转速历史 (每秒一个点，按时间先后拷贝，返回点数)
+ */
+uint8_t Fan_Get_History(uint16_t *out, uint8_t max);
+
+/**
+ * @brief 新的温度采样 (x100)，按当前控制方式更新自动模式需求
+ */
+void Fan_Temperature_Sample(int16_t temp);
+
+/**
+ * @brief 从EEPROM加载配置 / 主循环保存已修改的配置
+ */
+bool Fan_Load(void);
+void Fan_Process(void);
+
+/**
+ * @brief 配置修改 (参数非法时返回false)
+ */
+const FanConfig_t *Fan_Get_Config(void);
+bool Fan_Set_Mode(uint8_t mode);
+bool Fan_Set_Curve_Point(uint8_t index, int8_t temp, uint16_t permille);
+bool Fan_Set_Hysteresis(uint8_t hysteresis);
+bool Fan_Set_Pid(int8_t setpoint, uint16_t kp, uint16_t ki, uint16_t kd);
+bool Fan_Set_Tach(uint8_t pulsesPerRev);
+bool Fan_Set_Target_Rpm(uint16_t target);
+bool Fan_Set_Min_Rpm(uint16_t minimum);
+const char *Fan_Mode_Name(uint8_t mode);
+const char *Fan_Alarm_Name(uint8_t alarm);
+
+/**
+ * @brief 运行状态
+ */
+void Fan_Get_Status(FanStatus_t *status);
+const char *Fan_Phase_Name(uint8_t id);
+
+/**
+ * @brief Q16占空比换算为千分比 (显示用)
+ */
+uint16_t Fan_Duty_Permille(uint16_t value);
+
+#endif /* __FAN_H__ */
@@ -1,47 +1,57 @@
 // Pre-generated gamma correction lookup table for PWM values 0-100%
-// Maps input range [0, 513] to PWM range [1, 6098]
+// Maps input range [0, 512] to Q16 fraction of full scale [0, 65535]
 // Gamma value: 2.2
+// PWM = 1 + table * (period - 3) / 65536 (see Channels_LevelToPWM)
 const uint16_t gammaTable[513] = {
-    1,    1,    1,    1,    1,    1,    1,    1,    2,    2,    2,    2,
-    3,    3,    3,    4,    4,    4,    5,    5,    6,    6,    7,    8,
-    8,    9,    10,   10,   11,   12,   13,   14,   15,   16,   17,   18,
-    19,   20,   21,   22,   23,   25,   26,   27,   29,   30,   31,   33,
-    34,   36,   38,   39,   41,   43,   44,   46,   48,   50,   52,   54,
-    56,   58,   60,   62,   64,   66,   68,   71,   73,   75,   78,   80,
-    82,   85,   88,   90,   93,   95,   98,   101,  104,  107,  109,  112,
-    115,  118,  121,  124,  128,  131,  134,  137,  141,  144,  147,  151,
-    154,  158,  161,  165,  169,  172,  176,  180,  184,  188,  192,  196,
-    200,  204,  208,  212,  216,  221,  225,  229,  234,  238,  242,  247,
-    252,  256,  261,  266,  270,  275,  280,  285,  290,  295,  300,  305,
-    310,  315,  320,  326,  331,  336,  342,  347,  353,  358,  364,  370,
-    375,  381,  387,  393,  398,  404,  410,  416,  422,  429,  435,  441,
-    447,  454,  460,  466,  473,  479,  486,  493,  499,  506,  513,  519,
-    526,  533,  540,  547,  554,  561,  568,  576,  583,  590,  598,  605,
-    612,  620,  627,  635,  643,  650,  658,  666,  674,  682,  690,  698,
-    706,  714,  722,  730,  738,  747,  755,  763,  772,  780,  789,  798,
-    806,  815,  824,  832,  841,  850,  859,  868,  877,  886,  896,  905,
-    914,  923,  933,  942,  952,  961,  971,  980,  990,  1000, 1010, 1020,
-    1029, 1039, 1049, 1059, 1070, 1080, 1090, 1100, 1111, 1121, 1131, 1142,
-    1152, 1163, 1174, 1184, 1195, 1206, 1217, 1227, 1238, 1249, 1260, 1272,
-    1283, 1294, 1305, 1317, 1328, 1339, 1351, 1362, 1374, 1386, 1397, 1409,
-    1421, 1433, 1445, 1457, 1469, 1481, 1493, 1505, 1517, 1530, 1542, 1554,
-    1567, 1579, 1592, 1604, 1617, 1630, 1643, 1655, 1668, 1681, 1694, 1707,
-    1720, 1734, 1747, 1760, 1773, 1787, 1800, 1814, 1827, 1841, 1855, 1868,
-    1882, 1896, 1910, 1924, 1938, 1952, 1966, 1980, 1994, 2008, 2023, 2037,
-    2052, 2066, 2081, 2095, 2110, 2125, 2139, 2154, 2169, 2184, 2199, 2214,
-    2229, 2244, 2259, 2275, 2290, 2305, 2321, 2336, 2352, 2367, 2383, 2399,
-    2415, 2430, 2446, 2462, 2478, 2494, 2510, 2527, 2543, 2559, 2575, 2592,
-    2608, 2625, 2641, 2658, 2675, 2691, 2708, 2725, 2742, 2759, 2776, 2793,
-    2810, 2827, 2845, 2862, 2879, 2897, 2914, 2932, 2949, 2967, 2985, 3003,
-    3020, 3038, 3056, 3074, 3092, 3110, 3129, 3147, 3165, 3183, 3202, 3220,
-    3239, 3257, 3276, 3295, 3313, 3332, 3351, 3370, 3389, 3408, 3427, 3446,
-    3466, 3485, 3504, 3524, 3543, 3563, 3582, 3602, 3621, 3641, 3661, 3681,
-    3701, 3721, 3741, 3761, 3781, 3801, 3822, 3842, 3862, 3883, 3903, 3924,
-    3944, 3965, 3986, 4007, 4027, 4048, 4069, 4090, 4112, 4133, 4154, 4175,
-    4197, 4218, 4239, 4261, 4282, 4304, 4326, 4348, 4369, 4391, 4413, 4435,
-    4457, 4479, 4501, 4524, 4546, 4568, 4591, 4613, 4636, 4658, 4681, 4704,
-    4726, 4749, 4772, 4795, 4818, 4841, 4864, 4888, 4911, 4934, 4957, 4981,
-    5004, 5028, 5052, 5075, 5099, 5123, 5147, 5170, 5194, 5219, 5243, 5267,
-    5291, 5315, 5340, 5364, 5388, 5413, 5438, 5462, 5487, 5512, 5536, 5561,
-    5586, 5611, 5636, 5661, 5687, 5712, 5737, 5763, 5788, 5814, 5839, 5865,
-    5890, 5916, 5942, 5968, 5994, 6020, 6046, 6072, 6098};
\ No newline at end of file
+    0,     0,     0,     1,     2,     2,     4,     5,     7,     9,
+    11,    14,    17,    20,    24,    28,    32,    37,    41,    47,
+    52,    58,    64,    71,    78,    85,    93,    101,   110,   118,
+    128,   137,   147,   157,   168,   179,   191,   202,   215,   227,
+    240,   254,   267,   282,   296,   311,   327,   343,   359,   375,
+    392,   410,   428,   446,   465,   484,   504,   524,   544,   565,
+    586,   608,   630,   653,   676,   699,   723,   747,   772,   797,
+    823,   849,   875,   902,   930,   958,   986,   1015,  1044,  1074,
+    1104,  1134,  1165,  1197,  1229,  1261,  1294,  1327,  1361,  1396,
+    1430,  1465,  1501,  1537,  1574,  1611,  1648,  1686,  1725,  1764,
+    1803,  1843,  1884,  1925,  1966,  2008,  2050,  2093,  2136,  2180,
+    2224,  2269,  2314,  2360,  2406,  2453,  2500,  2547,  2595,  2644,
+    2693,  2743,  2793,  2844,  2895,  2946,  2998,  3051,  3104,  3158,
+    3212,  3266,  3322,  3377,  3433,  3490,  3547,  3605,  3663,  3721,
+    3781,  3840,  3900,  3961,  4022,  4084,  4146,  4209,  4272,  4336,
+    4400,  4465,  4530,  4596,  4663,  4729,  4797,  4865,  4933,  5002,
+    5072,  5142,  5212,  5283,  5355,  5427,  5499,  5573,  5646,  5720,
+    5795,  5870,  5946,  6023,  6099,  6177,  6255,  6333,  6412,  6492,
+    6572,  6652,  6733,  6815,  6897,  6980,  7063,  7147,  7231,  7316,
+    7402,  7488,  7574,  7661,  7749,  7837,  7926,  8015,  8105,  8195,
+    8286,  8377,  8469,  8562,  8655,  8749,  8843,  8937,  9033,  9129,
+    9225,  9322,  9419,  9517,  9616,  9715,  9815,  9915,  10016, 10117,
+    10219, 10321, 10425, 10528, 10632, 10737, 10842, 10948, 11054, 11161,
+    11269, 11377, 11486, 11595, 11705, 11815, 11926, 12037, 12149, 12262,
+    12375, 12489, 12603, 12718, 12833, 12949, 13066, 13183, 13301, 13419,
+    13538, 13657, 13777, 13898, 14019, 14141, 14263, 14386, 14509, 14633,
+    14758, 14883, 15009, 15135, 15262, 15389, 15517, 15646, 15775, 15905,
+    16035, 16166, 16298, 16430, 16563, 16696, 16830, 16964, 17099, 17235,
+    17371, 17508, 17645, 17783, 17922, 18061, 18201, 18341, 18482, 18623,
+    18765, 18908, 19051, 19195, 19339, 19484, 19630, 19776, 19923, 20070,
+    20218, 20367, 20516, 20666, 20816, 20967, 21119, 21271, 21424, 21577,
+    21731, 21885, 22040, 22196, 22352, 22509, 22667, 22825, 22984, 23143,
+    23303, 23463, 23624, 23786, 23949, 24111, 24275, 24439, 24604, 24769,
+    24935, 25102, 25269, 25436, 25605, 25774, 25943, 26114, 26284, 26456,
+    26628, 26800, 26973, 27147, 27322, 27497, 27672, 27849, 28026, 28203,
+    28381, 28560, 28739, 28919, 29100, 29281, 29462, 29645, 29828, 30011,
+    30196, 30381, 30566, 30752, 30939, 31126, 31314, 31502, 31692, 31881,
+    32072, 32263, 32454, 32647, 32840, 33033, 33227, 33422, 33617, 33813,
+    34010, 34207, 34405, 34603, 34802, 35002, 35202, 35403, 35605, 35807,
+    36010, 36213, 36417, 36622, 36827, 37033, 37240, 37447, 37655, 37863,
+    38072, 38282, 38493, 38704, 38915, 39127, 39340, 39554, 39768, 39983,
+    40198, 40414, 40631, 40848, 41066, 41284, 41503, 41723, 41944, 42165,
+    42387, 42609, 42832, 43055, 43280, 43505, 43730, 43956, 44183, 44410,
+    44639, 44867, 45097, 45327, 45557, 45788, 46020, 46253, 46486, 46720,
+    46954, 47189, 47425, 47661, 47899, 48136, 48374, 48613, 48853, 49093,
+    49334, 49576, 49818, 50061, 50304, 50548, 50793, 51038, 51284, 51531,
+    51778, 52026, 52275, 52524, 52774, 53024, 53276, 53527, 53780, 54033,
+    54287, 54541, 54796, 55052, 55308, 55566, 55823, 56082, 56341, 56600,
+    56860, 57121, 57383, 57645, 57908, 58172, 58436, 58701, 58966, 59232,
+    59499, 59767, 60035, 60304, 60573, 60843, 61114, 61385, 61657, 61930,
+    62203, 62477, 62752, 63027, 63303, 63580, 63857, 64135, 64414, 64693,
+    64973, 65254, 65535};
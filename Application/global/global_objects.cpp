@@ -17,7 +17,7 @@ SystemState state = {
     // 核心控制参数
     false, true, false, false, BRIGHTNESS_DEFAULT, COLOR_TEMP_DEFAULT,
     // PWM输出值
-    0, 0, 0, 0,
+    {0}, {0},
     // 用户界面状态
     1, 0,
     // 动画状态
@@ -32,7 +32,7 @@ SystemState lastState = {
     // 核心控制参数
     true, false, true, true, LED_MAX_BRIGHTNESS, 255,
     // PWM输出值
-    32767, 32767, 0, 0,
+    {32767, 32767}, {0},
     // 用户界面状态
     127, 127,
     // 动画状态
@@ -45,8 +45,6 @@ SystemState lastState = {
 }; // 初始化为不同值，确保首次更新
 //
 //
-uint16_t adc_value = 0;          // ADC采样值
-unsigned char adc_done_flag = 0; // ADC转换完成标志
 
 // U8G2 显示对象
 STM32_U8G2_Display u8g2;
@@ -66,6 +64,9 @@ Button btn_1(GPIOA, GPIO_PIN_5, true);
 // PA6
 Button btn_2(GPIOA, GPIO_PIN_6, true);
 
+// I2C1 0x43 电压电流采样 (在Init_Devices中按扫描结果初始化)
+PowerMonitor power_monitor;
+
 /* Function implementations --------------------------------------------------*/
 
 /**
@@ -11,6 +11,8 @@
 /* Includes ------------------------------------------------------------------*/
 #include "drivers/button.h"
 #include "drivers/encoder.h"
+#include "drivers/power_monitor.h"
+#include "global/channels.h"
 #include "stm32_u8g2.h"
 
 #define TITLE_TEXT "LED Controller" ///< Boot text to display
@@ -26,12 +28,9 @@ typedef struct {
   uint16_t brightness; // 亮度值 (0-MAX%)
   uint16_t colorTemp;  // 色温值 (3000-5700K)
 
-  // === PWM输出值 ===
-  uint16_t currentCh1PWM; // 通道1的当前PWM值 (0-6100)
-  uint16_t currentCh2PWM; // 通道2的当前PWM值 (0-6100)
-
-  uint16_t targetCh1PWM; // 通道1的目标PWM值 (0-6100)
-  uint16_t targetCh2PWM; // 通道2的目标PWM值 (0-6100)
+  // === PWM输出值 (按通道下标, CH1=0) ===
+  uint16_t currentPWM[LED_CHANNEL_COUNT]; // 各通道当前PWM值 (0-当前PWM周期)
+  uint16_t targetPWM[LED_CHANNEL_COUNT];  // 各通道目标PWM值 (0-当前PWM周期)
 
   // === 用户界面状态 ===
   uint8_t item; // 当前选中的项目 (0=主开关, 1=色温, 2=亮度)
@@ -66,8 +65,6 @@ extern SystemState lastState;
 
 /* Global Objects ------------------------------------------------------------*/
 
-extern uint16_t adc_value;          // ADC采样值
-extern unsigned char adc_done_flag; // ADC转换完成标志
 
 // Global encoder instance
 extern RotaryEncoder rotary_encoder;
@@ -84,6 +81,9 @@ extern Button btn_1;
 // PA6
 extern Button btn_2;
 
+// I2C1 0x43 电压电流采样
+extern PowerMonitor power_monitor;
+
 /* Function declarations -----------------------------------------------------*/
 
 /**
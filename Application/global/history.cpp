@@ -0,0 +1,407 @@
+/**
+ * @file history.cpp
+ * @brief 多分辨率时间序列实现
+ * @author User
+ * @date 2025-10-03
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "history.h"
+#include "analog.h"
+#include "drivers/eeprom.h"
+#include "drivers/settings.h"
+#include "fan.h"
+#include "global_objects.h"
+#include "thermal.h"
+#include "usart.h"
+#include "utils/custom_types.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define SENSOR_FAULT_TEMP (-99900) // Analog_Raw_To_Temperature开路/短路返回值
+
+// POWER量化步长 (mW): 所有通道都到THERMAL_CHANNEL_MW_MAX时不饱和，向上取
+// 100mW的整数倍 (2通道500mW，4通道1000mW)
+#define HISTORY_POWER_MW_MAX (LED_CHANNEL_COUNT * THERMAL_CHANNEL_MW_MAX)
+#define HISTORY_POWER_STEP                                                     \
+  ((HISTORY_POWER_MW_MAX / HISTORY_CODE_MAX + 100) / 100 * 100)
+static_assert(HISTORY_POWER_STEP <= UINT16_MAX &&
+                  HISTORY_POWER_MW_MAX / HISTORY_POWER_STEP <= HISTORY_CODE_MAX,
+              "POWER step must fit uint16 and cover all channels");
+
+/* Private types -------------------------------------------------------------*/
+
+/**
+ * @brief 全精度累计器 (量化前)
+ */
+typedef struct {
+  int32_t min;
+  int32_t max;
+  int32_t sum;
+  uint16_t count;
+} Accumulator_t;
+
+typedef struct {
+  HistoryBucket_t (*rows)[HISTORY_SERIES_COUNT];
+  uint8_t size;
+  uint8_t head;  // 下一个写入位置
+  uint8_t count;
+  uint32_t sequence;
+} Ring_t;
+
+/**
+ * @brief EEPROM快照 (小时环，从旧到新)
+ */
+typedef struct {
+  uint32_t sequence;
+  uint8_t count;
+  uint8_t enabled;
+  uint16_t powerStep; // 保存时的POWER步长，与当前不同时丢弃POWER序列
+  HistoryBucket_t rows[HISTORY_HOURS][HISTORY_SERIES_COUNT];
+} HistorySnapshot_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const HistoryScale_t scales[HISTORY_SERIES_COUNT] = {
+    {-2000, 50},             // TEMP: x100
+    {0, HISTORY_POWER_STEP}, // POWER: mW
+    {0, 4}};                 // FAN: ‰
+static const char *const series_names[HISTORY_SERIES_COUNT] = {"TEMP", "POWER",
+                                                               "FAN"};
+static const char *const res_names[HISTORY_RES_COUNT] = {"SEC", "MIN", "HOUR"};
+static const uint16_t bucket_seconds[HISTORY_RES_COUNT] = {1, 60, 3600};
+
+static HistoryBucket_t second_rows[HISTORY_SECONDS][HISTORY_SERIES_COUNT];
+static HistoryBucket_t minute_rows[HISTORY_MINUTES][HISTORY_SERIES_COUNT];
+static HistoryBucket_t hour_rows[HISTORY_HOURS][HISTORY_SERIES_COUNT];
+static Ring_t rings[HISTORY_RES_COUNT] = {
+    {second_rows, HISTORY_SECONDS, 0, 0, 0},
+    {minute_rows, HISTORY_MINUTES, 0, 0, 0},
+    {hour_rows, HISTORY_HOURS, 0, 0, 0}};
+
+// acc[res]累计下一个res桶: acc[SEC]为100ms样本，acc[MIN]为秒桶平均值...
+static Accumulator_t acc[HISTORY_RES_COUNT][HISTORY_SERIES_COUNT];
+static uint8_t children[HISTORY_RES_COUNT]; // 已并入acc[res]的下级桶数
+
+static bool snapshot_enabled = false;
+static volatile bool snapshot_requested = false;
+static volatile uint8_t display_series = HISTORY_SERIES_NONE;
+static volatile uint8_t display_res = HISTORY_RES_SEC;
+
+/* Private functions ---------------------------------------------------------*/
+
+static void resetAccumulator(Accumulator_t *a) {
+  a->min = INT32_MAX;
+  a->max = INT32_MIN;
+  a->sum = 0;
+  a->count = 0;
+}
+
+static void addValue(Accumulator_t *a, int32_t value) {
+  a->min = (value < a->min) ? value : a->min;
+  a->max = (value > a->max) ? value : a->max;
+  a->sum += value;
+  a->count++;
+}
+
+/**
+ * @brief 下级桶并入上级: 最小/最大取极值，平均值等权累计
+ */
+static void mergeInto(Accumulator_t *parent, const Accumulator_t *child) {
+  if (child->count == 0) {
+    return;
+  }
+  parent->min = (child->min < parent->min) ? child->min : parent->min;
+  parent->max = (child->max > parent->max) ? child->max : parent->max;
+  parent->sum += child->sum / child->count;
+  parent->count++;
+}
+
+static uint8_t quantize(uint8_t series, int32_t value) {
+  const HistoryScale_t *s = &scales[series];
+  int32_t code = (value - s->offset + s->step / 2) / (int32_t)s->step;
+  if (value < s->offset) {
+    code = 0;
+  }
+  return (code > HISTORY_CODE_MAX) ? HISTORY_CODE_MAX : code;
+}
+
+static int32_t dequantize(uint8_t series, uint8_t code) {
+  return scales[series].offset + (int32_t)code * scales[series].step;
+}
+
+/**
+ * @brief 关闭res级的当前桶: 写入环并并入上一级，满HISTORY_FANOUT个时逐级上推
+ */
+static void closeBucket(uint8_t res) {
+  HistoryBucket_t row[HISTORY_SERIES_COUNT];
+  for (uint8_t s = 0; s < HISTORY_SERIES_COUNT; s++) {
+    Accumulator_t *a = &acc[res][s];
+    if (a->count == 0) {
+      row[s] = {HISTORY_EMPTY, HISTORY_EMPTY, HISTORY_EMPTY};
+    } else {
+      row[s] = {quantize(s, a->min), quantize(s, a->max),
+                quantize(s, a->sum / a->count)};
+    }
+    if (res + 1 < HISTORY_RES_COUNT) {
+      mergeInto(&acc[res + 1][s], a);
+    }
+    resetAccumulator(a);
+  }
+
+  // 命令和显示都在主循环中读取环，不会与写入交错，不需要关中断
+  Ring_t *ring = &rings[res];
+  memcpy(ring->rows[ring->head], row, sizeof(row));
+  ring->head = (ring->head + 1) % ring->size;
+  if (ring->count < ring->size) {
+    ring->count++;
+  }
+  ring->sequence++;
+
+  if (res + 1 < HISTORY_RES_COUNT && ++children[res + 1] >= HISTORY_FANOUT) {
+    children[res + 1] = 0;
+    closeBucket(res + 1);
+  }
+}
+
+static void sample(void) {
+  int32_t temp = state.temp;
+  if (temp > SENSOR_FAULT_TEMP) {
+    addValue(&acc[HISTORY_RES_SEC][HISTORY_TEMP], temp);
+  }
+
+  ThermalStatus_t thermal;
+  Thermal_Get_Status(&thermal);
+  addValue(&acc[HISTORY_RES_SEC][HISTORY_POWER], thermal.inputMw);
+
+  FanStatus_t fan;
+  Fan_Get_Status(&fan);
+  addValue(&acc[HISTORY_RES_SEC][HISTORY_FAN], Fan_Duty_Permille(fan.duty));
+}
+
+/**
+ * @brief 保存小时环 (从旧到新排列，与环的写入位置无关)
+ */
+static void saveSnapshot(void) {
+  HistorySnapshot_t snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  const Ring_t *ring = &rings[HISTORY_RES_HOUR];
+
+  snapshot.sequence = ring->sequence;
+  snapshot.count = ring->count;
+  for (uint8_t i = 0; i < ring->count; i++) {
+    uint8_t index = (ring->head + ring->size - ring->count + i) % ring->size;
+    memcpy(snapshot.rows[i], ring->rows[index], sizeof(snapshot.rows[i]));
+  }
+  snapshot.enabled = snapshot_enabled;
+  snapshot.powerStep = HISTORY_POWER_STEP;
+
+  if (Settings_SaveBlock(EEPROM_ADDR_HISTORY, &snapshot, sizeof(snapshot))) {
+    serial_printf("History snapshot saved (%u hours)\r\n", snapshot.count);
+  }
+}
+
+static const uint8_t *rowAt(const Ring_t *ring, uint8_t age) {
+  uint8_t index = (ring->head + ring->size - 1 - age) % ring->size;
+  return (const uint8_t *)ring->rows[index];
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+bool History_Load(void) {
+  HistorySnapshot_t snapshot;
+  if (!Settings_LoadBlock(EEPROM_ADDR_HISTORY, &snapshot, sizeof(snapshot)) ||
+      snapshot.count > HISTORY_HOURS || snapshot.enabled > 1) {
+    serial_printf("History snapshot not found\r\n");
+    return false;
+  }
+
+  // 通道数或步长变化后旧的POWER量化值没有意义
+  if (snapshot.powerStep != HISTORY_POWER_STEP) {
+    for (uint8_t i = 0; i < snapshot.count; i++) {
+      snapshot.rows[i][HISTORY_POWER] = {HISTORY_EMPTY, HISTORY_EMPTY,
+                                         HISTORY_EMPTY};
+    }
+  }
+
+  Ring_t *ring = &rings[HISTORY_RES_HOUR];
+  memcpy(ring->rows, snapshot.rows,
+         (size_t)snapshot.count * sizeof(snapshot.rows[0]));
+  ring->count = snapshot.count;
+  ring->head = snapshot.count % ring->size;
+  ring->sequence = snapshot.sequence;
+  snapshot_enabled = snapshot.enabled;
+  serial_printf("History: restored %u hours%s\r\n", snapshot.count,
+                snapshot.enabled ? ", snapshots on" : "");
+  return true;
+}
+
+/**
+ * @brief 主循环调用: 采样、关闭到期的秒桶(逐级降采样)、保存快照
+ */
+void History_Process(void) {
+  static uint32_t last_sample = 0;
+  static uint32_t second_start = 0;
+  static bool started = false;
+
+  uint32_t now = HAL_GetTick();
+  if (!started) {
+    if (!Analog_Ready()) {
+      return;
+    }
+    started = true;
+    for (uint8_t r = 0; r < HISTORY_RES_COUNT; r++) {
+      for (uint8_t s = 0; s < HISTORY_SERIES_COUNT; s++) {
+        resetAccumulator(&acc[r][s]);
+      }
+    }
+    last_sample = now;
+    second_start = now;
+  }
+
+  if (now - last_sample >= HISTORY_SAMPLE_MS) {
+    last_sample = now;
+    sample();
+  }
+
+  if (now - second_start >= 1000) {
+    // 按1秒步进不累计误差；主循环被阻塞超过一个桶时重新对齐
+    second_start += 1000;
+    if (now - second_start >= 1000) {
+      second_start = now;
+    }
+    uint32_t hours = rings[HISTORY_RES_HOUR].sequence;
+    closeBucket(HISTORY_RES_SEC);
+    if (snapshot_enabled && rings[HISTORY_RES_HOUR].sequence != hours) {
+      snapshot_requested = true;
+    }
+  }
+
+  if (snapshot_requested) {
+    snapshot_requested = false;
+    saveSnapshot();
+  }
+}
+
+uint8_t History_Count(uint8_t res) {
+  return (res < HISTORY_RES_COUNT) ? rings[res].count : 0;
+}
+
+uint8_t History_Capacity(uint8_t res) {
+  return (res < HISTORY_RES_COUNT) ? rings[res].size : 0;
+}
+
+uint32_t History_Sequence(uint8_t res) {
+  return (res < HISTORY_RES_COUNT) ? rings[res].sequence : 0;
+}
+
+uint16_t History_Bucket_Seconds(uint8_t res) {
+  return (res < HISTORY_RES_COUNT) ? bucket_seconds[res] : 0;
+}
+
+bool History_Get(uint8_t res, uint8_t age, uint8_t series, int32_t *min,
+                 int32_t *max, int32_t *avg) {
+  if (res >= HISTORY_RES_COUNT || series >= HISTORY_SERIES_COUNT ||
+      age >= rings[res].count) {
+    return false;
+  }
+  const HistoryBucket_t *b =
+      (const HistoryBucket_t *)rowAt(&rings[res], age) + series;
+  if (b->avg == HISTORY_EMPTY) {
+    return false;
+  }
+  *min = dequantize(series, b->min);
+  *max = dequantize(series, b->max);
+  *avg = dequantize(series, b->avg);
+  return true;
+}
+
+uint16_t History_Dump_Size(uint8_t count) {
+  return sizeof(HistoryDumpHeader_t) + sizeof(scales) +
+         (uint16_t)count * sizeof(second_rows[0]) + sizeof(uint32_t);
+}
+
+uint16_t History_Dump(uint8_t res, uint8_t count, uint8_t skip) {
+  if (res >= HISTORY_RES_COUNT) {
+    return 0;
+  }
+  const Ring_t *ring = &rings[res];
+  uint8_t available = ring->count;
+  if (skip >= available || count == 0) {
+    return 0;
+  }
+  if (count > available - skip) {
+    count = available - skip;
+  }
+
+  HistoryDumpHeader_t header = {{'T', 'S'},
+                                HISTORY_DUMP_VERSION,
+                                res,
+                                bucket_seconds[res],
+                                HISTORY_SERIES_COUNT,
+                                count,
+                                ring->sequence - skip};
+  uint32_t crc = EEPROM::updateCRC32(0, (const uint8_t *)&header,
+                                     sizeof(header));
+  crc = EEPROM::updateCRC32(crc, (const uint8_t *)scales, sizeof(scales));
+  UART_Send_Data((uint8_t *)&header, sizeof(header));
+  UART_Send_Data((uint8_t *)scales, sizeof(scales));
+
+  // 从旧到新逐行发送，不需要整帧缓冲
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t row[sizeof(second_rows[0])];
+    memcpy(row, rowAt(ring, skip + count - 1 - i), sizeof(row));
+    crc = EEPROM::updateCRC32(crc, row, sizeof(row));
+    UART_Send_Data(row, sizeof(row));
+  }
+  UART_Send_Data((uint8_t *)&crc, sizeof(crc));
+  return History_Dump_Size(count);
+}
+
+void History_Set_Snapshot(bool enable) {
+  snapshot_enabled = enable;
+  snapshot_requested = true; // 保存开关状态
+}
+
+bool History_Snapshot_Enabled(void) { return snapshot_enabled; }
+
+void History_Request_Snapshot(void) { snapshot_requested = true; }
+
+void History_Set_Display(uint8_t series, uint8_t res) {
+  display_res = (res < HISTORY_RES_COUNT) ? res : HISTORY_RES_SEC;
+  display_series = (series < HISTORY_SERIES_COUNT) ? series
+                                                    : HISTORY_SERIES_NONE;
+}
+
+uint8_t History_Display_Series(void) { return display_series; }
+
+uint8_t History_Display_Resolution(void) { return display_res; }
+
+const char *History_Series_Name(uint8_t series) {
+  return (series < HISTORY_SERIES_COUNT) ? series_names[series] : "OFF";
+}
+
+const char *History_Res_Name(uint8_t res) {
+  return (res < HISTORY_RES_COUNT) ? res_names[res] : "?";
+}
+
+void History_Format(uint8_t series, int32_t value, char *buf, uint8_t size) {
+  switch (series) {
+  case HISTORY_TEMP: {
+    // 符号单独输出，-0.99~-0.01°C时整数部分为0
+    int32_t magnitude = (value < 0) ? -value : value;
+    snprintf(buf, size, "%s%ld.%ldC", (value < 0) ? "-" : "", magnitude / 100,
+             magnitude % 100 / 10);
+    break;
+  }
+  case HISTORY_POWER:
+    snprintf(buf, size, "%ld.%ldW", value / 1000, value % 1000 / 100);
+    break;
+  case HISTORY_FAN:
+    snprintf(buf, size, "%ld.%ld%%", value / 10, value % 10);
+    break;
+  default:
+    snprintf(buf, size, "-");
+    break;
+  }
+}
@@ -0,0 +1,145 @@
+/**
+ * @file history.h
+ * @brief 温度/功率/风扇的多分辨率时间序列 (RAM环形缓冲)
+ * @author User
+ * @date 2025-10-03
+ *
+ * 主循环每HISTORY_SAMPLE_MS采样一次NTC温度、LED电功率(thermal.h)和风扇
+ * 占空比，按全精度累计最小/最大/平均值。每满1秒把累计结果存入秒环，
+ * 同时并入分钟累计器；每满60个秒桶存入分钟环并入小时累计器，依此类推。
+ * 插入只做一次量化和一次环形写入，O(1)；降采样在累计器中随插入完成，
+ * 不需要回头遍历。上一级的平均值是下一级各桶平均值的平均 (等权)。
+ *
+ * 桶中每个序列存3字节 (最小/最大/平均)，按序列的偏移和步长量化为
+ * 0-254，255表示该桶没有有效样本 (如NTC开路):
+ * - TEMP:  -20.0~107.0°C，0.5°C一级
+ * - POWER: 0~通道数x60W (THERMAL_CHANNEL_MW_MAX)，2通道500mW一级，
+ *          4通道1000mW一级
+ * - FAN:   0~101.6%，0.4%一级
+ * 三个环共(60+60+24)x9字节。
+ *
+ * 二进制导出 (HIST DUMP): 先输出一行文本说明字节数，随后为小端序的
+ *   HistoryDumpHeader_t + 每个序列的HistoryScale_t
+ *   + count行 x 序列数 x HistoryBucket_t (从旧到新)
+ *   + CRC32 (与EEPROM数据块相同算法，覆盖之前所有字节)
+ *
+ * 快照: 开启后每产生一个小时桶把小时环写入EEPROM (约230字节，
+ * 每天24次)，开机时恢复，断电后仍能看到之前24小时的趋势。
+ */
+
+#ifndef __HISTORY_H__
+#define __HISTORY_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define HISTORY_SAMPLE_MS 100 // 采样间隔 (每秒桶10个样本)
+#define HISTORY_SECONDS 60    // 秒环桶数
+#define HISTORY_MINUTES 60    // 分钟环桶数
+#define HISTORY_HOURS 24      // 小时环桶数
+#define HISTORY_FANOUT 60     // 每个上级桶包含的下级桶数
+#define HISTORY_EMPTY 0xFF    // 桶中没有有效样本
+#define HISTORY_CODE_MAX 254  // 量化上限
+#define HISTORY_DUMP_VERSION 1
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef enum {
+  HISTORY_TEMP = 0, // NTC温度 (x100)
+  HISTORY_POWER,    // LED电功率 (mW)
+  HISTORY_FAN,      // 风扇占空比 (‰)
+  HISTORY_SERIES_COUNT,
+  HISTORY_SERIES_NONE = HISTORY_SERIES_COUNT
+} HistorySeries_t;
+
+typedef enum {
+  HISTORY_RES_SEC = 0,
+  HISTORY_RES_MIN,
+  HISTORY_RES_HOUR,
+  HISTORY_RES_COUNT
+} HistoryRes_t;
+
+/**
+ * @brief 一个序列在一个桶中的量化值
+ */
+typedef struct {
+  uint8_t min;
+  uint8_t max;
+  uint8_t avg;
+} HistoryBucket_t;
+
+/**
+ * @brief 量化参数: 值 = offset + code * step
+ */
+typedef struct {
+  int16_t offset;
+  uint16_t step;
+} __attribute__((packed)) HistoryScale_t;
+
+/**
+ * @brief 二进制导出帧头 (后跟HISTORY_SERIES_COUNT个HistoryScale_t)
+ */
+typedef struct {
+  uint8_t magic[2];       // 'T' 'S'
+  uint8_t version;        // HISTORY_DUMP_VERSION
+  uint8_t resolution;     // HistoryRes_t
+  uint16_t bucketSeconds; // 每桶秒数
+  uint8_t series;         // 序列数
+  uint8_t count;          // 行数
+  uint32_t sequence;      // 最后一行的序号 (该分辨率从开机/快照起的桶计数)
+} __attribute__((packed)) HistoryDumpHeader_t;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 从EEPROM恢复小时环快照 / 主循环采样、降采样并按需保存快照
+ */
+bool History_Load(void);
+void History_Process(void);
+
+/**
+ * @brief 某个分辨率已有的桶数 / 环的桶数 / 最新桶的序号
+ */
+uint8_t History_Count(uint8_t res);
+uint8_t History_Capacity(uint8_t res);
+uint32_t History_Sequence(uint8_t res);
+uint16_t History_Bucket_Seconds(uint8_t res);
+
+/**
+ * @brief 读取一个桶 (age=0为最新)，已换算回原单位
+ * @return 超出范围或桶中没有有效样本时返回false
+ */
+bool History_Get(uint8_t res, uint8_t age, uint8_t series, int32_t *min,
+                 int32_t *max, int32_t *avg);
+
+/**
+ * @brief 以二进制帧从串口输出从最新往前跳过skip个之后的count个桶
+ * @return 输出的字节数，没有数据时为0
+ */
+uint16_t History_Dump(uint8_t res, uint8_t count, uint8_t skip);
+uint16_t History_Dump_Size(uint8_t count);
+
+/**
+ * @brief 周期快照开关 / 在主循环中立即保存一次
+ */
+void History_Set_Snapshot(bool enable);
+bool History_Snapshot_Enabled(void);
+void History_Request_Snapshot(void);
+
+/**
+ * @brief OLED曲线页 (series为HISTORY_SERIES_NONE时关闭)
+ */
+void History_Set_Display(uint8_t series, uint8_t res);
+uint8_t History_Display_Series(void);
+uint8_t History_Display_Resolution(void);
+
+/**
+ * @brief 名称和按单位格式化的值 (显示/命令共用)
+ */
+const char *History_Series_Name(uint8_t series);
+const char *History_Res_Name(uint8_t res);
+void History_Format(uint8_t series, int32_t value, char *buf, uint8_t size);
+
+#endif /* __HISTORY_H__ */
@@ -0,0 +1,75 @@
+/**
+ * @file latency.cpp
+ * @brief 输入到出光延迟探针实现
+ * @author User
+ * @date 2025-09-27
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "latency.h"
+#include "stm32f1xx_hal.h"
+#include <string.h>
+
+/* Private types -------------------------------------------------------------*/
+
+typedef enum {
+  PROBE_IDLE = 0,
+  PROBE_INPUT,  // 已有有效输入，等待目标重算
+  PROBE_TARGET  // 目标已重算，等待写比较寄存器
+} ProbeStage_t;
+
+/* Private variables ---------------------------------------------------------*/
+static volatile uint32_t edge_cycles = 0;  // 最近一个编码器边沿
+static volatile uint32_t input_cycles = 0; // 产生有效输入的边沿
+static volatile uint8_t stage = PROBE_IDLE;
+static volatile bool fast_path = true;
+static LatencyStats_t stats;
+
+/* Public functions ----------------------------------------------------------*/
+
+void Latency_Mark_Edge(void) { edge_cycles = DWT->CYCCNT; }
+
+void Latency_Input(void) {
+  // 连续输入时保留最早未完成的边沿，测量的是用户感受到的最坏情况
+  if (stage == PROBE_IDLE) {
+    input_cycles = edge_cycles;
+  }
+  stage = PROBE_INPUT;
+}
+
+void Latency_Target_Updated(void) {
+  if (stage == PROBE_INPUT) {
+    stage = PROBE_TARGET;
+  }
+}
+
+void Latency_Output_Written(void) {
+  if (stage != PROBE_TARGET) {
+    return;
+  }
+  stage = PROBE_IDLE;
+
+  uint32_t cycles = DWT->CYCCNT - input_cycles;
+  if (stats.count == 0 || cycles < stats.minCycles) {
+    stats.minCycles = cycles;
+  }
+  if (cycles > stats.maxCycles) {
+    stats.maxCycles = cycles;
+  }
+  stats.sumCycles += cycles;
+  stats.count++;
+}
+
+const LatencyStats_t *Latency_Get_Stats(void) { return &stats; }
+
+void Latency_Reset(void) {
+  memset(&stats, 0, sizeof(stats));
+  stage = PROBE_IDLE;
+}
+
+void Latency_Set_Fast_Path(bool enabled) {
+  fast_path = enabled;
+  Latency_Reset();
+}
+
+bool Latency_Fast_Path(void) { return fast_path; }
@@ -0,0 +1,64 @@
+/**
+ * @file latency.h
+ * @brief 输入到出光延迟探针 (编码器边沿 -> TIM1比较值写入)
+ * @author User
+ * @date 2025-09-27
+ *
+ * 编码器EXTI入口记录DWT周期计数，产生有效旋转的那个边沿被保留下来，
+ * 目标PWM按新输入重算后，第一次写比较寄存器时结束一次测量。
+ * 快速路径(默认开启)在编码器中断中直接重算目标并缓变一步写入比较值；
+ * 关闭后走主循环calcPWM + TIM3节拍的原路径，便于对比两者的延迟。
+ * 比较值为预装载，实际出光还要再等待不超过一个PWM周期。
+ */
+
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef struct {
+  uint32_t count;     // 测量次数
+  uint32_t minCycles; // 最小/最大/累计延迟 (CPU周期)
+  uint32_t maxCycles;
+  uint64_t sumCycles;
+} LatencyStats_t;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 编码器EXTI入口调用: 记录边沿时间
+ */
+void Latency_Mark_Edge(void);
+
+/**
+ * @brief 编码器边沿产生了有效输入 (亮度/色温已修改)
+ */
+void Latency_Input(void);
+
+/**
+ * @brief 目标PWM已按最新输入重算
+ */
+void Latency_Target_Updated(void);
+
+/**
+ * @brief 比较寄存器已写入，结束一次测量
+ */
+void Latency_Output_Written(void);
+
+/**
+ * @brief 统计数据
+ */
+const LatencyStats_t *Latency_Get_Stats(void);
+void Latency_Reset(void);
+
+/**
+ * @brief 输入快速路径开关
+ */
+void Latency_Set_Fast_Path(bool enabled);
+bool Latency_Fast_Path(void);
+
+#endif /* __LATENCY_H__ */
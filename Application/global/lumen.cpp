@@ -0,0 +1,210 @@
+/**
+ * @file lumen.cpp
+ * @brief LED光衰补偿实现
+ * @author User
+ * @date 2025-09-24
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "lumen.h"
+#include "controller.h"
+#include "drivers/settings.h"
+#include "global_objects.h"
+#include "pwm_profile.h"
+#include "utils/custom_types.h"
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+// 一个加权秒 = 满占空比 x 温度系数1.0 持续PWM_UPDATE_HZ个节拍 (满占空比随PWM配置变化)
+#define LUMEN_UNIT_PER_COUNT ((uint32_t)LUMEN_TEMP_ONE * PWM_UPDATE_HZ)
+
+// 温度系数表: 25℃起每10℃一档，约每升高20℃光衰速度翻倍
+#define LUMEN_TEMP_BASE 2500 // ℃ x100
+#define LUMEN_TEMP_STEP 1000
+static const uint16_t lumenTempFactor[] = {256,  362,  512,  724,
+                                           1024, 1448, 2048, 2896};
+#define LUMEN_TEMP_LEVELS (sizeof(lumenTempFactor) / sizeof(lumenTempFactor[0]))
+
+static_assert(2896 < LUMEN_UNIT_PER_COUNT,
+              "One tick must add less than one weighted second");
+static_assert((uint64_t)PWM_PERIOD_MAX * LUMEN_UNIT_PER_COUNT * 2 < UINT32_MAX,
+              "Weighted second must fit the 32-bit accumulator");
+static_assert(sizeof(LumenRecord_t) + sizeof(uint32_t) <= 64,
+              "Lumen record must fit two EEPROM pages");
+
+/* Global variables ----------------------------------------------------------*/
+LumenRecord_t lumen;
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t lumen_frac[LED_CHANNEL_COUNT]; // 不足一个加权秒的余量
+static volatile uint16_t temp_factor = LUMEN_TEMP_ONE;
+static volatile uint8_t lumen_dirty = 1;    // 需要重算增益
+static volatile uint8_t lumen_unsaved = 0;  // 曲线/开关修改，需要立即保存
+
+/* Private functions ---------------------------------------------------------*/
+
+static uint16_t tempFactorFor(int32_t temp) {
+  if (temp <= LUMEN_TEMP_BASE) {
+    return lumenTempFactor[0];
+  }
+  uint32_t level = (temp - LUMEN_TEMP_BASE) / LUMEN_TEMP_STEP;
+  if (level >= LUMEN_TEMP_LEVELS) {
+    level = LUMEN_TEMP_LEVELS - 1;
+  }
+  return lumenTempFactor[level];
+}
+
+static void updateGains(void) {
+  bool changed = false;
+  forEachChannel([&](uint8_t ch) {
+    uint16_t gain = CHANNEL_GAIN_ONE;
+    if (lumen.enabled) {
+      uint16_t output = Lumen_Output_At(lumen.seconds[ch] / 3600);
+      gain = ((uint32_t)CHANNEL_GAIN_ONE * LUMEN_OUTPUT_FULL) / output;
+      gain = constrain(gain, CHANNEL_GAIN_ONE, LUMEN_GAIN_MAX);
+    }
+    if (channels.gain[ch] != gain) {
+      channels.gain[ch] = gain;
+      changed = true;
+    }
+  });
+
+  // 增益每变化一个LSB约对应数十小时，重算目标PWM的频率很低
+  if (changed) {
+    pwm_dirty = 1;
+  }
+}
+
+static void save(void) {
+  // 累计值在中断中递增，先取快照再计算CRC，保证写入的数据与CRC一致
+  LumenRecord_t snapshot = lumen;
+  if (Settings_SaveBlock(EEPROM_ADDR_LUMEN, &snapshot, sizeof(snapshot))) {
+    serial_printf("Lumen data saved\r\n");
+  }
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+ * @brief 恢复默认曲线并清零累计
+ * @note 默认曲线: 指数衰减，50000h时降到70% (TM-21常用的L70指标)
+ */
+void Lumen_Init(void) {
+  static const uint32_t hours[LUMEN_CURVE_POINTS] = {0,     10000, 20000,
+                                                     30000, 40000, 50000};
+  static const uint16_t output[LUMEN_CURVE_POINTS] = {1000, 931, 867,
+                                                      807,  751, 700};
+  memset(&lumen, 0, sizeof(lumen));
+  memcpy(lumen.curveHours, hours, sizeof(hours));
+  memcpy(lumen.curveOutput, output, sizeof(output));
+  lumen.enabled = 1;
+  memset(lumen_frac, 0, sizeof(lumen_frac));
+  lumen_dirty = 1;
+}
+
+/**
+ * @brief 从EEPROM加载累计数据和曲线
+ */
+bool Lumen_Load(void) {
+  LumenRecord_t record;
+  if (!Settings_LoadBlock(EEPROM_ADDR_LUMEN, &record, sizeof(record))) {
+    serial_printf("Lumen data not found, starting from zero\r\n");
+    return false;
+  }
+  for (uint8_t i = 0; i < LUMEN_CURVE_POINTS; i++) {
+    if (record.curveOutput[i] < LUMEN_OUTPUT_MIN ||
+        record.curveOutput[i] > LUMEN_OUTPUT_FULL ||
+        (i > 0 && record.curveHours[i] <= record.curveHours[i - 1])) {
+      serial_printf("Lumen curve invalid, using defaults\r\n");
+      return false;
+    }
+  }
+
+  lumen = record;
+  lumen_dirty = 1;
+  serial_printf("Lumen data loaded (CH1 %lu h)\r\n", lumen.seconds[0] / 3600);
+  return true;
+}
+
+/**
+ * @brief PWM更新中断中调用: 按实际输出占空比累计
+ * @note 每节拍最多加不到一个加权秒，进位只需一次比较
+ */
+void Lumen_Accumulate(const uint16_t *duty) {
+  uint32_t factor = temp_factor;
+  uint32_t unit = PwmProfile_Get_Max() * LUMEN_UNIT_PER_COUNT;
+  forEachChannel([&](uint8_t ch) {
+    lumen_frac[ch] += duty[ch] * factor;
+    if (lumen_frac[ch] >= unit) {
+      lumen_frac[ch] -= unit;
+      lumen.seconds[ch]++;
+    }
+  });
+}
+
+/**
+ * @brief 主循环调用: 更新温度系数和补偿增益，定期保存
+ */
+void Lumen_Process(void) {
+  static uint32_t last_update = 0;
+  static uint32_t last_save = 0;
+  uint32_t now = HAL_GetTick();
+
+  if (lumen_unsaved) {
+    lumen_unsaved = 0;
+    save();
+    last_save = now;
+  }
+
+  if (lumen_dirty || now - last_update >= LUMEN_UPDATE_MS) {
+    lumen_dirty = 0;
+    last_update = now;
+    temp_factor = tempFactorFor(state.temp);
+    updateGains();
+  }
+
+  if (now - last_save >= LUMEN_SAVE_INTERVAL_MS) {
+    last_save = now;
+    save();
+  }
+}
+
+void Lumen_Invalidate(void) {
+  lumen_dirty = 1;
+  lumen_unsaved = 1;
+}
+
+/**
+ * @brief 清零通道累计
+ */
+void Lumen_Reset(uint8_t ch) {
+  forEachChannel([&](uint8_t i) {
+    if (ch == 0xFF || ch == i) {
+      lumen.seconds[i] = 0;
+      lumen_frac[i] = 0;
+    }
+  });
+  Lumen_Invalidate();
+}
+
+/**
+ * @brief 按曲线线性插值查询光输出，超出末节点时保持末节点值
+ */
+uint16_t Lumen_Output_At(uint32_t hours) {
+  if (hours <= lumen.curveHours[0]) {
+    return lumen.curveOutput[0];
+  }
+  for (uint8_t i = 1; i < LUMEN_CURVE_POINTS; i++) {
+    if (hours < lumen.curveHours[i]) {
+      uint32_t h0 = lumen.curveHours[i - 1];
+      uint32_t h1 = lumen.curveHours[i];
+      int32_t o0 = lumen.curveOutput[i - 1];
+      int32_t o1 = lumen.curveOutput[i];
+      return o0 + (int32_t)(((int64_t)(o1 - o0) * (hours - h0)) / (h1 - h0));
+    }
+  }
+  return lumen.curveOutput[LUMEN_CURVE_POINTS - 1];
+}
+
+uint16_t Lumen_Get_Temp_Factor(void) { return temp_factor; }
@@ -0,0 +1,87 @@
+/**
+ * @file lumen.h
+ * @brief LED光衰补偿 (按累计加权点亮时长)
+ * @author User
+ * @date 2025-09-24
+ *
+ * 在PWM更新中断中按 占空比 x 时间 x 温度系数 累计每个通道的加权点亮时长，
+ * 单位为"25℃满占空比秒"。主循环按可配置的光衰曲线(加权小时 -> 光输出‰)
+ * 求出补偿增益，写入channels.gain作用于通道管线，并定期保存到EEPROM。
+ */
+
+#ifndef __LUMEN_H__
+#define __LUMEN_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include "channels.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define LUMEN_CURVE_POINTS 6          // 光衰曲线节点数
+#define LUMEN_OUTPUT_FULL 1000        // 光输出满量程 (‰)
+#define LUMEN_OUTPUT_MIN 500          // 曲线允许的最低光输出 (‰)
+#define LUMEN_GAIN_MAX 1536           // 补偿增益上限 (Q10, 1.5倍)
+#define LUMEN_TEMP_ONE 256            // 温度系数满量程 (25℃ = 1.0)
+#define LUMEN_UPDATE_MS 1000          // 增益/温度系数更新间隔
+#define LUMEN_SAVE_INTERVAL_MS 1800000 // 累计数据保存间隔 (30分钟)
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+ * @brief 光衰数据 (EEPROM布局，按LED_CHANNEL_MAX固定)
+ */
+typedef struct {
+  uint32_t seconds[LED_CHANNEL_MAX];         // 加权点亮时长 (25℃满占空比秒)
+  uint32_t curveHours[LUMEN_CURVE_POINTS];   // 曲线节点: 加权小时 (递增)
+  uint16_t curveOutput[LUMEN_CURVE_POINTS];  // 曲线节点: 光输出 (‰)
+  uint8_t enabled;                           // 补偿开关
+  uint8_t reserved[3];
+} __attribute__((packed)) LumenRecord_t;
+
+extern LumenRecord_t lumen;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 恢复默认曲线 (L70 @ 50000h 指数衰减) 并清零累计
+ */
+void Lumen_Init(void);
+
+/**
+ * @brief 从EEPROM加载累计数据和曲线
+ */
+bool Lumen_Load(void);
+
+/**
+ * @brief PWM更新中断中调用: 按实际输出占空比累计 (仅整数加法和比较)
+ * @param duty 各通道本次写入的PWM比较值
+ */
+void Lumen_Accumulate(const uint16_t *duty);
+
+/**
+ * @brief 主循环调用: 更新温度系数和补偿增益，定期保存
+ */
+void Lumen_Process(void);
+
+/**
+ * @brief 标记曲线/开关已修改，立即重算增益并保存
+ */
+void Lumen_Invalidate(void);
+
+/**
+ * @brief 清零通道累计 (更换LED后使用)，ch=0xFF清零所有通道
+ */
+void Lumen_Reset(uint8_t ch);
+
+/**
+ * @brief 按曲线查询给定加权小时的光输出 (‰)
+ */
+uint16_t Lumen_Output_At(uint32_t hours);
+
+/**
+ * @brief 当前温度系数 (LUMEN_TEMP_ONE = 1.0)
+ */
+uint16_t Lumen_Get_Temp_Factor(void);
+
+#endif /* __LUMEN_H__ */
@@ -0,0 +1,215 @@
+/**
+ * @file presets.cpp
+ * @brief 预设场景库实现
+ * @author User
+ * @date 2025-09-23
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "presets.h"
+#include "controller.h"
+#include "drivers/settings.h"
+#include "effects.h"
+#include "global_objects.h"
+#include "utils/custom_types.h"
+#include <string.h>
+
+static_assert(sizeof(Preset_t) == 16, "Preset EEPROM layout changed");
+
+/* Private variables ---------------------------------------------------------*/
+static Preset_t bank[PRESET_COUNT];                          // EEPROM镜像
+static uint16_t bank_target[PRESET_COUNT][LED_CHANNEL_COUNT]; // 预计算目标PWM
+static uint16_t fade_ms = PRESET_FADE_MS_DEFAULT;
+static int8_t active = -1;
+static volatile uint8_t bank_unsaved = 0;
+static volatile uint8_t bank_stale = 1; // 目标PWM需要重算
+
+/* Private functions ---------------------------------------------------------*/
+
+static void setPreset(uint8_t index, uint16_t colorTemp, uint16_t brightness) {
+  memset(&bank[index], 0, sizeof(Preset_t));
+  bank[index].colorTemp = colorTemp;
+  bank[index].brightness = brightness;
+  bank[index].fanAuto = 1;
+  bank[index].used = 1;
+  bank[index].effectType = EFFECT_NONE;
+  bank[index].effectSpeed = effect.speed;
+  bank[index].effectDepth = effect.depth;
+  bank[index].effectPeriod = effect.period;
+  bank[index].effectStep = effect.step;
+  bank[index].effectPattern = effect.pattern;
+}
+
+static EffectConfig_t presetEffect(const Preset_t *p) {
+  EffectConfig_t config;
+  config.type = p->effectType;
+  config.depth = p->effectDepth;
+  config.period = p->effectPeriod;
+  config.step = p->effectStep;
+  config.pattern = p->effectPattern;
+  config.speed = p->effectSpeed;
+  return config;
+}
+
+static bool validPreset(const Preset_t *p) {
+  if (!p->used) {
+    return true;
+  }
+  // 效果参数与EFFECT命令的范围相同，调用时直接交给Effects_Set
+  EffectConfig_t config = presetEffect(p);
+  return p->used == 1 && p->colorTemp >= COLOR_TEMP_MIN &&
+         p->colorTemp <= COLOR_TEMP_MAX &&
+         p->brightness <= LED_MAX_BRIGHTNESS && p->fanAuto <= 1 &&
+         Effects_Valid(&config);
+}
+
+static void refreshTargets(void) {
+  for (uint8_t i = 0; i < PRESET_COUNT; i++) {
+    if (bank[i].used) {
+      calculateChannelRatio(bank[i].colorTemp, bank[i].brightness,
+                            bank_target[i]);
+    }
+  }
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+/**
+ * @brief 恢复默认预设: 暖光/中性/冷光三档，其余为空
+ */
+void Presets_Init(void) {
+  memset(bank, 0, sizeof(bank));
+  setPreset(0, COLOR_TEMP_MIN, LED_MAX_BRIGHTNESS / 2);
+  setPreset(1, COLOR_TEMP_DEFAULT, LED_MAX_BRIGHTNESS * 3 / 4);
+  setPreset(2, COLOR_TEMP_MAX, LED_MAX_BRIGHTNESS);
+  active = -1;
+  bank_stale = 1;
+}
+
+/**
+ * @brief 从EEPROM加载预设库
+ */
+bool Presets_Load(void) {
+  bank_stale = 1;
+  if (!Settings_LoadBlock(EEPROM_ADDR_PRESETS, bank, sizeof(bank))) {
+    serial_printf("Presets not found, using defaults\r\n");
+    Presets_Init();
+    return false;
+  }
+  for (uint8_t i = 0; i < PRESET_COUNT; i++) {
+    if (!validPreset(&bank[i])) {
+      serial_printf("Preset %d invalid, using defaults\r\n", i + 1);
+      Presets_Init();
+      return false;
+    }
+  }
+
+  serial_printf("Presets loaded\r\n");
+  return true;
+}
+
+/**
+ * @brief 主循环调用: 重算目标PWM、保存已修改的预设库
+ */
+void Presets_Process(bool refresh) {
+  if (refresh || bank_stale) {
+    bank_stale = 0;
+    refreshTargets();
+  }
+  if (bank_unsaved) {
+    bank_unsaved = 0;
+    if (Settings_SaveBlock(EEPROM_ADDR_PRESETS, bank, sizeof(bank))) {
+      serial_printf("Presets saved\r\n");
+    }
+  }
+}
+
+/**
+ * @brief 调用预设，立即以预计算的目标PWM开始交叉渐变
+ */
+bool Presets_Recall(uint8_t index) {
+  if (index >= PRESET_COUNT || !bank[index].used) {
+    return false;
+  }
+  const Preset_t *p = &bank[index];
+
+  // 同步lastState，避免calcPWM再按色温/亮度重新求解
+  state.colorTemp = p->colorTemp;
+  state.brightness = p->brightness;
+  lastState.colorTemp = p->colorTemp;
+  lastState.brightness = p->brightness;
+
+  if (p->fanAuto) {
+    fan_auto();
+  } else {
+    fan_force();
+  }
+
+  EffectConfig_t config = presetEffect(p);
+  Effects_Set(&config);
+
+  if (!state.master) {
+    state.master = true;
+    startBounceAnimation();
+  }
+  startCrossfade(bank_target[index], fade_ms);
+
+  active = index;
+  btn_changed = 1;      // 唤醒屏幕
+  settings_changed = 1; // 只保存一次当前设置
+  return true;
+}
+
+/**
+ * @brief 按方向调用下一个/上一个已存储的预设
+ */
+bool Presets_Recall_Next(int8_t dir) {
+  int8_t index = active;
+  for (uint8_t n = 0; n < PRESET_COUNT; n++) {
+    index = (index + dir + PRESET_COUNT) % PRESET_COUNT;
+    if (bank[index].used) {
+      return Presets_Recall(index);
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief 将当前色温/亮度/风扇模式/效果存入预设
+ */
+bool Presets_Store(uint8_t index) {
+  if (index >= PRESET_COUNT) {
+    return false;
+  }
+
+  Preset_t *p = &bank[index];
+  p->colorTemp = state.colorTemp;
+  p->brightness = state.brightness;
+  p->fanAuto = state.fanAuto ? 1 : 0;
+  p->used = 1;
+  p->effectType = effect.type;
+  p->effectSpeed = effect.speed;
+  p->effectDepth = effect.depth;
+  p->effectPeriod = effect.period;
+  p->effectStep = effect.step;
+  p->effectPattern = effect.pattern;
+
+  active = index;
+  bank_stale = 1;
+  bank_unsaved = 1;
+  return true;
+}
+
+const Preset_t *Presets_Get(uint8_t index) {
+  return (index < PRESET_COUNT) ? &bank[index] : NULL;
+}
+
+const uint16_t *Presets_Get_Target(uint8_t index) {
+  return (index < PRESET_COUNT) ? bank_target[index] : NULL;
+}
+
+void Presets_Set_Fade(uint16_t ms) { fade_ms = ms; }
+
+uint16_t Presets_Get_Fade(void) { return fade_ms; }
+
+int8_t Presets_Get_Active(void) { return active; }
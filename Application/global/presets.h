@@ -0,0 +1,96 @@
+/**
+ * @file presets.h
+ * @brief 预设场景库 (色温/亮度/风扇模式/效果)，O(1)调用并交叉渐变
+ * @author User
+ * @date 2025-09-23
+ *
+ * 预设保存在EEPROM中，上电后整体镜像到RAM，同时为每个预设预先算好
+ * 各通道目标PWM。调用时只需拷贝目标值并启动交叉渐变，不再经过色度
+ * 求解和伽马计算；通道参数或色度数据变化后由主循环统一重算。
+ */
+
+#ifndef __PRESETS_H__
+#define __PRESETS_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include "channels.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define PRESET_COUNT 8            // 预设数量
+#define PRESET_FADE_MS_DEFAULT 500 // 默认交叉渐变时长
+#define PRESET_FADE_MS_MAX 10000
+#define PRESET_CLICK_BASE 3 // 编码器按键3/4/5击调用预设1/2/3
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+ * @brief 单个预设 (EEPROM布局，16字节)
+ */
+typedef struct {
+  uint16_t colorTemp;     // 色温 (K)
+  uint16_t brightness;    // 亮度 (0-LED_MAX_BRIGHTNESS)
+  uint8_t fanAuto;        // 风扇自动控制 (0/1)
+  uint8_t used;           // 槽位已存储
+  uint8_t effectType;     // EffectType_t
+  uint8_t effectSpeed;    // 效果参数，含义见EffectConfig_t
+  uint16_t effectDepth;
+  uint16_t effectPeriod;
+  uint16_t effectStep;
+  uint16_t effectPattern;
+} __attribute__((packed)) Preset_t;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 恢复默认预设 (随后可能被EEPROM数据覆盖)
+ */
+void Presets_Init(void);
+
+/**
+ * @brief 从EEPROM加载预设库，失败时保留默认值
+ */
+bool Presets_Load(void);
+
+/**
+ * @brief 主循环调用: 重算目标PWM、保存已修改的预设库
+ * @param refresh 通道参数/色度数据已变化，需要重算所有预设的目标PWM
+ */
+void Presets_Process(bool refresh);
+
+/**
+ * @brief 调用预设 (下标从0开始)，立即开始交叉渐变
+ * @return 槽位为空或越界时返回false
+ */
+bool Presets_Recall(uint8_t index);
+
+/**
+ * @brief 按方向调用下一个/上一个已存储的预设 (循环)
+ * @param dir 1=下一个, -1=上一个
+ */
+bool Presets_Recall_Next(int8_t dir);
+
+/**
+ * @brief 将当前色温/亮度/风扇模式/效果存入预设 (EEPROM写入延迟到主循环)
+ */
+bool Presets_Store(uint8_t index);
+
+/**
+ * @brief 读取预设内容和预计算的目标PWM
+ */
+const Preset_t *Presets_Get(uint8_t index);
+const uint16_t *Presets_Get_Target(uint8_t index);
+
+/**
+ * @brief 交叉渐变时长 (ms)
+ */
+void Presets_Set_Fade(uint16_t fade_ms);
+uint16_t Presets_Get_Fade(void);
+
+/**
+ * @brief 最近一次调用的预设下标 (未调用过为-1)
+ */
+int8_t Presets_Get_Active(void);
+
+#endif /* __PRESETS_H__ */
@@ -0,0 +1,133 @@
+/**
+ * @file pwm_profile.cpp
+ * @brief LED PWM频率/分辨率配置实现
+ * @author User
+ * @date 2025-09-26
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "pwm_profile.h"
+#include "channels.h"
+#include "controller.h"
+#include "global_objects.h"
+#include "tim.h"
+
+/* Private variables ---------------------------------------------------------*/
+
+static constexpr PwmProfile_t profiles[PWM_PROFILE_COUNT] = {
+    {"STD", 0, 6100},    // 128MHz / 6101  = 20.98kHz
+    {"VIDEO", 0, 3199},  // 128MHz / 3200  = 40.00kHz
+    {"HIRES", 0, 32767}, // 128MHz / 32768 = 3.91kHz
+};
+
+static constexpr bool profilesValid(void) {
+  for (const PwmProfile_t &p : profiles) {
+    if (p.period > PWM_PERIOD_MAX || p.period < 1000) {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(profilesValid(), "PWM profile period out of range");
+static_assert(profiles[PWM_PROFILE_STANDARD].period == MAX_PWM,
+              "Standard profile must match the TIM1 CubeMX configuration");
+
+static volatile uint8_t active = PWM_PROFILE_STANDARD;
+static volatile uint8_t requested = PWM_PROFILE_STANDARD;
+static volatile uint16_t active_max = MAX_PWM;
+static uint16_t switch_from = MAX_PWM; // 切换期间的旧/新量程
+static uint16_t switch_to = MAX_PWM;
+
+/* Private functions ---------------------------------------------------------*/
+
+static uint16_t scale(uint16_t value, uint16_t from, uint16_t to) {
+  uint32_t v = ((uint32_t)value * to + from / 2) / from;
+  return (v > to) ? to : v;
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+void PwmProfile_Init(void) {
+  // 周期寄存器使用预装载，与比较值一样在更新事件时才生效
+  htim1.Instance->CR1 |= TIM_CR1_ARPE;
+  active = PWM_PROFILE_STANDARD;
+  requested = PWM_PROFILE_STANDARD;
+  active_max = profiles[PWM_PROFILE_STANDARD].period;
+}
+
+bool PwmProfile_Select(uint8_t id) {
+  if (id >= PWM_PROFILE_COUNT) {
+    return false;
+  }
+  requested = id;
+  return true;
+}
+
+/**
+ * @brief 开始切换: 禁止更新事件，写入新周期并换算所有PWM量
+ * @note 在TIM3 PWM更新中断中调用。主循环中读写这些PWM量的代码 (命令、
+ *       预设交叉渐变、二进制协议) 先检查后写入时必须关中断，否则换算
+ *       可能夹在中间，写入旧量程的值
+ */
+bool PwmProfile_Begin_Switch(void) {
+  if (requested == active) {
+    return false;
+  }
+
+  const PwmProfile_t *p = &profiles[requested];
+  switch_from = active_max;
+  switch_to = p->period;
+
+  // UDIS置位期间PSC/ARR/CCR只写入预装载寄存器，恢复后在下一个周期边界一起生效
+  htim1.Instance->CR1 |= TIM_CR1_UDIS;
+  htim1.Instance->PSC = p->prescaler;
+  htim1.Instance->ARR = p->period;
+  htim1.Init.Prescaler = p->prescaler;
+  htim1.Init.Period = p->period;
+
+  forEachChannel([](uint8_t ch) {
+    state.currentPWM[ch] = PwmProfile_Rescale(state.currentPWM[ch]);
+    state.targetPWM[ch] = PwmProfile_Rescale(state.targetPWM[ch]);
+    lastState.targetPWM[ch] = PwmProfile_Rescale(lastState.targetPWM[ch]);
+    channels.limit[ch] = PwmProfile_Rescale(channels.limit[ch]);
+    uint16_t step = PwmProfile_Rescale(channels.fadeStep[ch]);
+    channels.fadeStep[ch] = step ? step : 1;
+  });
+
+  active = requested;
+  active_max = p->period;
+  pwm_dirty = 1; // 主循环按新量程重新查伽马表，得到完整分辨率的目标值
+  return true;
+}
+
+void PwmProfile_End_Switch(void) { htim1.Instance->CR1 &= ~TIM_CR1_UDIS; }
+
+uint16_t PwmProfile_Rescale(uint16_t value) {
+  return scale(value, switch_from, switch_to);
+}
+
+uint16_t PwmProfile_From_Standard(uint16_t value) {
+  return scale(value, MAX_PWM, active_max);
+}
+
+uint16_t PwmProfile_To_Standard(uint16_t value) {
+  return scale(value, active_max, MAX_PWM);
+}
+
+uint8_t PwmProfile_Get_Active(void) { return active; }
+
+uint8_t PwmProfile_Get_Requested(void) { return requested; }
+
+const PwmProfile_t *PwmProfile_Get(uint8_t id) {
+  return (id < PWM_PROFILE_COUNT) ? &profiles[id] : NULL;
+}
+
+uint16_t PwmProfile_Get_Max(void) { return active_max; }
+
+uint32_t PwmProfile_Frequency(uint8_t id) {
+  if (id >= PWM_PROFILE_COUNT) {
+    return 0;
+  }
+  return PWM_TIMER_CLOCK_HZ /
+         (((uint32_t)profiles[id].prescaler + 1) * (profiles[id].period + 1));
+}
@@ -0,0 +1,89 @@
+/**
+ * @file pwm_profile.h
+ * @brief LED PWM频率/分辨率配置 (运行时切换TIM1预分频和周期)
+ * @author User
+ * @date 2025-09-26
+ *
+ * 通道管线中的PWM量(目标/当前PWM、限幅、缓变步进)都以当前配置的计数值
+ * 表示，伽马表以Q16存储，由Channels_LevelToPWM按当前周期换算。
+ * EEPROM中的限幅仍以标准配置(MAX_PWM)为满量程，加载/保存时换算。
+ *
+ * 切换在PWM更新中断中进行: 先禁止TIM1更新事件，写入新的预分频、周期和
+ * 按新量程换算的比较值(均为预装载寄存器)，再恢复更新事件，使它们在同一个
+ * 周期边界一起生效，不会出现新周期配旧比较值的错误脉冲。
+ */
+
+#ifndef __PWM_PROFILE_H__
+#define __PWM_PROFILE_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define PWM_TIMER_CLOCK_HZ 128000000 // TIM1时钟 (APB2)
+#define PWM_PERIOD_MAX 32767         // 周期上限 (缓变计算使用int16)
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef enum {
+  PWM_PROFILE_STANDARD = 0, // 约21kHz, 6101级 (默认，与CubeMX配置一致)
+  PWM_PROFILE_VIDEO,        // 40kHz, 3200级，摄像机拍摄无滚动条纹
+  PWM_PROFILE_HIRES,        // 约3.9kHz, 32768级，建筑照明深度调光
+  PWM_PROFILE_COUNT
+} PwmProfileId_t;
+
+typedef struct {
+  const char *name;
+  uint16_t prescaler; // TIM1 PSC
+  uint16_t period;    // TIM1 ARR (满占空比比较值)
+} PwmProfile_t;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 初始化 (开启TIM1自动重装载预装载，当前为标准配置)
+ */
+void PwmProfile_Init(void);
+
+/**
+ * @brief 请求切换配置，在下一次PWM更新中断中生效
+ */
+bool PwmProfile_Select(uint8_t id);
+
+/**
+ * @brief PWM更新中断调用: 有待切换的配置时换算所有PWM量并写入周期寄存器
+ * @return 本次更新正在切换，比较值写完后必须调用PwmProfile_End_Switch
+ */
+bool PwmProfile_Begin_Switch(void);
+void PwmProfile_End_Switch(void);
+
+/**
+ * @brief 切换期间把旧量程的PWM量换算到新量程
+ */
+uint16_t PwmProfile_Rescale(uint16_t value);
+
+/**
+ * @brief 标准量程(MAX_PWM)与当前量程互相换算 (EEPROM存储用)
+ */
+uint16_t PwmProfile_From_Standard(uint16_t value);
+uint16_t PwmProfile_To_Standard(uint16_t value);
+
+/**
+ * @brief 当前/待生效配置
+ */
+uint8_t PwmProfile_Get_Active(void);
+uint8_t PwmProfile_Get_Requested(void);
+const PwmProfile_t *PwmProfile_Get(uint8_t id);
+
+/**
+ * @brief 当前满占空比比较值 (TIM1周期)
+ */
+uint16_t PwmProfile_Get_Max(void);
+
+/**
+ * @brief 配置的PWM频率 (Hz)
+ */
+uint32_t PwmProfile_Frequency(uint8_t id);
+
+#endif /* __PWM_PROFILE_H__ */
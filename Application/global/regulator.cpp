@@ -0,0 +1,290 @@
+/**
+ * @file regulator.cpp
+ * @brief 恒功率/恒流闭环实现
+ * @author User
+ * @date 2025-09-25
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "regulator.h"
+#include "analog.h"
+#include "channels.h"
+#include "controller.h"
+#include "effects.h"
+#include "fan.h"
+#include "global_objects.h"
+#include "hardware/devices.h"
+#include "stm32f1xx_hal.h"
+#include "thermal.h"
+#include "utils/custom_types.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Private defines -----------------------------------------------------------*/
+
+// 内部增益精度Q16，对外发布Q10
+#define GAIN_SHIFT 6
+// 每次只修正理想增益差值的1/4: 采样和TIM3节拍合计约两个样本的延迟，
+// 修正系数取1/4时约十几个样本稳定，超调不超过15%
+#define GAIN_ALPHA_SHIFT 2
+
+/* Private variables ---------------------------------------------------------*/
+static volatile uint8_t mode = REG_MODE_OFF;
+static volatile uint32_t setpoint = 0;
+static volatile uint8_t restart = 1; // 模式/设定值已修改 (可能来自命令中断)
+static volatile uint16_t gain = REG_GAIN_ONE;
+static uint32_t gain_q16 = (uint32_t)REG_GAIN_ONE << GAIN_SHIFT;
+static uint32_t ref_sum = 0; // 设定值对应的目标PWM总和
+
+static RegulatorTelemetry_t telemetry;
+static bool has_sample = false;
+static uint32_t last_read_tick = 0;
+static uint32_t last_sample_tick = 0;
+static uint32_t rate_tick = 0;
+static uint16_t rate_count = 0;
+static uint32_t settle_start = 0;
+static uint32_t settle_entry = 0; // 本轮连续进入判据的时间
+static uint8_t settle_count = 0;
+
+/* Private functions ---------------------------------------------------------*/
+
+static uint32_t measuredValue(void) {
+  if (mode == REG_MODE_CURRENT) {
+    return telemetry.currentMilliamps > 0 ? telemetry.currentMilliamps : 0;
+  }
+  return telemetry.powerMilliwatts;
+}
+
+static uint32_t targetSum(void) {
+  uint32_t sum = 0;
+  forEachChannel([&](uint8_t ch) { sum += state.targetPWM[ch]; });
+  return sum;
+}
+
+static bool fading(void) {
+  bool active = false;
+  forEachChannel([&](uint8_t ch) {
+    if (state.currentPWM[ch] != state.targetPWM[ch]) {
+      active = true;
+    }
+  });
+  return active;
+}
+
+// 增益上限: 任何通道放大后都不超过其限幅，保证通道配比不被削顶破坏
+static uint32_t gainCap(void) {
+  uint32_t cap = REG_GAIN_MAX;
+  forEachChannel([&](uint8_t ch) {
+    if (state.targetPWM[ch] > 0) {
+      uint32_t c = ((uint32_t)channels.limit[ch] * REG_GAIN_ONE) /
+                   state.targetPWM[ch];
+      if (c < cap) {
+        cap = c;
+      }
+    }
+  });
+  return cap < REG_GAIN_MIN ? REG_GAIN_MIN : cap;
+}
+
+static void setGain(uint32_t q16) {
+  gain_q16 = q16;
+  gain = q16 >> GAIN_SHIFT;
+}
+
+static void beginSettle(uint32_t now) {
+  settle_start = now;
+  settle_count = 0;
+  telemetry.settled = false;
+  telemetry.peakPermille = 0;
+}
+
+static void updateSettle(uint32_t now, int32_t permille) {
+  uint16_t magnitude = abs(permille);
+  if (telemetry.settled) {
+    if (magnitude > telemetry.peakPermille) {
+      telemetry.peakPermille = magnitude;
+    }
+    return;
+  }
+
+  if (magnitude > REG_SETTLE_BAND_PERMILLE) {
+    settle_count = 0;
+    return;
+  }
+  if (settle_count == 0) {
+    settle_entry = now;
+  }
+  if (++settle_count >= REG_SETTLE_SAMPLES) {
+    telemetry.settled = true;
+    telemetry.settleMs = settle_entry - settle_start;
+  }
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+void Regulator_Init(void) {
+  memset(&telemetry, 0, sizeof(telemetry));
+  mode = REG_MODE_OFF;
+  setpoint = 0;
+  restart = 1;
+  setGain((uint32_t)REG_GAIN_ONE << GAIN_SHIFT);
+}
+
+/**
+ * @brief 主循环调用: 发起采样、更新增益和遥测
+ */
+void Regulator_Process(void) {
+  if (!devices.extern_adc) {
+    return;
+  }
+  uint32_t now = HAL_GetTick();
+
+  PowerSample_t sample;
+  bool fresh = power_monitor.fetch(&sample);
+  if (fresh) {
+    telemetry.busMillivolts = sample.busMillivolts;
+    telemetry.currentMilliamps = sample.currentMilliamps;
+    telemetry.powerMilliwatts = sample.powerMilliwatts;
+    has_sample = true;
+    last_sample_tick = now;
+  }
+
+  // 非阻塞采样: 中断中读完两个寄存器，下一轮主循环取结果
+  if (now - last_read_tick >= REG_SAMPLE_MS && power_monitor.startRead()) {
+    last_read_tick = now;
+  }
+
+  // 统计实际闭环频率
+  if (now - rate_tick >= 1000) {
+    telemetry.loopRate = ((uint32_t)rate_count * 1000) / (now - rate_tick);
+    rate_count = 0;
+    rate_tick = now;
+  }
+
+  if (mode == REG_MODE_OFF) {
+    setGain((uint32_t)REG_GAIN_ONE << GAIN_SHIFT);
+    return;
+  }
+
+  // 模拟看门狗保护动作后输出已关断，测量值接近0，闭环会一路把增益推到
+  // 上限，ADC CLEAR后以过驱恢复。保护期间增益回到1.0，清除后重新进入调节
+  if (Analog_Tripped()) {
+    setGain((uint32_t)REG_GAIN_ONE << GAIN_SHIFT);
+    restart = 1;
+    return;
+  }
+
+  uint32_t sum = targetSum();
+  if (restart) {
+    restart = 0;
+    ref_sum = sum;
+    beginSettle(now);
+  } else if (sum && ref_sum && sum != ref_sum) {
+    // 亮度/色温变化: 设定值按目标PWM总和等比例缩放 (PWM调光下平均电流与占空比成正比)
+    uint64_t scaled = ((uint64_t)setpoint * sum) / ref_sum;
+    setpoint = constrain(scaled, 1, REG_SETPOINT_MAX);
+    ref_sum = sum;
+    beginSettle(now);
+  } else if (sum && !ref_sum) {
+    ref_sum = sum;
+  }
+
+  // 传感器无响应时退回开环
+  if (now - last_sample_tick > REG_SAMPLE_TIMEOUT_MS) {
+    if (!telemetry.fault) {
+      telemetry.fault = true;
+      setGain((uint32_t)REG_GAIN_ONE << GAIN_SHIFT);
+    }
+    return;
+  }
+  telemetry.fault = false;
+
+  // 关灯、渐变和效果调制期间测量值不代表稳态，冻结增益；
+  // 风扇故障/结温降额期间也冻结，否则闭环会把降额补偿回去
+  if (!fresh || !state.master || sum == 0 || setpoint == 0 || fading() ||
+      effect.type != EFFECT_NONE || Fan_Get_Derate() != FAN_DERATE_ONE ||
+      Thermal_Get_Derate() != THERMAL_DERATE_ONE) {
+    return;
+  }
+
+  uint32_t value = measuredValue();
+  int32_t error = (int32_t)value - (int32_t)setpoint;
+  int32_t permille = ((int64_t)error * 1000) / (int32_t)setpoint;
+  telemetry.error = error;
+  telemetry.errorPermille = constrain(permille, -32767, 32767);
+  rate_count++;
+  updateSettle(now, permille);
+
+  if (value == 0 || abs(permille) <= REG_DEADBAND_PERMILLE) {
+    return;
+  }
+
+  // 测量值近似与增益成正比: 理想增益 = 当前增益 x 设定/测量，每次只走一部分
+  int64_t ideal = ((uint64_t)gain_q16 * setpoint) / value;
+  int64_t next = (int64_t)gain_q16 + ((ideal - (int64_t)gain_q16) >> GAIN_ALPHA_SHIFT);
+  next = constrain(next, (int64_t)REG_GAIN_MIN << GAIN_SHIFT,
+                   (int64_t)gainCap() << GAIN_SHIFT);
+  setGain(next);
+}
+
+bool Regulator_Set_Mode(uint8_t new_mode) {
+  if (new_mode > REG_MODE_CURRENT) {
+    return false;
+  }
+  if (new_mode != REG_MODE_OFF && !devices.extern_adc) {
+    return false;
+  }
+  // 切换测量量纲时设定值必须重新指定
+  if (new_mode != mode) {
+    setpoint = 0;
+  }
+  mode = new_mode;
+  restart = 1;
+  return true;
+}
+
+uint8_t Regulator_Get_Mode(void) { return mode; }
+
+const char *Regulator_Mode_Name(uint8_t m) {
+  switch (m) {
+  case REG_MODE_POWER:
+    return "CP";
+  case REG_MODE_CURRENT:
+    return "CC";
+  default:
+    return "OFF";
+  }
+}
+
+void Regulator_Set_Setpoint(uint32_t value) {
+  setpoint = value > REG_SETPOINT_MAX ? REG_SETPOINT_MAX : value;
+  restart = 1;
+}
+
+uint32_t Regulator_Get_Setpoint(void) { return setpoint; }
+
+bool Regulator_Hold(void) {
+  if (!has_sample || mode == REG_MODE_OFF) {
+    return false;
+  }
+  uint32_t value = measuredValue();
+  if (value == 0) {
+    return false;
+  }
+  Regulator_Set_Setpoint(value);
+  return true;
+}
+
+uint16_t Regulator_Get_Gain(void) { return gain; }
+
+const RegulatorTelemetry_t *Regulator_Get_Telemetry(void) { return &telemetry; }
+
+bool Regulator_Measured_Power(uint32_t *milliwatts) {
+  // 按样本时间判断超时: telemetry.fault只在CP/CC模式下更新
+  if (!devices.extern_adc || !has_sample ||
+      HAL_GetTick() - last_sample_tick > REG_SAMPLE_TIMEOUT_MS) {
+    return false;
+  }
+  *milliwatts = telemetry.powerMilliwatts;
+  return true;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file regulator.h
+ * @brief 恒功率/恒流闭环 (基于I2C电压电流采样)
+ * @author User
+ * @date 2025-09-25
+ *
+ * 主循环每REG_SAMPLE_MS发起一次非阻塞采样，拿到新样本后按测量值与设定值
+ * 的偏差更新一个整体增益。增益在PWM更新中断中同比例乘到所有通道上，
+ * 通道配比(色温)不变；上限按各通道限幅留出的余量计算，不会突破限幅。
+ *
+ * 设定值跟随亮度/色温: 目标PWM变化时按目标PWM总和等比例缩放设定值，
+ * 所以编码器调光在闭环模式下仍然有效，闭环只负责消除温漂等慢变化。
+ * 渐变、效果运行期间以及主开关关闭时冻结增益。
+ */
+
+#ifndef __REGULATOR_H__
+#define __REGULATOR_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define REG_GAIN_ONE 1024            // 闭环增益满量程 (Q10)
+#define REG_GAIN_MIN 512             // 增益下限 (0.5倍)
+#define REG_GAIN_MAX 1536            // 增益上限 (1.5倍)，另受通道限幅约束
+#define REG_SAMPLE_MS 10             // 采样间隔 (INA226约8.8ms出一个结果)
+#define REG_SAMPLE_TIMEOUT_MS 200    // 超过该时间无样本判为传感器故障
+#define REG_SETPOINT_MAX 100000      // 设定值上限 (mW/mA)
+#define REG_DEADBAND_PERMILLE 5      // 误差死区 (‰)
+#define REG_SETTLE_BAND_PERMILLE 20  // 稳定判据 (‰)
+#define REG_SETTLE_SAMPLES 5         // 连续多少个样本在判据内视为稳定
+#define REG_SHUNT_MOHM 10            // 分流电阻 (毫欧)
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef enum {
+  REG_MODE_OFF = 0, // 开环
+  REG_MODE_POWER,   // 恒功率 (mW)
+  REG_MODE_CURRENT  // 恒流 (mA)
+} RegulatorMode_t;
+
+/**
+ * @brief 闭环遥测
+ */
+typedef struct {
+  uint16_t busMillivolts;   // 最近一次采样
+  int32_t currentMilliamps;
+  uint32_t powerMilliwatts;
+  uint16_t loopRate;        // 最近一秒的闭环更新次数 (Hz)
+  int32_t error;            // 最近一次误差 (测量-设定，mW/mA)
+  int16_t errorPermille;    // 最近一次误差 (‰)
+  uint16_t peakPermille;    // 稳定后的最大误差 (‰)
+  uint32_t settleMs;        // 最近一次扰动(设定/目标变化)到稳定的时间
+  bool settled;             // 已稳定
+  bool fault;               // 传感器超时，已退回开环
+} RegulatorTelemetry_t;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 初始化闭环 (开环模式，增益为1)
+ */
+void Regulator_Init(void);
+
+/**
+ * @brief 主循环调用: 发起采样、更新增益和遥测
+ */
+void Regulator_Process(void);
+
+/**
+ * @brief 切换模式，未检测到采样芯片时只能选择开环
+ */
+bool Regulator_Set_Mode(uint8_t mode);
+uint8_t Regulator_Get_Mode(void);
+const char *Regulator_Mode_Name(uint8_t mode);
+
+/**
+ * @brief 设定值 (恒功率为mW，恒流为mA)
+ */
+void Regulator_Set_Setpoint(uint32_t value);
+uint32_t Regulator_Get_Setpoint(void);
+
+/**
+ * @brief 以当前测量值作为设定值
+ * @return 还没有有效样本时返回false
+ */
+bool Regulator_Hold(void);
+
+/**
+ * @brief 当前闭环增益 (Q10)，在PWM更新中断中使用
+ */
+uint16_t Regulator_Get_Gain(void);
+
+const RegulatorTelemetry_t *Regulator_Get_Telemetry(void);
+
+/**
+ * @brief 最近一次实测功率 (mW)
+ * @return 没有外部采样芯片、还没有样本或传感器超时时返回false
+ */
+bool Regulator_Measured_Power(uint32_t *milliwatts);
+
+#endif /* __REGULATOR_H__ */
@@ -0,0 +1,110 @@
+/**
+ * @file tach.cpp
+ * @brief 风扇测速输入捕获实现
+ * @author User
+ * @date 2025-09-29
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "tach.h"
+#include "tim.h"
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t tach_clock_hz = 0;           // TIM2计数频率
+static volatile uint32_t overflows = 0;      // 时间戳高16位
+static volatile uint32_t last_stamp = 0;
+static volatile uint32_t period_sum = 0;     // 窗口内周期和 (计数)
+static volatile uint8_t period_count = 0;
+static volatile bool window_open = false;
+static volatile bool armed = false;          // 已有起点边沿
+
+/* Public functions ----------------------------------------------------------*/
+
+void Tach_Init(void) {
+  GPIO_InitTypeDef gpio = {0};
+  gpio.Pin = TACH_GPIO_PIN;
+  gpio.Mode = GPIO_MODE_INPUT;
+  gpio.Pull = GPIO_PULLUP; // 测速为集电极开路输出
+  HAL_GPIO_Init(TACH_GPIO_PORT, &gpio);
+
+  // APB1分频不为1时定时器时钟为PCLK1的2倍
+  uint32_t clock = HAL_RCC_GetPCLK1Freq();
+  if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) {
+    clock *= 2;
+  }
+  tach_clock_hz = clock / (htim2.Instance->PSC + 1);
+
+  // CH2映射到TI2，最大输入滤波 (fDTS/32, N=8)，上升沿捕获
+  TIM_TypeDef *tim = htim2.Instance;
+  tim->CCER &= ~TIM_CCER_CC2E;
+  tim->CCMR1 = (tim->CCMR1 & ~(TIM_CCMR1_CC2S | TIM_CCMR1_IC2F |
+                               TIM_CCMR1_IC2PSC)) |
+               TIM_CCMR1_CC2S_0 | TIM_CCMR1_IC2F;
+  tim->CCER &= ~TIM_CCER_CC2P;
+  tim->CCER |= TIM_CCER_CC2E;
+  tim->SR = ~(TIM_SR_CC2IF | TIM_SR_CC2OF | TIM_SR_UIF);
+  tim->DIER |= TIM_DIER_CC2IE | TIM_DIER_UIE;
+
+  HAL_NVIC_SetPriority(TIM2_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+void Tach_Start_Window(void) {
+  __disable_irq();
+  period_sum = 0;
+  period_count = 0;
+  armed = false;
+  window_open = true;
+  __enable_irq();
+}
+
+uint8_t Tach_Periods(void) { return period_count; }
+
+uint16_t Tach_Stop_Window(uint8_t pulsesPerRev) {
+  __disable_irq();
+  window_open = false;
+  uint32_t sum = period_sum;
+  uint8_t count = period_count;
+  __enable_irq();
+
+  if (count == 0 || sum == 0 || pulsesPerRev == 0) {
+    return 0;
+  }
+
+  // RPM = 60 * f / (平均周期 * 每转脉冲数)
+  uint64_t rpm = (uint64_t)60 * tach_clock_hz * count /
+                 ((uint64_t)sum * pulsesPerRev);
+  return (rpm > UINT16_MAX) ? UINT16_MAX : rpm;
+}
+
+/**
+ * @brief TIM2中断: 溢出计数和测速捕获
+ */
+extern "C" void Tach_IRQHandler(void) {
+  TIM_TypeDef *tim = htim2.Instance;
+  uint32_t sr = tim->SR;
+
+  if (sr & TIM_SR_CC2IF) {
+    uint32_t capture = tim->CCR2; // 读CCR2清除CC2IF
+    uint32_t high = overflows;
+    // 溢出标志尚未处理而捕获值很小: 捕获发生在这次溢出之后
+    if ((sr & TIM_SR_UIF) && capture < 0x8000) {
+      high++;
+    }
+    uint32_t stamp = (high << 16) | capture;
+    if (window_open) {
+      if (armed && period_count < UINT8_MAX) {
+        period_sum += stamp - last_stamp;
+        period_count = period_count + 1;
+      }
+      armed = true;
+    }
+    last_stamp = stamp;
+    tim->SR = ~TIM_SR_CC2OF;
+  }
+
+  if (sr & TIM_SR_UIF) {
+    tim->SR = ~TIM_SR_UIF;
+    overflows = overflows + 1;
+  }
+}
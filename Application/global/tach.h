@@ -0,0 +1,57 @@
+/**
+ * @file tach.h
+ * @brief 风扇测速输入捕获 (PA1, TIM2_CH2)
+ * @author User
+ * @date 2025-09-29
+ *
+ * TIM2作为微秒延时的自由计数器一直在运行，这里只开启CH2上升沿捕获和
+ * 溢出中断，不改变计数方式。中断里只把捕获值扩展为32位时间戳并累计
+ * 周期和与周期数，没有除法和HAL_GetTick；RPM在测量窗口结束时按周期
+ * 平均值一次算出。
+ *
+ * 测量按窗口进行: 打开窗口后的第一个边沿只作为起点，之后每个边沿累计
+ * 一个完整周期。风扇供电被PWM斩波时测速信号无效，由调用方在窗口内
+ * 保持满占空比(脉冲展宽)。
+ */
+
+#ifndef __TACH_H__
+#define __TACH_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define TACH_GPIO_PORT GPIOA
+#define TACH_GPIO_PIN GPIO_PIN_1 // TIM2_CH2
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 配置PA1输入、TIM2_CH2捕获和TIM2中断
+ */
+void Tach_Init(void);
+
+/**
+ * @brief 开始一个测量窗口 (清空累计，下一个边沿作为起点)
+ */
+void Tach_Start_Window(void);
+
+/**
+ * @brief 当前窗口内已累计的完整周期数
+ */
+uint8_t Tach_Periods(void);
+
+/**
+ * @brief 结束窗口并按平均周期计算转速
+ * @param pulsesPerRev 每转脉冲数
+ * @return RPM，窗口内没有完整周期时为0
+ */
+uint16_t Tach_Stop_Window(uint8_t pulsesPerRev);
+
+/**
+ * @brief TIM2中断处理 (stm32f1xx_it.c调用)
+ */
+extern "C" void Tach_IRQHandler(void);
+
+#endif /* __TACH_H__ */
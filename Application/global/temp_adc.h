@@ -1,11 +1,170 @@
-// ADC值查找表
-const static uint16_t tempTableADC[] = {
-    30,   36,   44,   53,   65,   80,   100,  126,  160,  206,
-    267,  350,  462,  613,  816,  1082, 1419, 1825, 2278, 2739,
-    3157, 3496, 3741, 3901, 3997, 4049, 4075, 4088, 4093, 4095};
-
-// 对应的温度值查找表 (温度*100)
-const static int16_t tempTableTemp[] = {
-    20000, 19000, 18000, 17000, 16000, 15000, 14000, 13000, 12000, 11000,
-    10000, 9000,  8000,  7000,  6000,  5000,  4000,  3000,  2000,  1000,
-    0,     -1000, -2000, -3000, -4000, -5000, -6000, -7000, -8000, -9000};
+/**
+ * @file temp_adc.h
+ * @brief NTC温度换算表 (编译期按B值公式生成)
+ * @author User
+ * @date 2025-10-01
+ *
+ * 分压电路: R_PULLUP接VCC，NTC接地，ADC读取NTC两端电压，
+ * R_ntc = R_PULLUP * a / (满量程 - a)，1/T = 1/T0 + ln(R_ntc/R0) / B。
+ * 表在编译期由controller.h中的R0_OHMS/B_VALUE/R_PULLUP生成，修改参数
+ * 后重新编译即可，不再需要外部脚本。
+ *
+ * 表按抽取后ADC值(analog.h)的高NTC_TABLE_BITS位直接索引，低位做线性
+ * 插值，换算为O(1)。编译期逐个ADC值与双精度公式比较，误差超出
+ * NTC_TABLE_MAX_ERROR时编译失败；主机上由test_adc_temp.py再与单精度
+ * 公式 (temperatureFloat，ADC BENCH也用它对比耗时) 逐个比较。
+ */
+
+#ifndef __TEMP_ADC_H__
+#define __TEMP_ADC_H__
+
+/* Includes ------------------------------------------------------------------*/
+// NTC参数来自controller.h (没有包含保护，由使用方先行包含)
+#include "analog.h"
+#include <array>
+#include <math.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define NTC_TABLE_BITS 8                             // 索引位数 (256段)
+#define NTC_TABLE_SIZE ((1 << NTC_TABLE_BITS) + 1)   // 含末端点
+#define NTC_TABLE_SHIFT (12 + ANALOG_EXTRA_BITS - NTC_TABLE_BITS) // 插值位数
+#define NTC_TEMP_MIN (-5500)      // 表值下限 (x100)
+#define NTC_TEMP_MAX 25000        // 表值上限 (x100)
+#define NTC_CHECK_MIN (-2000)     // 误差检查范围 (x100)
+#define NTC_CHECK_MAX 15000
+#define NTC_TABLE_MAX_ERROR 30    // 检查范围内允许的最大误差 (x100)
+
+static_assert(R0_OHMS > 0 && R_PULLUP > 0, "NTC resistances must be positive");
+static_assert(B_VALUE >= 2000 && B_VALUE <= 6000, "NTC B value out of range");
+static_assert(T0_KELVIN > 273150, "NTC reference temperature below 0 C");
+static_assert(NTC_TABLE_SHIFT >= 1, "NTC table finer than ADC resolution");
+static_assert(NTC_TEMP_MIN >= INT16_MIN && NTC_TEMP_MAX <= INT16_MAX,
+              "NTC table values must fit int16_t");
+
+namespace ntc {
+
+constexpr uint32_t FULL_SCALE = (ADC_MAX + 1) << ANALOG_EXTRA_BITS;
+
+/**
+ * @brief 编译期自然对数 (范围归约到[0.707,1.414)后用atanh级数)
+ * @note 整个量程的误差检查要在默认常量求值步数限制内完成，级数只取11项
+ */
+constexpr double log(double x) {
+  int k = 0;
+  while (x >= 1.41421356237309505) {
+    x /= 2.0;
+    k++;
+  }
+  while (x < 0.70710678118654752) {
+    x *= 2.0;
+    k--;
+  }
+  double y = (x - 1.0) / (x + 1.0);
+  double y2 = y * y;
+  double term = y;
+  double sum = 0.0;
+  for (int n = 1; n < 22; n += 2) {
+    sum += term / n;
+    term *= y2;
+  }
+  return 2.0 * sum + k * 0.69314718055994530942;
+}
+
+/**
+ * @brief 抽取后ADC值对应的温度 (°C，双精度)
+ */
+constexpr double temperature(double raw) {
+  double r = (double)R_PULLUP * raw / (FULL_SCALE - raw);
+  double t0 = T0_KELVIN / 1000.0;
+  double inv = 1.0 / t0 + log(r / R0_OHMS) / B_VALUE;
+  return 1.0 / inv - 273.15;
+}
+
+/**
+ * @brief 单精度公式直接换算 (查表前的做法，只用于对比耗时和误差)
+ * @return 温度x100
+ */
+inline int32_t temperatureFloat(uint32_t raw) {
+  float r = (float)R_PULLUP * raw / (FULL_SCALE - raw);
+  float inv = 1000.0f / T0_KELVIN + logf(r / R0_OHMS) / B_VALUE;
+  return (int32_t)lroundf((1.0f / inv - 273.15f) * 100.0f);
+}
+
+constexpr int16_t clampRound(double t) {
+  double x100 = t * 100.0;
+  if (x100 < NTC_TEMP_MIN) {
+    return NTC_TEMP_MIN;
+  }
+  if (x100 > NTC_TEMP_MAX) {
+    return NTC_TEMP_MAX;
+  }
+  return (int16_t)(x100 >= 0 ? x100 + 0.5 : x100 - 0.5);
+}
+
+constexpr std::array<int16_t, NTC_TABLE_SIZE> makeTable() {
+  std::array<int16_t, NTC_TABLE_SIZE> table{};
+  constexpr uint32_t step = 1U << NTC_TABLE_SHIFT;
+  for (uint32_t i = 0; i < NTC_TABLE_SIZE; i++) {
+    // 两个端点(0和满量程)电阻为0/无穷大，改取半段处并由上下限截断
+    double raw = (double)i * step;
+    if (i == 0) {
+      raw = step / 2.0;
+    } else if (i == NTC_TABLE_SIZE - 1) {
+      raw = FULL_SCALE - step / 2.0;
+    }
+    table[i] = clampRound(temperature(raw));
+  }
+  return table;
+}
+
+constexpr std::array<int16_t, NTC_TABLE_SIZE> table = makeTable();
+
+/**
+ * @brief 表查找+插值 (与运行时换算相同)
+ */
+constexpr int32_t lookup(uint32_t raw) {
+  uint32_t index = raw >> NTC_TABLE_SHIFT;
+  int32_t frac = raw & ((1U << NTC_TABLE_SHIFT) - 1);
+  int32_t t0 = table[index];
+  int32_t t1 = table[index + 1];
+  return t0 + (((t1 - t0) * frac) >> NTC_TABLE_SHIFT);
+}
+
+constexpr bool monotonic() {
+  for (uint32_t i = 1; i < NTC_TABLE_SIZE; i++) {
+    if (table[i] > table[i - 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief 检查范围内每个ADC值的最大误差 (x100)
+ */
+constexpr int32_t maxError() {
+  double worst = 0.0;
+  for (uint32_t raw = 1; raw < FULL_SCALE; raw++) {
+    double exact = temperature(raw) * 100.0;
+    if (exact < NTC_CHECK_MIN || exact > NTC_CHECK_MAX) {
+      continue;
+    }
+    double error = lookup(raw) - exact;
+    if (error < 0) {
+      error = -error;
+    }
+    if (error > worst) {
+      worst = error;
+    }
+  }
+  return (int32_t)(worst + 0.999);
+}
+
+static_assert(monotonic(), "NTC table must decrease with ADC value");
+static_assert(maxError() <= NTC_TABLE_MAX_ERROR,
+              "NTC table interpolation error too large");
+
+} // namespace ntc
+
+#endif /* __TEMP_ADC_H__ */
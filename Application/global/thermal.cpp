@@ -0,0 +1,449 @@
+/**
+ * @file thermal.cpp
+ * @brief 结温估计实现
+ * @author User
+ * @date 2025-10-02
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "thermal.h"
+#include "analog.h"
+#include "controller.h"
+#include "drivers/settings.h"
+#include "global_objects.h"
+#include "regulator.h"
+#include "tim.h"
+#include "utils/custom_types.h"
+#include <stdlib.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define SENSOR_FAULT_TEMP (-99900) // Analog_Raw_To_Temperature开路/短路返回值
+#define LOG_POWER_UNIT 10          // 记录中的功率单位 (mW)
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+  uint16_t power; // 发热功率 (LOG_POWER_UNIT)
+  int16_t temp;   // NTC温度 (x100)
+} LogPoint_t;
+
+/* Private variables ---------------------------------------------------------*/
+static ThermalConfig_t config = {
+    {THERMAL_CHANNEL_MW_DEFAULT, THERMAL_CHANNEL_MW_DEFAULT,
+     THERMAL_CHANNEL_MW_DEFAULT, THERMAL_CHANNEL_MW_DEFAULT},
+    THERMAL_HEAT_DEFAULT,
+    THERMAL_RJH_DEFAULT,
+    THERMAL_RHA_DEFAULT,
+    THERMAL_TAU_J_DEFAULT,
+    THERMAL_TAU_H_DEFAULT,
+    THERMAL_GAIN_DEFAULT,
+    THERMAL_AMBIENT_GAIN_DEFAULT,
+    THERMAL_LIMIT_DEFAULT,
+    0, // 风扇/降额默认不接入，模型参数核对后由THERM FAN ON/THERM LIMIT开启
+    0};
+static volatile uint8_t config_unsaved = 0;
+
+// 模型状态 (温度x100 << THERMAL_FRAC_BITS)
+static int32_t tj = 0;
+static int32_t th = 0;
+static int32_t ta = 0;
+static bool valid = false;
+static bool sensor_ok = false;
+static int32_t sensor = 0;
+static uint32_t input_mw = 0;
+static uint32_t heat_mw = 0;
+static bool measured = false;
+static volatile uint16_t derate = THERMAL_DERATE_ONE;
+static bool reported_derate = false;
+
+static LogPoint_t log_points[THERMAL_LOG_POINTS];
+static uint8_t log_count = 0;
+static uint8_t log_interval = 0; // 0=未记录
+static bool log_active = false;
+static uint32_t log_tick = 0;
+
+/* Private functions ---------------------------------------------------------*/
+
+static inline int32_t toState(int32_t temp) {
+  return temp * (1 << THERMAL_FRAC_BITS);
+}
+
+static inline int32_t fromState(int32_t value) {
+  return value >> THERMAL_FRAC_BITS;
+}
+
+/**
+ * @brief 功率P在热阻r上产生的温升 (状态单位)
+ */
+static inline int32_t rise(uint16_t r, uint32_t mw) {
+  // r: K/W x100，mW/1000 -> 温升x100
+  return (int32_t)(((int64_t)r * mw << THERMAL_FRAC_BITS) / 1000);
+}
+
+/**
+ * @brief 当前发热功率 (mW)，同时更新电功率input_mw
+ */
+static uint32_t heatPower(void) {
+  TIM_TypeDef *tim = htim1.Instance;
+  if (!(tim->BDTR & TIM_BDTR_MOE)) {
+    measured = false;
+    input_mw = 0;
+    return 0; // 过温关断，输出已切断
+  }
+
+  uint32_t electric = 0;
+  measured = Regulator_Measured_Power(&electric);
+  if (!measured) {
+    // 比较值已包含效果/闭环/降额增益，满占空比时CCR=ARR
+    uint32_t arr = tim->ARR;
+    for (uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++) {
+      uint32_t ccr = (&tim->CCR1)[ch];
+      if (ccr > arr) {
+        ccr = arr;
+      }
+      electric += arr ? (uint32_t)config.channelMw[ch] * ccr / arr : 0;
+    }
+  }
+  input_mw = electric;
+  return (uint64_t)electric * config.heatPermille / 1000;
+}
+
+/**
+ * @brief x += (target - x) * dt / tau，tau为0或短于dt时直接到达
+ */
+static int32_t approach(int32_t x, int32_t target, uint32_t dt_ms,
+                        uint32_t tau_ms) {
+  if (tau_ms <= dt_ms) {
+    return target;
+  }
+  return x + (int32_t)(((int64_t)(target - x) * dt_ms) / tau_ms);
+}
+
+static void step(uint32_t dt_ms) {
+  int32_t temp = state.temp;
+  sensor_ok = temp > SENSOR_FAULT_TEMP;
+  sensor = temp;
+  heat_mw = heatPower();
+
+  if (!valid) {
+    if (!sensor_ok) {
+      return;
+    }
+    // 第一个有效读数: 散热器取NTC读数，按当前功率反推环境和结温
+    th = toState(temp);
+    ta = th - rise(config.rha, heat_mw);
+    tj = th + rise(config.rjh, heat_mw);
+    valid = true;
+    return;
+  }
+
+  // 预测
+  th = approach(th, ta + rise(config.rha, heat_mw), dt_ms,
+                (uint32_t)config.tauH * 1000);
+
+  // 修正 (增益‰/s，乘dt ms)
+  if (sensor_ok) {
+    int64_t error = (int64_t)toState(temp) - th;
+    th += (int32_t)(error * config.gain * dt_ms / 1000000);
+    ta += (int32_t)(error * config.ambientGain * dt_ms / 1000000);
+    ta = constrain(ta, toState(THERMAL_AMBIENT_MIN),
+                   toState(THERMAL_AMBIENT_MAX));
+  }
+
+  tj = approach(tj, th + rise(config.rjh, heat_mw), dt_ms,
+                (uint32_t)config.tauJ * 100);
+}
+
+static void updateDerate(void) {
+  int32_t junction = fromState(tj);
+  uint16_t gain = THERMAL_DERATE_ONE;
+  if (valid && (config.flags & THERMAL_FLAG_DERATE) &&
+      junction > config.limit) {
+    int32_t over = junction - config.limit;
+    if (over >= THERMAL_DERATE_SPAN) {
+      gain = THERMAL_DERATE_MIN;
+    } else {
+      gain = THERMAL_DERATE_ONE - (THERMAL_DERATE_ONE - THERMAL_DERATE_MIN) *
+                                      over / THERMAL_DERATE_SPAN;
+    }
+  }
+  derate = gain;
+
+  bool active = gain != THERMAL_DERATE_ONE;
+  if (active != reported_derate) {
+    reported_derate = active;
+    if (active) {
+      serial_printf("Junction %d.%02d C above %d C, derating LED output\r\n",
+                    get_temperature_int(junction),
+                    get_temperature_frac(junction), config.limit / 100);
+    } else {
+      serial_printf("Junction derating released\r\n");
+    }
+  }
+}
+
+static void recordLog(uint32_t now) {
+  if (!log_active || now - log_tick < (uint32_t)log_interval * 1000) {
+    return;
+  }
+  log_tick = now;
+  uint32_t power = heat_mw / LOG_POWER_UNIT;
+  log_points[log_count].power = power > UINT16_MAX ? UINT16_MAX : power;
+  log_points[log_count].temp = constrain(sensor, INT16_MIN, INT16_MAX);
+  log_count++;
+  if (log_count >= THERMAL_LOG_POINTS) {
+    log_active = false;
+    serial_printf("Thermal log full (%u points)\r\n", log_count);
+  }
+}
+
+static void configChanged(void) { config_unsaved = 1; }
+
+/* Public functions ----------------------------------------------------------*/
+
+bool Thermal_Load(void) {
+  ThermalConfig_t record;
+  bool ok = Settings_LoadBlock(EEPROM_ADDR_THERMAL, &record, sizeof(record)) &&
+            record.heatPermille <= 1000 && record.rjh >= 1 &&
+            record.rjh <= THERMAL_R_MAX && record.rha >= 1 &&
+            record.rha <= THERMAL_R_MAX && record.tauJ <= THERMAL_TAU_J_MAX &&
+            record.tauH >= 1 && record.tauH <= THERMAL_TAU_H_MAX &&
+            record.gain <= THERMAL_GAIN_MAX &&
+            record.ambientGain <= THERMAL_GAIN_MAX &&
+            record.limit >= THERMAL_LIMIT_MIN &&
+            record.limit <= THERMAL_LIMIT_MAX;
+  for (uint8_t ch = 0; ok && ch < LED_CHANNEL_MAX; ch++) {
+    ok = record.channelMw[ch] <= THERMAL_CHANNEL_MW_MAX;
+  }
+  if (!ok) {
+    serial_printf("Thermal model not found, using defaults\r\n");
+    return false;
+  }
+
+  config = record;
+  serial_printf("Thermal model: Rjh %u.%02u K/W, Rha %u.%02u K/W, "
+                "tauH %u s\r\n",
+                record.rjh / 100, record.rjh % 100, record.rha / 100,
+                record.rha % 100, record.tauH);
+  return true;
+}
+
+/**
+ * @brief 主循环调用: 更新模型和降额、记录阶跃响应、保存已修改的配置
+ */
+void Thermal_Process(void) {
+  static uint32_t last_tick = 0;
+
+  uint32_t now = HAL_GetTick();
+  uint32_t dt = now - last_tick;
+  if (dt >= THERMAL_INTERVAL_MS && Analog_Ready()) {
+    last_tick = now;
+    // 主循环被阻塞(EEPROM写入等)时按实际间隔更新，过长时截断
+    step(dt > 1000 ? 1000 : dt);
+    updateDerate();
+    recordLog(now);
+  }
+
+  if (!config_unsaved) {
+    return;
+  }
+  config_unsaved = 0;
+
+  __disable_irq();
+  ThermalConfig_t snapshot = config;
+  __enable_irq();
+  if (Settings_SaveBlock(EEPROM_ADDR_THERMAL, &snapshot, sizeof(snapshot))) {
+    serial_printf("Thermal model saved\r\n");
+  }
+}
+
+void Thermal_Get_Status(ThermalStatus_t *status) {
+  status->junction = constrain(fromState(tj), INT16_MIN, INT16_MAX);
+  status->heatsink = constrain(fromState(th), INT16_MIN, INT16_MAX);
+  status->ambient = constrain(fromState(ta), INT16_MIN, INT16_MAX);
+  status->sensor = constrain(sensor, INT16_MIN, INT16_MAX);
+  status->inputMw = input_mw;
+  status->heatMw = heat_mw;
+  status->derate = derate;
+  status->measured = measured;
+  status->valid = valid;
+  status->sensorOk = sensor_ok;
+}
+
+const ThermalConfig_t *Thermal_Get_Config(void) { return &config; }
+
+uint16_t Thermal_Get_Derate(void) { return derate; }
+
+int32_t Thermal_Control_Temperature(void) {
+  if (valid && (config.flags & THERMAL_FLAG_FAN)) {
+    return fromState(tj);
+  }
+  return state.temp;
+}
+
+bool Thermal_Set_Model(uint16_t rjh, uint16_t rha, uint16_t tauJ,
+                       uint16_t tauH) {
+  if (rjh < 1 || rjh > THERMAL_R_MAX || rha < 1 || rha > THERMAL_R_MAX ||
+      tauJ > THERMAL_TAU_J_MAX || tauH < 1 || tauH > THERMAL_TAU_H_MAX) {
+    return false;
+  }
+  config.rjh = rjh;
+  config.rha = rha;
+  config.tauJ = tauJ;
+  config.tauH = tauH;
+  configChanged();
+  return true;
+}
+
+bool Thermal_Set_Observer(uint16_t gain, uint16_t ambientGain) {
+  if (gain > THERMAL_GAIN_MAX || ambientGain > THERMAL_GAIN_MAX) {
+    return false;
+  }
+  config.gain = gain;
+  config.ambientGain = ambientGain;
+  configChanged();
+  return true;
+}
+
+bool Thermal_Set_Channel_Power(uint8_t ch, uint16_t milliwatts) {
+  if (ch >= LED_CHANNEL_COUNT || milliwatts > THERMAL_CHANNEL_MW_MAX) {
+    return false;
+  }
+  config.channelMw[ch] = milliwatts;
+  configChanged();
+  return true;
+}
+
+bool Thermal_Set_Heat(uint16_t permille) {
+  if (permille > 1000) {
+    return false;
+  }
+  config.heatPermille = permille;
+  configChanged();
+  return true;
+}
+
+bool Thermal_Set_Limit(int16_t limit) {
+  if (limit < THERMAL_LIMIT_MIN || limit > THERMAL_LIMIT_MAX) {
+    return false;
+  }
+  config.limit = limit;
+  config.flags |= THERMAL_FLAG_DERATE;
+  configChanged();
+  return true;
+}
+
+void Thermal_Set_Flag(uint8_t flag, bool enable) {
+  if (enable) {
+    config.flags |= flag;
+  } else {
+    config.flags &= ~flag;
+  }
+  configChanged();
+}
+
+bool Thermal_Start_Log(uint8_t interval) {
+  if (interval < 1 || interval > THERMAL_LOG_INTERVAL_MAX) {
+    return false;
+  }
+  log_interval = interval;
+  log_count = 0;
+  // 立即记录第一个点作为阶跃前的基线
+  log_tick = HAL_GetTick() - (uint32_t)interval * 1000;
+  log_active = true;
+  return true;
+}
+
+bool Thermal_Get_Log(uint8_t index, uint32_t *heatMw, int16_t *temp) {
+  if (index >= log_count) {
+    return false;
+  }
+  *heatMw = (uint32_t)log_points[index].power * LOG_POWER_UNIT;
+  *temp = log_points[index].temp;
+  return true;
+}
+
+uint8_t Thermal_Log_Count(void) { return log_count; }
+
+uint8_t Thermal_Log_Interval(void) { return log_interval; }
+
+bool Thermal_Fit(ThermalFit_t *fit, bool apply) {
+  uint8_t n = log_count;
+  if (n < THERMAL_FIT_MIN_POINTS) {
+    return false;
+  }
+
+  // 基线取第一个点，终值取末尾四分之一的平均
+  uint8_t tail = n / 4;
+  int32_t p0 = log_points[0].power;
+  int32_t t0 = log_points[0].temp;
+  int32_t p_sum = 0;
+  int32_t t_sum = 0;
+  int32_t t_early = 0; // 末尾四分之一的前半段，用于判断是否稳定
+  for (uint8_t i = n - tail; i < n; i++) {
+    p_sum += log_points[i].power;
+    t_sum += log_points[i].temp;
+    if (i < n - tail / 2) {
+      t_early += log_points[i].temp;
+    }
+  }
+  int32_t p_end = p_sum / tail;
+  int32_t t_end = t_sum / tail;
+  int32_t t_late = (t_sum - t_early) / (tail - tail / 2);
+  t_early /= tail / 2;
+
+  int32_t dp = (p_end - p0) * LOG_POWER_UNIT;
+  int32_t dt = t_end - t0;
+  if (dp > -THERMAL_FIT_MIN_MW && dp < THERMAL_FIT_MIN_MW) {
+    return false;
+  }
+
+  // 阶跃点: 功率第一次越过变化量的一半
+  uint8_t s = 1;
+  while (s < n && abs((log_points[s].power - p0) * 2) < abs(p_end - p0)) {
+    s++;
+  }
+
+  // 63.2%时刻，两点间线性插值 (ms)
+  uint32_t interval_ms = (uint32_t)log_interval * 1000;
+  int32_t target = t0 + dt * 632 / 1000;
+  int32_t sign = dt >= 0 ? 1 : -1;
+  int32_t tau_ms = -1;
+  for (uint8_t i = s; i < n; i++) {
+    if ((log_points[i].temp - target) * sign < 0) {
+      continue;
+    }
+    int32_t prev = log_points[i - 1].temp;
+    int32_t span = log_points[i].temp - prev;
+    int32_t frac = span ? (int32_t)((int64_t)(target - prev) * interval_ms /
+                                    span)
+                        : 0;
+    // 阶跃发生在s-1和s两点之间，取中点；同一区间内就越过63.2%时中点可能
+    // 晚于越过时刻，改取s-1和越过时刻的中点 (两者在frac=interval处一致)
+    tau_ms = (int32_t)(i - 1 - s) * (int32_t)interval_ms + frac +
+             (int32_t)interval_ms / 2;
+    if (tau_ms < frac / 2) {
+      tau_ms = frac / 2;
+    }
+    break;
+  }
+
+  bool reached = tau_ms >= 0;
+  if (!reached) {
+    tau_ms = (int32_t)(n - s) * (int32_t)interval_ms; // 没有升到63.2%
+  }
+
+  int32_t rha = (int32_t)((int64_t)dt * 1000 / dp);
+  fit->deltaMw = dp;
+  fit->deltaT = dt;
+  fit->rha = constrain(rha, 1, THERMAL_R_MAX);
+  fit->tauH = constrain((tau_ms + 500) / 1000, 1, THERMAL_TAU_H_MAX);
+  // 末尾四分之一内温度变化超过温升的5%视为没有稳定，Rha偏小
+  fit->settled = reached && abs(t_late - t_early) * 20 <= abs(dt);
+
+  if (apply) {
+    config.rha = fit->rha;
+    config.tauH = fit->tauH;
+    configChanged();
+  }
+  return true;
+}
@@ -0,0 +1,181 @@
+/**
+ * @file thermal.h
+ * @brief 结温估计 (热模型+NTC观测器)，用于风扇前馈和LED降额
+ * @author User
+ * @date 2025-10-02
+ *
+ * NTC贴在散热器上，只能看到散热器温度，而且比LED结温滞后几十秒到几分钟；
+ * 亮度阶跃后风扇和降额要等散热器升温才响应。这里用二阶热网络按发热功率
+ * 预测结温:
+ *
+ *   P --Rjh--> Tj (结，时间常数tauJ)
+ *   P --Rha--> Th (散热器，时间常数tauH) --> Ta (环境)
+ *
+ *   Th' = (Ta + Rha*P - Th) / tauH + L  * (Tntc - Th)
+ *   Ta' =                              Li * (Tntc - Th)
+ *   Tj' = (Th + Rjh*P - Tj) / tauJ
+ *
+ * 观测器形式: 模型预测散热器温度，NTC读数与预测的误差按增益L修正状态，
+ * 误差的积分(Li)作为环境温度估计，吸收环境变化和Rha偏差，稳态下预测
+ * 散热器温度等于NTC读数。NTC开路/短路时停止修正，按模型继续开环预测。
+ * 结点在NTC上不可观测，Rjh/tauJ取LED数据手册的值，由命令设置。
+ *
+ * 发热功率: 外部电压电流采样芯片可用且没有故障时取实测电功率，否则按
+ * 各通道满占空比功率乘当前比较值估算；再乘发热比例(电功率中没有变成光
+ * 的部分)。过温关断(MOE清除)时功率为0。
+ *
+ * 全部为定点运算，状态为温度x100左移THERMAL_FRAC_BITS位，主循环每
+ * THERMAL_INTERVAL_MS按实际间隔更新一次。
+ *
+ * 输出:
+ * - 风扇: 开启后风扇曲线/PID的输入改为预测结温 (功率阶跃时立即响应)
+ * - 降额: 预测结温超过上限后LED增益线性下降，超过THERMAL_DERATE_SPAN
+ *   时为THERMAL_DERATE_MIN，与风扇故障降额相乘
+ *
+ * 参数辨识: THERM STEP开始按固定间隔记录功率和NTC温度，期间改变一次
+ * 亮度(功率阶跃)并保持到温度稳定；THERM FIT按记录起点和末尾四分之一的
+ * 平均值得到 Rha = dT/dP，按升到63.2%的时间得到tauH。
+ */
+
+#ifndef __THERMAL_H__
+#define __THERMAL_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include "channels.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define THERMAL_INTERVAL_MS 100     // 模型更新间隔
+#define THERMAL_FRAC_BITS 12        // 状态小数位 (温度x100之下)
+#define THERMAL_R_MAX 5000          // 热阻上限 (K/W x100)
+#define THERMAL_TAU_J_MAX 600       // 结时间常数上限 (0.1s)
+#define THERMAL_TAU_H_MAX 7200      // 散热器时间常数上限 (s)
+#define THERMAL_GAIN_MAX 1000       // 观测器增益上限 (‰/s)
+#define THERMAL_CHANNEL_MW_MAX 60000 // 单通道功率上限 (mW)
+#define THERMAL_LIMIT_MIN 5000      // 降额起点可设范围 (x100)
+#define THERMAL_LIMIT_MAX 15000
+#define THERMAL_AMBIENT_MIN (-4000) // 环境温度估计范围 (x100)
+#define THERMAL_AMBIENT_MAX 8500
+
+#define THERMAL_DERATE_ONE 1024  // 降额增益满量程 (Q10，与FAN_DERATE_ONE相同)
+#define THERMAL_DERATE_MIN 256   // 超过上限THERMAL_DERATE_SPAN时降到25%
+#define THERMAL_DERATE_SPAN 1000 // 降额区间 (x100)
+
+#define THERMAL_LOG_POINTS 64        // 阶跃响应记录点数
+#define THERMAL_LOG_INTERVAL_MAX 60  // 记录间隔上限 (s)
+#define THERMAL_FIT_MIN_MW 500       // 拟合要求的最小功率阶跃
+#define THERMAL_FIT_MIN_POINTS 16    // 拟合要求的最少点数
+
+// 默认参数: 每通道10W、70%变热，结到散热器1.5K/W、2s，散热器2K/W、5min
+#define THERMAL_CHANNEL_MW_DEFAULT 10000
+#define THERMAL_HEAT_DEFAULT 700     // 发热比例 (‰)
+#define THERMAL_RJH_DEFAULT 150
+#define THERMAL_RHA_DEFAULT 200
+#define THERMAL_TAU_J_DEFAULT 20
+#define THERMAL_TAU_H_DEFAULT 300
+#define THERMAL_GAIN_DEFAULT 50      // 约20s收敛
+#define THERMAL_AMBIENT_GAIN_DEFAULT 5
+#define THERMAL_LIMIT_DEFAULT 10500  // 105°C开始降额
+
+// ThermalConfig_t.flags
+#define THERMAL_FLAG_FAN 0x01    // 风扇按预测结温控制
+#define THERMAL_FLAG_DERATE 0x02 // 按预测结温降额
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+ * @brief 热模型配置 (EEPROM存储)
+ */
+typedef struct {
+  uint16_t channelMw[LED_CHANNEL_MAX]; // 各通道满占空比电功率 (mW)
+  uint16_t heatPermille; // 电功率中变成热的比例 (‰)
+  uint16_t rjh;          // 结到散热器热阻 (K/W x100)
+  uint16_t rha;          // 散热器到环境热阻 (K/W x100)
+  uint16_t tauJ;         // 结时间常数 (0.1s)
+  uint16_t tauH;         // 散热器时间常数 (s)
+  uint16_t gain;         // 观测器增益L (‰/s)
+  uint16_t ambientGain;  // 环境温度估计增益Li (‰/s)
+  int16_t limit;         // 降额起点结温 (x100)
+  uint8_t flags;         // THERMAL_FLAG_*
+  uint8_t reserved;
+} ThermalConfig_t;
+
+typedef struct {
+  int16_t junction; // 预测结温 (x100)
+  int16_t heatsink; // 预测散热器温度 (x100)
+  int16_t ambient;  // 环境温度估计 (x100)
+  int16_t sensor;   // 最近一次NTC读数 (x100)
+  uint32_t inputMw; // LED电功率 (实测或按占空比估算)
+  uint32_t heatMw;  // 发热功率
+  uint16_t derate;  // LED降额增益 (Q10)
+  bool measured;    // 功率取自外部采样芯片
+  bool valid;       // 已由NTC初始化
+  bool sensorOk;    // NTC读数有效，观测器在修正
+} ThermalStatus_t;
+
+/**
+ * @brief 阶跃响应拟合结果
+ */
+typedef struct {
+  int32_t deltaMw;  // 功率阶跃 (发热功率)
+  int32_t deltaT;   // 温升 (x100)
+  uint16_t rha;     // K/W x100
+  uint16_t tauH;    // s
+  bool settled;     // 记录末尾温度已稳定
+} ThermalFit_t;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 从EEPROM加载配置 / 主循环更新模型、记录阶跃响应并保存配置
+ */
+bool Thermal_Load(void);
+void Thermal_Process(void);
+
+/**
+ * @brief 运行状态 / 配置
+ */
+void Thermal_Get_Status(ThermalStatus_t *status);
+const ThermalConfig_t *Thermal_Get_Config(void);
+
+/**
+ * @brief LED降额增益 (Q10，PWM更新时乘到所有通道)
+ */
+uint16_t Thermal_Get_Derate(void);
+
+/**
+ * @brief 风扇控制用温度 (x100): 开启时为预测结温，否则为NTC温度
+ */
+int32_t Thermal_Control_Temperature(void);
+
+/**
+ * @brief 配置修改 (参数非法时返回false)
+ */
+bool Thermal_Set_Model(uint16_t rjh, uint16_t rha, uint16_t tauJ,
+                       uint16_t tauH);
+bool Thermal_Set_Observer(uint16_t gain, uint16_t ambientGain);
+bool Thermal_Set_Channel_Power(uint8_t ch, uint16_t milliwatts);
+bool Thermal_Set_Heat(uint16_t permille);
+bool Thermal_Set_Limit(int16_t limit);
+void Thermal_Set_Flag(uint8_t flag, bool enable);
+
+/**
+ * @brief 开始记录阶跃响应 (每interval秒一个点，记满停止)
+ */
+bool Thermal_Start_Log(uint8_t interval);
+
+/**
+ * @brief 阶跃响应记录 (index从0开始，超出已记录点数返回false)
+ */
+bool Thermal_Get_Log(uint8_t index, uint32_t *heatMw, int16_t *temp);
+uint8_t Thermal_Log_Count(void);
+uint8_t Thermal_Log_Interval(void);
+
+/**
+ * @brief 按记录拟合Rha/tauH，apply为true时写入配置
+ * @return 点数不足或功率阶跃太小时返回false
+ */
+bool Thermal_Fit(ThermalFit_t *fit, bool apply);
+
+#endif /* __THERMAL_H__ */
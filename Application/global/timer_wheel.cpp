@@ -0,0 +1,142 @@
+/**
+ * @file timer_wheel.cpp
+ * @brief 分层时间轮实现
+ * @author User
+ * @date 2025-10-05
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "timer_wheel.h"
+#include "stm32f1xx_hal.h"
+#include <stddef.h>
+
+/* Private defines -----------------------------------------------------------*/
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define BUCKET_EXPIRING 0xFF // 已从槽中取下，正在执行到期回调
+
+/* Private variables ---------------------------------------------------------*/
+static TimerWheelTimer_t *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+static uint32_t now = 0;      // 下一个待处理的毫秒
+static bool started = false; // now已与HAL_GetTick()对齐
+static TimerWheelTimer_t *expiring = NULL; // 本毫秒到期、尚未回调的定时器
+
+/* Private functions ---------------------------------------------------------*/
+
+static void sync(void) {
+  if (!started) {
+    now = HAL_GetTick();
+    started = true;
+  }
+}
+
+/**
+ * @brief 按剩余时间挂到对应层的槽上
+ */
+static void insert(TimerWheelTimer_t *timer) {
+  uint32_t when = timer->expires;
+  uint32_t delta = when - now;
+  if ((int32_t)delta < 0) {
+    // 已过期 (启动后主循环才推进到这里)，挂到马上要处理的槽
+    when = now;
+    delta = 0;
+  } else if (delta >= TIMER_WHEEL_SPAN) {
+    // 超出跨度先挂在最高层最远的槽，级联时按剩余时间重新挂入
+    when = now + TIMER_WHEEL_SPAN - 1;
+    delta = TIMER_WHEEL_SPAN - 1;
+  }
+
+  uint8_t level = 0;
+  while (level < TIMER_WHEEL_LEVELS - 1 &&
+         delta >= (1UL << (TIMER_WHEEL_BITS * (level + 1)))) {
+    level++;
+  }
+  uint8_t index = (when >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK;
+
+  timer->bucket = level * TIMER_WHEEL_SLOTS + index;
+  timer->next = slots[level][index];
+  slots[level][index] = timer;
+}
+
+/**
+ * @brief 把上层一个槽中的定时器按剩余时间重新分配到下层
+ */
+static void cascade(uint8_t level, uint8_t index) {
+  TimerWheelTimer_t *timer = slots[level][index];
+  slots[level][index] = NULL;
+  while (timer != NULL) {
+    TimerWheelTimer_t *next = timer->next;
+    insert(timer);
+    timer = next;
+  }
+}
+
+/* Public functions ----------------------------------------------------------*/
+
+void TimerWheel_Process(void) {
+  sync();
+  uint32_t tick = HAL_GetTick();
+
+  while ((int32_t)(tick - now) >= 0) {
+    // 第0层转满一圈时级联第1层当前槽，第1层也转满时再级联第2层，依此类推
+    uint8_t index = now & SLOT_MASK;
+    for (uint8_t level = 1; index == 0 && level < TIMER_WHEEL_LEVELS;
+         level++) {
+      index = (now >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK;
+      cascade(level, index);
+    }
+
+    // 第0层当前槽中的定时器全部在这一毫秒到期。整条取下后再逐个回调，
+    // 回调中重新启动的定时器即使落回同一个槽也要等下一圈；取消尚未
+    // 回调的定时器时从expiring中摘除
+    expiring = slots[0][now & SLOT_MASK];
+    slots[0][now & SLOT_MASK] = NULL;
+    for (TimerWheelTimer_t *t = expiring; t != NULL; t = t->next) {
+      t->bucket = BUCKET_EXPIRING;
+    }
+    now++; // 回调中重新启动的定时器从下一毫秒算起
+
+    while (expiring != NULL) {
+      TimerWheelTimer_t *timer = expiring;
+      expiring = timer->next;
+      timer->active = false;
+      timer->callback(timer->arg);
+    }
+  }
+}
+
+void TimerWheel_Start(TimerWheelTimer_t *timer, uint32_t delayMs,
+                      TimerCallback_t callback, uint32_t arg) {
+  TimerWheel_Cancel(timer);
+  sync();
+
+  timer->expires = HAL_GetTick() + delayMs;
+  timer->callback = callback;
+  timer->arg = arg;
+  timer->active = true;
+  insert(timer);
+}
+
+void TimerWheel_Cancel(TimerWheelTimer_t *timer) {
+  if (!timer->active) {
+    return;
+  }
+
+  TimerWheelTimer_t **link = (timer->bucket == BUCKET_EXPIRING)
+                                 ? &expiring
+                                 : &slots[0][0] + timer->bucket;
+  while (*link != NULL && *link != timer) {
+    link = &(*link)->next;
+  }
+  if (*link == timer) {
+    *link = timer->next;
+  }
+  timer->active = false;
+}
+
+uint32_t TimerWheel_Remaining(const TimerWheelTimer_t *timer) {
+  if (!timer->active) {
+    return 0;
+  }
+  int32_t remaining = timer->expires - HAL_GetTick();
+  return (remaining > 0) ? remaining : 0;
+}
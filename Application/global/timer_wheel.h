@@ -0,0 +1,69 @@
+/**
+ * @file timer_wheel.h
+ * @brief 毫秒分辨率的分层时间轮 (主循环驱动的软件定时器)
+ * @author User
+ * @date 2025-10-05
+ *
+ * TIMER_WHEEL_LEVELS层，每层TIMER_WHEEL_SLOTS个槽:
+ *   第0层每槽1ms，第1层每槽16ms，第2层每槽256ms，第3层每槽4096ms
+ * 定时器按剩余时间挂到对应层的槽上，插入和删除为O(1) (删除需遍历同槽
+ * 的短链表)；低层转满一圈时把上一层的当前槽重新分配到下层 (级联)。
+ * 超过总跨度(65.5s)的定时器先挂在最高层，级联时按剩余时间重新挂入，
+ * 所以定时时长不受跨度限制。
+ *
+ * 主循环调用TimerWheel_Process()，按HAL_GetTick()逐毫秒推进，到期回调
+ * 在主循环中执行，分辨率1ms，实际触发还要等主循环轮到这里。
+ * 定时器结构由使用者提供 (静态分配)，只能在主循环中启动和取消。
+ */
+
+#ifndef __TIMER_WHEEL_H__
+#define __TIMER_WHEEL_H__
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define TIMER_WHEEL_BITS 4 // 每层槽数的位数
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SPAN (1UL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+/* Exported types ------------------------------------------------------------*/
+
+typedef void (*TimerCallback_t)(uint32_t arg);
+
+typedef struct TimerWheelTimer {
+  struct TimerWheelTimer *next; // 同一槽中的下一个定时器
+  uint32_t expires;             // 到期时间 (时间轮毫秒计数)
+  TimerCallback_t callback;
+  uint32_t arg;
+  uint8_t bucket; // 所在的槽 (层 x TIMER_WHEEL_SLOTS + 槽号)
+  bool active;
+} TimerWheelTimer_t;
+
+/* Function prototypes -------------------------------------------------------*/
+
+/**
+ * @brief 主循环调用: 推进到当前时间并执行到期回调
+ */
+void TimerWheel_Process(void);
+
+/**
+ * @brief 启动定时器 (已启动的先取消再按新时长启动)
+ * @param delayMs 定时时长，0表示下一次TimerWheel_Process时到期
+ */
+void TimerWheel_Start(TimerWheelTimer_t *timer, uint32_t delayMs,
+                      TimerCallback_t callback, uint32_t arg);
+
+/**
+ * @brief 取消定时器 (未启动时无操作)
+ */
+void TimerWheel_Cancel(TimerWheelTimer_t *timer);
+
+/**
+ * @brief 剩余毫秒数 (未启动时为0)
+ */
+uint32_t TimerWheel_Remaining(const TimerWheelTimer_t *timer);
+
+#endif /* __TIMER_WHEEL_H__ */
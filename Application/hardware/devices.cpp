@@ -1,9 +1,18 @@
 #include "devices.h"
 #include "drivers/iwdg_a.h"
 #include "drivers/settings.h"
+#include "global/analog.h"
+#include "global/color_engine.h"
 #include "global/controller.h"
+#include "global/fan.h"
+#include "global/history.h"
+#include "global/lumen.h"
+#include "global/presets.h"
+#include "global/regulator.h"
+#include "global/thermal.h"
 #include "global/global_objects.h"
 #include "utils/custom_types.h"
+#include <i2c.h>
 
 SystemDeviceAvailable devices;
 
@@ -20,6 +29,25 @@ void Init_Devices() {
         // 立即保存默认设置
         Settings_Save(&state);
       }
+      // 色度校准数据独立存放，缺失时沿用默认值
+      Color_Load();
+      Presets_Load();
+      Lumen_Load();
+      Fan_Load();
+      Analog_Load();
+      Thermal_Load();
+      History_Load();
+    }
+  }
+
+  if (devices.extern_adc) {
+    // 写入连续转换配置，之后由主循环非阻塞读取
+    if (power_monitor.init(&hi2c1, 0x43 << 1, REG_SHUNT_MOHM)) {
+      serial_printf("Power monitor: %s, shunt %d mOhm\r\n",
+                    power_monitor.getTypeName(), REG_SHUNT_MOHM);
+    } else {
+      serial_printf("Power monitor init failed\r\n");
+      devices.extern_adc = false;
     }
   }
 }
\ No newline at end of file
@@ -41,7 +41,11 @@ extern "C" {
 
 /* Exported constants --------------------------------------------------------*/
 /* USER CODE BEGIN EC */
-
+// LED输出通道数 (TIM1 CH1-CH4, 2=双色温, 3=双色温+琥珀, 4=RGBW)
+// 注意: CH4(PA11)与USB D-复用，4通道固件不能同时使用USB
+#ifndef LED_CHANNEL_COUNT
+#define LED_CHANNEL_COUNT 2
+#endif
 /* USER CODE END EC */
 
 /* Exported macro ------------------------------------------------------------*/
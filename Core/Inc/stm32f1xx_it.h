@@ -66,6 +66,8 @@ void I2C1_ER_IRQHandler(void);
 void USART2_IRQHandler(void);
 void EXTI15_10_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void TIM2_IRQHandler(void);
+void DMA1_Channel1_IRQHandler(void);
 
 /* USER CODE END EFP */
 
@@ -40,12 +40,15 @@ extern UART_HandleTypeDef huart2;
 #define UART_RX_BUFFER_SIZE     512
 #define UART_CMD_MAX_LENGTH     256
 #define UART_CMD_DELIMITER      '\n'
+#define UART_FRAME_DELIMITER    0x00    // 二进制帧定界符 (COBS编码后帧内不含0x00)
 
 // 串口消息状态
 typedef enum {
     UART_MSG_IDLE = 0,
     UART_MSG_RECEIVING,
-    UART_MSG_READY
+    UART_MSG_READY,
+    UART_MSG_BINARY,    // 正在接收二进制帧 (收到0x00后进入)
+    UART_MSG_DISCARD    // 二进制帧超长，丢弃到下一个0x00
 } UartMsgState_t;
 
 // 串口消息结构体
@@ -53,6 +56,7 @@ typedef struct {
     uint8_t data[UART_CMD_MAX_LENGTH];
     uint16_t length;
     UartMsgState_t state;
+    bool binary;        // true: data为COBS编码的二进制帧 (不含定界符)
 } UartMessage_t;
 
 // 外部变量声明
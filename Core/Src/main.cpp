@@ -31,6 +31,8 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "app.h"
+#include "drivers/power_monitor.h"
+#include "global/latency.h"
 #include "iwdg.h"
 #include <sys/_types.h>
 /* USER CODE END Includes */
@@ -198,6 +200,7 @@ extern "C" void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
   switch (GPIO_Pin) {
   case GPIO_PIN_12: // Encoder Pin A
   case GPIO_PIN_13: // Encoder Pin B
+    Latency_Mark_Edge(); // 输入延迟探针的起点
     rotary_encoder.onGpioInterrupt(GPIO_Pin);
     break;
 
@@ -219,16 +222,6 @@ extern "C" void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
   }
 }
 
-extern unsigned char adc_done_flag;
-extern uint16_t adc_value; // ADC采样值
-extern "C" void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc) {
-  if (hadc == &hadc1) {
-    adc_value = HAL_ADC_GetValue(hadc);
-    // HAL_ADC_Start_IT(&hadc1); // 需要的时候再开启ADC
-    adc_done_flag = 1; // 设置ADC完成标志
-  }
-}
-
 // 用于计算频率的全局变量
 extern "C" void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
   if (htim == &htim3) {
@@ -241,6 +234,17 @@ extern "C" void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
   }
 }
 
+// 电压电流采样的中断读取 (I2C1)
+extern "C" void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c) {
+  extern PowerMonitor power_monitor;
+  power_monitor.onRxComplete(hi2c);
+}
+
+extern "C" void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+  extern PowerMonitor power_monitor;
+  power_monitor.onError(hi2c);
+}
+
 /* USER CODE END 4 */
 
 /**
@@ -47,7 +47,8 @@
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
-
+void Tach_IRQHandler(void); // Application/global/tach.cpp
+void Analog_DMA_IRQHandler(void); // Application/global/analog.cpp
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -353,4 +354,20 @@ void EXTI15_10_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles TIM2 global interrupt (fan tach capture).
+  */
+void TIM2_IRQHandler(void)
+{
+  Tach_IRQHandler();
+}
+
+/**
+  * @brief This function handles DMA1 channel1 global interrupt (ADC1 NTC).
+  */
+void DMA1_Channel1_IRQHandler(void)
+{
+  Analog_DMA_IRQHandler();
+}
+
 /* USER CODE END 1 */
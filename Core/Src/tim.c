@@ -90,7 +90,16 @@ void MX_TIM1_Init(void) {
     Error_Handler();
   }
   /* USER CODE BEGIN TIM1_Init 2 */
-
+#if LED_CHANNEL_COUNT >= 3
+  if (HAL_TIM_PWM_ConfigChannel(&htim1, &sConfigOC, TIM_CHANNEL_3) != HAL_OK) {
+    Error_Handler();
+  }
+#endif
+#if LED_CHANNEL_COUNT >= 4
+  if (HAL_TIM_PWM_ConfigChannel(&htim1, &sConfigOC, TIM_CHANNEL_4) != HAL_OK) {
+    Error_Handler();
+  }
+#endif
   /* USER CODE END TIM1_Init 2 */
   HAL_TIM_MspPostInit(&htim1);
 }
@@ -145,7 +154,7 @@ void MX_TIM3_Init(void) {
   htim3.Instance = TIM3;
   htim3.Init.Prescaler = 699;
   htim3.Init.CounterMode = TIM_COUNTERMODE_UP;
-  htim3.Init.Period = 6300;
+  htim3.Init.Period = 1574;
   htim3.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
   htim3.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
   if (HAL_TIM_Base_Init(&htim3) != HAL_OK) {
@@ -267,7 +276,17 @@ void HAL_TIM_MspPostInit(TIM_HandleTypeDef *timHandle) {
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
     /* USER CODE BEGIN TIM1_MspPostInit 1 */
-
+#if LED_CHANNEL_COUNT >= 3
+    /**TIM1 GPIO Configuration (扩展通道)
+    PA10     ------> TIM1_CH3
+    PA11     ------> TIM1_CH4
+    */
+    GPIO_InitStruct.Pin = GPIO_PIN_10;
+#if LED_CHANNEL_COUNT >= 4
+    GPIO_InitStruct.Pin |= GPIO_PIN_11;
+#endif
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+#endif
     /* USER CODE END TIM1_MspPostInit 1 */
   }
 }
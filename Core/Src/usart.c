@@ -30,6 +30,7 @@
 uint8_t uart_rx_dma_buffer[UART_RX_BUFFER_SIZE];
 volatile uint16_t uart_rx_write_pos = 0;
 volatile uint16_t uart_rx_read_pos = 0;
+static volatile uint8_t uart_rx_restarted = 0; // 错误中断中已重启DMA，读位置需要归零
 
 // 消息处理相关变量
 UartMessage_t uart_message = {0};
@@ -104,7 +105,7 @@ void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
     hdma_usart2_rx.Init.MemInc = DMA_MINC_ENABLE;
     hdma_usart2_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
     hdma_usart2_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
-    hdma_usart2_rx.Init.Mode = DMA_NORMAL;
+    hdma_usart2_rx.Init.Mode = DMA_CIRCULAR;
     hdma_usart2_rx.Init.Priority = DMA_PRIORITY_MEDIUM;
     if (HAL_DMA_Init(&hdma_usart2_rx) != HAL_OK)
     {
@@ -180,28 +181,80 @@ void UART_Start_DMA_Reception(void)
 }
 
 /**
- * @brief 处理DMA接收的数据
+ * @brief 处理DMA接收的数据 (只在主循环中调用)
  */
 void UART_Process_DMA_Reception(void)
 {
-    // 获取当前DMA传输位置
+    __disable_irq();
+    if (uart_rx_restarted) {
+        // DMA从缓冲区开头重新接收，丢弃未完成的消息
+        uart_rx_restarted = 0;
+        uart_rx_read_pos = 0;
+        if (uart_message.state != UART_MSG_READY) {
+            uart_message.length = 0;
+            uart_message.state = UART_MSG_IDLE;
+        }
+    }
+
+    // 获取当前DMA传输位置 (循环模式下计数器重装载的瞬间可能读到0)
     uint16_t current_pos = UART_RX_BUFFER_SIZE - __HAL_DMA_GET_COUNTER(&hdma_usart2_rx);
-    
-    if (current_pos != uart_rx_write_pos) {
-        uart_rx_write_pos = current_pos;
+    __enable_irq();
+    if (current_pos >= UART_RX_BUFFER_SIZE) {
+        current_pos = 0;
+    }
+    uart_rx_write_pos = current_pos;
+
+    // 上一条消息未处理时留在缓冲区中的字节，在消息清除后继续解析
+    if (uart_rx_read_pos != uart_rx_write_pos) {
         UART_Parse_Buffer();
     }
 }
 
 /**
  * @brief 解析接收缓冲区中的数据
+ * @note 0x00开始一个二进制帧，直到下一个0x00结束 (帧内容为COBS编码，
+ *       不含0x00)；其余字节按文本命令行处理，'\n'或'\r'结束一行。
+ *       消息就绪后停止解析，剩余字节等消息清除后再处理。
  */
 void UART_Parse_Buffer(void)
 {
     while (uart_rx_read_pos != uart_rx_write_pos) {
+        if (uart_message.state == UART_MSG_READY) {
+            return;
+        }
+
         uint8_t byte = uart_rx_dma_buffer[uart_rx_read_pos];
         uart_rx_read_pos = (uart_rx_read_pos + 1) % UART_RX_BUFFER_SIZE;
-        
+
+        // 二进制帧: 收集到下一个定界符，空帧 (连续的0x00) 忽略
+        if (uart_message.state == UART_MSG_BINARY ||
+            uart_message.state == UART_MSG_DISCARD) {
+            if (byte == UART_FRAME_DELIMITER) {
+                if (uart_message.state == UART_MSG_BINARY &&
+                    uart_message.length > 0) {
+                    uart_message.binary = true;
+                    uart_message.state = UART_MSG_READY;
+                    return; // 帧完成，退出解析
+                }
+                uart_message.length = 0;
+                uart_message.state = UART_MSG_BINARY;
+            } else if (uart_message.state == UART_MSG_BINARY) {
+                if (uart_message.length < UART_CMD_MAX_LENGTH) {
+                    uart_message.data[uart_message.length++] = byte;
+                } else {
+                    uart_message.state = UART_MSG_DISCARD;
+                }
+            }
+            continue;
+        }
+
+        // 定界符开始二进制帧，丢弃未完成的文本行
+        if (byte == UART_FRAME_DELIMITER) {
+            uart_message.length = 0;
+            uart_message.state = UART_MSG_BINARY;
+            continue;
+        }
+
         // 如果当前没有正在接收的消息，开始新消息
         if (uart_message.state == UART_MSG_IDLE) {
             uart_message.length = 0;
@@ -212,6 +265,7 @@ void UART_Parse_Buffer(void)
         if (byte == UART_CMD_DELIMITER || byte == '\r') {
             if (uart_message.length > 0) {
                 uart_message.data[uart_message.length] = '\0'; // 添加字符串结束符
+                uart_message.binary = false;
                 uart_message.state = UART_MSG_READY;
                 return; // 消息完成，退出解析
             }
@@ -232,14 +286,25 @@ void UART_Parse_Buffer(void)
 
 /**
  * @brief 处理空闲线路中断
+ * @note 只清除标志；解析在主循环中进行，避免与主循环同时修改消息
  */
 void UART_Handle_Idle_Interrupt(void)
 {
     // 清除空闲标志
     __HAL_UART_CLEAR_IDLEFLAG(&huart2);
-    
-    // 处理接收到的数据
-    UART_Process_DMA_Reception();
+}
+
+/**
+ * @brief 串口错误回调
+ * @note DMA接收时任何接收错误 (帧错误、噪声、溢出) 都会让HAL中止DMA，
+ *       主机热插拔时很容易出现，这里立即重启接收
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance == USART2) {
+        HAL_UART_Receive_DMA(&huart2, uart_rx_dma_buffer, UART_RX_BUFFER_SIZE);
+        uart_rx_restarted = 1;
+    }
 }
 
 /**
@@ -270,6 +335,7 @@ void UART_Clear_Message(void)
 {
     uart_message.length = 0;
     uart_message.state = UART_MSG_IDLE;
+    uart_message.binary = false;
     memset(uart_message.data, 0, UART_CMD_MAX_LENGTH);
 }
 
@@ -0,0 +1,178 @@
+/**
+ * @file bench_commands.cpp
+ * @brief 主机上的命令解析基准测试 (由bench_commands.py生成回调桩并编译运行)
+ * @author User
+ * @date 2025-10-09
+ *
+ * 比较两种方式每秒能处理的命令数:
+ *   旧: 执行时逐表strcmp查找，父命令回调逐层调用，参数用atoi转换
+ *   新: 入队时按编译期索引查找、转换整数参数，执行时按操作码调用一次回调
+ * 同时检查索引中的每个节点都能按名称找回自己。
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "command_index.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+/* Private defines -----------------------------------------------------------*/
+#define BENCH_ROUNDS 200000
+
+/* Private variables ---------------------------------------------------------*/
+static const char *const bench_lines[] = {
+    "POWER CH1 SET 500",      "FAN READ",
+    "EFFECT BREATHE 2000 80", "FAN CURVE 2 45 300",
+    "ADC READ",               "HIST DUMP MIN 10",
+    "THERM MODEL 8 20 5 600", "COLOR XY 3 3127 3290",
+    "HELP"};
+#define BENCH_LINES (sizeof(bench_lines) / sizeof(bench_lines[0]))
+
+static volatile uint32_t sink;
+
+/* Private functions ---------------------------------------------------------*/
+
+typedef struct {
+  const char *text;
+  uint8_t length;
+} Token_t;
+
+static uint8_t tokenize(const char *line, Token_t *tokens) {
+  uint8_t count = 0;
+  const char *p = line;
+  while (*p && count < CMD_MAX_PARAMS) {
+    while (*p == ' ') {
+      p++;
+    }
+    if (!*p) {
+      break;
+    }
+    tokens[count].text = p;
+    while (*p && *p != ' ') {
+      p++;
+    }
+    tokens[count].length = p - tokens[count].text;
+    count++;
+  }
+  return count;
+}
+
+/**
+ * @brief 旧方式: 逐表strcmp查找，依次调用各层回调，其余参数atoi
+ */
+static void run_linear(const char **params, uint8_t count) {
+  const CommandStruct_t *table = main_commands;
+  uint8_t table_count = main_command_count;
+  for (uint8_t level = 0; level < count; level++) {
+    const CommandStruct_t *entry = NULL;
+    for (uint8_t j = 0; j < table_count; j++) {
+      if (strcmp(params[level], table[j].command) == 0) {
+        entry = &table[j];
+        break;
+      }
+    }
+    if (entry == NULL) {
+      return;
+    }
+    entry->callback(&params[level], count - level);
+    if (entry->subcommands == NULL) {
+      for (uint8_t i = level + 1; i < count; i++) {
+        sink += atoi(params[i]);
+      }
+      return;
+    }
+    table_count = entry->subcommand_count;
+    table = entry->subcommands;
+  }
+}
+
+/**
+ * @brief 新方式: 按索引逐层查找，转换整数参数，调用一次回调
+ */
+static void run_indexed(const Token_t *tokens, const char **params,
+                        uint8_t count) {
+  uint8_t node = CMD_NODE_NONE;
+  uint8_t depth = 0;
+  while (depth < count) {
+    uint8_t child =
+        Commands_Lookup(node, tokens[depth].text, tokens[depth].length);
+    if (child == CMD_NODE_NONE) {
+      return;
+    }
+    node = child;
+    depth++;
+    if (command_index.nodes[node].entry->subcommands == NULL) {
+      break;
+    }
+  }
+
+  const CommandStruct_t *entry = command_index.nodes[node].entry;
+  int32_t value;
+  for (uint8_t i = 0; i < entry->int_args && depth + i < count; i++) {
+    if (Commands_Parse_Int(tokens[depth + i].text, tokens[depth + i].length,
+                           &value)) {
+      sink += value;
+    }
+  }
+  entry->callback(&params[depth - 1], count - depth + 1);
+}
+
+/**
+ * @brief 每个节点都能按 (父节点, 名称) 找回自己
+ */
+static bool check_index(void) {
+  for (uint8_t i = 0; i < command_node_count; i++) {
+    const CommandNode_t *node = &command_index.nodes[i];
+    const char *name = node->entry->command;
+    if (Commands_Lookup(node->parent, name, strlen(name)) != i) {
+      printf("index lookup failed for node %u (%s)\n", i, name);
+      return false;
+    }
+  }
+  return Commands_Lookup(CMD_NODE_NONE, "POWERX", 6) == CMD_NODE_NONE;
+}
+
+template <typename F> static double commands_per_second(F run) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+    for (uint8_t i = 0; i < BENCH_LINES; i++) {
+      run(i);
+    }
+  }
+  std::chrono::duration<double> seconds =
+      std::chrono::steady_clock::now() - start;
+  return BENCH_ROUNDS * BENCH_LINES / seconds.count();
+}
+
+int main(void) {
+  Token_t tokens[BENCH_LINES][CMD_MAX_PARAMS];
+  char text[BENCH_LINES][CMD_MAX_PARAMS][16];
+  const char *params[BENCH_LINES][CMD_MAX_PARAMS];
+  uint8_t counts[BENCH_LINES];
+
+  // 预先分词，只测查找、参数转换和回调调用
+  for (uint8_t i = 0; i < BENCH_LINES; i++) {
+    counts[i] = tokenize(bench_lines[i], tokens[i]);
+    for (uint8_t j = 0; j < counts[i]; j++) {
+      snprintf(text[i][j], sizeof(text[i][j]), "%.*s", tokens[i][j].length,
+               tokens[i][j].text);
+      params[i][j] = text[i][j];
+    }
+  }
+
+  if (!check_index()) {
+    return 1;
+  }
+  printf("Index: %u nodes, %u slots, max probe %u\n", command_node_count,
+         CMD_INDEX_SLOTS, command_index.maxProbe);
+
+  double linear = commands_per_second(
+      [&](uint8_t i) { run_linear(params[i], counts[i]); });
+  double indexed = commands_per_second(
+      [&](uint8_t i) { run_indexed(tokens[i], params[i], counts[i]); });
+  printf("Table walk (strcmp + atoi): %.1f M cmd/s, %.1f ns/cmd\n",
+         linear / 1e6, 1e9 / linear);
+  printf("Indexed opcode:             %.1f M cmd/s, %.1f ns/cmd\n",
+         indexed / 1e6, 1e9 / indexed);
+  return 0;
+}
@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""
+命令解析主机基准测试
+为commands.h中声明的全部回调生成空桩，与bench_commands.cpp一起用主机
+g++编译运行 (命令表和索引直接取自Application/global/command_index.h)
+
+用法: python3 bench_commands.py [通道数]
+"""
+
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+
+INCLUDES = [
+    "Core/Inc",
+    "Drivers/STM32F1xx_HAL_Driver/Inc",
+    "Drivers/CMSIS/Device/ST/STM32F1xx/Include",
+    "Drivers/CMSIS/Include",
+    "Application",
+    "Application/global",
+]
+
+
+def generate_stubs():
+    """为每个命令回调生成返回SUCCESS的空函数"""
+    with open(os.path.join(ROOT, "Application/global/commands.h")) as f:
+        handlers = re.findall(r"CommandStatus_t (Cmd_\w+_Handler)\(", f.read())
+
+    lines = ['#include "commands.h"', ""]
+    for name in handlers:
+        lines.append(f"CommandStatus_t {name}(const char *params[], "
+                     f"uint8_t param_count) {{ return CMD_STATUS_SUCCESS; }}")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    channels = sys.argv[1] if len(sys.argv) > 1 else "2"
+
+    with tempfile.TemporaryDirectory() as tmp:
+        stubs = os.path.join(tmp, "stubs.cpp")
+        binary = os.path.join(tmp, "bench_commands")
+        with open(stubs, "w") as f:
+            f.write(generate_stubs())
+
+        command = ["g++", "-O2", "-std=gnu++23", "-DUSE_HAL_DRIVER",
+                   "-DSTM32F103xB", f"-DLED_CHANNEL_COUNT={channels}",
+                   "-D__weak=__attribute__((weak))", "-w"]
+        command += ["-I" + os.path.join(ROOT, path) for path in INCLUDES]
+        command += [os.path.join(ROOT, "bench_commands.cpp"), stubs,
+                    "-o", binary]
+        subprocess.run(command, check=True)
+        subprocess.run([binary], check=True)
+
+
+if __name__ == "__main__":
+    main()
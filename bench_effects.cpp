@@ -0,0 +1,67 @@
+/**
+ * @file bench_effects.cpp
+ * @brief 主机上的效果引擎耗时测量 (由bench_effects.py编译运行)
+ * @author User
+ * @date 2025-10-10
+ *
+ * 直接编译Application/global/effects.cpp (DWT/CoreDebug换成内存中的结构，
+ * HAL_GetTick按TIM3节拍递增)，每种效果连续调用Effects_Update，按TSC
+ * 计时得到每次更新的平均周期数。目标板上的Cortex-M3周期数用EFFECT READ
+ * 读取 (DWT测量)。
+ */
+
+/* Includes ------------------------------------------------------------------*/
+// x86intrin.h要在CMSIS之前包含 (core_cm3.h把__I/__O定义为宏)
+#include <x86intrin.h>
+#include "main.h"
+#include <chrono>
+#include <cstdio>
+
+// 寄存器结构含const成员，用原始内存代替
+alignas(DWT_Type) static uint8_t host_dwt[sizeof(DWT_Type)];
+alignas(CoreDebug_Type) static uint8_t host_debug[sizeof(CoreDebug_Type)];
+#undef DWT
+#define DWT ((DWT_Type *)host_dwt)
+#undef CoreDebug
+#define CoreDebug ((CoreDebug_Type *)host_debug)
+// 主机上没有中断，开关中断指令为空
+#define __disable_irq() ((void)0)
+#define __enable_irq() ((void)0)
+#include "effects.cpp"
+
+/* Private defines -----------------------------------------------------------*/
+#define BENCH_UPDATES 10000000
+#define BENCH_TICK_MS 9 // TIM3节拍约8.6ms
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t host_tick = 0;
+static volatile uint16_t sink;
+
+extern "C" uint32_t HAL_GetTick(void) { return host_tick; }
+
+/* Private functions ---------------------------------------------------------*/
+
+static void run(EffectConfig_t config) {
+  Effects_Set(&config);
+  uint64_t start = __rdtsc();
+  auto begin = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_UPDATES; i++) {
+    host_tick += BENCH_TICK_MS;
+    sink = Effects_Update();
+  }
+  uint64_t cycles = __rdtsc() - start;
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - begin;
+  printf("%-8s %5.1f TSC cycles, %5.2f ns per update\n",
+         Effects_Name(config.type), (double)cycles / BENCH_UPDATES,
+         elapsed.count() / BENCH_UPDATES);
+}
+
+int main(void) {
+  Effects_Init();
+  run({EFFECT_NONE, EFFECT_GAIN_ONE, 3000, 100, 0xAAAA, 3});
+  run({EFFECT_BREATHE, 800, 3000, 100, 0xAAAA, 3});
+  run({EFFECT_CANDLE, 800, 3000, 100, 0xAAAA, 3});
+  run({EFFECT_STROBE, 800, 3000, 100, 0xF0F0, 3});
+  return 0;
+}
@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+"""
+效果引擎主机耗时测量
+用主机g++编译bench_effects.cpp (直接包含Application/global/effects.cpp)
+并运行，输出每种效果每次Effects_Update的平均TSC周期数
+
+用法: python3 bench_effects.py
+"""
+
+import os
+import subprocess
+import tempfile
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+
+INCLUDES = [
+    "Core/Inc",
+    "Drivers/STM32F1xx_HAL_Driver/Inc",
+    "Drivers/CMSIS/Device/ST/STM32F1xx/Include",
+    "Drivers/CMSIS/Include",
+    "Application",
+    "Application/global",
+]
+
+
+def main():
+    with tempfile.TemporaryDirectory() as tmp:
+        binary = os.path.join(tmp, "bench_effects")
+
+        command = ["g++", "-O2", "-std=gnu++23", "-DUSE_HAL_DRIVER",
+                   "-DSTM32F103xB", "-D__weak=__attribute__((weak))", "-w"]
+        command += ["-I" + os.path.join(ROOT, path) for path in INCLUDES]
+        command += [os.path.join(ROOT, "bench_effects.cpp"), "-o", binary]
+        subprocess.run(command, check=True)
+        subprocess.run([binary], check=True)
+
+
+if __name__ == "__main__":
+    main()
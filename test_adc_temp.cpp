@@ -0,0 +1,80 @@
+/**
+ * @file test_adc_temp.cpp
+ * @brief 主机上的NTC换算测试 (由test_adc_temp.py编译运行)
+ * @author User
+ * @date 2025-10-10
+ *
+ * 对检查范围内的每个抽取后ADC值，比较固件的查表插值 (ntc::lookup) 与
+ * 单精度B值公式 (ntc::temperatureFloat) 及双精度公式，误差超出
+ * NTC_TABLE_MAX_ERROR时返回非0。同时测量两种换算的主机耗时。
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "controller.h"
+#include "temp_adc.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+/* Private defines -----------------------------------------------------------*/
+#define BENCH_ROUNDS 100
+
+/* Private variables ---------------------------------------------------------*/
+static volatile int32_t sink;
+
+/* Private functions ---------------------------------------------------------*/
+
+template <typename F> static double nanoseconds_per_conversion(F convert) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+    for (uint32_t raw = 1; raw < ntc::FULL_SCALE; raw++) {
+      sink = convert(raw);
+    }
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / (BENCH_ROUNDS * (ntc::FULL_SCALE - 1));
+}
+
+int main(void) {
+  int32_t worstFloat = 0;
+  double worstExact = 0.0;
+  uint32_t worstRaw = 0;
+  uint32_t checked = 0;
+
+  for (uint32_t raw = 1; raw < ntc::FULL_SCALE; raw++) {
+    int32_t reference = ntc::temperatureFloat(raw);
+    if (reference < NTC_CHECK_MIN || reference > NTC_CHECK_MAX) {
+      continue;
+    }
+    checked++;
+    int32_t table = ntc::lookup(raw);
+    int32_t error = std::abs(table - reference);
+    if (error > worstFloat) {
+      worstFloat = error;
+      worstRaw = raw;
+    }
+    double exact = std::fabs(table - ntc::temperature(raw) * 100.0);
+    if (exact > worstExact) {
+      worstExact = exact;
+    }
+  }
+
+  printf("Checked %u ADC codes (%d..%d, x100 degC)\n", checked, NTC_CHECK_MIN,
+         NTC_CHECK_MAX);
+  printf("Max error vs float formula:  %d (raw %u)\n", worstFloat, worstRaw);
+  printf("Max error vs double formula: %.1f\n", worstExact);
+
+  double table = nanoseconds_per_conversion(
+      [](uint32_t raw) { return ntc::lookup(raw); });
+  double single = nanoseconds_per_conversion(
+      [](uint32_t raw) { return ntc::temperatureFloat(raw); });
+  printf("Host time: table %.1f ns, float %.1f ns\n", table, single);
+
+  if (worstFloat > NTC_TABLE_MAX_ERROR || worstExact > NTC_TABLE_MAX_ERROR) {
+    printf("FAIL: limit is %d\n", NTC_TABLE_MAX_ERROR);
+    return 1;
+  }
+  printf("PASS\n");
+  return 0;
+}
@@ -0,0 +1,40 @@
+#!/usr/bin/env python3
+"""
+NTC温度换算主机测试
+用主机g++编译test_adc_temp.cpp (换算表和公式直接取自
+Application/global/temp_adc.h)，逐个ADC值比较查表结果与浮点公式
+
+用法: python3 test_adc_temp.py
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+
+INCLUDES = [
+    "Core/Inc",
+    "Drivers/STM32F1xx_HAL_Driver/Inc",
+    "Drivers/CMSIS/Device/ST/STM32F1xx/Include",
+    "Drivers/CMSIS/Include",
+    "Application",
+    "Application/global",
+]
+
+
+def main():
+    with tempfile.TemporaryDirectory() as tmp:
+        binary = os.path.join(tmp, "test_adc_temp")
+
+        command = ["g++", "-O2", "-std=gnu++23", "-DUSE_HAL_DRIVER",
+                   "-DSTM32F103xB", "-D__weak=__attribute__((weak))", "-w"]
+        command += ["-I" + os.path.join(ROOT, path) for path in INCLUDES]
+        command += [os.path.join(ROOT, "test_adc_temp.cpp"), "-o", binary]
+        subprocess.run(command, check=True)
+        return subprocess.run([binary]).returncode
+
+
+if __name__ == "__main__":
+    sys.exit(main())